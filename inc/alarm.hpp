@@ -16,12 +16,14 @@
 #include "state_persistence.hpp"
 #include "kinect.hpp"
 #include "log.hpp"
-#include "video_stream.hpp"
-#include "video.hpp"
+#include "intrusion_recorder_interface.hpp"
+#include "zip_writer.hpp"
 #include "liveview.hpp"
 #include "detection.hpp"
 #include "base64_encoder.hpp"
 #include "threadpool.hpp"
+#include "task_graph.hpp"
+#include "shm_frame_ring.hpp"
 
 /*******************************************************************
  * Structures
@@ -34,6 +36,7 @@ struct AlarmConfig
     int detection_active;
     int liveview_active;
     int current_detection_number;
+    bool liveview_base64;
 };
 
 /*******************************************************************
@@ -47,7 +50,8 @@ public:
     AlarmDetectionObserver(Alarm& alarm);
     void IntrusionStarted() override;
     void IntrusionStopped(uint32_t frame_num) override;
-    void IntrusionFrame(std::shared_ptr<KinectVideoFrame> frame, uint32_t frame_num) override;
+    void IntrusionFrame(std::shared_ptr<const KinectVideoFrame> frame, uint32_t frame_num) override;
+    void IntrusionHeatMap(const DifferenceMap& heat_map) override;
 private:
     Alarm& m_alarm;
 };
@@ -56,9 +60,15 @@ class AlarmLiveviewObserver : public LiveviewObserver
 {
 public:
     AlarmLiveviewObserver(Alarm& alarm);
-    void NewFrame(KinectVideoFrame& frame) override;
+    void NewFrame(const KinectVideoFrame& frame) override;
+    void NewDepthFrame(const KinectDepthFrame& frame) override;
+    void NewSideBySideFrame(const KinectDepthFrame& depth_frame, const KinectVideoFrame& video_frame) override;
 private:
     Alarm& m_alarm;
+    std::vector<uint8_t> m_liveview_jpeg;
+    std::string m_liveview_base64;
+
+    void PublishJpeg();
 };
 
 class Alarm
@@ -69,8 +79,10 @@ public:
     /**
      * @brief Contructor
      * 
+     * @param[in] liveview_shm_name : name of the shared memory of the liveview frames
      */
-    Alarm(std::shared_ptr<IMessageBroker> message_broker, std::shared_ptr<IDatabase> data_base);
+    Alarm(std::shared_ptr<IMessageBroker> message_broker, std::shared_ptr<IDatabase> data_base,
+          const std::string& liveview_shm_name = LIVEVIEW_SHM_NAME);
 
     /**
      * @brief Destructor
@@ -174,6 +186,49 @@ public:
      */
     int ChangeSensitivity(int32_t value);
 
+    /**
+     * @brief Add a detection zone, or replace the one with the same id
+     * 
+     */
+    int SetDetectionZone(int32_t id, int32_t threshold, int32_t sensitivity, const std::vector<RoiPoint>& polygon);
+
+    /**
+     * @brief Delete a detection zone
+     * 
+     */
+    int DeleteDetectionZone(int32_t id);
+
+    /**
+     * @brief Delete all detection zones, the whole frame is evaluated again
+     * 
+     */
+    int ResetDetectionZones();
+
+    /**
+     * @brief Change the frames streamed by the liveview: video, depth or both side by side
+     * 
+     */
+    int ChangeLiveviewMode(LiveviewMode mode);
+
+    /**
+     * @brief Publish the liveview frames also in base64 on the text channel, for the clients that can't receive
+     *        binary messages
+     * 
+     */
+    int EnableLiveviewBase64(bool enable);
+
+    /**
+     * @brief Enable or disable the publication of the intrusion heat map
+     * 
+     */
+    int EnableHeatMap(bool enable);
+
+    /**
+     * @brief Write the frame drop and latency counters of the Kinect streams in Redis
+     * 
+     */
+    int PublishFrameStats();
+
 private:
     /* Kinect object */
     std::shared_ptr<IKinect> m_kinect;
@@ -202,11 +257,20 @@ private:
     /* Base64 encoder object */
     Base64Encoder m_base64_encoder;
 
+    /* Liveview frames for the consumers in the same host */
+    ShmFrameRing m_liveview_shm;
+
     /* Threadpool object */
-    ThreadPool<4> m_threadPool;
+    ThreadPool m_threadPool{THREADPOOL_THREADS};
 
-    /* Vector SavetoJpeg tasks*/
-    std::vector<std::shared_ptr<Task>> m_jpeg_tasks;
+    /* Intrusion recorder object */
+    std::shared_ptr<IIntrusionRecorder> m_intrusion_recorder;
+
+    /* Archive of the intrusion in progress */
+    std::shared_ptr<ZipWriter> m_intrusion_archive;
+
+    /* Jobs of the intrusion in progress: encode -> archive -> database -> publish */
+    std::unique_ptr<TaskGraph> m_intrusion_graph;
 
     AlarmConfig m_alarm_config{
         .tilt = ALARM_TILT,
@@ -214,24 +278,27 @@ private:
         .contrast = ALARM_CONTRAST,
         .detection_active = 0,
         .liveview_active = 0,
-        .current_detection_number = 0
+        .current_detection_number = 0,
+        .liveview_base64 = LIVEVIEW_BASE64
     };
 
-    DetectionConfig m_detection_config = {
-        .threshold = DETECTION_THRESHOLD,
-        .sensitivity = DETECTION_SENSITIVITY,
-        .cooldown_ms = DETECTION_COOLDOWN_MS,
-        .refresh_reference_interval_ms = DETECTION_REFRESH_REFERENCE_INTERVAL_MS,
-        .take_depth_frame_interval_ms = DETECTION_TAKE_DEPTH_FRAME_INTERVAL_MS,
-        .take_video_frame_interval_ms = DETECTION_TAKE_VIDEO_FRAME_INTERVAL_MS
+    DetectionConfig m_detection_config{
+        DETECTION_THRESHOLD,
+        DETECTION_SENSITIVITY,
+        DETECTION_COOLDOWN_MS,
+        DETECTION_REFRESH_REFERENCE_INTERVAL_MS,
+        DETECTION_TAKE_DEPTH_FRAME_INTERVAL_MS,
+        DETECTION_TAKE_VIDEO_FRAME_INTERVAL_MS
     };
 
-    LiveviewConfig m_liveview_config = {
-        .video_frame_interval_ms = LIVEVIEW_FRAME_INTERVAL_MS
+    LiveviewConfig m_liveview_config{
+        LIVEVIEW_FRAME_INTERVAL_MS,
+        LIVEVIEW_MODE
     };
 
     std::shared_ptr<IDataTable> m_detection_table;
     std::shared_ptr<IDataTable> m_status_table;
+    std::shared_ptr<IDataTable> m_zones_table;
 
     uint16_t threshold;
     uint16_t sensitivity;
@@ -265,11 +332,19 @@ private:
         {"FILENAME_VID", DataType::String,}
     };
 
+    const Entry m_zones_table_definition = {
+        {"ID",          DataType::Integer,},
+        {"THRESHOLD",   DataType::Integer,},
+        {"SENSITIVITY", DataType::Integer,},
+        {"POLYGON",     DataType::String,}
+    };
+
     int UpdateLed();
 
     int ReadStatus();
     int WriteStatus();
     int CreateStatus();
+    int ReadDetectionZones();
 
     int InitVarsRedis();
     int InitStatePersistenceVars();
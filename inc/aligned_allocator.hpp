@@ -0,0 +1,77 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file aligned_allocator.hpp
+ *
+ */
+
+#ifndef ALIGNED_ALLOCATOR_H_
+#define ALIGNED_ALLOCATOR_H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/*******************************************************************
+ * Defines
+ *******************************************************************/
+/* Cache line size, also a multiple of the widest SIMD register used by the kernels */
+#define FRAME_BUFFER_ALIGNMENT 64U
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+/**
+ * @brief Allocator of buffers aligned to Alignment bytes, so the kernels never split a load across cache lines
+ */
+template<class T, std::size_t Alignment = FRAME_BUFFER_ALIGNMENT>
+class AlignedAllocator
+{
+public:
+    using value_type = T;
+
+    template<class U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept
+    {
+    }
+
+    template<class U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template<class U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept
+    {
+        return true;
+    }
+
+    template<class U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept
+    {
+        return false;
+    }
+};
+
+template<class T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+#endif /* ALIGNED_ALLOCATOR_H_ */
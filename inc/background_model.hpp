@@ -0,0 +1,102 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file background_model.hpp
+ *
+ */
+
+#ifndef BACKGROUND_MODEL_H_
+#define BACKGROUND_MODEL_H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "kinect_frame.hpp"
+#include "kinect_frame_kernels.hpp"
+#include "aligned_allocator.hpp"
+#include "frame_pool.hpp"
+
+/*******************************************************************
+ * Struct declaration
+ *******************************************************************/
+/* Immutable output of the background model, compared against the live frames */
+struct DepthBackground
+{
+    /* Rounded mean of each pixel, blank where no depth has been measured yet */
+    KinectDepthFrame mean;
+    /* k_sigma times the standard deviation of each pixel */
+    AlignedVector<uint16_t> tolerances;
+
+    DepthBackground(uint32_t width, uint32_t height) : mean(width, height), tolerances(width * height, 0)
+    {
+    }
+};
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+/**
+ * @brief Per-pixel running background of the depth frames: exponential moving average of the mean and the variance.
+ *        Pixels out of the tolerance are foreground, they only move the mean so static changes are slowly absorbed.
+ *        Each update is a single O(pixels) pass that also writes the published background, so no other copy of the
+ *        frame is made. The published backgrounds are recycled once no reader holds them.
+ */
+class DepthBackgroundModel
+{
+public:
+    /**
+     * @brief Construct an empty model, its size is taken from the first frame
+     *
+     * @param[in] learning_rate : weight of each new frame, between 0 and 1
+     * @param[in] k_sigma : number of standard deviations tolerated around the mean
+     * @param[in] min_tolerance : pixels nearer than it to the mean are always background
+     */
+    DepthBackgroundModel(float learning_rate, float k_sigma, float min_tolerance);
+
+    /**
+     * @brief Change the model parameters, the learned values are kept
+     *
+     */
+    void SetParameters(float learning_rate, float k_sigma, float min_tolerance);
+
+    /**
+     * @brief Forget everything learned, the next frame initializes the model
+     *
+     */
+    void Reset();
+
+    /**
+     * @brief Learn a new frame and publish the resulting background. A frame of a different size resets the model
+     *
+     * @param[in] frame : depth frame
+     */
+    void Update(const KinectDepthFrame& frame);
+
+    /**
+     * @brief Get the last published background
+     *
+     * @return background, nullptr if no frame has been learned since the last reset
+     */
+    std::shared_ptr<const DepthBackground> GetBackground() const;
+
+private:
+    mutable std::mutex m_mutex;
+    float m_learning_rate;
+    float m_k_sigma;
+    float m_min_tolerance;
+    uint32_t m_width;
+    uint32_t m_height;
+    AlignedVector<float> m_mean;
+    AlignedVector<float> m_variance;
+    AlignedVector<uint16_t> m_mean_out;
+    std::unique_ptr<FramePool<DepthBackground>> m_backgrounds;
+    std::shared_ptr<const DepthBackground> m_background;
+    UpdateBackgroundKernel m_update_background;
+};
+
+#endif /* BACKGROUND_MODEL_H_ */
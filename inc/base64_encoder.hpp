@@ -8,58 +8,225 @@
 #ifndef BASE64_ENCODER_H_
 #define BASE64_ENCODER_H_
 
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <openssl/pem.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BASE64_X86
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__aarch64__)
+#include <arm_neon.h>
+#define BASE64_NEON
+#endif
+
+#include "kinect_frame_kernels.hpp"
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+/**
+ * @brief Base64 encoder (RFC 4648, with padding and without line breaks). The input is read in place and the output
+ *        is written into a buffer owned by the caller, so a buffer reused between messages is only grown by the
+ *        first ones. The AVX2 and NEON kernels encode 24 and 48 bytes per iteration, the rest goes through the
+ *        scalar one.
+ */
 class Base64Encoder
 {
-    public:
-        Base64Encoder()
+public:
+    /**
+     * @brief Encode the input bytes into the output characters, EncodedSize(size) of them
+     *
+     * @param[in] src : bytes to encode
+     * @param[in] size : number of bytes
+     * @param[out] dst : encoded characters
+     */
+    using Kernel = void (*)(const uint8_t* src, size_t size, char* dst);
+
+    /**
+     * @brief Number of characters needed to encode size bytes
+     *
+     */
+    static size_t EncodedSize(size_t size)
+    {
+        return 4 * ((size + 2) / 3);
+    }
+
+    /**
+     * @brief Encode a buffer in base64
+     *
+     * @param[in] data : bytes to encode
+     * @param[in] size : number of bytes
+     * @param[out] output : encoded string, its capacity is reused
+     */
+    void Encode(const uint8_t* data, size_t size, std::string& output) const
+    {
+        output.resize(EncodedSize(size));
+        m_kernel(data, size, output.data());
+    }
+
+    /**
+     * @brief Reference implementation of the kernel
+     *
+     */
+    static void EncodeScalar(const uint8_t* src, size_t size, char* dst)
+    {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        size_t i = 0;
+
+        for(; i + 3 <= size; i += 3)
         {
-            /* Initialize base64 filter and memory sink BIO */
-            m_b64_bio = BIO_new(BIO_f_base64());
-            m_mem_bio = BIO_new(BIO_s_mem());
+            uint32_t triplet = (src[i] << 16) | (src[i + 1] << 8) | src[i + 2];
 
-            /* Link the BIOs by creating a filter-sink BIO chain */
-            BIO_push(m_b64_bio, m_mem_bio);
+            *dst++ = alphabet[(triplet >> 18) & 0x3F];
+            *dst++ = alphabet[(triplet >> 12) & 0x3F];
+            *dst++ = alphabet[(triplet >> 6) & 0x3F];
+            *dst++ = alphabet[triplet & 0x3F];
+        }
 
-            /* No newlines every 64 characters or less */
-            BIO_set_flags(m_b64_bio, BIO_FLAGS_BASE64_NO_NL);
+        if(i < size)
+        {
+            uint32_t triplet = (src[i] << 16) | ((i + 1 < size) ? (src[i + 1] << 8) : 0);
 
-            /* Store address of mem_bio's memory structure */
-            BIO_get_mem_ptr(m_mem_bio, &m_mem_buffer);
+            *dst++ = alphabet[(triplet >> 18) & 0x3F];
+            *dst++ = alphabet[(triplet >> 12) & 0x3F];
+            *dst++ = (i + 1 < size) ? alphabet[(triplet >> 6) & 0x3F] : '=';
+            *dst++ = '=';
         }
+    }
+
+    /**
+     * @brief Get the implementation of the kernel for a given variant
+     *
+     * @return pointer to the kernel, nullptr if the variant is not supported by the build or the CPU
+     */
+    static Kernel GetKernel(KernelVariant variant)
+    {
+        Kernel kernel = nullptr;
 
-        std::string& Encode(std::string input)
+        switch(variant)
         {
-            /* Reset bio structures */
-            BIO_reset(m_b64_bio);
-            BIO_reset(m_mem_bio);
+            case KernelVariant::Scalar:
+                kernel = EncodeScalar;
+                break;
+#if defined(BASE64_X86)
+            case KernelVariant::Avx2:
+                if(__builtin_cpu_supports("avx2"))
+                {
+                    kernel = EncodeAvx2;
+                }
+                break;
+#endif
+#if defined(BASE64_NEON)
+            case KernelVariant::Neon:
+                kernel = EncodeNeon;
+                break;
+#endif
+            default:
+                break;
+        }
 
-            /* Records base64 encoded data */
-            BIO_write(m_b64_bio, input.data(), input.length());
+        return kernel;
+    }
 
-            /* Flush data. Necessary for b64 encoding, because of pad characters */
-            BIO_flush(m_b64_bio);
+private:
+    Kernel m_kernel = GetBestKernel();
 
-            /* Add null terminator */
-            BUF_MEM_grow(m_mem_buffer, (*m_mem_buffer).length + 1);
-            (*m_mem_buffer).data[(*m_mem_buffer).length] = '\0';
+    static Kernel GetBestKernel()
+    {
+        /* Select once the fastest implementation supported by the CPU */
+        static const Kernel best = []
+        {
+            for(KernelVariant variant : {KernelVariant::Avx2, KernelVariant::Neon})
+            {
+                if(GetKernel(variant) != nullptr)
+                {
+                    return GetKernel(variant);
+                }
+            }
+            return GetKernel(KernelVariant::Scalar);
+        }();
+
+        return best;
+    }
+
+#if defined(BASE64_X86)
+    __attribute__((target("avx2")))
+    static void EncodeAvx2(const uint8_t* src, size_t size, char* dst)
+    {
+        /* Characters of each range are the index plus its offset: A-Z, a-z, 0-9, + and / */
+        const __m256i shift_lut = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                   '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                                   '/' - 63, 'A', 0, 0,
+                                                   'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                   '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                                   '/' - 63, 'A', 0, 0);
+        /* Each 32 bits lane gets the 3 bytes of a group, in the order the 6 bits indexes are cut from them */
+        const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                                1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+        size_t i = 0;
+
+        /* Each 128 bits half reads 16 bytes and uses 12 */
+        for(; i + 28 <= size; i += 24)
+        {
+            __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))),
+                                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 12)), 1);
+            in = _mm256_shuffle_epi8(in, spread);
+
+            /* Move the four 6 bits fields of each lane to their own byte */
+            __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+            __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+            __m256i indexes = _mm256_or_si256(t0, t1);
 
-            m_output = (*m_mem_buffer).data;
+            /* Entry of the offset of each index: 13 for 0-25, 0 for 26-51, 1 to 10 for the digits, 11 for '+' and 12 for '/' */
+            __m256i range = _mm256_subs_epu8(indexes, _mm256_set1_epi8(51));
+            range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indexes), _mm256_set1_epi8(13)));
 
-            return m_output;
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_add_epi8(indexes, _mm256_shuffle_epi8(shift_lut, range)));
+            dst += 32;
         }
 
-        ~Base64Encoder()
+        EncodeScalar(src + i, size - i, dst);
+    }
+#endif
+
+#if defined(BASE64_NEON)
+    static void EncodeNeon(const uint8_t* src, size_t size, char* dst)
+    {
+        static const uint8_t alphabet[64] = {
+            'A','B','C','D','E','F','G','H','I','J','K','L','M','N','O','P','Q','R','S','T','U','V','W','X','Y','Z',
+            'a','b','c','d','e','f','g','h','i','j','k','l','m','n','o','p','q','r','s','t','u','v','w','x','y','z',
+            '0','1','2','3','4','5','6','7','8','9','+','/'};
+        const uint8x16x4_t table = vld1q_u8_x4(alphabet);
+        const uint8x16_t mask = vdupq_n_u8(0x3F);
+        size_t i = 0;
+
+        for(; i + 48 <= size; i += 48)
         {
-            BIO_free_all(m_b64_bio);
+            /* Deinterleaved load: the first, second and third byte of 16 groups */
+            uint8x16x3_t in = vld3q_u8(src + i);
+            uint8x16x4_t out;
+
+            out.val[0] = vshrq_n_u8(in.val[0], 2);
+            out.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), mask);
+            out.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), mask);
+            out.val[3] = vandq_u8(in.val[2], mask);
+
+            out.val[0] = vqtbl4q_u8(table, out.val[0]);
+            out.val[1] = vqtbl4q_u8(table, out.val[1]);
+            out.val[2] = vqtbl4q_u8(table, out.val[2]);
+            out.val[3] = vqtbl4q_u8(table, out.val[3]);
+
+            vst4q_u8(reinterpret_cast<uint8_t*>(dst), out);
+            dst += 64;
         }
 
-    private:
-        BIO *m_b64_bio = nullptr, *m_mem_bio = nullptr;
-        BUF_MEM *m_mem_buffer = nullptr;
-        std::string m_output;
+        EncodeScalar(src + i, size - i, dst);
+    }
+#endif
 };
 
-#endif /* BASE64_ENCODER_H_ */
\ No newline at end of file
+#endif /* BASE64_ENCODER_H_ */
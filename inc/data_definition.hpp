@@ -40,4 +40,21 @@ struct Variable
 /* */
 using Entry = std::vector<Variable>;
 
+/*******************************************************************
+ * Function declaration
+ *******************************************************************/
+/**
+ * @brief Text form of the value of a variable, as kept by the message brokers
+ *
+ * @return 0 if ok, -1 if the value doesn't hold the data type of the variable
+ */
+int VariableToString(const Variable& variable, std::string& value);
+
+/**
+ * @brief Set the value of a variable from its text form, converted to the data type of the variable
+ *
+ * @return 0 if ok, -1 if the text can't be converted
+ */
+int StringToVariable(const std::string& value, Variable& variable);
+
 #endif /* DATA_DEFINITION__H_ */
\ No newline at end of file
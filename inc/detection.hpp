@@ -11,16 +11,31 @@
 /*******************************************************************
  * Includes
  *******************************************************************/
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+
 #include "common.hpp"
 #include "global_parameters.hpp"
 #include "log.hpp"
 #include "kinect_interface.hpp"
-#include "cyclic_task.hpp"
 #include "alarm_module_interface.hpp"
+#include "roi_mask.hpp"
+#include "background_model.hpp"
 
 /*******************************************************************
  * Struct declaration
  *******************************************************************/
+/* Region of the depth frame evaluated with its own sensitivity and threshold */
+struct DetectionZone
+{
+    uint16_t id;
+    uint16_t threshold;
+    uint16_t sensitivity;
+    std::vector<RoiPoint> polygon;
+};
+
 struct DetectionConfig : AlarmModuleConfig
 {
     uint16_t threshold;
@@ -29,6 +44,26 @@ struct DetectionConfig : AlarmModuleConfig
     uint32_t refresh_reference_interval_ms;
     uint32_t take_depth_frame_interval_ms;
     uint32_t take_video_frame_interval_ms;
+    /* When empty the whole frame is evaluated with threshold and sensitivity */
+    std::vector<DetectionZone> zones;
+    /* Report where the differences are during intrusions */
+    bool heat_map = false;
+    /* Pyramid level compared first while idle (0 disables it), full resolution is only compared when its
+     * number of differences is greater than coarse_threshold. With zones each one is compared at the level with its
+     * own sensitivity, against coarse_threshold or its threshold scaled to the level if smaller */
+    uint32_t coarse_level = DETECTION_COARSE_LEVEL;
+    uint32_t coarse_threshold = DETECTION_COARSE_THRESHOLD;
+    /* Compare against a running background (mean +- k_sigma standard deviations, never less than the sensitivity)
+     * learned every refresh_reference_interval_ms while idle, instead of a snapshot refreshed only during intrusions.
+     * Enabling or disabling it takes effect on the next Start */
+    bool background_model = DETECTION_BACKGROUND_MODEL;
+    float background_learning_rate = DETECTION_BACKGROUND_LEARNING_RATE;
+    float background_k_sigma = DETECTION_BACKGROUND_K_SIGMA;
+    /* Video frames kept while idle, at the take_video_frame_interval_ms rate, and handed to the observer when an
+     * intrusion starts: up to preroll_ms of them without taking more than preroll_max_bytes (0 disables it).
+     * Enabling it takes effect on the next Start */
+    uint32_t preroll_ms = DETECTION_PREROLL_MS;
+    uint32_t preroll_max_bytes = DETECTION_PREROLL_MAX_BYTES;
 
     DetectionConfig()
     {
@@ -53,7 +88,6 @@ struct DetectionConfig : AlarmModuleConfig
 /*******************************************************************
  * Class declaration
  *******************************************************************/
-class RefreshReferenceFrame;
 class TakeVideoFrames;
 
 class DetectionObserver
@@ -61,10 +95,11 @@ class DetectionObserver
 public:
     virtual void IntrusionStarted() = 0;
     virtual void IntrusionStopped(uint32_t frame_num) = 0;
-    virtual void IntrusionFrame(std::shared_ptr<KinectVideoFrame> frame, uint32_t frame_num) = 0;
+    virtual void IntrusionFrame(std::shared_ptr<const KinectVideoFrame> frame, uint32_t frame_num) = 0;
+    virtual void IntrusionHeatMap(const DifferenceMap& heat_map) = 0;
 };
 
-class Detection : public IAlarmModule, public CyclicTask
+class Detection : public IAlarmModule
 {
     friend TakeVideoFrames;
 public:
@@ -88,8 +123,6 @@ public:
 
     void UpdateConfig(AlarmModuleConfig& config) override;
 
-    void ExecutionCycle() override;
-
 private:
     enum class State
     {
@@ -98,45 +131,76 @@ private:
         Cooldown
     };
 
+    /**
+     * @brief Called by the Kinect depth subscription with each delivered frame
+     *
+     */
+    void NewDepthFrame(std::shared_ptr<const KinectDepthFrame> frame);
+
+    /**
+     * @brief Replace the reference with a new frame, or learn it when the background model is enabled
+     *
+     */
+    void RefreshReference(std::shared_ptr<const KinectDepthFrame> frame);
+
     DetectionConfig m_detection_config;
+    std::vector<RoiMask> m_zone_masks;
+    /* Zone masks downsampled to the coarse level */
+    std::vector<RoiMask> m_zone_coarse_masks;
+    std::mutex m_config_mutex;
     State m_current_state;
     std::chrono::time_point<std::chrono::system_clock> m_cooldown_abs_time;
-    std::shared_ptr<KinectDepthFrame> m_depth_frame_ref;
-    std::shared_ptr<KinectDepthFrame> m_depth_frame;
-    uint32_t m_timestamp;
+    std::chrono::time_point<std::chrono::system_clock> m_heat_map_abs_time;
+    std::chrono::time_point<std::chrono::system_clock> m_refresh_abs_time;
+    DifferenceMap m_heat_map;
+    /* Only used from the depth subscription thread */
+    std::shared_ptr<const KinectDepthFrame> m_depth_frame_ref;
+    std::shared_ptr<const DepthBackground> m_background;
+    std::unique_ptr<DepthBackgroundModel> m_background_model;
+    bool m_background_enabled;
     std::shared_ptr<IKinect> m_kinect;
-    uint8_t* liveview_jpeg;
-    std::unique_ptr<RefreshReferenceFrame> m_refresh_reference_frame;
+    int m_depth_subscription;
     std::unique_ptr<TakeVideoFrames> m_take_video_frames;
     std::shared_ptr<DetectionObserver> m_detection_observer;
 };
 
-class RefreshReferenceFrame : public CyclicTask
-{
-public:
-    RefreshReferenceFrame(std::shared_ptr<IKinect> kinect,
-                          std::shared_ptr<KinectDepthFrame> depth_frame_reff,
-                          uint32_t loop_period_ms);
-    void ExecutionCycle() override;
-private:
-    std::shared_ptr<KinectDepthFrame> m_depth_frame_ref;
-    std::shared_ptr<IKinect> m_kinect;
-};
-
-class TakeVideoFrames : public CyclicTask
+/**
+ * @brief Forwards the video frames to the detection observer during an intrusion. With the pre-roll started the
+ *        video frames are also taken while idle and the last ones are kept, they are shared with the Kinect's pool
+ *        so keeping them doesn't copy any pixel. When the intrusion starts they are handed to the observer first,
+ *        so the recording includes the moments before the trigger and doesn't wait for the subscription
+ */
+class TakeVideoFrames
 {
 public:
     TakeVideoFrames(Detection& detection,
                     std::shared_ptr<IKinect> kinect,
-                    uint32_t loop_period_ms);
-    void ExecutionCycle() override;
+                    uint32_t decimation);
+    ~TakeVideoFrames();
     void Start();
     uint32_t Stop();
+    void StartPreroll();
+    void StopPreroll();
+    void ChangeDecimation(uint32_t decimation);
+    void ChangePreroll(uint32_t max_frames, uint32_t max_bytes);
 private:
     Detection& m_detection;
-    std::shared_ptr<KinectVideoFrame> m_frame;
     std::shared_ptr<IKinect> m_kinect;
+    uint32_t m_decimation;
+    int m_subscription;
+    bool m_preroll_started;
+    std::mutex m_mutex;
+    /* Used from the subscription thread, never held while unsubscribing */
+    std::mutex m_frames_mutex;
+    bool m_recording;
     uint32_t m_frame_counter;
+    std::deque<std::shared_ptr<const KinectVideoFrame>> m_preroll;
+    uint64_t m_preroll_bytes;
+    uint32_t m_preroll_max_frames;
+    uint32_t m_preroll_max_bytes;
+
+    void Subscribe();
+    void NewVideoFrame(std::shared_ptr<const KinectVideoFrame> frame);
 };
 
 #endif /* DETECTION_H_ */
\ No newline at end of file
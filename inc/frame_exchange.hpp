@@ -0,0 +1,453 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file frame_exchange.hpp
+ *
+ */
+
+#ifndef FRAME_EXCHANGE_H_
+#define FRAME_EXCHANGE_H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+
+#include "log.hpp"
+#include "frame_pool.hpp"
+
+/*******************************************************************
+ * Type definitions
+ *******************************************************************/
+/* Frame discarded when a new one arrives and the subscription queue is full */
+enum class FrameDropPolicy
+{
+    DropOldest,
+    DropNewest
+};
+
+/* Queue between the producer and a subscription */
+struct FrameQueueConfig
+{
+    uint32_t size;
+    FrameDropPolicy drop_policy;
+};
+
+/* Counters of a frame stream. Published, delivered and dropped are accumulated since the creation, the latency
+ * (capture to consumption, in microseconds) is measured over the frames delivered since the previous read */
+struct FrameStreamStats
+{
+    uint64_t published;
+    uint64_t delivered;
+    uint64_t dropped;
+    uint32_t latency_mean_us;
+    uint32_t latency_max_us;
+};
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+/**
+ * @brief Counters shared by the producer and the subscriptions of a FrameExchange
+ */
+class FrameStreamCounters
+{
+public:
+    FrameStreamCounters() :
+        m_published(0), m_delivered(0), m_dropped(0), m_latency_sum_us(0), m_latency_count(0), m_latency_max_us(0)
+    {
+    }
+
+    void AddPublished()
+    {
+        m_published++;
+    }
+
+    void AddDropped()
+    {
+        m_dropped++;
+    }
+
+    void AddDelivered(std::chrono::steady_clock::time_point capture_time)
+    {
+        uint64_t latency_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::steady_clock::now() - capture_time).count();
+        uint64_t latency_max_us = m_latency_max_us;
+
+        m_delivered++;
+        m_latency_sum_us += latency_us;
+        m_latency_count++;
+        while(latency_us > latency_max_us && !m_latency_max_us.compare_exchange_weak(latency_max_us, latency_us))
+        {
+        }
+    }
+
+    /**
+     * @brief Get the counters, starting a new latency measurement window
+     *
+     */
+    FrameStreamStats Read()
+    {
+        uint64_t latency_sum_us = m_latency_sum_us.exchange(0);
+        uint64_t latency_count = m_latency_count.exchange(0);
+        uint64_t latency_max_us = m_latency_max_us.exchange(0);
+
+        return {m_published, m_delivered, m_dropped,
+                static_cast<uint32_t>((latency_count != 0) ? latency_sum_us / latency_count : 0),
+                static_cast<uint32_t>(std::min<uint64_t>(latency_max_us, UINT32_MAX))};
+    }
+
+private:
+    std::atomic<uint64_t> m_published;
+    std::atomic<uint64_t> m_delivered;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_latency_sum_us;
+    std::atomic<uint64_t> m_latency_count;
+    std::atomic<uint64_t> m_latency_max_us;
+};
+
+/**
+ * @brief Consumer of the frames of a FrameExchange. The producer offers every frame and one of each decimation is
+ *        queued for the subscription thread, which only wakes up to run the callback. The queue is a fixed ring, when
+ *        it's full the drop policy decides whether the oldest queued frame or the new one is discarded, so a slow
+ *        consumer never builds an unbounded backlog nor blocks the producer.
+ */
+template<class FrameType>
+class FrameSubscription
+{
+public:
+    using Callback = std::function<void(std::shared_ptr<const FrameType>)>;
+
+    /**
+     * @brief Constructor, starts the subscription thread
+     *
+     * @param[in] callback : called from the subscription thread with each delivered frame
+     * @param[in] decimation : one of each decimation frames is delivered, 0 is taken as 1
+     * @param[in] queue_config : size of the queue (0 is taken as 1) and drop policy when it's full
+     * @param[in] counters : counters of the stream, must outlive the subscription
+     */
+    FrameSubscription(Callback callback, uint32_t decimation, FrameQueueConfig queue_config, FrameStreamCounters& counters) :
+        m_callback(callback),
+        m_decimation(std::max(decimation, 1U)),
+        m_counter(0),
+        m_running(true),
+        m_queue(std::max(queue_config.size, 1U)),
+        m_queue_head(0),
+        m_queue_count(0),
+        m_drop_policy(queue_config.drop_policy),
+        m_counters(counters)
+    {
+        m_thread = std::thread(&FrameSubscription::ThreadLoop, this);
+    }
+
+    /**
+     * @brief Destructor, waits for the callback in progress. Must not be called from the callback
+     *
+     */
+    ~FrameSubscription()
+    {
+        {
+            std::lock_guard<std::mutex> lock_guard(m_mutex);
+            m_running = false;
+        }
+        m_condition_variable.notify_one();
+        m_thread.join();
+    }
+
+    /**
+     * @brief Offer a new frame, called by the producer
+     *
+     */
+    void Offer(const std::shared_ptr<const FrameType>& frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+            if((m_counter++ % m_decimation) != 0)
+            {
+                return;
+            }
+            if(m_queue_count == m_queue.size())
+            {
+                m_counters.AddDropped();
+                if(m_drop_policy == FrameDropPolicy::DropNewest)
+                {
+                    LOG(LOG_DEBUG, "FrameSubscription: queue full, frame %u dropped\n", frame->GetTimestamp());
+                    return;
+                }
+                LOG(LOG_DEBUG, "FrameSubscription: queue full, frame %u dropped\n", m_queue[m_queue_head]->GetTimestamp());
+                m_queue[m_queue_head] = nullptr;
+                m_queue_head = (m_queue_head + 1) % m_queue.size();
+                m_queue_count--;
+            }
+            m_queue[(m_queue_head + m_queue_count) % m_queue.size()] = frame;
+            m_queue_count++;
+        }
+        m_condition_variable.notify_one();
+    }
+
+    void SetDecimation(uint32_t decimation)
+    {
+        std::lock_guard<std::mutex> lock_guard(m_mutex);
+        m_decimation = std::max(decimation, 1U);
+    }
+
+    bool IsSubscriptionThread() const
+    {
+        return std::this_thread::get_id() == m_thread.get_id();
+    }
+
+private:
+    Callback m_callback;
+    uint32_t m_decimation;
+    uint32_t m_counter;
+    bool m_running;
+    /* Ring of queued frames, m_queue_count of them starting at m_queue_head */
+    std::vector<std::shared_ptr<const FrameType>> m_queue;
+    uint32_t m_queue_head;
+    uint32_t m_queue_count;
+    FrameDropPolicy m_drop_policy;
+    FrameStreamCounters& m_counters;
+    std::mutex m_mutex;
+    std::condition_variable m_condition_variable;
+    std::thread m_thread;
+
+    void ThreadLoop()
+    {
+        std::unique_lock<std::mutex> ulock(m_mutex);
+
+        while(true)
+        {
+            m_condition_variable.wait(ulock, [this]{ return !m_running || m_queue_count != 0; });
+
+            if(!m_running)
+            {
+                break;
+            }
+
+            /* The callback runs without the lock, so the producer is never blocked by a consumer */
+            std::shared_ptr<const FrameType> frame = std::move(m_queue[m_queue_head]);
+            m_queue[m_queue_head] = nullptr;
+            m_queue_head = (m_queue_head + 1) % m_queue.size();
+            m_queue_count--;
+            ulock.unlock();
+            m_counters.AddDelivered(frame->GetCaptureTime());
+            m_callback(frame);
+            frame = nullptr;
+            ulock.lock();
+        }
+    }
+};
+
+/**
+ * @brief Hand-over point between the frame producer (libfreenect callback) and the frame consumers.
+ *
+ * The producer fills a slot of the frame pool that no consumer is holding and publishes it as the latest frame.
+ * Consumers receive a shared, immutable snapshot of the latest frame, so the frame data is copied only once per
+ * capture regardless of the number of consumers. With one consumer three slots are enough (triple buffer), the
+ * pool grows if consumers keep more snapshots alive.
+ *
+ * Consumers either poll with Get or subscribe, in which case every published frame is offered to them. Frames are
+ * stamped with the monotonic capture time so the subscriptions can measure how stale they are when consumed.
+ */
+template<class FrameType>
+class FrameExchange
+{
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param[in] width : pixel width of the frames
+     * @param[in] height : pixel height of the frames
+     * @param[in] number_slots : number of frames preallocated
+     */
+    FrameExchange(uint32_t width, uint32_t height, uint32_t number_slots = 3) :
+        m_pool(width, height, number_slots)
+    {
+        m_latest = m_pool.Acquire();
+    }
+
+    /**
+     * @brief Copy the frame data into a free slot and publish it as the latest frame
+     *
+     * @param[in] frame_data : frame data
+     * @param[in] timestamp : timestamp related to the frame
+     */
+    void Publish(const uint16_t* frame_data, uint32_t timestamp)
+    {
+        std::chrono::steady_clock::time_point capture_time = std::chrono::steady_clock::now();
+        std::shared_ptr<FrameType> slot = m_pool.Acquire();
+
+        /* No one else can reach the slot until it's published, so it's filled without holding the lock */
+        slot->Fill(frame_data, timestamp);
+        slot->SetCaptureTime(capture_time);
+        m_counters.AddPublished();
+
+        {
+            std::lock_guard<std::mutex> lock_guard(m_mutex);
+            m_latest = slot;
+        }
+
+        m_condition_variable.notify_all();
+
+        std::lock_guard<std::mutex> lock_guard(m_subscriptions_mutex);
+        for(auto& subscription : m_subscriptions)
+        {
+            subscription.second->Offer(slot);
+        }
+    }
+
+    /**
+     * @brief Subscribe to the published frames
+     *
+     * @param[in] id : identifier of the subscription, chosen by the caller
+     * @param[in] callback : called from the subscription thread with each delivered frame
+     * @param[in] decimation : one of each decimation frames is delivered
+     * @param[in] queue_config : size and drop policy of the subscription queue
+     *
+     * @return 0 if ok, -1 if the identifier is already in use
+     */
+    int Subscribe(int id, typename FrameSubscription<FrameType>::Callback callback, uint32_t decimation,
+                  FrameQueueConfig queue_config)
+    {
+        std::lock_guard<std::mutex> lock_guard(m_subscriptions_mutex);
+
+        if(m_subscriptions.count(id) != 0)
+        {
+            return -1;
+        }
+        m_subscriptions[id] = std::make_unique<FrameSubscription<FrameType>>(callback, decimation, queue_config, m_counters);
+
+        return 0;
+    }
+
+    /**
+     * @brief Change the decimation of a subscription
+     *
+     * @return 0 if ok, -1 if the subscription doesn't exist
+     */
+    int ChangeDecimation(int id, uint32_t decimation)
+    {
+        std::lock_guard<std::mutex> lock_guard(m_subscriptions_mutex);
+        auto it = m_subscriptions.find(id);
+
+        if(it == m_subscriptions.end())
+        {
+            return -1;
+        }
+        it->second->SetDecimation(decimation);
+
+        return 0;
+    }
+
+    /**
+     * @brief Cancel a subscription, waiting for the callback in progress. Must not be called from its own callback
+     *
+     * @return 0 if ok, -1 if the subscription doesn't exist or it's called from its callback
+     */
+    int Unsubscribe(int id)
+    {
+        std::unique_ptr<FrameSubscription<FrameType>> subscription;
+
+        {
+            std::lock_guard<std::mutex> lock_guard(m_subscriptions_mutex);
+            auto it = m_subscriptions.find(id);
+
+            if(it == m_subscriptions.end())
+            {
+                return -1;
+            }
+            if(it->second->IsSubscriptionThread())
+            {
+                LOG(LOG_ERR, "FrameExchange: subscription %d can't be cancelled from its own callback\n", id);
+                return -1;
+            }
+            subscription = std::move(it->second);
+            m_subscriptions.erase(it);
+        }
+
+        /* Joined without the lock, the producer keeps publishing meanwhile */
+        subscription.reset();
+
+        return 0;
+    }
+
+    /**
+     * @brief Get a snapshot of the latest frame. If the given snapshot is already the latest one it waits for the
+     *        next frame until the timeout expires
+     *
+     * @param[in/out] frame : last snapshot obtained by the caller (can be null), replaced by the latest one
+     * @param[in] timeout_ms : maximum time waiting for a new frame
+     *
+     * @return true if a new frame was obtained before the timeout
+     */
+    bool Get(std::shared_ptr<const FrameType>& frame, uint32_t timeout_ms)
+    {
+        bool retval = true;
+        std::unique_lock<std::mutex> ulock(m_mutex);
+        uint32_t timestamp = (frame != nullptr) ? frame->GetTimestamp() : 0;
+
+        /* Compare the given timestamp with the current, if it's the same must wait to the next frame */
+        if(timestamp == m_latest->GetTimestamp())
+        {
+            retval = m_condition_variable.wait_for(ulock, std::chrono::milliseconds(timeout_ms),
+                                                   [this, timestamp]{ return timestamp != m_latest->GetTimestamp(); });
+        }
+
+        frame = m_latest;
+
+        return retval;
+    }
+
+    /**
+     * @brief Get the counters of the stream, see FrameStreamStats
+     *
+     */
+    FrameStreamStats GetStats()
+    {
+        return m_counters.Read();
+    }
+
+    /**
+     * @brief Get the number of frames allocated by the pool
+     *
+     */
+    uint32_t GetPoolSize() const
+    {
+        return m_pool.GetSize();
+    }
+
+    /**
+     * @brief Publish an empty frame with timestamp 0, so the next Get waits for a new capture
+     *
+     */
+    void Reset()
+    {
+        std::lock_guard<std::mutex> lock_guard(m_mutex);
+        std::shared_ptr<FrameType> slot = m_pool.Acquire();
+        slot->SetTimestamp(0);
+        m_latest = slot;
+    }
+
+private:
+    FramePool<FrameType> m_pool;
+    std::shared_ptr<FrameType> m_latest;
+    std::mutex m_mutex;
+    std::condition_variable m_condition_variable;
+    /* Declared before the subscriptions so it outlives them */
+    FrameStreamCounters m_counters;
+    std::map<int, std::unique_ptr<FrameSubscription<FrameType>>> m_subscriptions;
+    std::mutex m_subscriptions_mutex;
+};
+
+#endif /* FRAME_EXCHANGE_H_ */
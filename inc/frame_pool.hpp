@@ -0,0 +1,100 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file frame_pool.hpp
+ *
+ */
+
+#ifndef FRAME_POOL_H_
+#define FRAME_POOL_H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "log.hpp"
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+/**
+ * @brief Fixed set of preallocated frames (or any object constructed from a width and a height) that are recycled
+ *        instead of being allocated for each capture.
+ *
+ * The pool keeps a reference to each frame and hands it out as a shared pointer, a frame is free again once the
+ * pool holds the only reference to it, i.e. when the last consumer drops it. This recycles the frames without any
+ * allocation, a custom deleter would need a new control block for each shared pointer handed out. If every frame
+ * is held when one is requested the pool grows by one, so it settles at the number of frames in flight and the
+ * steady state performs no allocations.
+ */
+template<class FrameType>
+class FramePool
+{
+public:
+    /**
+     * @brief Constructor, preallocates the frames
+     *
+     * @param[in] width : pixel width of the frames
+     * @param[in] height : pixel height of the frames
+     * @param[in] number_frames : number of frames preallocated
+     */
+    FramePool(uint32_t width, uint32_t height, uint32_t number_frames) :
+        m_width(width), m_height(height)
+    {
+        m_frames.reserve(number_frames);
+        for(uint32_t i = 0; i < number_frames; i++)
+        {
+            m_frames.push_back(std::make_shared<FrameType>(m_width, m_height));
+        }
+    }
+
+    /**
+     * @brief Get a frame that no one else holds. Its content is the one of its previous use
+     *
+     * @return frame, only referenced by the pool and the caller
+     */
+    std::shared_ptr<FrameType> Acquire()
+    {
+        std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+        for(const auto& frame : m_frames)
+        {
+            if(frame.use_count() == 1)
+            {
+                /* use_count() is a relaxed load, the writes of the last holder must be visible before reusing it */
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return frame;
+            }
+        }
+
+        m_frames.push_back(std::make_shared<FrameType>(m_width, m_height));
+        /* It should only grow until the frames in flight are covered, a steady growth means frames are leaked */
+        LOG(LOG_WARNING, "FramePool: all frames in use, pool grown to %zu frames\n", m_frames.size());
+
+        return m_frames.back();
+    }
+
+    /**
+     * @brief Get the number of frames allocated by the pool
+     *
+     */
+    uint32_t GetSize() const
+    {
+        std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+        return m_frames.size();
+    }
+
+private:
+    uint32_t m_width;
+    uint32_t m_height;
+    std::vector<std::shared_ptr<FrameType>> m_frames;
+    mutable std::mutex m_mutex;
+};
+
+#endif /* FRAME_POOL_H_ */
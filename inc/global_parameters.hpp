@@ -8,6 +8,11 @@
 #ifndef GLOBAL_PARAMETERS_H_
 #define GLOBAL_PARAMETERS_H_
 
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <string>
+
 /*******************************************************************
  * Defines
  *******************************************************************/
@@ -25,8 +30,17 @@
 #define REDIS_EVENT_SUCCESS_CHANNEL  "event_success"
 #define REDIS_EVENT_ERROR_CHANNEL    "event_error"
 #define REDIS_LIVEFRAMES_CHANNEL     "liveview"
+#define REDIS_LIVEFRAMES_BIN_CHANNEL "liveview_bin"
 #define REDIS_DET_INTRUSION_CHANNEL  "new_det"
 #define REDIS_DET_EMAIL_SEND_CHANNEL "email_send_det"
+#define REDIS_DET_HEAT_MAP_CHANNEL   "det_heatmap"
+
+/* MessageBrokerType::Redis or MessageBrokerType::Local to run without a Redis server */
+#define MESSAGE_BROKER_TYPE              MessageBrokerType::Redis
+#define MESSAGE_BROKER_QUEUE_SIZE        256U
+#define MESSAGE_BROKER_PIPELINE_DEPTH    32U
+#define MESSAGE_BROKER_FLUSH_TIMEOUT_MS  1000U
+#define MESSAGE_BROKER_STATS_INTERVAL_S  60U
 
 #define ALARM_TILT       0
 #define ALARM_BRIGHTNESS 1000
@@ -38,15 +52,60 @@
 #define DETECTION_REFRESH_REFERENCE_INTERVAL_MS 1000U
 #define DETECTION_TAKE_DEPTH_FRAME_INTERVAL_MS  10U
 #define DETECTION_TAKE_VIDEO_FRAME_INTERVAL_MS  200U
+#define DETECTION_MAX_ZONES          8U
+#define DETECTION_MAX_ZONE_VERTICES  16U
+#define DETECTION_HEAT_MAP_BLOCK_SIZE 16U
+#define DETECTION_COARSE_LEVEL        0U
+#define DETECTION_COARSE_THRESHOLD    50U
+#define DETECTION_BACKGROUND_MODEL          true
+#define DETECTION_BACKGROUND_LEARNING_RATE  0.05f
+#define DETECTION_BACKGROUND_K_SIGMA        3.0f
+#define DETECTION_DEPTH_QUEUE_SIZE 2U
+#define DETECTION_VIDEO_QUEUE_SIZE 8U
+#define DETECTION_PREROLL_MS        2000U
+#define DETECTION_PREROLL_MAX_BYTES (8U * 1024U * 1024U)
+
+#define JPEG_QUALITY  75
+#define JPEG_FAST_DCT false
+#define JPEG_GAMMA    1.0f
+
+#define RECORDER_CODEC        RecorderCodec::H264
+#define RECORDER_QUEUE_SIZE   16U
+#define RECORDER_GOP_SIZE     25
+#define RECORDER_H264_PRESET  "veryfast"
+#define RECORDER_H264_CRF     "28"
+#define RECORDER_MJPEG_QSCALE 5
+
+/* 0 for one thread per hardware thread */
+#define THREADPOOL_THREADS 0U
 
 #define LIVEVIEW_FRAME_INTERVAL_MS 150U
+#define LIVEVIEW_QUEUE_SIZE        1U
+#define LIVEVIEW_MODE              LiveviewMode::Video
+#define LIVEVIEW_BASE64            false
+
+/* Ring of liveview frames for the consumers in the same host, announced in the lvw_shm variable */
+#define LIVEVIEW_SHM                true
+#define LIVEVIEW_SHM_NAME           "/kinectalarm_liveview"
+#define LIVEVIEW_SHM_SLOTS          4U
+#define LIVEVIEW_SHM_MAX_FRAME_SIZE (1024U * 1024U)
 
 #define KINECT_GETFRAMES_TIMEOUT_MS 1000U
+#define KINECT_FRAME_INTERVAL_MS    33U
 
 #define DEPTH_WIDTH    640U
 #define DEPTH_HEIGHT   480U
 #define VIDEO_WIDTH    640U
 #define VIDEO_HEIGHT   480U
 
+/*******************************************************************
+ * Function definition
+ *******************************************************************/
+/* Frames and heat maps are streams, a newer one makes the queued one stale */
+inline bool IsStreamChannel(const std::string& channel)
+{
+    return channel == REDIS_LIVEFRAMES_CHANNEL || channel == REDIS_LIVEFRAMES_BIN_CHANNEL ||
+           channel == REDIS_DET_HEAT_MAP_CHANNEL;
+}
 
 #endif /* GLOBAL_PARAMETERS_H_ */
@@ -0,0 +1,125 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file intrusion_recorder.hpp
+ *
+ */
+
+#ifndef INTRUSION_RECORDER_H_
+#define INTRUSION_RECORDER_H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "intrusion_recorder_interface.hpp"
+#include "jpeg_encoder.hpp"
+
+/*******************************************************************
+ * Type definitions
+ *******************************************************************/
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVStream;
+struct AVFrame;
+struct AVPacket;
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+/**
+ * @brief Records the video frames of an intrusion in an MP4 file with libavcodec, H.264 or MJPEG, as they arrive.
+ *
+ * The calls only queue the work for a thread owned by the recorder, so the detection thread is never blocked by the
+ * encoder. The encoder is opened with the first frame of each recording, when its size is known, and the file is
+ * written and finalized sequentially, so no step is left for when the intrusion stops. The 10 bits frames are
+ * converted with the same tone table as the JPEG frames into the luma plane, the chroma planes are left neutral.
+ * The pending frames are limited to queue_size, the next ones are dropped until the encoder catches up. The
+ * destructor finalizes the recording in progress.
+ */
+class IntrusionRecorder : public IIntrusionRecorder
+{
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param[in] codec : codec of the recordings, MJPEG is used if the H.264 encoder is not available
+     * @param[in] queue_size : maximum number of frames waiting to be encoded
+     */
+    IntrusionRecorder(RecorderCodec codec, uint32_t queue_size);
+
+    /**
+     * @brief Destructor
+     *
+     */
+    ~IntrusionRecorder();
+
+    IntrusionRecorder(const IntrusionRecorder&) = delete;
+    IntrusionRecorder& operator=(const IntrusionRecorder&) = delete;
+
+    int Start(const std::string& path, uint32_t frame_interval_ms, int32_t brightness, int32_t contrast) override;
+    int AddFrame(std::shared_ptr<const KinectVideoFrame> frame, uint32_t frame_num) override;
+    int Stop(std::function<void()> finalized = nullptr) override;
+
+private:
+    enum class CommandType
+    {
+        Start,
+        Frame,
+        Stop
+    };
+
+    struct Command
+    {
+        CommandType type;
+        std::string path;
+        uint32_t frame_interval_ms;
+        int32_t brightness;
+        int32_t contrast;
+        std::shared_ptr<const KinectVideoFrame> frame;
+        uint32_t frame_num;
+        std::function<void()> finalized;
+    };
+
+    RecorderCodec m_codec;
+    uint32_t m_queue_size;
+
+    /* State shared with the thread */
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition_variable;
+    std::deque<Command> m_commands;
+    uint32_t m_pending_frames;
+    bool m_recording;
+    bool m_exit;
+
+    /* State of the recording in progress, only used by the thread */
+    std::string m_path;
+    uint32_t m_frame_interval_ms;
+    AVFormatContext* m_format_context;
+    AVCodecContext* m_codec_context;
+    AVStream* m_stream;
+    AVFrame* m_frame;
+    AVPacket* m_packet;
+    bool m_header_written;
+    int64_t m_first_frame_num;
+    int64_t m_last_pts;
+    uint32_t m_frames_encoded;
+    bool m_failed;
+    ToneMapKernel m_tone_map;
+    alignas(FRAME_BUFFER_ALIGNMENT) JpegToneLut m_lut;
+
+    void Run();
+    void Queue(Command&& command);
+
+    int Open(uint32_t width, uint32_t height);
+    int EncodeFrame(const KinectVideoFrame& frame, uint32_t frame_num);
+    int WritePackets(const AVFrame* frame);
+    void Close();
+};
+
+#endif /* INTRUSION_RECORDER_H_ */
@@ -0,0 +1,27 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file intrusion_recorder_factory.hpp
+ *
+ */
+
+#ifndef INTRUSION_RECORDER_FACTORY__H_
+#define INTRUSION_RECORDER_FACTORY__H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <memory>
+
+#include "intrusion_recorder_interface.hpp"
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+class IntrusionRecorderFactory
+{
+public:
+    static std::shared_ptr<IIntrusionRecorder> Create(RecorderCodec codec, uint32_t queue_size);
+};
+
+#endif /* INTRUSION_RECORDER_FACTORY__H_ */
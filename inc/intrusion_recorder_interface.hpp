@@ -0,0 +1,75 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file intrusion_recorder_interface.hpp
+ *
+ */
+
+#ifndef IINTRUSION_RECORDER__H_
+#define IINTRUSION_RECORDER__H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "kinect_frame.hpp"
+
+/*******************************************************************
+ * Enumerations
+ *******************************************************************/
+enum class RecorderCodec
+{
+    H264,
+    Mjpeg
+};
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+class IIntrusionRecorder
+{
+public:
+    /**
+     * @brief Destructor
+     *
+     */
+    virtual ~IIntrusionRecorder() {};
+
+    /**
+     * @brief Start the recording of an intrusion
+     *
+     * @param[in] path : path of the video file
+     * @param[in] frame_interval_ms : interval between two consecutive frame numbers
+     * @param[in] brightness : brightness adjust of the frames
+     * @param[in] contrast : contrast adjust of the frames
+     *
+     * @return 0 if ok
+     */
+    virtual int Start(const std::string& path, uint32_t frame_interval_ms, int32_t brightness, int32_t contrast) = 0;
+
+    /**
+     * @brief Add a frame to the recording. The frame is held until it has been encoded
+     *
+     * @param[in] frame : video frame
+     * @param[in] frame_num : number of the frame within the intrusion, gives its presentation time
+     *
+     * @return 0 if ok
+     */
+    virtual int AddFrame(std::shared_ptr<const KinectVideoFrame> frame, uint32_t frame_num) = 0;
+
+    /**
+     * @brief Stop the recording, the file is finalized once the pending frames have been encoded
+     *
+     * @param[in] finalized : called from the recorder once the file is finalized, or given up if the recording
+     *                        failed. Not called if there is no recording in progress
+     *
+     * @return 0 if ok
+     */
+    virtual int Stop(std::function<void()> finalized = nullptr) = 0;
+};
+
+#endif /* IINTRUSION_RECORDER__H_ */
@@ -0,0 +1,226 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file jpeg_encoder.hpp
+ *
+ */
+
+#ifndef JPEG_ENCODER_H_
+#define JPEG_ENCODER_H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <csetjmp>
+#include <string>
+#include <vector>
+#include <jpeglib.h>
+
+#include "aligned_allocator.hpp"
+#include "kinect_frame.hpp"
+#include "kinect_frame_kernels.hpp"
+
+/*******************************************************************
+ * Defines
+ *******************************************************************/
+/* Number of values of a 10 bits IR pixel */
+#define JPEG_TONE_LUT_SIZE 1024U
+
+/* Number of values of an 11 bits depth pixel, the last one is BLANK_DEPTH_PIXEL */
+#define JPEG_DEPTH_LUT_SIZE 2048U
+
+/* Raw depth values mapped to the two ends of the colormap, nearer and farther values are clamped */
+#define JPEG_DEPTH_NEAR 400U
+#define JPEG_DEPTH_FAR  1100U
+
+/* Rows converted and handed to the compressor at once */
+#define JPEG_ROWS_PER_BATCH 16U
+
+/*******************************************************************
+ * Type definitions
+ *******************************************************************/
+/* 10 bits pixel value to 8 bits sample, brightness, contrast and gamma applied */
+using JpegToneLut = std::array<uint8_t, JPEG_TONE_LUT_SIZE>;
+
+/* 11 bits depth value to its RGB color, three consecutive bytes per value */
+using JpegDepthLut = std::array<uint8_t, 3 * JPEG_DEPTH_LUT_SIZE>;
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+/**
+ * @brief Grayscale JPEG encoder of 10 bits IR frames on top of libjpeg. The compressor is created once and reused
+ *        for every frame, so an instance must not be shared between threads. The 10 to 8 bits conversion, the
+ *        brightness, the contrast and the gamma are a single lookup per pixel that writes the rows handed to the
+ *        compressor, and the compressed data is written straight into the output vector, reusing its capacity.
+ *        The lookup table is kept between frames and only rebuilt when the brightness, the contrast or the gamma
+ *        change.
+ *        Depth frames are encoded in color, each 11 bits value looked up in a turbo colormap, and both kinds of
+ *        frames can be encoded side by side in the same image.
+ */
+class JpegEncoder
+{
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param[in] quality : JPEG quality, from 1 to 100
+     * @param[in] fast_dct : use the fast integer DCT, less accurate than the default one
+     * @param[in] gamma : gamma applied after the brightness and the contrast, 1 leaves the samples as they are
+     */
+    JpegEncoder(int quality, bool fast_dct, float gamma);
+
+    /**
+     * @brief Destructor
+     *
+     */
+    ~JpegEncoder();
+
+    JpegEncoder(const JpegEncoder&) = delete;
+    JpegEncoder& operator=(const JpegEncoder&) = delete;
+
+    /**
+     * @brief Change the quality and the DCT of the next frames
+     *
+     */
+    void SetQuality(int quality, bool fast_dct);
+
+    /**
+     * @brief Change the gamma of the next frames
+     *
+     */
+    void SetGamma(float gamma);
+
+    /**
+     * @brief Get the number of times the lookup table has been built
+     *
+     */
+    uint32_t GetToneLutBuilds() const;
+
+    /**
+     * @brief Encode a 10 bits frame as a grayscale JPEG
+     *
+     * @param[in] view : pixels of the frame
+     * @param[in] brightness : brightness adjust in percentage, same scale as FreeImage_AdjustBrightness
+     * @param[in] contrast : contrast adjust in percentage, same scale as FreeImage_AdjustContrast
+     * @param[out] jpeg : JPEG data, its capacity is reused
+     *
+     * @return 0 on success, -1 on error
+     */
+    int Encode(const KinectFrameView& view, int32_t brightness, int32_t contrast, std::vector<uint8_t>& jpeg);
+
+    /**
+     * @brief Encode a 10 bits frame as a grayscale JPEG file
+     *
+     * @return 0 on success, -1 on error
+     */
+    int EncodeToFile(const KinectFrameView& view, int32_t brightness, int32_t contrast, const std::string& path);
+
+    /**
+     * @brief Encode an 11 bits depth frame as a colormapped JPEG, near pixels red and far pixels blue. Blank pixels
+     *        are black
+     *
+     * @param[in] view : pixels of the frame
+     * @param[out] jpeg : JPEG data, its capacity is reused
+     *
+     * @return 0 on success, -1 on error
+     */
+    int EncodeDepth(const KinectFrameView& view, std::vector<uint8_t>& jpeg);
+
+    /**
+     * @brief Encode an 11 bits depth frame as a colormapped JPEG file
+     *
+     * @return 0 on success, -1 on error
+     */
+    int EncodeDepthToFile(const KinectFrameView& view, const std::string& path);
+
+    /**
+     * @brief Encode a colormapped depth frame and a 10 bits frame next to each other in a single JPEG, the depth
+     *        frame on the left. The shorter frame is padded with black rows
+     *
+     * @param[in] depth_view : pixels of the depth frame
+     * @param[in] video_view : pixels of the 10 bits frame
+     * @param[in] brightness : brightness adjust of the 10 bits frame
+     * @param[in] contrast : contrast adjust of the 10 bits frame
+     * @param[out] jpeg : JPEG data, its capacity is reused
+     *
+     * @return 0 on success, -1 on error
+     */
+    int EncodeSideBySide(const KinectFrameView& depth_view, const KinectFrameView& video_view, int32_t brightness,
+                         int32_t contrast, std::vector<uint8_t>& jpeg);
+
+    /**
+     * @brief Build the table that maps each 10 bits value to its 8 bits sample, with the brightness and the contrast
+     *        applied with the rounding of FreeImage, first the brightness and then the contrast, and then the gamma
+     *
+     * @param[in] brightness : brightness adjust in percentage
+     * @param[in] contrast : contrast adjust in percentage
+     * @param[in] gamma : gamma, 1 leaves the samples as they are
+     * @param[out] lut : table to fill
+     */
+    static void BuildToneLut(int32_t brightness, int32_t contrast, float gamma, JpegToneLut& lut);
+
+    /**
+     * @brief Build the table that maps each 11 bits depth value to its color of the turbo colormap, from red at
+     *        JPEG_DEPTH_NEAR to blue at JPEG_DEPTH_FAR. BLANK_DEPTH_PIXEL is black
+     *
+     * @param[out] lut : table to fill
+     */
+    static void BuildDepthLut(JpegDepthLut& lut);
+
+private:
+    struct ErrorManager
+    {
+        jpeg_error_mgr pub;
+        jmp_buf jump_buffer;
+    };
+
+    struct VectorDestination
+    {
+        jpeg_destination_mgr pub;
+        std::vector<uint8_t>* buffer;
+    };
+
+    jpeg_compress_struct m_compressor;
+    ErrorManager m_error_manager;
+    VectorDestination m_destination;
+    int m_quality;
+    bool m_fast_dct;
+    float m_gamma;
+    ToneMapKernel m_tone_map;
+    alignas(FRAME_BUFFER_ALIGNMENT) JpegToneLut m_lut;
+    bool m_lut_valid;
+    int32_t m_lut_brightness;
+    int32_t m_lut_contrast;
+    float m_lut_gamma;
+    uint32_t m_lut_builds;
+    JpegDepthLut m_depth_lut;
+    AlignedVector<uint8_t> m_rows;
+    AlignedVector<uint8_t> m_gray_row;
+    std::vector<uint8_t> m_file_buffer;
+
+    void UpdateToneLut(int32_t brightness, int32_t contrast);
+
+    /**
+     * @brief Compress an image whose rows are written by convert_row(row, samples) right before being handed to
+     *        libjpeg
+     *
+     * @return 0 on success, -1 on error
+     */
+    template<class RowConverter>
+    int Compress(uint32_t width, uint32_t height, bool color, RowConverter convert_row, std::vector<uint8_t>& jpeg);
+
+    void ColormapDepthRow(const uint16_t* src, uint32_t width, uint8_t* dst) const;
+
+    int WriteFile(const std::vector<uint8_t>& jpeg, const std::string& path);
+
+    static void ErrorExit(j_common_ptr common);
+    static void InitDestination(j_compress_ptr compressor);
+    static boolean EmptyOutputBuffer(j_compress_ptr compressor);
+    static void TermDestination(j_compress_ptr compressor);
+};
+
+#endif /* JPEG_ENCODER_H_ */
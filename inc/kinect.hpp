@@ -12,14 +12,14 @@
  * Includes
  *******************************************************************/
 #include <memory>
-#include <mutex>
-#include <condition_variable>
+#include <atomic>
 #include <libfreenect/libfreenect.h>
 #include <libfreenect/libfreenect_sync.h>
 
 #include "kinect_interface.hpp"
 #include "cyclic_task.hpp"
 #include "kinect_frame.hpp"
+#include "frame_exchange.hpp"
 #include "common.hpp"
 #include "global_parameters.hpp"
 
@@ -37,8 +37,14 @@ public:
     int Start() override;
     int Stop() override;
     bool IsRunning() override;
-    void GetDepthFrame(KinectDepthFrame& frame) override;
-    void GetVideoFrame(KinectVideoFrame& frame) override;
+    void GetDepthFrame(std::shared_ptr<const KinectDepthFrame>& frame) override;
+    void GetVideoFrame(std::shared_ptr<const KinectVideoFrame>& frame) override;
+    int SubscribeDepthFrames(DepthFrameCallback callback, uint32_t decimation, FrameQueueConfig queue_config) override;
+    int SubscribeVideoFrames(VideoFrameCallback callback, uint32_t decimation, FrameQueueConfig queue_config) override;
+    int ChangeDecimation(int subscription, uint32_t decimation) override;
+    int Unsubscribe(int subscription) override;
+    FrameStreamStats GetDepthFrameStats() override;
+    FrameStreamStats GetVideoFrameStats() override;
     int ChangeTilt(double tilt_angle) override;
     int ChangeLedColor(freenect_led_options color) override;
 
@@ -53,13 +59,12 @@ private:
     /* Get frames timeout in ms */
     static uint32_t m_timeout_ms;
 
-    /* Frames */
-    static std::unique_ptr<KinectDepthFrame> m_depth_frame;
-    static std::unique_ptr<KinectVideoFrame> m_video_frame;
+    /* Identifier of the next subscription, unique across both streams */
+    std::atomic<int> m_next_subscription;
 
-    /* Concurrency safe */
-    static std::mutex m_depth_mutex, m_video_mutex;
-    static std::condition_variable m_depth_cv,m_video_cv;
+    /* Frames */
+    static std::unique_ptr<FrameExchange<KinectDepthFrame>> m_depth_frames;
+    static std::unique_ptr<FrameExchange<KinectVideoFrame>> m_video_frames;
 
     /* Private funtions */
     static void VideoCallback(freenect_device* dev, void* data, uint32_t timestamp);
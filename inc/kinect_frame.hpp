@@ -11,18 +11,71 @@
 /*******************************************************************
  * Includes
  *******************************************************************/
+#include <cstdint>
+#include <chrono>
 #include <string>
 #include <vector>
 #include <mutex>
 
+#include "roi_mask.hpp"
+#include "aligned_allocator.hpp"
+
 /*******************************************************************
  * Defines
  *******************************************************************/
 #define BLANK_DEPTH_PIXEL 0x07FF
 
+/* Full resolution plus two levels, each one half the width and height of the previous */
+#define DEPTH_PYRAMID_LEVELS 3U
+
+/*******************************************************************
+ * Type definitions
+ *******************************************************************/
+enum class PixelFormat
+{
+    Depth11Bit,
+    Ir10Bit
+};
+
+/*******************************************************************
+ * Struct declaration
+ *******************************************************************/
+/* Read-only view of the pixels of a frame, it doesn't own them so it's valid while the frame is alive and unchanged.
+ * Rows are stride pixels apart */
+struct KinectFrameView
+{
+    const uint16_t* data;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    PixelFormat format;
+
+    const uint16_t* Row(uint32_t y) const
+    {
+        return data + y * stride;
+    }
+
+    uint32_t NumPixels() const
+    {
+        return width * height;
+    }
+};
+
+/* Number of pixels exceeding the tolerance in each block of block_size x block_size pixels, row major */
+struct DifferenceMap
+{
+    uint32_t block_size;
+    uint32_t columns;
+    uint32_t rows;
+    std::vector<uint32_t> counts;
+};
+
 /*******************************************************************
  * Class declaration
  *******************************************************************/
+class KinectDepthFrame;
+class KinectVideoFrame;
+
 class KinectFrame
 {
 public:
@@ -41,10 +94,17 @@ public:
      */
     KinectFrame(const KinectFrame& kinect_frame);
 
+    /**
+     * @brief Move Constructor, takes the buffer of the other frame, which is left empty (0x0)
+     *
+     * @param[in] kinect_frame : kinect frame object to be moved
+     */
+    KinectFrame(KinectFrame&& kinect_frame) noexcept;
+
     /**
      * @brief Destructor
      */
-    ~KinectFrame();
+    virtual ~KinectFrame();
 
     /**
      * @brief Operator=
@@ -53,20 +113,60 @@ public:
      */
     KinectFrame& operator=(const KinectFrame& kinect);
 
+    /**
+     * @brief Move Operator=, takes the buffer of the other frame, which is left empty (0x0)
+     *
+     * @param[in] kinect_frame : kinect frame object to be moved
+     */
+    KinectFrame& operator=(KinectFrame&& kinect_frame) noexcept;
+
+    /**
+     * @brief Exchange the content of two frames of the same type and size without copying their pixels
+     *
+     * @param[in/out] kinect_frame : frame to exchange the content with
+     *
+     * @return 0 on success, -1 if the frames differ in type or size
+     */
+    int Swap(KinectFrame& kinect_frame);
+
+    /**
+     * @brief Set the content of the frame by exchanging its buffer with the given one, which gets the previous
+     *        content of the frame. The counterpart of Fill without copying the pixels
+     *
+     * @param[in/out] frame_data : buffer with the new content, as many pixels as the frame
+     * @param[in] timestamp : timestamp related to the frame
+     *
+     * @return 0 on success, -1 if the buffer size doesn't match the frame
+     */
+    virtual int SwapData(AlignedVector<uint16_t>& frame_data, uint32_t timestamp);
+
     /**
      * @brief Set the content and timestamp of the frame
      *
      * @param[in] frame_data : frame data
      * @param[in] timestamp : timestamp related to the frame
      */
-    void Fill(const uint16_t* frame_data, uint32_t timestamp);
+    virtual void Fill(const uint16_t* frame_data, uint32_t timestamp);
 
     /**
-     * @brief Get the pointer to the frame data
+     * @brief Get the pointer to the frame data. Frames are only written before being shared, so reading the
+     *        data of a shared frame doesn't need the lock
      * 
      */
     const uint16_t* GetDataPointer() const;
 
+    /**
+     * @brief Get a read-only view of the pixels
+     *
+     */
+    KinectFrameView GetView() const;
+
+    virtual PixelFormat GetPixelFormat() const = 0;
+
+    uint32_t GetWidth() const;
+
+    uint32_t GetHeight() const;
+
     /**
      * @brief Get the timestamp associated with the frame
      * 
@@ -81,6 +181,14 @@ public:
      */
     void SetTimestamp(uint32_t timestamp);
 
+    /**
+     * @brief Get the monotonic time when the frame was captured, as opposed to the device timestamp
+     *
+     */
+    std::chrono::steady_clock::time_point GetCaptureTime() const;
+
+    void SetCaptureTime(std::chrono::steady_clock::time_point capture_time);
+
     /**
      * @brief Save the frame to file in JPEG format.
      *
@@ -90,7 +198,7 @@ public:
      *
      * @return number of pixel that exceeded tolerance
      */
-    virtual int SaveToJpegInFile(std::string path, int32_t brightness, int32_t contrast) = 0;
+    virtual int SaveToJpegInFile(std::string path, int32_t brightness, int32_t contrast) const = 0;
 
     /**
      * @brief Save the frame to memory in JPEG format.
@@ -101,14 +209,24 @@ public:
      *
      * @return number of pixel that exceeded tolerance
      */
-    virtual int SaveToJpegInMemory(std::vector<uint8_t>& jpeg_frame, int32_t brightness, int32_t contrast)  = 0;
+    virtual int SaveToJpegInMemory(std::vector<uint8_t>& jpeg_frame, int32_t brightness, int32_t contrast) const = 0;
+
+    friend int SaveSideBySideToJpegInMemory(const KinectDepthFrame& depth_frame, const KinectVideoFrame& video_frame,
+                                            std::vector<uint8_t>& jpeg_frame, int32_t brightness, int32_t contrast);
 
 protected:
-    std::mutex m_mutex;
+    /**
+     * @brief Exchange the members of the derived classes, called by Swap holding the lock of both frames
+     *
+     */
+    virtual void SwapDerived(KinectFrame& kinect_frame);
+
+    mutable std::mutex m_mutex;
     uint32_t m_timestamp;
+    std::chrono::steady_clock::time_point m_capture_time;
     uint32_t m_width;
     uint32_t m_height;
-    std::vector<uint16_t> m_data;
+    AlignedVector<uint16_t> m_data;
 };
 
 class KinectDepthFrame : public KinectFrame
@@ -116,21 +234,151 @@ class KinectDepthFrame : public KinectFrame
 public:
     KinectDepthFrame(uint32_t width, uint32_t height);
     KinectDepthFrame(const KinectDepthFrame& kinect_depth_frame);
+    KinectDepthFrame(KinectDepthFrame&& kinect_depth_frame) noexcept;
     ~KinectDepthFrame();
 
-    int SaveToJpegInFile(std::string path, int32_t brightness, int32_t contrast) override;
-    int SaveToJpegInMemory(std::vector<uint8_t>& jpeg_frame, int32_t brightness, int32_t contrast) override;
+    KinectDepthFrame& operator=(const KinectDepthFrame& kinect_depth_frame);
+    KinectDepthFrame& operator=(KinectDepthFrame&& kinect_depth_frame) noexcept;
+
+    PixelFormat GetPixelFormat() const override;
+
+    int SaveToJpegInFile(std::string path, int32_t brightness, int32_t contrast) const override;
+    int SaveToJpegInMemory(std::vector<uint8_t>& jpeg_frame, int32_t brightness, int32_t contrast) const override;
+
+    /**
+     * @brief Set the content and timestamp of the frame and build its downsampled levels
+     *
+     * @param[in] frame_data : frame data
+     * @param[in] timestamp : timestamp related to the frame
+     */
+    void Fill(const uint16_t* frame_data, uint32_t timestamp) override;
+
+    /**
+     * @brief Set the content of the frame by exchanging its buffer, see KinectFrame::SwapData, and build its
+     *        downsampled levels
+     *
+     */
+    int SwapData(AlignedVector<uint16_t>& frame_data, uint32_t timestamp) override;
+
+    /**
+     * @brief Get a read-only view of a pyramid level
+     *
+     * @param[in] level : 0 is the full resolution frame
+     *
+     * @return view of the level, with null data if the level doesn't exist
+     */
+    KinectFrameView GetLevelView(uint32_t level) const;
+
+    /**
+     * @brief Get the pointer to the data of a pyramid level. Each pixel of a level is the minimum (nearest depth) of
+     *        the 2x2 pixels of the previous level, so blank pixels only remain where no depth was measured
+     *
+     * @param[in] level : 0 is the full resolution frame
+     *
+     * @return pointer to the level data, nullptr if the level doesn't exist
+     */
+    const uint16_t* GetLevelDataPointer(uint32_t level) const;
+
+    /**
+     * @brief Compute differences betwen two depth frames at a pyramid level
+     *
+     * @param[in] frame : frame to compare with
+     * @param[in] tolerance : minumum distance value betwen pixel
+     * @param[in] level : pyramid level, 0 is the full resolution frame
+     * @param[in] limit : the comparison stops once the count is greater than it
+     *
+     * @return number of pixels of the level that exceeded tolerance, a partial count greater than limit on early exit
+     */
+    uint32_t ComputeDifferencesAtLevel(const KinectDepthFrame& frame, uint32_t tolerance, uint32_t level, uint32_t limit = UINT32_MAX) const;
+
+    /**
+     * @brief Compute differences betwen two depth frames at a pyramid level only inside a region of interest
+     *
+     * @param[in] frame : frame to compare with
+     * @param[in] tolerance : minumum distance value betwen pixel
+     * @param[in] level : pyramid level, 0 is the full resolution frame
+     * @param[in] mask : region of interest, must have the same size as the level, see RoiMask::Downsample
+     * @param[in] limit : the comparison stops once the count is greater than it
+     *
+     * @return number of pixels of the level inside the region that exceeded tolerance, a partial count greater than
+     *         limit on early exit
+     */
+    uint32_t ComputeDifferencesAtLevel(const KinectDepthFrame& frame, uint32_t tolerance, uint32_t level, const RoiMask& mask,
+                                       uint32_t limit = UINT32_MAX) const;
 
     /**
      * @brief Compute differences betwen two depth frames. It done by comparing pixel by pixel the absolute difference
-     *        and returning the number of pixels that exceed the tolerance
+     *        and returning the number of pixels that exceed the tolerance. The frame is processed in bands of rows
+     *        and the comparison stops as soon as the count exceeds the limit
      *
      * @param[in] frame : frame to compare with
      * @param[in] tolerance : minumum distance value betwen pixel 
+     * @param[in] limit : the comparison stops once the count is greater than it
+     *
+     * @return number of pixel that exceeded tolerance, a partial count greater than limit on early exit
+     */
+    uint32_t ComputeDifferences(const KinectDepthFrame& frame, uint32_t tolerance, uint32_t limit = UINT32_MAX) const;
+
+    /**
+     * @brief Compute differences betwen two depth frames only inside a region of interest
+     *
+     * @param[in] frame : frame to compare with
+     * @param[in] tolerance : minumum distance value betwen pixel
+     * @param[in] mask : region of interest, must have the same size as the frame
+     * @param[in] limit : the comparison stops once the count is greater than it
+     *
+     * @return number of pixel inside the region that exceeded tolerance, a partial count greater than limit on early exit
+     */
+    uint32_t ComputeDifferences(const KinectDepthFrame& frame, uint32_t tolerance, const RoiMask& mask, uint32_t limit = UINT32_MAX) const;
+
+    /**
+     * @brief Compute differences betwen two depth frames with a tolerance per pixel, e.g. the spread of a background model
+     *
+     * @param[in] frame : frame to compare with
+     * @param[in] tolerances : tolerance of each pixel, as many as pixels of the frame
+     * @param[in] tolerance : minimum tolerance of every pixel
+     * @param[in] limit : the comparison stops once the count is greater than it
+     *
+     * @return number of pixel that exceeded their tolerance, a partial count greater than limit on early exit
+     */
+    uint32_t ComputeDifferencesWithTolerances(const KinectDepthFrame& frame, const uint16_t* tolerances, uint32_t tolerance,
+                                              uint32_t limit = UINT32_MAX) const;
+
+    /**
+     * @brief Compute differences betwen two depth frames with a tolerance per pixel only inside a region of interest
+     *
+     * @param[in] frame : frame to compare with
+     * @param[in] tolerances : tolerance of each pixel, as many as pixels of the frame
+     * @param[in] tolerance : minimum tolerance of every pixel
+     * @param[in] mask : region of interest, must have the same size as the frame
+     * @param[in] limit : the comparison stops once the count is greater than it
+     *
+     * @return number of pixel inside the region that exceeded their tolerance, a partial count greater than limit on early exit
+     */
+    uint32_t ComputeDifferencesWithTolerances(const KinectDepthFrame& frame, const uint16_t* tolerances, uint32_t tolerance,
+                                              const RoiMask& mask, uint32_t limit = UINT32_MAX) const;
+
+    /**
+     * @brief Compute differences betwen two depth frames per block of pixels. The whole frame is always processed
+     *
+     * @param[in] frame : frame to compare with
+     * @param[in] tolerance : minumum distance value betwen pixel
+     * @param[in] block_size : side in pixels of the blocks, the last column and row of blocks can be smaller
+     * @param[out] map : number of pixels that exceeded the tolerance in each block
      *
      * @return number of pixel that exceeded tolerance
      */
-    uint32_t ComputeDifferences(KinectDepthFrame& frame, uint32_t tolerance);
+    uint32_t ComputeDifferenceMap(const KinectDepthFrame& frame, uint32_t tolerance, uint32_t block_size, DifferenceMap& map) const;
+
+protected:
+    void SwapDerived(KinectFrame& kinect_frame) override;
+
+private:
+    /* Levels 1 to DEPTH_PYRAMID_LEVELS - 1 */
+    AlignedVector<uint16_t> m_levels[DEPTH_PYRAMID_LEVELS - 1];
+    AlignedVector<uint16_t> m_pyramid_row;
+
+    void BuildPyramid();
 };
 
 class KinectVideoFrame : public KinectFrame
@@ -138,10 +386,33 @@ class KinectVideoFrame : public KinectFrame
 public:
     KinectVideoFrame(uint32_t width, uint32_t height);
     KinectVideoFrame(const KinectVideoFrame& kinect_depth_frame);
+    KinectVideoFrame(KinectVideoFrame&& kinect_video_frame) noexcept;
     ~KinectVideoFrame();
 
-    int SaveToJpegInFile(std::string path, int32_t brightness, int32_t contrast) override;
-    int SaveToJpegInMemory(std::vector<uint8_t>& jpeg_frame, int32_t brightness, int32_t contrast) override;
+    KinectVideoFrame& operator=(const KinectVideoFrame& kinect_video_frame);
+    KinectVideoFrame& operator=(KinectVideoFrame&& kinect_video_frame) noexcept;
+
+    PixelFormat GetPixelFormat() const override;
+
+    int SaveToJpegInFile(std::string path, int32_t brightness, int32_t contrast) const override;
+    int SaveToJpegInMemory(std::vector<uint8_t>& jpeg_frame, int32_t brightness, int32_t contrast) const override;
 };
 
+/*******************************************************************
+ * Function declaration
+ *******************************************************************/
+/**
+ * @brief Save a colormapped depth frame and a video frame next to each other in a single JPEG in memory
+ *
+ * @param[in] depth_frame : depth frame, on the left
+ * @param[in] video_frame : video frame, on the right
+ * @param[in] jpeg_frame : vector object where the JPEG image will be saved
+ * @param[in] brightness : brightness adjusts of the video frame
+ * @param[in] contrast : contrast adjusts of the video frame
+ *
+ * @return 0 on success, 1 on error
+ */
+int SaveSideBySideToJpegInMemory(const KinectDepthFrame& depth_frame, const KinectVideoFrame& video_frame,
+                                 std::vector<uint8_t>& jpeg_frame, int32_t brightness, int32_t contrast);
+
 #endif /* KINECT_FRAMES_H_ */
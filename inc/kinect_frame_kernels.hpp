@@ -0,0 +1,166 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file kinect_frame_kernels.hpp
+ *
+ */
+
+#ifndef KINECT_FRAME_KERNELS_H_
+#define KINECT_FRAME_KERNELS_H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <cstdint>
+
+/*******************************************************************
+ * Type definitions
+ *******************************************************************/
+enum class KernelVariant
+{
+    Scalar,
+    Sse41,
+    Avx2,
+    Neon
+};
+
+/**
+ * @brief Count the pixels whose absolute difference exceeds the tolerance. Pixels that are blank
+ *        (BLANK_DEPTH_PIXEL) in any of the two buffers are not taken into account.
+ *
+ * @param[in] lhs : first buffer of pixels
+ * @param[in] rhs : second buffer of pixels
+ * @param[in] num_pixels : number of pixels of each buffer
+ * @param[in] tolerance : maximum absolute difference allowed between two pixels
+ *
+ * @return number of pixels that exceeded the tolerance
+ */
+using CountDifferencesKernel = uint32_t (*)(const uint16_t* lhs, const uint16_t* rhs, uint32_t num_pixels, uint32_t tolerance);
+
+/**
+ * @brief Count the pixels whose absolute difference exceeds their own tolerance, max(tolerances[i], tolerance).
+ *        Pixels that are blank (BLANK_DEPTH_PIXEL) in any of the two buffers are not taken into account.
+ *
+ * @param[in] lhs : first buffer of pixels
+ * @param[in] rhs : second buffer of pixels
+ * @param[in] tolerances : tolerance of each pixel
+ * @param[in] num_pixels : number of pixels of each buffer
+ * @param[in] tolerance : minimum tolerance of every pixel
+ *
+ * @return number of pixels that exceeded their tolerance
+ */
+using CountDifferencesPerPixelKernel = uint32_t (*)(const uint16_t* lhs, const uint16_t* rhs, const uint16_t* tolerances,
+                                                    uint32_t num_pixels, uint32_t tolerance);
+
+/**
+ * @brief Update a per-pixel running background (exponential moving average of the mean and the variance) with a
+ *        new depth frame, writing in the same pass the rounded mean and the k-sigma tolerance of each pixel.
+ *        Pixels out of max(k_sigma * sigma, min_tolerance) are foreground: they move the mean, so static changes
+ *        are absorbed, but not the variance, so an intrusion doesn't widen its own tolerance.
+ *        Blank pixels of the frame don't update the model, pixels never measured have a negative mean and
+ *        are written as BLANK_DEPTH_PIXEL.
+ *
+ * @param[in] frame : new depth frame
+ * @param[in/out] mean : mean of each pixel
+ * @param[in/out] variance : variance of each pixel
+ * @param[out] mean_out : rounded mean of each pixel
+ * @param[out] tolerances_out : k_sigma times the standard deviation of each pixel, saturated to 16 bits
+ * @param[in] num_pixels : number of pixels of each buffer
+ * @param[in] learning_rate : weight of the new frame, between 0 and 1
+ * @param[in] k_sigma : number of standard deviations of the tolerance
+ * @param[in] min_tolerance : minimum distance from the mean of the foreground pixels
+ */
+using UpdateBackgroundKernel = void (*)(const uint16_t* frame, float* mean, float* variance, uint16_t* mean_out,
+                                        uint16_t* tolerances_out, uint32_t num_pixels, float learning_rate, float k_sigma,
+                                        float min_tolerance);
+
+/**
+ * @brief Map 10 bits pixels to 8 bits samples through a table of 1024 entries. Only the 10 low bits of each pixel
+ *        index the table.
+ *
+ * @param[in] src : 10 bits pixels
+ * @param[out] dst : 8 bits samples
+ * @param[in] num_pixels : number of pixels of each buffer
+ * @param[in] lut : sample of each 10 bits value
+ */
+using ToneMapKernel = void (*)(const uint16_t* src, uint8_t* dst, uint32_t num_pixels, const uint8_t* lut);
+
+/*******************************************************************
+ * Function declaration
+ *******************************************************************/
+/**
+ * @brief Reference implementation of CountDifferencesKernel
+ *
+ */
+uint32_t CountDifferencesScalar(const uint16_t* lhs, const uint16_t* rhs, uint32_t num_pixels, uint32_t tolerance);
+
+/**
+ * @brief Get the implementation of CountDifferencesKernel for a given variant
+ *
+ * @param[in] variant : kernel variant
+ *
+ * @return pointer to the kernel, nullptr if the variant is not supported by the build or the CPU
+ */
+CountDifferencesKernel GetCountDifferencesKernel(KernelVariant variant);
+
+/**
+ * @brief Reference implementation of CountDifferencesPerPixelKernel
+ *
+ */
+uint32_t CountDifferencesPerPixelScalar(const uint16_t* lhs, const uint16_t* rhs, const uint16_t* tolerances,
+                                        uint32_t num_pixels, uint32_t tolerance);
+
+/**
+ * @brief Get the implementation of CountDifferencesPerPixelKernel for a given variant
+ *
+ * @return pointer to the kernel, nullptr if the variant is not supported by the build or the CPU
+ */
+CountDifferencesPerPixelKernel GetCountDifferencesPerPixelKernel(KernelVariant variant);
+
+/**
+ * @brief Reference implementation of UpdateBackgroundKernel
+ *
+ */
+void UpdateBackgroundScalar(const uint16_t* frame, float* mean, float* variance, uint16_t* mean_out,
+                            uint16_t* tolerances_out, uint32_t num_pixels, float learning_rate, float k_sigma,
+                            float min_tolerance);
+
+/**
+ * @brief Get the implementation of UpdateBackgroundKernel for a given variant
+ *
+ * @return pointer to the kernel, nullptr if the variant is not supported by the build or the CPU
+ */
+UpdateBackgroundKernel GetUpdateBackgroundKernel(KernelVariant variant);
+
+/**
+ * @brief Reference implementation of ToneMapKernel
+ *
+ */
+void ToneMapScalar(const uint16_t* src, uint8_t* dst, uint32_t num_pixels, const uint8_t* lut);
+
+/**
+ * @brief Get the implementation of ToneMapKernel for a given variant
+ *
+ * @return pointer to the kernel, nullptr if the variant is not supported by the build or the CPU
+ */
+ToneMapKernel GetToneMapKernel(KernelVariant variant);
+
+/**
+ * @brief Get the fastest implementation of ToneMapKernel supported by the CPU, the scalar one if there is none
+ *
+ */
+ToneMapKernel GetBestToneMapKernel();
+
+/**
+ * @brief Get the fastest kernel variant supported by the CPU, detected at runtime
+ *
+ */
+KernelVariant GetBestKernelVariant();
+
+/**
+ * @brief Get the name of a kernel variant
+ *
+ */
+const char* GetKernelVariantName(KernelVariant variant);
+
+#endif /* KINECT_FRAME_KERNELS_H_ */
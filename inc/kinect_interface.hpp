@@ -11,10 +11,21 @@
 /*******************************************************************
  * Includes
  *******************************************************************/
+#include <memory>
+#include <functional>
+#include <algorithm>
 #include <libfreenect/libfreenect.h>
 #include <libfreenect/libfreenect_sync.h>
 
 #include "kinect_frame.hpp"
+#include "frame_exchange.hpp"
+#include "global_parameters.hpp"
+
+/*******************************************************************
+ * Type definitions
+ *******************************************************************/
+using DepthFrameCallback = std::function<void(std::shared_ptr<const KinectDepthFrame>)>;
+using VideoFrameCallback = std::function<void(std::shared_ptr<const KinectVideoFrame>)>;
 
 /*******************************************************************
  * Class declaration
@@ -60,18 +71,66 @@ public:
     virtual bool IsRunning() = 0;
 
     /**
-     * @brief Synchonous function to get a depth frame.
+     * @brief Synchonous function to get a depth frame. The frame is shared with the rest of consumers and
+     *        must not be modified. If the given frame is already the latest one, it waits for the next.
      * 
-     * @param[in/out] frame : reference to a frame object
+     * @param[in/out] frame : last frame obtained by the caller (can be null), replaced by the latest one
      */
-    virtual void GetDepthFrame(KinectDepthFrame& frame) = 0;
+    virtual void GetDepthFrame(std::shared_ptr<const KinectDepthFrame>& frame) = 0;
 
     /**
-     * @brief Synchonous function to get a depth frame.
+     * @brief Synchonous function to get a video frame. The frame is shared with the rest of consumers and
+     *        must not be modified. If the given frame is already the latest one, it waits for the next.
      * 
-     * @param[in/out] frame : reference to a frame object
+     * @param[in/out] frame : last frame obtained by the caller (can be null), replaced by the latest one
+     */
+    virtual void GetVideoFrame(std::shared_ptr<const KinectVideoFrame>& frame) = 0;
+
+    /**
+     * @brief Subscribe to the depth frames. The callback runs in a thread of the subscription that only wakes up
+     *        when a frame is delivered, frames arriving while it's busy wait in a bounded queue
+     *
+     * @param[in] callback : called with each delivered frame, shared with the rest of consumers
+     * @param[in] decimation : one of each decimation frames is delivered
+     * @param[in] queue_config : size of the queue and frame dropped when it's full
+     *
+     * @return subscription identifier, -1 on error
+     */
+    virtual int SubscribeDepthFrames(DepthFrameCallback callback, uint32_t decimation, FrameQueueConfig queue_config) = 0;
+
+    /**
+     * @brief Subscribe to the video frames, see SubscribeDepthFrames
+     *
+     * @return subscription identifier, -1 on error
+     */
+    virtual int SubscribeVideoFrames(VideoFrameCallback callback, uint32_t decimation, FrameQueueConfig queue_config) = 0;
+
+    /**
+     * @brief Change the decimation of a subscription
+     *
+     * @return 0 on success
      */
-    virtual void GetVideoFrame(KinectVideoFrame& frame) = 0;
+    virtual int ChangeDecimation(int subscription, uint32_t decimation) = 0;
+
+    /**
+     * @brief Cancel a subscription, waits for the callback in progress so it must not be called from its callback
+     *
+     * @return 0 on success
+     */
+    virtual int Unsubscribe(int subscription) = 0;
+
+    /**
+     * @brief Get the counters of the depth stream: frames captured, delivered to and dropped by the subscriptions
+     *        and the capture to consumption latency since the previous call
+     *
+     */
+    virtual FrameStreamStats GetDepthFrameStats() = 0;
+
+    /**
+     * @brief Get the counters of the video stream, see GetDepthFrameStats
+     *
+     */
+    virtual FrameStreamStats GetVideoFrameStats() = 0;
 
     /**
      * @brief To get change kinect's tilt
@@ -91,4 +150,19 @@ public:
     virtual int ChangeLedColor(freenect_led_options color) = 0;
 };
 
+/*******************************************************************
+ * Function definition
+ *******************************************************************/
+/**
+ * @brief Decimation of the Kinect frames closest to a frame interval
+ *
+ * @param[in] interval_ms : desired interval between delivered frames
+ *
+ * @return number of captured frames per delivered frame, at least 1
+ */
+inline uint32_t FrameDecimation(uint32_t interval_ms)
+{
+    return std::max((interval_ms + KINECT_FRAME_INTERVAL_MS / 2) / KINECT_FRAME_INTERVAL_MS, 1U);
+}
+
 #endif /* IKINECT_H_ */
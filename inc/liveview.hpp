@@ -11,21 +11,34 @@
 /*******************************************************************
  * Includes
  *******************************************************************/
+#include <atomic>
 #include <memory>
+#include <mutex>
 
 #include "common.hpp"
 #include "global_parameters.hpp"
 #include "log.hpp"
 #include "kinect_interface.hpp"
-#include "cyclic_task.hpp"
 #include "alarm_module_interface.hpp"
 
+/*******************************************************************
+ * Type definitions
+ *******************************************************************/
+/* Frames streamed by the liveview */
+enum class LiveviewMode
+{
+    Video,
+    Depth,
+    SideBySide
+};
+
 /*******************************************************************
  * Struct declaration
  *******************************************************************/
 struct LiveviewConfig : AlarmModuleConfig
 {
     uint32_t video_frame_interval_ms;
+    LiveviewMode mode = LiveviewMode::Video;
 
     LiveviewConfig()
     {
@@ -35,6 +48,12 @@ struct LiveviewConfig : AlarmModuleConfig
         video_frame_interval_ms(_video_frame_interval_ms)
     {
     }
+
+    LiveviewConfig(uint32_t _video_frame_interval_ms, LiveviewMode _mode) :
+        video_frame_interval_ms(_video_frame_interval_ms),
+        mode(_mode)
+    {
+    }
 };
 
 /*******************************************************************
@@ -43,10 +62,14 @@ struct LiveviewConfig : AlarmModuleConfig
 class LiveviewObserver
 {
 public:
-    virtual void NewFrame(KinectVideoFrame& frame) = 0;
+    virtual void NewFrame(const KinectVideoFrame& frame) = 0;
+
+    virtual void NewDepthFrame(const KinectDepthFrame& frame) = 0;
+
+    virtual void NewSideBySideFrame(const KinectDepthFrame& depth_frame, const KinectVideoFrame& video_frame) = 0;
 };
 
-class Liveview : public IAlarmModule, public CyclicTask
+class Liveview : public IAlarmModule
 {
 public:
     /**
@@ -69,13 +92,34 @@ public:
 
     void UpdateConfig(AlarmModuleConfig& config) override;
 
-    void ExecutionCycle() override;
-
 private:
     LiveviewConfig m_liveview_config;
+    /* Mode of the running subscriptions, the callbacks read it while the configuration may be replaced */
+    std::atomic<LiveviewMode> m_mode;
     std::shared_ptr<IKinect> m_kinect;
-    std::shared_ptr<KinectVideoFrame> m_frame;
     std::shared_ptr<LiveviewObserver> m_liveview_observer;
+    int m_subscription;
+    int m_depth_subscription;
+    std::shared_ptr<const KinectDepthFrame> m_last_depth_frame;
+    std::mutex m_depth_frame_mutex;
+
+    /**
+     * @brief Subscribe to the streams of the configured mode
+     *
+     */
+    int Subscribe();
+
+    /**
+     * @brief Called by the Kinect video subscription with each delivered frame
+     *
+     */
+    void NewVideoFrame(std::shared_ptr<const KinectVideoFrame> frame);
+
+    /**
+     * @brief Called by the Kinect depth subscription with each delivered frame
+     *
+     */
+    void NewDepthFrame(std::shared_ptr<const KinectDepthFrame> frame);
 };
 
 #endif /* LIVEVIEW_H_ */
\ No newline at end of file
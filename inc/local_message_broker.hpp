@@ -0,0 +1,102 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file local_message_broker.hpp
+ *
+ */
+
+#ifndef LOCAL_MESSAGE_BROKER__H_
+#define LOCAL_MESSAGE_BROKER__H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "message_broker_interface.hpp"
+#include "outbound_queue.hpp"
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+/**
+ * @brief Message broker kept in the process, for single host deployments and benchmarks without a Redis server.
+ *        The variables are stored in memory and set at once, the messages go through the same lanes as the ones
+ *        sent to Redis and a delivery thread calls the observers, so a slow observer doesn't block the publisher.
+ *        The observers of each channel are a snapshot replaced on every (un)subscription, the delivery thread calls
+ *        them without holding any lock and they may (un)subscribe from the callback.
+ */
+class LocalMessageBroker : public IMessageBroker
+{
+public:
+    LocalMessageBroker();
+
+    ~LocalMessageBroker();
+
+    int Subscribe(const std::string& channel, const std::shared_ptr<IChannelMessageObserver> observer) override;
+
+    int Unsubscribe(const std::string& channel, const std::shared_ptr<IChannelMessageObserver> observer) override;
+
+    int Publish(const std::string& channel, const std::string& message) override;
+
+    int PublishBinary(const std::string& channel, const uint8_t* data, size_t size) override;
+
+    int GetVariable(Variable& variable) override;
+
+    int SetVariable(const Variable& variable) override;
+
+    int SetVariableExpiration(const Variable& variable, int livetime_seconds) override;
+
+    int SetVariables(const std::vector<Variable>& variables) override;
+
+    int SetVariablesAndPublish(const std::vector<Variable>& variables, const std::string& channel, const std::string& message) override;
+
+    int Clear() override;
+
+    /**
+     * @brief Wait until the published messages have been delivered
+     *
+     * @return 0 if ok, -1 on timeout
+     */
+    int Flush(uint32_t timeout_ms);
+
+    /**
+     * @brief Get the statistics of the published messages of each channel
+     *
+     */
+    std::vector<OutboundChannelStats> GetOutboundStats() const;
+
+private:
+    using Observers = std::vector<std::shared_ptr<IChannelMessageObserver>>;
+    using ObserverMap = std::map<std::string, Observers>;
+
+    struct StoredVariable
+    {
+        std::string value;
+        /* Never expires if not set */
+        bool expires;
+        std::chrono::steady_clock::time_point expiration;
+    };
+
+    std::map<std::string, StoredVariable> m_variables;
+    std::shared_mutex m_variables_mutex;
+    /* Read by the delivery thread with std::atomic_load, the mutex only serialises the (un)subscriptions */
+    std::shared_ptr<const ObserverMap> m_observer_map;
+    std::mutex m_observer_mutex;
+    OutboundQueue m_outbound_queue;
+    std::unique_ptr<std::thread> m_delivery_thread;
+
+    void ProccessDelivery();
+    void Deliver(const OutboundCommand& command);
+    int QueueMessage(const std::string& channel, std::string message);
+    int StoreVariables(const std::vector<Variable>& variables, int livetime_seconds);
+};
+
+#endif /* LOCAL_MESSAGE_BROKER__H_ */
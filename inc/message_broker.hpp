@@ -17,12 +17,14 @@
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <chrono>
 
 #include <hiredis/hiredis.h>
 #include <hiredis/async.h>
 #include <hiredis/adapters/libevent.h>
 
 #include "message_broker_interface.hpp"
+#include "outbound_queue.hpp"
 #include "log.hpp"
 
 /*******************************************************************
@@ -52,17 +54,41 @@ public:
 
     int Publish(const std::string& channel, const std::string& message) override;
 
+    int PublishBinary(const std::string& channel, const uint8_t* data, size_t size) override;
+
     int GetVariable(Variable& variable) override;
 
     int SetVariable(const Variable& variable) override;
 
     int SetVariableExpiration(const Variable& variable, int livetime_seconds) override;
 
+    int SetVariables(const std::vector<Variable>& variables) override;
+
+    int SetVariablesAndPublish(const std::vector<Variable>& variables, const std::string& channel, const std::string& message) override;
+
     int Clear() override;
 
     int CallObservers(const std::string& channel, const std::string& message);
+
+    /**
+     * @brief Wait until the queued commands have been sent
+     *
+     * @return 0 if ok, -1 on timeout
+     */
+    int Flush(uint32_t timeout_ms);
+
+    /**
+     * @brief Get the statistics of the queued commands of each channel
+     *
+     */
+    std::vector<OutboundChannelStats> GetOutboundStats() const;
 private:
     redisContext *m_context = nullptr;
+    /* Publish and Set* are queued and sent pipelined by the outbound thread through their own context */
+    redisContext *m_outbound_context = nullptr;
+    OutboundQueue m_outbound_queue;
+    std::unique_ptr<std::thread> m_outbound_thread;
+    std::chrono::steady_clock::time_point m_last_stats_report;
     redisAsyncContext *m_async_context = nullptr;
     event_base *m_event_base = nullptr;
     std::mutex m_context_mutex;
@@ -70,6 +96,12 @@ private:
     std::map<std::string, std::vector<std::shared_ptr<IChannelMessageObserver>>> m_observer_map;
 
     void ProccessAsyncEvents();
+    void ProccessOutbound();
+    void SendOutbound(std::vector<OutboundCommand>& batch);
+    void ReportOutboundStats();
+    int QueueCommands(const std::string& channel, std::vector<std::vector<std::string>> commands, OutboundPriority priority, bool coalesce);
+    int AppendOutbound(const std::vector<std::string>& args);
+    int ReadOutboundReplies(const OutboundCommand& command, bool& success);
     int RegisterObserver(const std::string& channel, std::shared_ptr<IChannelMessageObserver> observer);
     int UnRegisterObserver(const std::string& channel, std::shared_ptr<IChannelMessageObserver> observer);
 };
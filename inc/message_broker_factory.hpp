@@ -15,13 +15,31 @@
 
 #include "message_broker_interface.hpp"
 
+/*******************************************************************
+ * Enumerations
+ *******************************************************************/
+enum class MessageBrokerType
+{
+    /* Redis server reached through its unix socket */
+    Redis,
+    /* Kept in the process, no server needed */
+    Local
+};
+
 /*******************************************************************
  * Class declaration
  *******************************************************************/
 class MessageBrokerFactory
 {
 public:
-    static std::shared_ptr<IMessageBroker> Create(std::string path);
+    /**
+     * @brief Create a message broker
+     *
+     * @param[in] path : unix socket of the Redis server, not used by the local broker
+     * @param[in] type : backend of the broker
+     *
+     */
+    static std::shared_ptr<IMessageBroker> Create(std::string path, MessageBrokerType type = MessageBrokerType::Redis);
 };
 
 #endif /* MESSAGE_BROKER_FACTORY__H_ */
\ No newline at end of file
@@ -11,8 +11,11 @@
 /*******************************************************************
  * Includes
  *******************************************************************/
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 #include "data_definition.hpp"
 
 /*******************************************************************
@@ -50,6 +53,13 @@ public:
      */
     virtual int Publish(const std::string& channel, const std::string& message) = 0;
 
+    /**
+     * @brief Publish a binary message, sent as it is without any copy or encoding
+     * 
+     * @return 0 if ok
+     */
+    virtual int PublishBinary(const std::string& channel, const uint8_t* data, size_t size) = 0;
+
     /**
      * @brief GetVariable
      * 
@@ -71,6 +81,21 @@ public:
      */
     virtual int SetVariableExpiration(const Variable& variable, int livetime_seconds) = 0;
 
+    /**
+     * @brief Set several variables in a single command, a pending write of the same variables is replaced
+     * 
+     * @return 0 if ok
+     */
+    virtual int SetVariables(const std::vector<Variable>& variables) = 0;
+
+    /**
+     * @brief Set several variables and publish a message, in a single transaction so the subscribers read the new
+     *        values
+     * 
+     * @return 0 if ok
+     */
+    virtual int SetVariablesAndPublish(const std::vector<Variable>& variables, const std::string& channel, const std::string& message) = 0;
+
     /**
      * @brief Clear DB
      * 
@@ -0,0 +1,156 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file outbound_queue.hpp
+ *
+ */
+
+#ifndef OUTBOUND_QUEUE_H_
+#define OUTBOUND_QUEUE_H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*******************************************************************
+ * Enumerations
+ *******************************************************************/
+/* Lanes of the queue, the commands of a lane are sent before the ones of the next */
+enum class OutboundPriority
+{
+    Alarm,
+    Watchdog,
+    State,
+    Liveview
+};
+
+#define OUTBOUND_PRIORITIES 4U
+
+/*******************************************************************
+ * Type definition
+ *******************************************************************/
+struct OutboundCommand
+{
+    /* Channel or variable the command writes to, the statistics are kept per channel */
+    std::string channel;
+    /* Commands and their arguments, e.g. {{"PUBLISH", channel, message}}, sent in a MULTI/EXEC transaction when
+       there are several */
+    std::vector<std::vector<std::string>> commands;
+    OutboundPriority priority;
+    /* Replaces the command of the same channel queued after the last command of its lane that doesn't coalesce,
+       only the latest value is sent */
+    bool coalesce;
+    std::chrono::steady_clock::time_point queued_time;
+};
+
+struct OutboundChannelStats
+{
+    std::string channel;
+    /* Commands waiting to be sent */
+    uint32_t depth;
+    uint64_t sent;
+    /* Sent but failed */
+    uint64_t failed;
+    /* Not queued or evicted, the queue was full */
+    uint64_t dropped;
+    /* Replaced by a newer value before being sent */
+    uint64_t coalesced;
+    /* From being queued until the reply */
+    double average_latency_ms;
+    double max_latency_ms;
+};
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+/**
+ * @brief Queue of commands to send to the message broker. The callers push the commands and return, a sender thread
+ *        pops them in batches, pipelines them and reports the result of each one. Each priority has its own lane,
+ *        sent in the order the commands were pushed, and the higher lanes go first. When the queue is full the
+ *        oldest command of a lower lane is evicted to make room, so a slow broker drops stale frames instead of
+ *        alarm events.
+ */
+class OutboundQueue
+{
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param[in] max_size : commands waiting to be sent in all the lanes
+     */
+    OutboundQueue(uint32_t max_size);
+
+    /**
+     * @brief Queue a command
+     *
+     * @return 0 if ok (queued or coalesced), -1 if the queue is full of commands of the same or higher priority or
+     *         closed
+     */
+    int Push(OutboundCommand command);
+
+    /**
+     * @brief Take the oldest commands of the highest lanes, waiting for them if there are none
+     *
+     * @param[out] batch : commands to send
+     * @param[in] max_commands : maximum size of the batch
+     * @param[in] timeout_ms : time to wait for commands
+     *
+     * @return 0 if ok (the batch may be empty on timeout), -1 if the queue is closed and empty
+     */
+    int PopBatch(std::vector<OutboundCommand>& batch, uint32_t max_commands, uint32_t timeout_ms);
+
+    /**
+     * @brief Report the result of a command taken by PopBatch
+     *
+     */
+    void Complete(const OutboundCommand& command, bool success);
+
+    /**
+     * @brief Wait until every command has been sent and completed
+     *
+     * @return true if the queue is empty
+     */
+    bool WaitEmpty(uint32_t timeout_ms);
+
+    /**
+     * @brief Don't accept more commands and wake up the sender once the queue is empty
+     *
+     */
+    void Close();
+
+    /**
+     * @brief Get the statistics of each channel
+     *
+     */
+    std::vector<OutboundChannelStats> GetStats() const;
+
+private:
+    struct Stats
+    {
+        OutboundChannelStats stats;
+        double total_latency_ms;
+    };
+
+    uint32_t m_max_size;
+    std::array<std::deque<OutboundCommand>, OUTBOUND_PRIORITIES> m_lanes;
+    uint32_t m_size;
+    uint32_t m_in_flight;
+    bool m_closed;
+    std::map<std::string, Stats> m_stats;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition_variable;
+    std::condition_variable m_empty_condition_variable;
+
+    Stats& GetChannelStats(const std::string& channel);
+};
+
+#endif /* OUTBOUND_QUEUE_H_ */
@@ -0,0 +1,118 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file roi_mask.hpp
+ *
+ */
+
+#ifndef ROI_MASK_H_
+#define ROI_MASK_H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*******************************************************************
+ * Struct declaration
+ *******************************************************************/
+struct RoiPoint
+{
+    int32_t x;
+    int32_t y;
+};
+
+/* Pixels [begin, end) of a row that are inside the region */
+struct RoiSpan
+{
+    uint16_t row;
+    uint16_t begin;
+    uint16_t end;
+};
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+/**
+ * @brief Region of interest of a frame stored as horizontal runs of pixels, sorted by row. Rows outside the
+ *        region have no spans, so walking the spans only touches the pixels inside the region.
+ */
+class RoiMask
+{
+public:
+    /**
+     * @brief Construct an empty mask
+     *
+     * @param[in] width : pixel width of the frame
+     * @param[in] height : pixel height of the frame
+     */
+    RoiMask(uint32_t width, uint32_t height);
+
+    /**
+     * @brief Create a mask covering the whole frame
+     *
+     */
+    static RoiMask FromFullFrame(uint32_t width, uint32_t height);
+
+    /**
+     * @brief Create a mask from a bitmap, pixels with a non zero value are inside the region
+     *
+     * @param[in] bitmap : width * height values, row major
+     */
+    static RoiMask FromBitmap(uint32_t width, uint32_t height, const std::vector<uint8_t>& bitmap);
+
+    /**
+     * @brief Create a mask from a polygon (even-odd rule). A pixel is inside when its center is inside the polygon,
+     *        vertices out of the frame are clipped.
+     *
+     * @param[in] polygon : polygon vertices in pixel coordinates, at least 3
+     */
+    static RoiMask FromPolygon(uint32_t width, uint32_t height, const std::vector<RoiPoint>& polygon);
+
+    /**
+     * @brief Create the mask of a downsampled level of the frame, a pixel of the level is inside when any of the
+     *        pixels it covers is inside this mask
+     *
+     * @param[in] level : each level halves the width and height
+     */
+    RoiMask Downsample(uint32_t level) const;
+
+    const std::vector<RoiSpan>& GetSpans() const;
+
+    uint32_t GetWidth() const;
+
+    uint32_t GetHeight() const;
+
+    /**
+     * @brief Get the number of pixels inside the region
+     *
+     */
+    uint32_t GetNumPixels() const;
+
+private:
+    uint32_t m_width;
+    uint32_t m_height;
+    std::vector<RoiSpan> m_spans;
+
+    void AddSpan(uint32_t row, uint32_t begin, uint32_t end);
+};
+
+/*******************************************************************
+ * Function declaration
+ *******************************************************************/
+/**
+ * @brief Serialize a polygon as "x1 y1 x2 y2 ..."
+ *
+ */
+std::string RoiPolygonToString(const std::vector<RoiPoint>& polygon);
+
+/**
+ * @brief Parse a polygon serialized with RoiPolygonToString
+ *
+ * @return 0 if ok
+ */
+int RoiPolygonFromString(const std::string& string_value, std::vector<RoiPoint>& polygon);
+
+#endif /* ROI_MASK_H_ */
@@ -0,0 +1,224 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file shm_frame_ring.hpp
+ *
+ */
+
+#ifndef SHM_FRAME_RING_H_
+#define SHM_FRAME_RING_H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*******************************************************************
+ * Defines
+ *******************************************************************/
+#define SHM_FRAME_RING_MAGIC   0x4B414C56U /* "KALV" */
+#define SHM_FRAME_RING_VERSION 1U
+
+/*******************************************************************
+ * Enumerations
+ *******************************************************************/
+enum class ShmFrameFormat : uint32_t
+{
+    Jpeg,
+    /* 8 bits per channel RGB */
+    Rgb
+};
+
+/*******************************************************************
+ * Type definition
+ *******************************************************************/
+/* Layout of the shared memory: the header followed by slot_count slots of slot_size bytes, each one a ShmFrameSlot
+   followed by the frame. Shared by processes, only address-free atomics */
+struct ShmFrameRingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    /* Size of a slot including its header, multiple of 64 */
+    uint32_t slot_size;
+    /* Frames written so far, frame n is in slot n % slot_count */
+    std::atomic<uint64_t> frames;
+    /* Futex the readers wait on, changes with every frame */
+    std::atomic<uint32_t> notify;
+};
+
+struct alignas(64) ShmFrameSlot
+{
+    /* Seqlock: 2n + 1 while frame n is written, 2n + 2 once it is complete */
+    std::atomic<uint64_t> sequence;
+    uint64_t timestamp_us;
+    uint32_t size;
+    ShmFrameFormat format;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "The shared memory needs lock free atomics");
+
+/* Frame read in place from the shared memory */
+struct ShmFrame
+{
+    uint64_t number;
+    uint64_t timestamp_us;
+    ShmFrameFormat format;
+    const uint8_t* data;
+    uint32_t size;
+};
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+/**
+ * @brief Ring of frames in POSIX shared memory, for the consumers in the same host. The writer never waits for the
+ *        readers: each slot is guarded by a seqlock, a reader uses the frame in place and then checks it wasn't
+ *        overwritten meanwhile, retrying or copying if it is too slow for the writer. The readers wait for new
+ *        frames on a futex in the header.
+ */
+class ShmFrameRing
+{
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param[in] name : name of the shared memory object, e.g. "/kinectalarm_liveview"
+     * @param[in] slot_count : frames kept
+     * @param[in] max_frame_size : largest frame that fits in a slot
+     */
+    ShmFrameRing(const std::string& name, uint32_t slot_count, uint32_t max_frame_size);
+
+    /**
+     * @brief Destructor, closes and removes the shared memory
+     *
+     */
+    ~ShmFrameRing();
+
+    ShmFrameRing(const ShmFrameRing&) = delete;
+    ShmFrameRing& operator=(const ShmFrameRing&) = delete;
+
+    /**
+     * @brief Create the shared memory, replacing the one left by a writer that is gone
+     *
+     * @return 0 on success, -1 on error or if another writer has it
+     */
+    int Open();
+
+    /**
+     * @brief Close and remove the shared memory, the readers that have it mapped keep the last frames
+     *
+     */
+    void Close();
+
+    /**
+     * @brief Write a frame and wake up the waiting readers
+     *
+     * @return 0 on success, -1 if not open or the frame doesn't fit in a slot
+     */
+    int Write(const uint8_t* data, size_t size, ShmFrameFormat format);
+
+    /**
+     * @brief Check if the shared memory is created
+     *
+     */
+    bool IsOpen() const;
+
+    /**
+     * @brief Get the name of the shared memory object
+     *
+     */
+    const std::string& GetName() const;
+
+    /**
+     * @brief Get the number of frames written
+     *
+     */
+    uint64_t GetFrames() const;
+
+private:
+    std::string m_name;
+    uint32_t m_slot_count;
+    uint32_t m_slot_size;
+    size_t m_size;
+    /* Locked while open, so a ring left by a crash can be told from one in use */
+    int m_fd;
+    ShmFrameRingHeader* m_header;
+};
+
+/**
+ * @brief Reader of a ShmFrameRing, from the same or another process
+ */
+class ShmFrameRingReader
+{
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param[in] name : name of the shared memory object, announced by the writer
+     */
+    ShmFrameRingReader(const std::string& name);
+
+    /**
+     * @brief Destructor, unmaps the shared memory
+     *
+     */
+    ~ShmFrameRingReader();
+
+    ShmFrameRingReader(const ShmFrameRingReader&) = delete;
+    ShmFrameRingReader& operator=(const ShmFrameRingReader&) = delete;
+
+    /**
+     * @brief Map the shared memory read only
+     *
+     * @return 0 on success, -1 if it doesn't exist or is not a frame ring
+     */
+    int Open();
+
+    /**
+     * @brief Wait until there are more frames than the given ones
+     *
+     * @param[in] frames : frames already seen, e.g. the number of the last one read plus one
+     * @param[in] timeout_ms : time to wait
+     *
+     * @return 0 if there are new frames, -1 on timeout
+     */
+    int WaitFrame(uint64_t frames, uint32_t timeout_ms);
+
+    /**
+     * @brief Get the newest frame in place, it must be checked with IsValid once used
+     *
+     * @return 0 on success, -1 if there are no frames yet or the writer is on it
+     */
+    int GetLatest(ShmFrame& frame) const;
+
+    /**
+     * @brief Check that the frame hasn't been overwritten since it was got
+     *
+     */
+    bool IsValid(const ShmFrame& frame) const;
+
+    /**
+     * @brief Copy the newest frame, retrying if the writer overwrites it meanwhile
+     *
+     * @param[out] frame : frame, its data points to the buffer
+     * @param[out] buffer : copy of the frame
+     *
+     * @return 0 on success, -1 if there are no frames yet or the writer kept overwriting it
+     */
+    int CopyLatest(ShmFrame& frame, std::vector<uint8_t>& buffer) const;
+
+private:
+    std::string m_name;
+    size_t m_size;
+    const ShmFrameRingHeader* m_header;
+
+    const ShmFrameSlot* GetSlot(uint64_t number) const;
+};
+
+#endif /* SHM_FRAME_RING_H_ */
@@ -30,6 +30,7 @@ public:
     int NumberItems(int& number_items);
     int InsertItem(const Entry& item);
     int GetItem(Entry& item);
+    int GetAllItems(std::vector<Entry>& items);
     int SetItem(const Entry& item);
     int DeleteItem(const Entry& item);
     int DeleteAllItems();
@@ -49,12 +50,14 @@ private:
     int FormNumberItemsMessage(std::string& command);
     int FormInsertItemMessage(std::string& command, const Entry& item);
     int FormGetItemMessage(std::string& command, const Entry& item);
+    int FormGetAllItemsMessage(std::string& command);
     int FormSetItemMessage(std::string& command, const Entry& item);
     int FormDeleteItemMessage(std::string& command, const Entry& item);
     int FormDeleteAllItemsMessage(std::string& command);
 
     int HandleNumberItemsResponse(sqlite3_stmt **response, int& number_items);
     int HandleGetItemResponse(sqlite3_stmt **response, Entry& item);
+    int HandleGetAllItemsResponse(sqlite3_stmt **response, std::vector<Entry>& items);
 
     std::string VariableToString(const Variable& variable);
     int StringToVariable(const std::string& string_value, Variable& variable);
@@ -13,6 +13,7 @@
  *******************************************************************/
 #include <string>
 #include <memory>
+#include <vector>
 #include "data_definition.hpp"
 
 /*******************************************************************
@@ -30,6 +31,7 @@ public:
     virtual int NumberItems(int& number_items) = 0;
     virtual int InsertItem(const Entry& item) = 0;
     virtual int GetItem(Entry& item) = 0;
+    virtual int GetAllItems(std::vector<Entry>& items) = 0;
     virtual int SetItem(const Entry& item) = 0;
     virtual int DeleteItem(const Entry& item) = 0;
     virtual int DeleteAllItems() = 0;
@@ -0,0 +1,294 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file task_graph.hpp
+ *
+ */
+
+#ifndef TASK_GRAPH__H_
+#define TASK_GRAPH__H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "log.hpp"
+#include "threadpool.hpp"
+
+/*******************************************************************
+ * Type definition
+ *******************************************************************/
+struct StageTiming
+{
+    std::string stage;
+    uint32_t nodes;
+    /* Sum of the run time of the nodes */
+    double busy_ms;
+    /* Longest node */
+    double max_ms;
+    /* From the start of the first node to the end of the last one */
+    double elapsed_ms;
+};
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+/**
+ * @brief Graph of tasks run on a ThreadPool. Each node belongs to a stage and is queued once its inputs have run, so
+ *        nodes can be added while the earlier ones are already running and no worker waits for another. Finish adds
+ *        a last node that depends on all the others and reports the timing of each stage, in the order the stages
+ *        were first used.
+ *
+ *        The nodes only share the timings with the graph, so it can be destroyed once finished while its nodes are
+ *        still pending.
+ */
+class TaskGraph
+{
+    public:
+        using Node = std::shared_ptr<Task>;
+        using Report = std::function<void(const std::vector<StageTiming>& timings, double total_ms)>;
+        using Trigger = std::function<void()>;
+
+        TaskGraph(ThreadPool& pool, std::string name) :
+            m_pool(pool), m_name(name), m_timings(std::make_shared<Timings>())
+        {
+        }
+
+        TaskGraph(const TaskGraph&) = delete;
+        TaskGraph& operator=(const TaskGraph&) = delete;
+
+        /**
+         * @brief Add a node
+         *
+         * @param[in] stage : stage the node is accounted to
+         * @param[in] function : work of the node, released once it has run
+         * @param[in] inputs : nodes of this graph that must run before
+         * @param[in] priority : priority of the node once it is ready
+         *
+         * @return the node, nullptr if the graph is already finished
+         */
+        Node AddNode(const std::string& stage, std::function<void()> function, const std::vector<Node>& inputs = {},
+                     TaskPriority priority = TaskPriority::Normal)
+        {
+            if(m_finished)
+            {
+                LOG(LOG_ERR, "Error adding %s to the finished graph %s\n", stage.c_str(), m_name.c_str());
+                return nullptr;
+            }
+
+            Node node = std::make_shared<GraphTask>(stage, priority, std::move(function), m_timings, m_timings->GetStage(stage));
+
+            m_nodes.push_back(node);
+            m_pool.WhenAll(inputs, node);
+
+            return node;
+        }
+
+        /**
+         * @brief Add a node completed by something outside the pool, e.g. the callback of another thread. The nodes
+         *        that depend on it run once the trigger is called, the trigger can outlive the graph but not the pool
+         *
+         * @param[in] stage : stage the node is accounted to
+         * @param[out] trigger : completes the node, to be called once
+         *
+         * @return the node, nullptr if the graph is already finished
+         */
+        Node AddEvent(const std::string& stage, Trigger& trigger)
+        {
+            if(m_finished)
+            {
+                LOG(LOG_ERR, "Error adding %s to the finished graph %s\n", stage.c_str(), m_name.c_str());
+                return nullptr;
+            }
+
+            /* Accounted from the time it is added until it is triggered */
+            std::chrono::steady_clock::time_point added = std::chrono::steady_clock::now();
+            std::shared_ptr<Timings> timings = m_timings;
+            size_t stage_index = m_timings->GetStage(stage);
+            Node node = std::make_shared<GraphTask>(stage, TaskPriority::High, [timings, stage_index, added]
+            {
+                timings->Record(stage_index, added, std::chrono::steady_clock::now());
+            }, nullptr, 0);
+            ThreadPool& pool = m_pool;
+
+            m_nodes.push_back(node);
+            trigger = [&pool, node]{ pool.QueueTask(node); };
+
+            return node;
+        }
+
+        /**
+         * @brief Get the nodes of a stage added so far
+         *
+         */
+        std::vector<Node> GetNodes(const std::string& stage) const
+        {
+            std::vector<Node> nodes;
+
+            std::copy_if(m_nodes.begin(), m_nodes.end(), std::back_inserter(nodes),
+                         [&stage](const Node& node){ return node->GetName() == stage; });
+
+            return nodes;
+        }
+
+        /**
+         * @brief No more nodes are added, report the timings once all of them have run
+         *
+         * @param[in] report : called with the timings, they are logged if not given
+         *
+         * @return 0 if ok, -1 if already finished
+         */
+        int Finish(Report report = nullptr)
+        {
+            if(m_finished)
+            {
+                return -1;
+            }
+            m_finished = true;
+
+            std::shared_ptr<Timings> timings = m_timings;
+            std::string name = m_name;
+
+            if(!report)
+            {
+                report = [name](const std::vector<StageTiming>& stage_timings, double total_ms)
+                {
+                    for(const StageTiming& timing : stage_timings)
+                    {
+                        LOG(LOG_INFO, "%s: %s: %u tasks, %.1f ms busy, %.1f ms max, %.1f ms elapsed\n", name.c_str(),
+                            timing.stage.c_str(), timing.nodes, timing.busy_ms, timing.max_ms, timing.elapsed_ms);
+                    }
+                    LOG(LOG_INFO, "%s: finished in %.1f ms\n", name.c_str(), total_ms);
+                };
+            }
+
+            Node last = std::make_shared<GraphTask>("report", TaskPriority::Normal, [timings, report]
+            {
+                report(timings->Get(), timings->GetTotalMs());
+            }, nullptr, 0);
+
+            m_pool.WhenAll(m_nodes, last);
+            m_nodes.clear();
+
+            return 0;
+        }
+
+    private:
+        class Timings
+        {
+            public:
+                Timings() : m_created(std::chrono::steady_clock::now())
+                {
+                }
+
+                size_t GetStage(const std::string& stage)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+
+                    for(size_t i = 0; i < m_stages.size(); i++)
+                    {
+                        if(m_stages[i].timing.stage == stage)
+                        {
+                            return i;
+                        }
+                    }
+                    m_stages.push_back({{stage, 0, 0.0, 0.0, 0.0}, {}, {}});
+
+                    return m_stages.size() - 1;
+                }
+
+                void Record(size_t index, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    Stage& stage = m_stages[index];
+                    double duration_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+                    if(stage.timing.nodes == 0 || start < stage.first_start)
+                    {
+                        stage.first_start = start;
+                    }
+                    if(stage.timing.nodes == 0 || end > stage.last_end)
+                    {
+                        stage.last_end = end;
+                    }
+                    stage.timing.nodes++;
+                    stage.timing.busy_ms += duration_ms;
+                    stage.timing.max_ms = std::max(stage.timing.max_ms, duration_ms);
+                    stage.timing.elapsed_ms = std::chrono::duration<double, std::milli>(stage.last_end - stage.first_start).count();
+                }
+
+                std::vector<StageTiming> Get()
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    std::vector<StageTiming> timings;
+
+                    for(const Stage& stage : m_stages)
+                    {
+                        timings.push_back(stage.timing);
+                    }
+
+                    return timings;
+                }
+
+                double GetTotalMs() const
+                {
+                    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_created).count();
+                }
+
+            private:
+                struct Stage
+                {
+                    StageTiming timing;
+                    std::chrono::steady_clock::time_point first_start;
+                    std::chrono::steady_clock::time_point last_end;
+                };
+
+                std::mutex m_mutex;
+                std::vector<Stage> m_stages;
+                std::chrono::steady_clock::time_point m_created;
+        };
+
+        class GraphTask : public Task
+        {
+            public:
+                GraphTask(const std::string& stage, TaskPriority priority, std::function<void()> function,
+                          std::shared_ptr<Timings> timings, size_t stage_index) :
+                    Task(stage, priority), m_function(std::move(function)), m_timings(timings), m_stage_index(stage_index)
+                {
+                }
+
+                void operator() () override
+                {
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+                    m_function();
+                    /* Release what the function holds, the node is kept until the graph finishes */
+                    m_function = nullptr;
+
+                    if(m_timings)
+                    {
+                        m_timings->Record(m_stage_index, start, std::chrono::steady_clock::now());
+                    }
+                }
+
+            private:
+                std::function<void()> m_function;
+                std::shared_ptr<Timings> m_timings;
+                size_t m_stage_index;
+        };
+
+        ThreadPool& m_pool;
+        std::string m_name;
+        std::shared_ptr<Timings> m_timings;
+        std::vector<Node> m_nodes;
+        bool m_finished = false;
+};
+
+#endif /* TASK_GRAPH__H_ */
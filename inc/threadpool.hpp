@@ -14,54 +14,87 @@
 #include <iostream>
 #include <thread>
 #include <array>
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
-#include <queue>
+#include <deque>
+#include <functional>
+#include <future>
+#include <vector>
 
 #include "log.hpp"
 
+/*******************************************************************
+ * Enumerations
+ *******************************************************************/
+/* The tasks of higher priority are taken first, from any worker */
+enum class TaskPriority
+{
+    High,
+    Normal
+};
+
+#define THREADPOOL_PRIORITIES 2U
+
 /*******************************************************************
  * Class declaration
  *******************************************************************/
+class ThreadPool;
+
 class Task
 {
-    public:
-        std::string m_name;
-        std::mutex m_mutex;
-        std::condition_variable m_condition_variable;
-        bool m_ended = false;
+    friend ThreadPool;
 
     public:
-        Task(std::string name) : m_name(name)
+        Task(std::string name, TaskPriority priority = TaskPriority::Normal) :
+            m_name(name), m_priority(priority)
+        {
+        }
+
+        virtual ~Task()
         {
         }
 
         virtual void operator() () = 0;
 
+        /**
+         * @brief Wait until the task has been executed. Must not be called from a task of the same pool, make the
+         *        waiting task depend on this one instead
+         *
+         */
         void Join()
         {
             std::unique_lock<std::mutex> lock(m_mutex);
-            if(!m_ended)
-            {
-                LOG(LOG_DEBUG, "Join on Task: %s\n", m_name.c_str());
-                m_condition_variable.wait(lock);
-            }
-            else
-            {
-                LOG(LOG_DEBUG, "Join on Task: %s, but it's ended\n", m_name.c_str());
-            }
+            m_condition_variable.wait(lock, [this]{ return m_ended; });
         }
 
-        void ExecuteTask()
+        /**
+         * @brief Wait until the task has been executed or the timeout expires
+         *
+         * @return true if the task has been executed
+         */
+        bool Join(uint32_t timeout_ms)
         {
             std::unique_lock<std::mutex> lock(m_mutex);
-            LOG(LOG_DEBUG, "Task: %s started\n", m_name.c_str());
-            operator()();
-            LOG(LOG_DEBUG, "Task: %s ended\n", m_name.c_str());
-            m_ended = true;
-            m_condition_variable.notify_one();
+            return m_condition_variable.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]{ return m_ended; });
+        }
+
+        bool IsEnded()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_ended;
+        }
+
+        const std::string& GetName() const
+        {
+            return m_name;
+        }
+
+        TaskPriority GetPriority() const
+        {
+            return m_priority;
         }
 
         friend std::ostream& operator<<(std::ostream& os, const Task& task)
@@ -69,97 +102,316 @@ class Task
             os << task.m_name;
             return os;
         }
-};
 
-template<int number_threads>
-class ThreadPool
-{
     private:
-        std::array<std::unique_ptr<std::thread>, number_threads> m_threads;
-        std::queue<std::shared_ptr<Task>> m_task_queue;
+        std::string m_name;
+        TaskPriority m_priority;
         std::mutex m_mutex;
         std::condition_variable m_condition_variable;
-        bool m_running = true;
+        bool m_ended = false;
+        /* Set once the task is handed to a pool, a task runs only once */
+        std::atomic<bool> m_scheduled{false};
+        /* Dependencies not executed yet, the task is queued when it reaches 0 */
+        std::atomic<uint32_t> m_pending_dependencies{0};
+        /* Tasks waiting for this one */
+        std::vector<std::shared_ptr<Task>> m_dependents;
+};
 
+/**
+ * @brief Task that runs a function and gives its result, or its exception, through a future
+ */
+template<class Result>
+class FunctionTask : public Task
+{
     public:
-        ThreadPool()
+        FunctionTask(std::string name, TaskPriority priority, std::function<Result()> function) :
+            Task(name, priority), m_function(std::move(function))
         {
-            LOG(LOG_INFO, "Threadpool created\n");
-            std::unique_lock<std::mutex> lock(m_mutex);
-            int thread_id = 0;
-            for(auto& thread : m_threads)
+        }
+
+        std::future<Result> GetFuture()
+        {
+            return m_function.get_future();
+        }
+
+        void operator() () override
+        {
+            m_function();
+        }
+
+    private:
+        std::packaged_task<Result()> m_function;
+};
+
+/**
+ * @brief Pool of worker threads, each with its own queue per priority. The tasks queued from outside the pool are
+ *        spread between the workers and the ones queued from a worker (i.e. the dependents of the task it just
+ *        executed) stay in its own queue. A worker takes the tasks of its queue in order and, when it runs out,
+ *        steals the newest ones of the other workers, the higher priority first. No lock is held while a task runs
+ *        or while logging.
+ *
+ *        A task can depend on others (Then, WhenAll): it's queued by the worker that executes the last of them, so
+ *        no worker is ever blocked waiting. The tasks queued before the destruction of the pool are executed.
+ */
+class ThreadPool
+{
+    public:
+        /**
+         * @brief Constructor
+         *
+         * @param[in] number_threads : number of workers, 0 for one per hardware thread
+         */
+        explicit ThreadPool(uint32_t number_threads = 0)
+        {
+            if(number_threads == 0)
+            {
+                number_threads = std::max(std::thread::hardware_concurrency(), 1U);
+            }
+
+            for(uint32_t i = 0; i < number_threads; i++)
+            {
+                m_workers.push_back(std::make_unique<Worker>());
+            }
+            for(uint32_t i = 0; i < number_threads; i++)
             {
-                thread = std::make_unique<std::thread>(&ThreadPool::ThreadLoop, this, thread_id);
-                LOG(LOG_DEBUG, "Thread: %d created\n", thread_id++);
+                m_workers[i]->thread = std::thread(&ThreadPool::ThreadLoop, this, i);
             }
+
+            LOG(LOG_INFO, "Threadpool created with %u threads\n", number_threads);
         }
 
         ~ThreadPool()
         {
             {
-                std::unique_lock<std::mutex> lock(m_mutex);
-                LOG(LOG_INFO, "Threadpool ending\n");
-
+                std::lock_guard<std::mutex> lock(m_mutex);
                 m_running = false;
-
-                m_condition_variable.notify_all();
             }
+            m_condition_variable.notify_all();
 
-            int thread_id = 0;
-            for(auto& thread : m_threads)
+            for(auto& worker : m_workers)
             {
-                thread->join();
-                LOG(LOG_DEBUG, "Thread: %d destroyed\n", thread_id++);
+                worker->thread.join();
             }
             LOG(LOG_INFO, "Threadpool destroyed\n");
         }
 
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        uint32_t GetNumberThreads() const
+        {
+            return m_workers.size();
+        }
+
+        /**
+         * @brief Queue a task
+         *
+         * @return 0 if ok, -1 if the task was already handed to a pool
+         */
         int QueueTask(std::shared_ptr<Task> task)
         {
-            int ret_val = 0;
-            std::unique_lock<std::mutex> lock(m_mutex);
-            if(!task->m_ended)
+            return WhenAll({}, task);
+        }
+
+        /**
+         * @brief Queue a task once another one has been executed
+         *
+         * @return 0 if ok, -1 if the task was already handed to a pool
+         */
+        int Then(std::shared_ptr<Task> dependency, std::shared_ptr<Task> task)
+        {
+            return WhenAll({dependency}, task);
+        }
+
+        /**
+         * @brief Queue a task once all the given ones have been executed. The dependencies must be queued too,
+         *        otherwise the task never runs
+         *
+         * @return 0 if ok, -1 if the task was already handed to a pool
+         */
+        int WhenAll(const std::vector<std::shared_ptr<Task>>& dependencies, std::shared_ptr<Task> task)
+        {
+            if(task->m_scheduled.exchange(true))
+            {
+                LOG(LOG_ERR, "Error queueing an already queued task: %s\n", task->m_name.c_str());
+                return -1;
+            }
+
+            /* One extra count so the task isn't queued by a dependency ending while the others are registered */
+            task->m_pending_dependencies = dependencies.size() + 1;
+
+            for(const auto& dependency : dependencies)
             {
-                m_task_queue.push(task);
-                LOG(LOG_DEBUG, "Added task: %s, Threadpool size: %u\n", task->m_name.c_str(), m_task_queue.size());
-                m_condition_variable.notify_one();
+                bool ended;
+                {
+                    std::lock_guard<std::mutex> lock(dependency->m_mutex);
+                    ended = dependency->m_ended;
+                    if(!ended)
+                    {
+                        dependency->m_dependents.push_back(task);
+                    }
+                }
+                if(ended)
+                {
+                    task->m_pending_dependencies--;
+                }
             }
-            else
+
+            if(--task->m_pending_dependencies == 0)
             {
-                LOG(LOG_ERR, "Error queueing an already ended task\n");
-                ret_val = -1;
+                Push(task);
             }
-            return ret_val;
+
+            return 0;
+        }
+
+        /**
+         * @brief Queue a function
+         *
+         * @return future of the result of the function
+         */
+        template<class Function>
+        auto Submit(std::string name, Function function, TaskPriority priority = TaskPriority::Normal) -> std::future<decltype(function())>
+        {
+            using Result = decltype(function());
+
+            std::shared_ptr<FunctionTask<Result>> task = std::make_shared<FunctionTask<Result>>(name, priority, std::move(function));
+            std::future<Result> future = task->GetFuture();
+
+            QueueTask(task);
+
+            return future;
         }
 
     private:
-        void ThreadLoop(int thread_id)
+        struct Worker
+        {
+            std::mutex mutex;
+            std::array<std::deque<std::shared_ptr<Task>>, THREADPOOL_PRIORITIES> queues;
+            std::thread thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::atomic<uint32_t> m_next_worker{0};
+        /* Number of tasks in the queues, the workers sleep while it's 0 */
+        std::mutex m_mutex;
+        std::condition_variable m_condition_variable;
+        uint32_t m_queued = 0;
+        bool m_running = true;
+
+        /* Pool and worker of the current thread, if it's a worker */
+        static inline thread_local ThreadPool* t_pool = nullptr;
+        static inline thread_local uint32_t t_worker = 0;
+
+        void Push(std::shared_ptr<Task> task)
         {
-            while (m_running)
+            uint32_t worker_id = (t_pool == this) ? t_worker : (m_next_worker++ % m_workers.size());
+            Worker& worker = *m_workers[worker_id];
+
+            /* Counted before being visible, so it's never taken before being counted */
             {
-                std::unique_lock<std::mutex> lock(m_mutex);
-                if(!m_running)
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_queued++;
+            }
+            {
+                std::lock_guard<std::mutex> lock(worker.mutex);
+                worker.queues[static_cast<size_t>(task->m_priority)].push_back(std::move(task));
+            }
+            m_condition_variable.notify_one();
+        }
+
+        std::shared_ptr<Task> Pop(uint32_t worker_id)
+        {
+            std::shared_ptr<Task> task;
+
+            for(size_t priority = 0; priority < THREADPOOL_PRIORITIES && !task; priority++)
+            {
+                /* Own queue first, in order */
                 {
-                    break;
+                    std::lock_guard<std::mutex> lock(m_workers[worker_id]->mutex);
+                    auto& queue = m_workers[worker_id]->queues[priority];
+                    if(!queue.empty())
+                    {
+                        task = std::move(queue.front());
+                        queue.pop_front();
+                    }
                 }
 
-                LOG(LOG_DEBUG, "Thread: %d waiting\n", thread_id);
-                if(!m_task_queue.empty())
+                /* Then the newest task of the other workers */
+                for(size_t i = 1; i < m_workers.size() && !task; i++)
+                {
+                    Worker& victim = *m_workers[(worker_id + i) % m_workers.size()];
+                    std::lock_guard<std::mutex> lock(victim.mutex);
+                    auto& queue = victim.queues[priority];
+                    if(!queue.empty())
+                    {
+                        task = std::move(queue.back());
+                        queue.pop_back();
+                    }
+                }
+            }
+
+            if(task)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_queued--;
+            }
+
+            return task;
+        }
+
+        void Execute(std::shared_ptr<Task> task)
+        {
+            try
+            {
+                (*task)();
+            }
+            catch(const std::exception& exception)
+            {
+                LOG(LOG_ERR, "Task: %s threw: %s\n", task->m_name.c_str(), exception.what());
+            }
+            catch(...)
+            {
+                LOG(LOG_ERR, "Task: %s threw\n", task->m_name.c_str());
+            }
+
+            std::vector<std::shared_ptr<Task>> dependents;
+            {
+                std::lock_guard<std::mutex> lock(task->m_mutex);
+                task->m_ended = true;
+                dependents.swap(task->m_dependents);
+            }
+            task->m_condition_variable.notify_all();
+
+            for(auto& dependent : dependents)
+            {
+                if(--dependent->m_pending_dependencies == 0)
                 {
-                    std::shared_ptr<Task> task = m_task_queue.front();
-                    m_task_queue.pop();
-                    LOG(LOG_DEBUG, "Threadpool size: %u\n", m_task_queue.size());
-                    LOG(LOG_DEBUG, "Thread n: %d started task %s execution\n", thread_id, task->m_name.c_str());
-                    lock.unlock();
-                    task->ExecuteTask();
-                    LOG(LOG_DEBUG, "Thread n: %d ended task %s execution\n", thread_id, task->m_name.c_str());
+                    Push(std::move(dependent));
                 }
-                else
+            }
+        }
+
+        void ThreadLoop(uint32_t worker_id)
+        {
+            t_pool = this;
+            t_worker = worker_id;
+
+            while(true)
+            {
+                std::shared_ptr<Task> task = Pop(worker_id);
+                if(task)
                 {
-                    m_condition_variable.wait(lock);
-                    LOG(LOG_DEBUG, "Thread n: %d awake but with no task\n", thread_id);
+                    Execute(std::move(task));
+                    continue;
                 }
 
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition_variable.wait(lock, [this]{ return m_queued > 0 || !m_running; });
+                if(!m_running && m_queued == 0)
+                {
+                    break;
+                }
             }
         }
 };
@@ -0,0 +1,96 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file zip_writer.hpp
+ *
+ */
+
+#ifndef ZIP_WRITER_H_
+#define ZIP_WRITER_H_
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*******************************************************************
+ * Class declaration
+ *******************************************************************/
+/**
+ * @brief Streaming writer of zip archives with stored (uncompressed) entries, which is what JPEG files need. Each
+ *        entry is written whole from memory with its CRC32 and sizes in the local header, so the archive is a
+ *        single sequential write and nothing is read back. The central directory is kept in memory and written by
+ *        Close. Entries can be added from several threads, each one is written under a lock, in the order they
+ *        arrive.
+ */
+class ZipWriter
+{
+public:
+    /**
+     * @brief Constructor
+     *
+     */
+    ZipWriter();
+
+    /**
+     * @brief Destructor, closes the archive if it is still open
+     *
+     */
+    ~ZipWriter();
+
+    ZipWriter(const ZipWriter&) = delete;
+    ZipWriter& operator=(const ZipWriter&) = delete;
+
+    /**
+     * @brief Create the archive
+     *
+     * @param[in] path : path of the archive, overwritten if it exists
+     *
+     * @return 0 on success, -1 on error
+     */
+    int Open(const std::string& path);
+
+    /**
+     * @brief Add a file to the archive
+     *
+     * @param[in] name : name of the file inside the archive
+     * @param[in] data : content of the file
+     * @param[in] size : size of the content
+     * @param[in] modification_time : modification time of the file
+     *
+     * @return 0 on success, -1 on error
+     */
+    int AddFile(const std::string& name, const uint8_t* data, size_t size, time_t modification_time);
+
+    /**
+     * @brief Write the central directory and close the archive
+     *
+     * @return 0 on success, -1 on error
+     */
+    int Close();
+
+    /**
+     * @brief Get the number of files in the archive
+     *
+     */
+    uint32_t GetNumEntries() const;
+
+private:
+    std::FILE* m_file;
+    std::string m_path;
+    std::vector<uint8_t> m_central_directory;
+    std::vector<uint8_t> m_header;
+    uint32_t m_num_entries;
+    uint32_t m_offset;
+    bool m_failed;
+    mutable std::mutex m_mutex;
+
+    int Write(const void* data, size_t size);
+};
+
+#endif /* ZIP_WRITER_H_ */
@@ -9,6 +9,7 @@
  * Includes
  *******************************************************************/
 #include <filesystem>
+#include <algorithm>
 #include <time.h>
 
 #include "alarm.hpp"
@@ -16,61 +17,35 @@
 #include "alarm_module_factory.hpp"
 #include "message_broker_factory.hpp"
 #include "state_persistence_factory.hpp"
+#include "intrusion_recorder_factory.hpp"
+#include "zip_writer.hpp"
 
 /*******************************************************************
- * Class definition
+ * Function definition
  *******************************************************************/
-class SaveToJpegTask : public Task
-{
-    private:
-        std::shared_ptr<KinectVideoFrame> m_frame;
-        std::string m_filepath;
-        int m_brightness;
-        int m_constrast;
-
-    public:
-        SaveToJpegTask(std::shared_ptr<KinectVideoFrame> frame, std::string filepath, int brightness, int constrast)
-         : Task("SaveToJpeg"), m_frame(frame), m_filepath(filepath), m_brightness(brightness), m_constrast(constrast)
-        {
-        }
-
-        void operator() () override
-        {
-            if(m_frame->SaveToJpegInFile(m_filepath, m_brightness, m_constrast))
-            {
-                LOG(LOG_ERR,"Error saving intrusion Jpeg frame to file\n");
-            }
-        }
-};
-
-class CreateDetectionTarbalTask : public Task
+static void SaveToJpeg(const KinectVideoFrame& frame, ZipWriter& archive, const std::string& filename, int brightness, int contrast)
 {
-    private:
-        std::vector<std::shared_ptr<Task>> m_tasks;
-        std::string m_path;
-        int m_current_detection_num;
-
-    public:
-        CreateDetectionTarbalTask(std::vector<std::shared_ptr<Task>> tasks, std::string path, int current_detection_num)
-            : Task("CreateDetectionTarbal"), m_tasks(tasks), m_path(path), m_current_detection_num(current_detection_num)
-        {
-        }
+    /* Reused by every frame encoded in this thread */
+    thread_local std::vector<uint8_t> jpeg;
 
-        void operator() () override
-        {
-            for(auto& task : m_tasks)
-            {
-                task->Join();
-            }
-            char command[PATH_MAX];
-            sprintf(command,"cd %s;zip -q %u_capture.zip %u*", m_path.c_str(), m_current_detection_num, m_current_detection_num);
-            system(command);
-        }
-};
+    if(frame.SaveToJpegInMemory(jpeg, brightness, contrast))
+    {
+        LOG(LOG_ERR,"Error converting intrusion frame to Jpeg\n");
+    }
+    else if(archive.AddFile(filename, jpeg.data(), jpeg.size(), time(NULL)))
+    {
+        LOG(LOG_ERR,"Error adding intrusion Jpeg frame to the archive\n");
+    }
+}
 
-Alarm::Alarm(std::shared_ptr<IMessageBroker> message_broker, std::shared_ptr<IDatabase> data_base) :
+/*******************************************************************
+ * Class definition
+ *******************************************************************/
+Alarm::Alarm(std::shared_ptr<IMessageBroker> message_broker, std::shared_ptr<IDatabase> data_base,
+             const std::string& liveview_shm_name) :
     m_message_broker(message_broker),
-    m_data_base(data_base)
+    m_data_base(data_base),
+    m_liveview_shm(liveview_shm_name, LIVEVIEW_SHM_SLOTS, LIVEVIEW_SHM_MAX_FRAME_SIZE)
 {
     m_detection_observer = std::make_shared<AlarmDetectionObserver>(*this);
     m_liveview_observer  = std::make_shared<AlarmLiveviewObserver>(*this);
@@ -78,6 +53,8 @@ Alarm::Alarm(std::shared_ptr<IMessageBroker> message_broker, std::shared_ptr<IDa
     m_kinect    = KinectFactory::Create(KINECT_GETFRAMES_TIMEOUT_MS);
     m_detection = AlarmModuleFactory::CreateDetectionModule(m_kinect, m_detection_observer, m_detection_config);
     m_liveview  = AlarmModuleFactory::CreateLiveviewModule(m_kinect, m_liveview_observer, m_liveview_config);
+
+    m_intrusion_recorder = IntrusionRecorderFactory::Create(RECORDER_CODEC, RECORDER_QUEUE_SIZE);
 }
 
 Alarm::~Alarm()
@@ -88,6 +65,12 @@ int Alarm::Init()
 {
     int ret_val = -1;
 
+    /* The broker still gets the frames without it */
+    if(LIVEVIEW_SHM && (0 != m_liveview_shm.Open()))
+    {
+        LOG(LOG_WARNING, "Couldn't create the liveview frame ring, local consumers must use the broker\n");
+    }
+
     if(0 != InitStatePersistenceVars())
     {
         LOG(LOG_ERR, "Error: couldn't initialize StatePersistence vars\n");
@@ -186,22 +169,16 @@ int Alarm::StartDetection()
                 LOG(LOG_WARNING, "Couldn't write Status in the Persisten DB\n");
             }
 
-            /* Update Cache DB */
-            if(0 != m_message_broker->SetVariable({"det_status",  DataType::Integer, 1}))
-            {
-                LOG(LOG_WARNING, "Couldn't write Status in the Cache DB\n");
-            }
-
             /* Update led */
             if(0 != UpdateLed())
             {
                 LOG(LOG_WARNING, "Couldn't update Kinect's led\n");
             }
 
-            /* Publish event */
-            if(0 != m_message_broker->Publish(REDIS_EVENT_INFO_CHANNEL, "Detection started"))
+            /* Update Cache DB and publish event */
+            if(0 != m_message_broker->SetVariablesAndPublish({{"det_status",  DataType::Integer, 1}}, REDIS_EVENT_INFO_CHANNEL, "Detection started"))
             {
-                LOG(LOG_WARNING, "Couldn't publish event\n");
+                LOG(LOG_WARNING, "Couldn't write Status in the Cache DB and publish event\n");
             }
 
             LOG(LOG_NOTICE, "Detection module started\n");
@@ -232,22 +209,16 @@ int Alarm::StopDetection()
                 LOG(LOG_WARNING, "Couldn't write Status in the Persisten DB\n");
             }
 
-            /* Update Cache DB */
-            if(0 != m_message_broker->SetVariable({"det_status",  DataType::Integer, 0}))
-            {
-                LOG(LOG_WARNING, "Couldn't write Status in the Cache DB\n");
-            }
-
             /* Update led */
             if(0 != UpdateLed())
             {
                 LOG(LOG_WARNING, "Couldn't update Kinect's led\n");
             }
 
-            /* Publish event */
-            if(0 != m_message_broker->Publish(REDIS_EVENT_INFO_CHANNEL, "Detection stopped"))
+            /* Update Cache DB and publish event */
+            if(0 != m_message_broker->SetVariablesAndPublish({{"det_status",  DataType::Integer, 0}}, REDIS_EVENT_INFO_CHANNEL, "Detection stopped"))
             {
-                LOG(LOG_WARNING, "Couldn't publish event\n");
+                LOG(LOG_WARNING, "Couldn't write Status in the Cache DB and publish event\n");
             }
 
             LOG(LOG_NOTICE, "Detection module stopped\n");
@@ -295,22 +266,16 @@ int Alarm::StartLiveview()
                 LOG(LOG_WARNING, "Couldn't write Status in the Persisten DB\n");
             }
 
-            /* Update Cache DB */
-            if(0 != m_message_broker->SetVariable({"lvw_status",  DataType::Integer, 1}))
-            {
-                LOG(LOG_WARNING, "Couldn't write Status in the Cache DB\n");
-            }
-
             /* Update led */
             if(0 != UpdateLed())
             {
                 LOG(LOG_WARNING, "Couldn't update Kinect's led\n");
             }
 
-            /* Publish event */
-            if(0 != m_message_broker->Publish(REDIS_EVENT_INFO_CHANNEL,"Liveview started"))
+            /* Update Cache DB and publish event */
+            if(0 != m_message_broker->SetVariablesAndPublish({{"lvw_status",  DataType::Integer, 1}}, REDIS_EVENT_INFO_CHANNEL, "Liveview started"))
             {
-                LOG(LOG_WARNING, "Couldn't publish event\n");
+                LOG(LOG_WARNING, "Couldn't write Status in the Cache DB and publish event\n");
             }
 
             LOG(LOG_NOTICE, "Liveview module started\n");
@@ -341,22 +306,16 @@ int Alarm::StopLiveview()
                 LOG(LOG_WARNING, "Couldn't write Status in the Persisten DB\n");
             }
 
-            /* Update Cache DB */
-            if(0 != m_message_broker->SetVariable({"lvw_status",  DataType::Integer, 0}))
-            {
-                LOG(LOG_WARNING, "Couldn't write Status in the Cache DB\n");
-            }
-
             /* Update led */
             if(0 != UpdateLed())
             {
                 LOG(LOG_WARNING, "Couldn't update Kinect's led\n");
             }
 
-            /* Publish event */
-            if(0 != m_message_broker->Publish(REDIS_EVENT_INFO_CHANNEL, "Liveview stopped"))
+            /* Update Cache DB and publish event */
+            if(0 != m_message_broker->SetVariablesAndPublish({{"lvw_status",  DataType::Integer, 0}}, REDIS_EVENT_INFO_CHANNEL, "Liveview stopped"))
             {
-                LOG(LOG_WARNING, "Couldn't publish event\n");
+                LOG(LOG_WARNING, "Couldn't write Status in the Cache DB and publish event\n");
             }
 
             LOG(LOG_NOTICE, "Liveview module stopped\n");
@@ -478,7 +437,7 @@ int Alarm::DeleteDetection(int id)
 int Alarm::InitVarsRedis()
 {
     int rel_val = 0;
-    std::array<Variable, 8> variables{{
+    std::vector<Variable> variables{{
         {"det_status",  DataType::Integer, m_alarm_config.detection_active},
         {"lvw_status",  DataType::Integer, m_alarm_config.liveview_active},
         {"det_numdet",  DataType::Integer, m_alarm_config.current_detection_number-1},
@@ -486,16 +445,14 @@ int Alarm::InitVarsRedis()
         {"brightness",  DataType::Integer, m_alarm_config.brightness},
         {"contrast",    DataType::Integer, m_alarm_config.contrast},
         {"threshold",   DataType::Integer, m_detection_config.threshold},
-        {"sensitivity", DataType::Integer, m_detection_config.sensitivity}
+        {"sensitivity", DataType::Integer, m_detection_config.sensitivity},
+        {"lvw_shm",     DataType::String,  m_liveview_shm.IsOpen() ? m_liveview_shm.GetName() : std::string()}
     }};
 
-    for(const auto& variable : variables)
+    /* All of them in a single command */
+    if(0 != m_message_broker->SetVariables(variables))
     {
-        if(0 != m_message_broker->SetVariable(variable))
-        {
-            rel_val = -1;
-            break;
-        }
+        rel_val = -1;
     }
     return rel_val;
 }
@@ -512,6 +469,10 @@ int Alarm::InitStatePersistenceVars()
     {
         LOG(LOG_ERR,"Error creating Status table \n");
     }
+    else if (nullptr == (m_zones_table = StatePersistenceFactory::CreateDatatable(m_data_base, "DETECTION_ZONES", m_zones_table_definition)))
+    {
+        LOG(LOG_ERR,"Error creating Detection zones table \n");
+    }
     else
     {
         if(0 != ReadStatus())
@@ -533,6 +494,51 @@ int Alarm::InitStatePersistenceVars()
             LOG(LOG_INFO,"Status read\n");
             ret_val = 0;
         }
+
+        if(0 != ReadDetectionZones())
+        {
+            LOG(LOG_WARNING,"Couldn't read the detection zones, the whole frame will be evaluated\n");
+        }
+
+        /* Apply the persisted detection parameters */
+        m_detection->UpdateConfig(m_detection_config);
+    }
+
+    return ret_val;
+}
+
+int Alarm::ReadDetectionZones()
+{
+    int ret_val = -1;
+    std::vector<Entry> zones;
+
+    m_detection_config.zones.clear();
+
+    if(0 != m_zones_table->GetAllItems(zones))
+    {
+        LOG(LOG_WARNING,"Error reading detection zones table\n");
+    }
+    else
+    {
+        for(const auto& zone : zones)
+        {
+            DetectionZone detection_zone;
+            detection_zone.id          = static_cast<uint16_t>(std::get<int>(zone[0].value));
+            detection_zone.threshold   = static_cast<uint16_t>(std::get<int>(zone[1].value));
+            detection_zone.sensitivity = static_cast<uint16_t>(std::get<int>(zone[2].value));
+
+            if(0 != RoiPolygonFromString(std::get<std::string>(zone[3].value), detection_zone.polygon))
+            {
+                LOG(LOG_WARNING,"Discarded detection zone %d, invalid polygon\n", detection_zone.id);
+            }
+            else if(m_detection_config.zones.size() < DETECTION_MAX_ZONES)
+            {
+                m_detection_config.zones.push_back(detection_zone);
+            }
+        }
+
+        LOG(LOG_INFO,"Detection zones read: %zu\n", m_detection_config.zones.size());
+        ret_val = 0;
     }
 
     return ret_val;
@@ -715,22 +721,17 @@ int Alarm::ChangeThreshold(int32_t value)
     m_detection_config.threshold = static_cast<uint16_t>(value);
     m_detection->UpdateConfig(m_detection_config);
 
-    /* Update Cache DB */
-    if(0 != m_message_broker->SetVariable({"threshold",  DataType::Integer, static_cast<int32_t>(value)}))
-    {
-        LOG(LOG_WARNING, "Couldn't write Status in the Cache DB\n");
-    }
-
     /* Update Persistence DB */
     if(0 != WriteStatus())
     {
         LOG(LOG_WARNING, "Couldn't write Status in the Persisten DB\n");
     }
 
-    /* Publish event */
-    if(0 != m_message_broker->Publish(REDIS_EVENT_SUCCESS_CHANNEL, std::string("Threshold changed to ") + std::to_string(value)))
+    /* Update Cache DB and publish event */
+    if(0 != m_message_broker->SetVariablesAndPublish({{"threshold",  DataType::Integer, static_cast<int32_t>(value)}},
+                                                     REDIS_EVENT_SUCCESS_CHANNEL, std::string("Threshold changed to ") + std::to_string(value)))
     {
-        LOG(LOG_WARNING, "Couldn't publish event\n");
+        LOG(LOG_WARNING, "Couldn't write Status in the Cache DB and publish event\n");
     }
 
     LOG(LOG_INFO,"Changed Kinect's threshold to: %d\n",value);
@@ -743,29 +744,215 @@ int Alarm::ChangeSensitivity(int32_t value)
     m_detection_config.sensitivity = static_cast<uint16_t>(value);
     m_detection->UpdateConfig(m_detection_config);
 
-    /* Update Cache DB */
-    if(0 != m_message_broker->SetVariable({"sensitivity",  DataType::Integer, static_cast<int32_t>(value)}))
+    /* Update Persistence DB */
+    if(0 != WriteStatus())
     {
-        LOG(LOG_WARNING, "Couldn't write Status in the Cache DB\n");
+        LOG(LOG_WARNING, "Couldn't write Status in the Persisten DB\n");
     }
 
+    /* Update Cache DB and publish event */
+    if(0 != m_message_broker->SetVariablesAndPublish({{"sensitivity",  DataType::Integer, static_cast<int32_t>(value)}},
+                                                     REDIS_EVENT_SUCCESS_CHANNEL, std::string("Sensitivity changed to ") + std::to_string(value)))
+    {
+        LOG(LOG_WARNING, "Couldn't write Status in the Cache DB and publish event\n");
+    }
+
+    LOG(LOG_INFO,"Changed Kinect's sensitivity to: %d\n",value);
+
+    return 0;
+}
+
+int Alarm::SetDetectionZone(int32_t id, int32_t threshold, int32_t sensitivity, const std::vector<RoiPoint>& polygon)
+{
+    int ret_val = -1;
+    DetectionZone detection_zone{static_cast<uint16_t>(id), static_cast<uint16_t>(threshold), static_cast<uint16_t>(sensitivity), polygon};
+    auto it = std::find_if(m_detection_config.zones.begin(), m_detection_config.zones.end(),
+                           [id](const DetectionZone& zone){ return zone.id == id; });
+    bool new_zone = (it == m_detection_config.zones.end());
+
+    if(id < 0 || id > UINT16_MAX || threshold < 0 || threshold > UINT16_MAX || sensitivity < 0 || sensitivity > UINT16_MAX)
+    {
+        LOG(LOG_ERR,"Detection zone parameters out of range\n");
+    }
+    else if(polygon.size() < 3 || polygon.size() > DETECTION_MAX_ZONE_VERTICES)
+    {
+        LOG(LOG_ERR,"Detection zone must have between 3 and %u vertices\n", DETECTION_MAX_ZONE_VERTICES);
+    }
+    else if(new_zone && m_detection_config.zones.size() >= DETECTION_MAX_ZONES)
+    {
+        LOG(LOG_ERR,"Maximum number of detection zones reached\n");
+    }
+    else
+    {
+        if(new_zone)
+        {
+            m_detection_config.zones.push_back(detection_zone);
+        }
+        else
+        {
+            *it = detection_zone;
+        }
+        m_detection->UpdateConfig(m_detection_config);
+
+        /* Update Persistence DB */
+        Entry zone_entry = m_zones_table_definition;
+        zone_entry[0].value = static_cast<int>(id); /*ID*/
+        zone_entry[1].value = static_cast<int>(threshold); /*THRESHOLD*/
+        zone_entry[2].value = static_cast<int>(sensitivity); /*SENSITIVITY*/
+        zone_entry[3].value = RoiPolygonToString(polygon); /*POLYGON*/
+
+        if(0 != (new_zone ? m_zones_table->InsertItem(zone_entry) : m_zones_table->SetItem(zone_entry)))
+        {
+            LOG(LOG_WARNING, "Couldn't write the detection zone in the Persisten DB\n");
+        }
+
+        /* Publish event */
+        if(0 != m_message_broker->Publish(REDIS_EVENT_SUCCESS_CHANNEL, std::string("Detection zone ") + std::to_string(id) + " set"))
+        {
+            LOG(LOG_WARNING, "Couldn't publish event\n");
+        }
+
+        LOG(LOG_INFO,"Detection zone %d set: threshold %d, sensitivity %d, %zu vertices\n", id, threshold, sensitivity, polygon.size());
+        ret_val = 0;
+    }
+
+    return ret_val;
+}
+
+int Alarm::DeleteDetectionZone(int32_t id)
+{
+    int ret_val = -1;
+    auto it = std::find_if(m_detection_config.zones.begin(), m_detection_config.zones.end(),
+                           [id](const DetectionZone& zone){ return zone.id == id; });
+
+    if(it == m_detection_config.zones.end())
+    {
+        LOG(LOG_WARNING,"Detection zone %d not found\n", id);
+    }
+    else
+    {
+        m_detection_config.zones.erase(it);
+        m_detection->UpdateConfig(m_detection_config);
+
+        /* Update Persistence DB */
+        Entry zone_entry = m_zones_table_definition;
+        zone_entry[0].value = static_cast<int>(id); /*ID*/
+
+        if(0 != m_zones_table->DeleteItem(zone_entry))
+        {
+            LOG(LOG_WARNING, "Couldn't delete the detection zone from the Persisten DB\n");
+        }
+
+        /* Publish event */
+        if(0 != m_message_broker->Publish(REDIS_EVENT_SUCCESS_CHANNEL, std::string("Detection zone ") + std::to_string(id) + " deleted"))
+        {
+            LOG(LOG_WARNING, "Couldn't publish event\n");
+        }
+
+        LOG(LOG_INFO,"Detection zone %d deleted\n", id);
+        ret_val = 0;
+    }
+
+    return ret_val;
+}
+
+int Alarm::ResetDetectionZones()
+{
+    m_detection_config.zones.clear();
+    m_detection->UpdateConfig(m_detection_config);
+
     /* Update Persistence DB */
-    if(0 != WriteStatus())
+    if(0 != m_zones_table->DeleteAllItems())
     {
-        LOG(LOG_WARNING, "Couldn't write Status in the Persisten DB\n");
+        LOG(LOG_WARNING, "Couldn't delete the detection zones from the Persisten DB\n");
     }
 
     /* Publish event */
-    if(0 != m_message_broker->Publish(REDIS_EVENT_SUCCESS_CHANNEL, std::string("Sensitivity changed to ") + std::to_string(value)))
+    if(0 != m_message_broker->Publish(REDIS_EVENT_SUCCESS_CHANNEL, "Deleted all detection zones"))
     {
         LOG(LOG_WARNING, "Couldn't publish event\n");
     }
 
-    LOG(LOG_INFO,"Changed Kinect's sensitivity to: %d\n",value);
+    LOG(LOG_INFO,"Deleted all detection zones\n");
+
+    return 0;
+}
+
+int Alarm::ChangeLiveviewMode(LiveviewMode mode)
+{
+    const char* mode_name = (mode == LiveviewMode::Depth) ? "depth" : (mode == LiveviewMode::SideBySide) ? "side by side" : "video";
+
+    m_liveview_config.mode = mode;
+    m_liveview->UpdateConfig(m_liveview_config);
+
+    /* Publish event */
+    if(0 != m_message_broker->Publish(REDIS_EVENT_SUCCESS_CHANNEL, std::string("Liveview mode changed to ") + mode_name))
+    {
+        LOG(LOG_WARNING, "Couldn't publish event\n");
+    }
+
+    LOG(LOG_INFO,"Liveview mode changed to %s\n", mode_name);
+
+    return 0;
+}
+
+int Alarm::EnableLiveviewBase64(bool enable)
+{
+    m_alarm_config.liveview_base64 = enable;
+
+    /* Publish event */
+    if(0 != m_message_broker->Publish(REDIS_EVENT_SUCCESS_CHANNEL, enable ? "Liveview base64 enabled" : "Liveview base64 disabled"))
+    {
+        LOG(LOG_WARNING, "Couldn't publish event\n");
+    }
+
+    LOG(LOG_INFO,"Liveview base64 channel %s\n", enable ? "enabled" : "disabled");
 
     return 0;
 }
 
+int Alarm::EnableHeatMap(bool enable)
+{
+    m_detection_config.heat_map = enable;
+    m_detection->UpdateConfig(m_detection_config);
+
+    /* Publish event */
+    if(0 != m_message_broker->Publish(REDIS_EVENT_SUCCESS_CHANNEL, enable ? "Heat map enabled" : "Heat map disabled"))
+    {
+        LOG(LOG_WARNING, "Couldn't publish event\n");
+    }
+
+    LOG(LOG_INFO,"Detection heat map %s\n", enable ? "enabled" : "disabled");
+
+    return 0;
+}
+
+int Alarm::PublishFrameStats()
+{
+    int ret_val = 0;
+    FrameStreamStats depth_stats = m_kinect->GetDepthFrameStats();
+    FrameStreamStats video_stats = m_kinect->GetVideoFrameStats();
+    auto to_integer = [](uint64_t value){ return static_cast<int32_t>(std::min<uint64_t>(value, INT32_MAX)); };
+    std::vector<Variable> variables{{
+        {"kinect_depth_frames",         DataType::Integer, to_integer(depth_stats.published)},
+        {"kinect_depth_drops",          DataType::Integer, to_integer(depth_stats.dropped)},
+        {"kinect_depth_latency_us",     DataType::Integer, to_integer(depth_stats.latency_mean_us)},
+        {"kinect_depth_latency_max_us", DataType::Integer, to_integer(depth_stats.latency_max_us)},
+        {"kinect_video_frames",         DataType::Integer, to_integer(video_stats.published)},
+        {"kinect_video_drops",          DataType::Integer, to_integer(video_stats.dropped)},
+        {"kinect_video_latency_us",     DataType::Integer, to_integer(video_stats.latency_mean_us)},
+        {"kinect_video_latency_max_us", DataType::Integer, to_integer(video_stats.latency_max_us)}
+    }};
+
+    if(0 != m_message_broker->SetVariables(variables))
+    {
+        LOG(LOG_WARNING, "Couldn't write the frame statistics in the Cache DB\n");
+        ret_val = -1;
+    }
+
+    return ret_val;
+}
+
 AlarmDetectionObserver::AlarmDetectionObserver(Alarm& alarm) :
     m_alarm(alarm)
 {
@@ -776,22 +963,68 @@ AlarmLiveviewObserver::AlarmLiveviewObserver(Alarm& alarm) :
 {
 }
 
-void AlarmLiveviewObserver::NewFrame(KinectVideoFrame& frame)
+void AlarmLiveviewObserver::NewFrame(const KinectVideoFrame& frame)
 {
-    static std::vector<uint8_t> liveview_jpeg;
-
     /* Convert to jpeg */
-    if(0 != frame.SaveToJpegInMemory(liveview_jpeg, m_alarm.m_alarm_config.brightness, m_alarm.m_alarm_config.contrast))
+    if(0 != frame.SaveToJpegInMemory(m_liveview_jpeg, m_alarm.m_alarm_config.brightness, m_alarm.m_alarm_config.contrast))
     {
         LOG(LOG_ERR, "Couldn't convert frame to Jpeg\n");
     }
     else
+    {
+        PublishJpeg();
+    }
+}
+
+void AlarmLiveviewObserver::NewDepthFrame(const KinectDepthFrame& frame)
+{
+    /* Convert to jpeg */
+    if(0 != frame.SaveToJpegInMemory(m_liveview_jpeg, m_alarm.m_alarm_config.brightness, m_alarm.m_alarm_config.contrast))
+    {
+        LOG(LOG_ERR, "Couldn't convert depth frame to Jpeg\n");
+    }
+    else
+    {
+        PublishJpeg();
+    }
+}
+
+void AlarmLiveviewObserver::NewSideBySideFrame(const KinectDepthFrame& depth_frame, const KinectVideoFrame& video_frame)
+{
+    /* Convert to jpeg */
+    if(0 != SaveSideBySideToJpegInMemory(depth_frame, video_frame, m_liveview_jpeg, m_alarm.m_alarm_config.brightness,
+                                         m_alarm.m_alarm_config.contrast))
+    {
+        LOG(LOG_ERR, "Couldn't convert frames to Jpeg\n");
+    }
+    else
+    {
+        PublishJpeg();
+    }
+}
+
+void AlarmLiveviewObserver::PublishJpeg()
+{
+    /* Local consumers read it in place */
+    if(m_alarm.m_liveview_shm.IsOpen() &&
+       (0 != m_alarm.m_liveview_shm.Write(m_liveview_jpeg.data(), m_liveview_jpeg.size(), ShmFrameFormat::Jpeg)))
+    {
+        LOG(LOG_WARNING, "Couldn't write the frame in the liveview frame ring\n");
+    }
+
+    /* Publish the encoder's buffer as it is */
+    if(0 != m_alarm.m_message_broker->PublishBinary(REDIS_LIVEFRAMES_BIN_CHANNEL, m_liveview_jpeg.data(), m_liveview_jpeg.size()))
+    {
+        LOG(LOG_WARNING, "Couldn't publish event\n");
+    }
+
+    if(m_alarm.m_alarm_config.liveview_base64)
     {
         /* Convert to base64 */
-        std::string base64_jpeg_frame = m_alarm.m_base64_encoder.Encode(std::string(liveview_jpeg.begin(), liveview_jpeg.end()));
+        m_alarm.m_base64_encoder.Encode(m_liveview_jpeg.data(), m_liveview_jpeg.size(), m_liveview_base64);
 
         /* Publish event */
-        if(0 != m_alarm.m_message_broker->Publish(REDIS_LIVEFRAMES_CHANNEL, base64_jpeg_frame))
+        if(0 != m_alarm.m_message_broker->Publish(REDIS_LIVEFRAMES_CHANNEL, m_liveview_base64))
         {
             LOG(LOG_WARNING, "Couldn't publish event\n");
         }
@@ -817,26 +1050,74 @@ void AlarmDetectionObserver::IntrusionStarted()
         LOG(LOG_ERR, "Error couldn't change Kinect's Led color\n");
     }
 
-    m_alarm.m_jpeg_tasks.clear();
+    /* Jobs of the intrusion, the ones of the previous intrusion keep running on their own */
+    if(m_alarm.m_intrusion_graph)
+    {
+        m_alarm.m_intrusion_graph->Finish();
+    }
+    m_alarm.m_intrusion_graph = std::make_unique<TaskGraph>(m_alarm.m_threadPool, "Intrusion " +
+                                                            std::to_string(m_alarm.m_alarm_config.current_detection_number));
+
+    /* Archive of the intrusion frames, written as they are converted */
+    m_alarm.m_intrusion_archive = std::make_shared<ZipWriter>();
+    std::string archive_path = std::string(DETECTION_PATH) + "/" + std::to_string(m_alarm.m_alarm_config.current_detection_number) + "_capture.zip";
+
+    if(0 != m_alarm.m_intrusion_archive->Open(archive_path))
+    {
+        LOG(LOG_ERR, "Error couldn't create the intrusion archive\n");
+        m_alarm.m_intrusion_archive.reset();
+    }
+
+    /* Start the video of the intrusion, the frames are encoded as they arrive */
+    std::string video_path = std::string(DETECTION_PATH) + "/" + std::to_string(m_alarm.m_alarm_config.current_detection_number) + "_capture_vid.mp4";
+
+    if(0 != m_alarm.m_intrusion_recorder->Start(video_path, m_alarm.m_detection_config.take_video_frame_interval_ms,
+                                                m_alarm.m_alarm_config.brightness, m_alarm.m_alarm_config.contrast))
+    {
+        LOG(LOG_ERR, "Error couldn't start the intrusion recording\n");
+    }
 }
 
 void AlarmDetectionObserver::IntrusionStopped(uint32_t frame_num)
 {
     time_t intrusion_date = time(NULL);
 
+    /* Jobs of the intrusion, if its start wasn't notified */
+    if(!m_alarm.m_intrusion_graph)
+    {
+        m_alarm.m_intrusion_graph = std::make_unique<TaskGraph>(m_alarm.m_threadPool, "Intrusion " +
+                                                                std::to_string(m_alarm.m_alarm_config.current_detection_number));
+    }
+
+    /* Finalize the video of the intrusion, completed from the recorder once the file has its trailer */
+    TaskGraph::Trigger video_finalized;
+    std::vector<TaskGraph::Node> finalized_nodes{m_alarm.m_intrusion_graph->AddEvent("video", video_finalized)};
+
+    if(0 != m_alarm.m_intrusion_recorder->Stop(video_finalized))
+    {
+        LOG(LOG_ERR, "Error couldn't stop the intrusion recording\n");
+        video_finalized();
+    }
+
     /* Update kinect led */
     m_alarm.UpdateLed();
 
-    /* Publish event */
-    std::string message = std::string("newdet ") + std::to_string(m_alarm.m_alarm_config.current_detection_number) + " " +
-                          std::to_string(intrusion_date) + " " + std::to_string(frame_num);
-
-    if(0 != m_alarm.m_message_broker->Publish(REDIS_DET_INTRUSION_CHANNEL, message))
+    /* Finalize the archive once the pending frames have been added */
+    if(m_alarm.m_intrusion_archive)
     {
-        LOG(LOG_WARNING, "Couldn't publish event\n");
+        std::shared_ptr<ZipWriter> archive = m_alarm.m_intrusion_archive;
+
+        finalized_nodes.push_back(m_alarm.m_intrusion_graph->AddNode("archive", [archive]
+        {
+            if(archive->Close())
+            {
+                LOG(LOG_ERR,"Error closing the intrusion archive\n");
+            }
+        }, m_alarm.m_intrusion_graph->GetNodes("encode"), TaskPriority::High));
+        m_alarm.m_intrusion_archive.reset();
     }
 
-    /* Update SQLite db */
+    /* Update SQLite db once the archive and the video are complete */
     Entry detection_entry = m_alarm.m_detection_table_definition;
     detection_entry[0].value = static_cast<int>(m_alarm.m_alarm_config.current_detection_number); /*ID*/
     detection_entry[1].value = static_cast<int>(intrusion_date); /*DATE*/
@@ -844,34 +1125,71 @@ void AlarmDetectionObserver::IntrusionStopped(uint32_t frame_num)
     detection_entry[3].value = std::string(DETECTION_PATH) + "/" + std::to_string(m_alarm.m_alarm_config.current_detection_number) + "_capture.zip"; /*FILENAME_IMG*/
     detection_entry[4].value = std::string(DETECTION_PATH) + "/" + std::to_string(m_alarm.m_alarm_config.current_detection_number) + "_capture_vid.mp4"; /*FILENAME_VID*/
 
-    if(0 != m_alarm.m_detection_table->InsertItem(detection_entry))
+    std::shared_ptr<IDataTable> detection_table = m_alarm.m_detection_table;
+    TaskGraph::Node database_node = m_alarm.m_intrusion_graph->AddNode("database", [detection_table, detection_entry]
     {
-        LOG(LOG_WARNING,"Error creating status table\n");
-    }
+        if(0 != detection_table->InsertItem(detection_entry))
+        {
+            LOG(LOG_WARNING,"Error creating status table\n");
+        }
+    }, finalized_nodes, TaskPriority::High);
 
-    /* Update Redis db */
-    if(0 != m_alarm.m_message_broker->SetVariable({"det_numdet",  DataType::Integer, static_cast<int32_t>(m_alarm.m_alarm_config.current_detection_number)}))
+    /* Update Redis db and publish event once the detection is in the db */
+    std::vector<Variable> variables{{"det_numdet", DataType::Integer, static_cast<int32_t>(m_alarm.m_alarm_config.current_detection_number)}};
+    std::string message = std::string("newdet ") + std::to_string(m_alarm.m_alarm_config.current_detection_number) + " " +
+                          std::to_string(intrusion_date) + " " + std::to_string(frame_num);
+    std::shared_ptr<IMessageBroker> message_broker = m_alarm.m_message_broker;
+
+    m_alarm.m_intrusion_graph->AddNode("publish", [message_broker, variables, message]
     {
-        LOG(LOG_WARNING, "Couldn't write Status in the Cache DB\n");
-    }
+        if(0 != message_broker->SetVariablesAndPublish(variables, REDIS_DET_INTRUSION_CHANNEL, message))
+        {
+            LOG(LOG_WARNING, "Couldn't publish event\n");
+        }
+    }, {database_node}, TaskPriority::High);
 
-    /* Package detections */
-    std::shared_ptr<Task> package_task = std::make_shared<CreateDetectionTarbalTask>(m_alarm.m_jpeg_tasks, DETECTION_PATH, m_alarm.m_alarm_config.current_detection_number);
-    m_alarm.m_threadPool.QueueTask(package_task);
+    /* The timing of each stage is reported once they have all run */
+    m_alarm.m_intrusion_graph->Finish();
+    m_alarm.m_intrusion_graph.reset();
 
     /* Change Status */
     m_alarm.m_alarm_config.current_detection_number += 1;
     m_alarm.WriteStatus();
 }
 
-void AlarmDetectionObserver::IntrusionFrame(std::shared_ptr<KinectVideoFrame> frame, uint32_t frame_num)
+void AlarmDetectionObserver::IntrusionFrame(std::shared_ptr<const KinectVideoFrame> frame, uint32_t frame_num)
 {
-    /* Save the frame to JPEG */
-    std::string filepath = std::string(DETECTION_PATH) + "/" + std::to_string(m_alarm.m_alarm_config.current_detection_number) + 
-                           "_capture_" + std::to_string(frame_num) + ".jpeg";
+    /* Add the frame to the archive as JPEG */
+    if(m_alarm.m_intrusion_graph && m_alarm.m_intrusion_archive)
+    {
+        std::string filename = std::to_string(m_alarm.m_alarm_config.current_detection_number) + "_capture_" + std::to_string(frame_num) + ".jpeg";
+        std::shared_ptr<ZipWriter> archive = m_alarm.m_intrusion_archive;
+        int brightness = m_alarm.m_alarm_config.brightness;
+        int contrast = m_alarm.m_alarm_config.contrast;
 
-    std::shared_ptr<Task> jpeg_task = std::make_shared<SaveToJpegTask>(frame, filepath, m_alarm.m_alarm_config.brightness, m_alarm.m_alarm_config.contrast);
-    m_alarm.m_threadPool.QueueTask(jpeg_task);
-    m_alarm.m_jpeg_tasks.push_back(jpeg_task);
+        m_alarm.m_intrusion_graph->AddNode("encode", [frame, archive, filename, brightness, contrast]
+        {
+            SaveToJpeg(*frame, *archive, filename, brightness, contrast);
+        });
+    }
+
+    /* Add the frame to the video */
+    m_alarm.m_intrusion_recorder->AddFrame(frame, frame_num);
 }
 
+
+void AlarmDetectionObserver::IntrusionHeatMap(const DifferenceMap& heat_map)
+{
+    /* "{columns} {rows} {count_0} {count_1} ..." */
+    std::string message = std::to_string(heat_map.columns) + " " + std::to_string(heat_map.rows);
+
+    for(uint32_t count : heat_map.counts)
+    {
+        message += " " + std::to_string(count);
+    }
+
+    if(0 != m_alarm.m_message_broker->Publish(REDIS_DET_HEAT_MAP_CHANNEL, message))
+    {
+        LOG(LOG_WARNING, "Couldn't publish event\n");
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file background_model.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <algorithm>
+
+#include "background_model.hpp"
+#include "log.hpp"
+
+/*******************************************************************
+ * Class definition
+ *******************************************************************/
+DepthBackgroundModel::DepthBackgroundModel(float learning_rate, float k_sigma, float min_tolerance) :
+    m_learning_rate(std::clamp(learning_rate, 0.0f, 1.0f)),
+    m_k_sigma(k_sigma),
+    m_min_tolerance(min_tolerance),
+    m_width(0),
+    m_height(0)
+{
+    /* Not every variant has this kernel, the scalar one is always available */
+    KernelVariant variant = GetBestKernelVariant();
+    m_update_background = GetUpdateBackgroundKernel(variant);
+    if(m_update_background == nullptr)
+    {
+        variant = KernelVariant::Scalar;
+        m_update_background = GetUpdateBackgroundKernel(variant);
+    }
+    LOG(LOG_INFO,"DepthBackgroundModel kernel: %s\n", GetKernelVariantName(variant));
+}
+
+void DepthBackgroundModel::SetParameters(float learning_rate, float k_sigma, float min_tolerance)
+{
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    m_learning_rate = std::clamp(learning_rate, 0.0f, 1.0f);
+    m_k_sigma = k_sigma;
+    m_min_tolerance = min_tolerance;
+}
+
+void DepthBackgroundModel::Reset()
+{
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    /* A negative mean marks the pixels without any measure */
+    std::fill(m_mean.begin(), m_mean.end(), -1.0f);
+    std::fill(m_variance.begin(), m_variance.end(), 0.0f);
+    m_background = nullptr;
+}
+
+void DepthBackgroundModel::Update(const KinectDepthFrame& frame)
+{
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    uint32_t width = frame.GetWidth();
+    uint32_t height = frame.GetHeight();
+
+    if(width != m_width || height != m_height)
+    {
+        LOG(LOG_INFO,"DepthBackgroundModel: new size %ux%u\n", width, height);
+        m_width = width;
+        m_height = height;
+        m_mean.assign(width * height, -1.0f);
+        m_variance.assign(width * height, 0.0f);
+        m_mean_out.resize(width * height);
+        /* The published one, the one held by the reader and the one being written */
+        m_backgrounds = std::make_unique<FramePool<DepthBackground>>(width, height, 3);
+        m_background = nullptr;
+    }
+
+    /* A background neither published nor held by any reader */
+    std::shared_ptr<DepthBackground> background = m_backgrounds->Acquire();
+
+    m_update_background(frame.GetDataPointer(), m_mean.data(), m_variance.data(), m_mean_out.data(),
+                        background->tolerances.data(), width * height, m_learning_rate, m_k_sigma, m_min_tolerance);
+
+    /* The rounded mean becomes the background frame by exchanging buffers, the kernel overwrites the old one next time */
+    background->mean.SwapData(m_mean_out, frame.GetTimestamp());
+
+    m_background = background;
+}
+
+std::shared_ptr<const DepthBackground> DepthBackgroundModel::GetBackground() const
+{
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    return m_background;
+}
@@ -0,0 +1,72 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file data_definition.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include "data_definition.hpp"
+#include "log.hpp"
+
+/*******************************************************************
+ * Function definition
+ *******************************************************************/
+int VariableToString(const Variable& variable, std::string& value)
+{
+    try
+    {
+        switch(variable.data_type)
+        {
+            case DataType::Integer:
+            value = std::to_string(std::get<int>(variable.value));
+            break;
+            case DataType::Float:
+            value = std::to_string(std::get<float>(variable.value));
+            break;
+            case DataType::String:
+            value = std::get<std::string>(variable.value);
+            break;
+            case DataType::Boolean:
+            value = std::get<bool>(variable.value) == true ? "true" : "false";
+            break;
+        }
+    }
+    catch(...)
+    {
+        LOG(LOG_INFO,"Exception raised\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int StringToVariable(const std::string& value, Variable& variable)
+{
+    try
+    {
+        switch(variable.data_type)
+        {
+            case DataType::Integer:
+                variable.value = std::stoi(value, nullptr);
+                break;
+            case DataType::Float:
+                variable.value = std::stof(value, nullptr);
+                break;
+            case DataType::String:
+                variable.value = value;
+                break;
+            case DataType::Boolean:
+                variable.value = value == "true" ? true : false;
+                break;
+        }
+    }
+    catch(...)
+    {
+        return -1;
+    }
+
+    return 0;
+}
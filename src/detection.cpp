@@ -8,42 +8,95 @@
 /*******************************************************************
  * Includes
  *******************************************************************/
+#include <algorithm>
+
 #include "detection.hpp"
 
+/*******************************************************************
+ * Function definition
+ *******************************************************************/
+static uint32_t PrerollFrames(const DetectionConfig& detection_config)
+{
+    return detection_config.preroll_ms / std::max(detection_config.take_video_frame_interval_ms, 1U);
+}
+
+static void RasterizeZones(const DetectionConfig& detection_config, std::vector<RoiMask>& zone_masks,
+                           std::vector<RoiMask>& zone_coarse_masks)
+{
+    for(const auto& zone : detection_config.zones)
+    {
+        zone_masks.push_back(RoiMask::FromPolygon(DEPTH_WIDTH, DEPTH_HEIGHT, zone.polygon));
+        if(detection_config.coarse_level > 0)
+        {
+            zone_coarse_masks.push_back(zone_masks.back().Downsample(detection_config.coarse_level));
+        }
+    }
+}
+
 /*******************************************************************
  * Class definition
  *******************************************************************/
 Detection::Detection(std::shared_ptr<IKinect> kinect, std::shared_ptr<DetectionObserver> detection_observer, DetectionConfig detection_config) :
-    CyclicTask("Detection", detection_config.take_depth_frame_interval_ms),
     m_detection_config(detection_config),
     m_current_state(State::Idle),
+    m_background_enabled(false),
     m_kinect(kinect),
+    m_depth_subscription(-1),
     m_detection_observer(detection_observer)
 {
-    m_depth_frame_ref         = std::make_unique<KinectDepthFrame>(DEPTH_WIDTH,DEPTH_HEIGHT);
-    m_depth_frame             = std::make_unique<KinectDepthFrame>(DEPTH_WIDTH,DEPTH_HEIGHT);
-    m_refresh_reference_frame = std::make_unique<RefreshReferenceFrame>(kinect, m_depth_frame_ref, detection_config.refresh_reference_interval_ms);
-    m_take_video_frames       = std::make_unique<TakeVideoFrames>(*this, kinect, detection_config.take_video_frame_interval_ms);
+    RasterizeZones(m_detection_config, m_zone_masks, m_zone_coarse_masks);
+
+    m_background_model  = std::make_unique<DepthBackgroundModel>(detection_config.background_learning_rate,
+                                                                  detection_config.background_k_sigma,
+                                                                  detection_config.sensitivity);
+    m_take_video_frames = std::make_unique<TakeVideoFrames>(*this, kinect, FrameDecimation(detection_config.take_video_frame_interval_ms));
+    m_take_video_frames->ChangePreroll(PrerollFrames(detection_config), detection_config.preroll_max_bytes);
 }
 
 Detection::~Detection()
 {
+    Stop();
 }
 
 int Detection::Start()
 {
     int retval = -1;
+    uint32_t decimation = 0;
+    bool preroll = false;
 
-    /* Reset intrusion variables */
+    if(m_depth_subscription >= 0)
+    {
+        LOG(LOG_INFO,"Detection is already started\n");
+        return 0;
+    }
+
+    /* Reset intrusion variables, the first frame delivered becomes the reference */
     m_current_state = State::Idle;
+    m_depth_frame_ref = nullptr;
+    m_background = nullptr;
+    m_background_model->Reset();
+
+    {
+        std::lock_guard<std::mutex> lock_guard(m_config_mutex);
+        m_background_enabled = m_detection_config.background_model;
+        decimation = FrameDecimation(m_detection_config.take_depth_frame_interval_ms);
+        preroll = (PrerollFrames(m_detection_config) > 0) && (m_detection_config.preroll_max_bytes > 0);
+    }
 
-    /* Get Reference Depth frame */
-    m_kinect->GetDepthFrame(*m_depth_frame_ref);
-    LOG(LOG_INFO,"Detection: Depth reference frame\n");
+    /* The video frames are kept from now on, so an intrusion detected right away has them too */
+    if(preroll)
+    {
+        m_take_video_frames->StartPreroll();
+    }
 
-    if(0 != CyclicTask::Start())
+    /* Driven by the arrival of depth frames, one of each decimation. Stale frames are dropped in favour of the
+     * newest one, detecting late is worse than skipping a frame */
+    m_depth_subscription = m_kinect->SubscribeDepthFrames([this](std::shared_ptr<const KinectDepthFrame> frame){ NewDepthFrame(frame); },
+                                                          decimation, {DETECTION_DEPTH_QUEUE_SIZE, FrameDropPolicy::DropOldest});
+    if(m_depth_subscription < 0)
     {
-        LOG(LOG_ERR,"CyclicTask::Start() failed\n");
+        LOG(LOG_ERR,"Detection: SubscribeDepthFrames() failed\n");
+        m_take_video_frames->StopPreroll();
     }
     else
     {
@@ -58,16 +111,23 @@ int Detection::Stop()
 {
     int retval = 0;
 
-    m_take_video_frames->Stop();
-    m_refresh_reference_frame->Stop();
+    if(m_depth_subscription < 0)
+    {
+        return retval;
+    }
 
-    /* Call parent Stop to stop the execution thread*/
-    if(0 != CyclicTask::Stop())
+    /* No depth frame is processed after it, so the video frames can't be restarted */
+    if(0 != m_kinect->Unsubscribe(m_depth_subscription))
     {
-        LOG(LOG_ERR,"CyclicTask::Stop() failed\n");
+        LOG(LOG_ERR,"Detection: Unsubscribe() failed\n");
         retval = -1;
     }
-    else
+    m_depth_subscription = -1;
+
+    m_take_video_frames->Stop();
+    m_take_video_frames->StopPreroll();
+
+    if(retval == 0)
     {
         LOG(LOG_INFO,"Detection stopped successfully\n");
     }
@@ -77,28 +137,145 @@ int Detection::Stop()
 
 bool Detection::IsRunning()
 {
-    return CyclicTask::IsRunning();
+    return m_depth_subscription >= 0;
 }
 
 void Detection::UpdateConfig(AlarmModuleConfig& config)
 {
-    m_detection_config = dynamic_cast<DetectionConfig&>(config);
+    DetectionConfig detection_config = dynamic_cast<DetectionConfig&>(config);
+    std::vector<RoiMask> zone_masks;
+    std::vector<RoiMask> zone_coarse_masks;
 
-    CyclicTask::ChangeLoopInterval(m_detection_config.take_depth_frame_interval_ms);
-    m_refresh_reference_frame->ChangeLoopInterval(m_detection_config.refresh_reference_interval_ms);
-    m_take_video_frames->ChangeLoopInterval(m_detection_config.take_video_frame_interval_ms);
+    /* Rasterize the zones before taking the lock, so the detection cycle is not delayed */
+    RasterizeZones(detection_config, zone_masks, zone_coarse_masks);
+
+    {
+        std::lock_guard<std::mutex> lock_guard(m_config_mutex);
+        m_detection_config = detection_config;
+        m_zone_masks.swap(zone_masks);
+        m_zone_coarse_masks.swap(zone_coarse_masks);
+    }
+
+    if(m_depth_subscription >= 0)
+    {
+        m_kinect->ChangeDecimation(m_depth_subscription, FrameDecimation(detection_config.take_depth_frame_interval_ms));
+    }
+    m_take_video_frames->ChangeDecimation(FrameDecimation(detection_config.take_video_frame_interval_ms));
+    m_take_video_frames->ChangePreroll(PrerollFrames(detection_config), detection_config.preroll_max_bytes);
+    /* A pre-roll enabled while running starts right away, ChangePreroll stops a disabled one */
+    if(m_depth_subscription >= 0 && (PrerollFrames(detection_config) > 0) && (detection_config.preroll_max_bytes > 0))
+    {
+        m_take_video_frames->StartPreroll();
+    }
+    m_background_model->SetParameters(detection_config.background_learning_rate, detection_config.background_k_sigma,
+                                      detection_config.sensitivity);
 }
 
-void Detection::ExecutionCycle()
+void Detection::NewDepthFrame(std::shared_ptr<const KinectDepthFrame> depth_frame)
 {
-    /* Get depth frame */
-    m_kinect->GetDepthFrame(*m_depth_frame);
+    if(depth_frame == nullptr)
+    {
+        LOG(LOG_WARNING,"Detection: depth frame not available\n");
+        return;
+    }
+
+    if(m_depth_frame_ref == nullptr)
+    {
+        std::lock_guard<std::mutex> lock_guard(m_config_mutex);
+        RefreshReference(depth_frame);
+        m_refresh_abs_time = std::chrono::system_clock::now() + std::chrono::milliseconds(m_detection_config.refresh_reference_interval_ms);
+        LOG(LOG_INFO,"Detection: Depth reference frame\n");
+        return;
+    }
+
+    const std::shared_ptr<const KinectDepthFrame>& depth_frame_ref = m_depth_frame_ref;
+    const std::shared_ptr<const DepthBackground>& background = m_background;
 
-    uint32_t diff = m_depth_frame->ComputeDifferences((*m_depth_frame_ref.get()), m_detection_config.sensitivity);
+    bool detected_movement = false;
+    bool heat_map_due = false;
+    uint32_t cooldown_ms = 0;
+    uint32_t refresh_reference_interval_ms = 0;
+    {
+        std::lock_guard<std::mutex> lock_guard(m_config_mutex);
+        cooldown_ms = m_detection_config.cooldown_ms;
+        refresh_reference_interval_ms = m_detection_config.refresh_reference_interval_ms;
 
-    LOG(LOG_DEBUG,"Detection: Diff %d\n", diff);
+        /* While idle a coarse level filters out the frames without changes, the full resolution comparison
+         * only runs when the coarse one exceeds its threshold */
+        bool coarse_enabled = (m_current_state == State::Idle) && (m_detection_config.coarse_level > 0);
 
-    bool detected_movement = diff > m_detection_config.threshold ? true : false; 
+        /* Only whether the threshold is exceeded matters, so the comparisons stop as soon as it is */
+        if(m_zone_masks.empty())
+        {
+            bool coarse_changes = true;
+            if(coarse_enabled)
+            {
+                uint32_t coarse_diff = depth_frame->ComputeDifferencesAtLevel(*depth_frame_ref, m_detection_config.sensitivity,
+                                                                              m_detection_config.coarse_level, m_detection_config.coarse_threshold);
+
+                LOG(LOG_DEBUG,"Detection: Coarse diff %d\n", coarse_diff);
+
+                coarse_changes = coarse_diff > m_detection_config.coarse_threshold ? true : false;
+            }
+
+            if(coarse_changes)
+            {
+                uint32_t diff = background ?
+                    depth_frame->ComputeDifferencesWithTolerances(*depth_frame_ref, background->tolerances.data(),
+                                                                  m_detection_config.sensitivity, m_detection_config.threshold) :
+                    depth_frame->ComputeDifferences(*depth_frame_ref, m_detection_config.sensitivity, m_detection_config.threshold);
+
+                LOG(LOG_DEBUG,"Detection: Diff %d\n", diff);
+
+                detected_movement = diff > m_detection_config.threshold ? true : false;
+            }
+        }
+        else
+        {
+            /* Each zone is compared only inside its mask, the first one exceeding its threshold is enough */
+            for(size_t i = 0; i < m_zone_masks.size() && !detected_movement; i++)
+            {
+                const DetectionZone& zone = m_detection_config.zones[i];
+
+                /* The coarse pass of a zone is never stricter than its own threshold at that level */
+                if(coarse_enabled)
+                {
+                    uint32_t coarse_threshold = std::min<uint32_t>(m_detection_config.coarse_threshold,
+                                                                   zone.threshold >> (2 * m_detection_config.coarse_level));
+                    uint32_t coarse_diff = depth_frame->ComputeDifferencesAtLevel(*depth_frame_ref, zone.sensitivity,
+                                                                                  m_detection_config.coarse_level,
+                                                                                  m_zone_coarse_masks[i], coarse_threshold);
+
+                    LOG(LOG_DEBUG,"Detection: Zone %d coarse diff %d\n", zone.id, coarse_diff);
+
+                    if(coarse_diff <= coarse_threshold)
+                    {
+                        continue;
+                    }
+                }
+
+                uint32_t diff = background ?
+                    depth_frame->ComputeDifferencesWithTolerances(*depth_frame_ref, background->tolerances.data(),
+                                                                  zone.sensitivity, m_zone_masks[i], zone.threshold) :
+                    depth_frame->ComputeDifferences(*depth_frame_ref, zone.sensitivity, m_zone_masks[i], zone.threshold);
+
+                LOG(LOG_DEBUG,"Detection: Zone %d diff %d\n", zone.id, diff);
+
+                detected_movement = diff > zone.threshold ? true : false;
+            }
+        }
+
+        /* The heat map needs a full comparison, it's computed when the intrusion starts and then at the video frames rate */
+        bool intrusion_starts = (m_current_state == State::Idle) && detected_movement;
+        bool intrusion_ongoing = (m_current_state != State::Idle) && (std::chrono::system_clock::now() >= m_heat_map_abs_time);
+
+        if(m_detection_config.heat_map && (intrusion_starts || intrusion_ongoing))
+        {
+            depth_frame->ComputeDifferenceMap(*depth_frame_ref, m_detection_config.sensitivity, DETECTION_HEAT_MAP_BLOCK_SIZE, m_heat_map);
+            m_heat_map_abs_time = std::chrono::system_clock::now() + std::chrono::milliseconds(m_detection_config.take_video_frame_interval_ms);
+            heat_map_due = true;
+        }
+    }
 
     switch (m_current_state)
     {
@@ -107,7 +284,11 @@ void Detection::ExecutionCycle()
         {
             m_detection_observer->IntrusionStarted();
             m_take_video_frames->Start();
-            m_refresh_reference_frame->Start();
+            if(!m_background_enabled)
+            {
+                /* The snapshot reference is replaced by this frame and then refreshed during the intrusion */
+                m_refresh_abs_time = std::chrono::system_clock::now();
+            }
             m_current_state = State::Intrusion;
             LOG(LOG_WARNING,"Detection: Intrusion started\n");
         }
@@ -116,7 +297,7 @@ void Detection::ExecutionCycle()
         if(!detected_movement)
         {
             m_current_state = State::Cooldown;
-            m_cooldown_abs_time = std::chrono::system_clock::now() + std::chrono::milliseconds(m_detection_config.cooldown_ms);
+            m_cooldown_abs_time = std::chrono::system_clock::now() + std::chrono::milliseconds(cooldown_ms);
         }
         break;
     case State::Cooldown:
@@ -129,7 +310,6 @@ void Detection::ExecutionCycle()
             if(std::chrono::system_clock::now() > m_cooldown_abs_time)
             {
                 uint32_t num_frames = m_take_video_frames->Stop();
-                m_refresh_reference_frame->Stop();
                 LOG(LOG_WARNING,"Detection: Intrusion Stopped\n");
                 m_detection_observer->IntrusionStopped(num_frames);
                 m_current_state = State::Idle;
@@ -139,49 +319,201 @@ void Detection::ExecutionCycle()
     default:
         break;
     }
-}
 
-RefreshReferenceFrame::RefreshReferenceFrame(std::shared_ptr<IKinect> kinect,
-                                             std::shared_ptr<KinectDepthFrame> depth_frame_reff,
-                                             uint32_t loop_period_ms) :
-    CyclicTask("RefreshReferenceFrame", loop_period_ms),
-    m_depth_frame_ref(depth_frame_reff),
-    m_kinect(kinect)
-{
+    if(heat_map_due)
+    {
+        m_detection_observer->IntrusionHeatMap(m_heat_map);
+    }
+
+    /* The background is only learned while idle so the intruder doesn't become part of it,
+       the snapshot reference only changes during intrusions */
+    bool refresh_enabled = m_background_enabled ? (m_current_state == State::Idle) : (m_current_state != State::Idle);
+    if(refresh_enabled && std::chrono::system_clock::now() >= m_refresh_abs_time)
+    {
+        RefreshReference(depth_frame);
+        m_refresh_abs_time = std::chrono::system_clock::now() + std::chrono::milliseconds(refresh_reference_interval_ms);
+    }
 }
 
-void RefreshReferenceFrame::ExecutionCycle()
+void Detection::RefreshReference(std::shared_ptr<const KinectDepthFrame> frame)
 {
-    m_kinect->GetDepthFrame(*m_depth_frame_ref);
+    if(!m_background_enabled)
+    {
+        /* Frames are immutable snapshots, replacing the reference doesn't copy the frame data */
+        m_depth_frame_ref = frame;
+        m_background = nullptr;
+        return;
+    }
+
+    if(frame == nullptr)
+    {
+        return;
+    }
+
+    m_background_model->Update(*frame);
+    std::shared_ptr<const DepthBackground> background = m_background_model->GetBackground();
+
+    /* The reference shares the ownership of the background, it isn't recycled while being compared */
+    m_depth_frame_ref = std::shared_ptr<const KinectDepthFrame>(background, &background->mean);
+    m_background = background;
 }
 
 TakeVideoFrames::TakeVideoFrames(Detection& detection,
                                  std::shared_ptr<IKinect> kinect,
-                                 uint32_t loop_period_ms) :
-    CyclicTask("TakeVideoFrames", loop_period_ms),
+                                 uint32_t decimation) :
     m_detection(detection),
     m_kinect(kinect),
-    m_frame_counter(0)
+    m_decimation(decimation),
+    m_subscription(-1),
+    m_preroll_started(false),
+    m_recording(false),
+    m_frame_counter(0),
+    m_preroll_bytes(0),
+    m_preroll_max_frames(0),
+    m_preroll_max_bytes(0)
+{
+}
+
+TakeVideoFrames::~TakeVideoFrames()
 {
-    m_frame = std::make_unique<KinectVideoFrame>(VIDEO_WIDTH, VIDEO_HEIGHT);
+    Stop();
+    StopPreroll();
 }
 
 void TakeVideoFrames::Start()
 {
-    m_frame_counter = 0;
-    CyclicTask::Start();
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    /* The pre-roll frames go first, then the ones taken from now on */
+    {
+        std::lock_guard<std::mutex> frames_lock_guard(m_frames_mutex);
+
+        m_frame_counter = 0;
+        for(const auto& frame : m_preroll)
+        {
+            m_detection.m_detection_observer->IntrusionFrame(frame, m_frame_counter++);
+        }
+        m_preroll.clear();
+        m_preroll_bytes = 0;
+        m_recording = true;
+    }
+
+    Subscribe();
 }
 
 uint32_t TakeVideoFrames::Stop()
 {
-    CyclicTask::Stop();
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    /* With the pre-roll the frames keep being taken, for the next intrusion */
+    if(!m_preroll_started && m_subscription >= 0)
+    {
+        m_kinect->Unsubscribe(m_subscription);
+        m_subscription = -1;
+    }
+
+    std::lock_guard<std::mutex> frames_lock_guard(m_frames_mutex);
+    m_recording = false;
+
     return m_frame_counter;
 }
 
-void TakeVideoFrames::ExecutionCycle()
+void TakeVideoFrames::StartPreroll()
+{
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    m_preroll_started = true;
+    Subscribe();
+}
+
+void TakeVideoFrames::StopPreroll()
+{
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    m_preroll_started = false;
+
+    /* An intrusion in progress keeps its frames */
+    {
+        std::lock_guard<std::mutex> frames_lock_guard(m_frames_mutex);
+        m_preroll.clear();
+        m_preroll_bytes = 0;
+        if(m_recording)
+        {
+            return;
+        }
+    }
+
+    if(m_subscription >= 0)
+    {
+        m_kinect->Unsubscribe(m_subscription);
+        m_subscription = -1;
+    }
+}
+
+void TakeVideoFrames::ChangeDecimation(uint32_t decimation)
 {
-    m_kinect->GetVideoFrame(*m_frame);
-    LOG(LOG_DEBUG,"TakeVideoFrames cycle: frame taken\n");
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    m_decimation = decimation;
+    if(m_subscription >= 0)
+    {
+        m_kinect->ChangeDecimation(m_subscription, decimation);
+    }
+}
+
+void TakeVideoFrames::ChangePreroll(uint32_t max_frames, uint32_t max_bytes)
+{
+    {
+        std::lock_guard<std::mutex> frames_lock_guard(m_frames_mutex);
+
+        m_preroll_max_frames = max_frames;
+        m_preroll_max_bytes = max_bytes;
+    }
+
+    /* Without room for any frame the idle subscription would only drop them */
+    if(max_frames == 0 || max_bytes == 0)
+    {
+        StopPreroll();
+    }
+}
 
-    m_detection.m_detection_observer->IntrusionFrame(m_frame, m_frame_counter++);
+void TakeVideoFrames::Subscribe()
+{
+    if(m_subscription < 0)
+    {
+        /* The intrusion frames already queued are kept, so the recording doesn't have gaps in the middle */
+        m_subscription = m_kinect->SubscribeVideoFrames([this](std::shared_ptr<const KinectVideoFrame> frame){ NewVideoFrame(frame); },
+                                                        m_decimation, {DETECTION_VIDEO_QUEUE_SIZE, FrameDropPolicy::DropNewest});
+        if(m_subscription < 0)
+        {
+            LOG(LOG_ERR,"TakeVideoFrames: SubscribeVideoFrames() failed\n");
+        }
+    }
+}
+
+void TakeVideoFrames::NewVideoFrame(std::shared_ptr<const KinectVideoFrame> frame)
+{
+    std::lock_guard<std::mutex> frames_lock_guard(m_frames_mutex);
+
+    if(m_recording)
+    {
+        LOG(LOG_DEBUG,"TakeVideoFrames: frame received\n");
+
+        m_detection.m_detection_observer->IntrusionFrame(frame, m_frame_counter++);
+        return;
+    }
+
+    /* Idle: keep the newest frames within the limits of the pre-roll */
+    KinectFrameView view = frame->GetView();
+
+    m_preroll.push_back(frame);
+    m_preroll_bytes += static_cast<uint64_t>(view.stride) * view.height * sizeof(uint16_t);
+
+    while(!m_preroll.empty() && ((m_preroll.size() > m_preroll_max_frames) || (m_preroll_bytes > m_preroll_max_bytes)))
+    {
+        KinectFrameView oldest = m_preroll.front()->GetView();
+
+        m_preroll_bytes -= static_cast<uint64_t>(oldest.stride) * oldest.height * sizeof(uint16_t);
+        m_preroll.pop_front();
+    }
 }
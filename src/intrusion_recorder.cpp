@@ -0,0 +1,424 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file intrusion_recorder.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <algorithm>
+#include <cstring>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/opt.h>
+}
+
+#include "intrusion_recorder.hpp"
+#include "global_parameters.hpp"
+#include "log.hpp"
+
+/*******************************************************************
+ * Class definition
+ *******************************************************************/
+IntrusionRecorder::IntrusionRecorder(RecorderCodec codec, uint32_t queue_size) :
+    m_codec(codec),
+    m_queue_size(queue_size),
+    m_pending_frames(0),
+    m_recording(false),
+    m_exit(false),
+    m_frame_interval_ms(0),
+    m_format_context(nullptr),
+    m_codec_context(nullptr),
+    m_stream(nullptr),
+    m_frame(nullptr),
+    m_packet(nullptr),
+    m_header_written(false),
+    m_first_frame_num(-1),
+    m_last_pts(-1),
+    m_frames_encoded(0),
+    m_failed(false),
+    m_tone_map(GetBestToneMapKernel())
+{
+    m_thread = std::thread(&IntrusionRecorder::Run, this);
+}
+
+IntrusionRecorder::~IntrusionRecorder()
+{
+    {
+        std::lock_guard<std::mutex> lock_guard(m_mutex);
+        m_exit = true;
+    }
+    m_condition_variable.notify_one();
+
+    if(m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+int IntrusionRecorder::Start(const std::string& path, uint32_t frame_interval_ms, int32_t brightness, int32_t contrast)
+{
+    {
+        std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+        if(m_recording)
+        {
+            LOG(LOG_ERR, "IntrusionRecorder: a recording is already in progress\n");
+            return -1;
+        }
+        m_recording = true;
+    }
+
+    Queue({CommandType::Start, path, frame_interval_ms, brightness, contrast, nullptr, 0});
+
+    return 0;
+}
+
+int IntrusionRecorder::AddFrame(std::shared_ptr<const KinectVideoFrame> frame, uint32_t frame_num)
+{
+    {
+        std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+        if(!m_recording)
+        {
+            LOG(LOG_ERR, "IntrusionRecorder: no recording in progress\n");
+            return -1;
+        }
+        if(m_pending_frames >= m_queue_size)
+        {
+            LOG(LOG_WARNING, "IntrusionRecorder: encoder behind, frame %u dropped\n", frame_num);
+            return -1;
+        }
+        m_pending_frames++;
+    }
+
+    Queue({CommandType::Frame, "", 0, 0, 0, std::move(frame), frame_num});
+
+    return 0;
+}
+
+int IntrusionRecorder::Stop(std::function<void()> finalized)
+{
+    {
+        std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+        if(!m_recording)
+        {
+            LOG(LOG_ERR, "IntrusionRecorder: no recording in progress\n");
+            return -1;
+        }
+        m_recording = false;
+    }
+
+    Queue({CommandType::Stop, "", 0, 0, 0, nullptr, 0, std::move(finalized)});
+
+    return 0;
+}
+
+void IntrusionRecorder::Queue(Command&& command)
+{
+    {
+        std::lock_guard<std::mutex> lock_guard(m_mutex);
+        m_commands.push_back(std::move(command));
+    }
+    m_condition_variable.notify_one();
+}
+
+void IntrusionRecorder::Run()
+{
+    std::unique_lock<std::mutex> ulock(m_mutex);
+
+    while(true)
+    {
+        m_condition_variable.wait(ulock, [this]{ return m_exit || !m_commands.empty(); });
+
+        /* The commands queued before the exit are completed */
+        if(m_commands.empty())
+        {
+            break;
+        }
+
+        Command command = std::move(m_commands.front());
+        m_commands.pop_front();
+        ulock.unlock();
+
+        switch(command.type)
+        {
+            case CommandType::Start:
+                Close();
+                m_path = command.path;
+                m_frame_interval_ms = (command.frame_interval_ms > 0) ? command.frame_interval_ms : 1;
+                m_first_frame_num = -1;
+                m_last_pts = -1;
+                m_frames_encoded = 0;
+                m_failed = false;
+                JpegEncoder::BuildToneLut(command.brightness, command.contrast, JPEG_GAMMA, m_lut);
+                break;
+
+            case CommandType::Frame:
+                if(!m_failed && !m_path.empty())
+                {
+                    KinectFrameView view = command.frame->GetView();
+
+                    if((m_format_context == nullptr) && (0 != Open(view.width, view.height)))
+                    {
+                        m_failed = true;
+                    }
+                    else if(0 != EncodeFrame(*command.frame, command.frame_num))
+                    {
+                        LOG(LOG_ERR, "IntrusionRecorder: error encoding frame %u, recording finished\n", command.frame_num);
+                        m_failed = true;
+                    }
+
+                    if(m_failed)
+                    {
+                        Close();
+                    }
+                }
+                /* Release the frame before taking the lock, so it goes back to its pool right away */
+                command.frame.reset();
+                break;
+
+            case CommandType::Stop:
+                Close();
+                m_path.clear();
+                if(command.finalized)
+                {
+                    command.finalized();
+                }
+                break;
+        }
+
+        ulock.lock();
+        if(command.type == CommandType::Frame)
+        {
+            m_pending_frames--;
+        }
+    }
+
+    ulock.unlock();
+    Close();
+}
+
+int IntrusionRecorder::Open(uint32_t width, uint32_t height)
+{
+    const AVCodec* codec = nullptr;
+
+    if(m_codec == RecorderCodec::H264)
+    {
+        codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+        if(codec == nullptr)
+        {
+            LOG(LOG_WARNING, "IntrusionRecorder: H.264 encoder not available, using MJPEG\n");
+        }
+    }
+    if(codec == nullptr)
+    {
+        codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+    }
+    if(codec == nullptr)
+    {
+        LOG(LOG_ERR, "IntrusionRecorder: no encoder available\n");
+        return -1;
+    }
+
+    /* 4:2:0 needs an even size */
+    width &= ~1U;
+    height &= ~1U;
+    if((width == 0) || (height == 0))
+    {
+        LOG(LOG_ERR, "IntrusionRecorder: invalid frame size\n");
+        return -1;
+    }
+
+    if(avformat_alloc_output_context2(&m_format_context, nullptr, "mp4", m_path.c_str()) < 0)
+    {
+        LOG(LOG_ERR, "IntrusionRecorder: couldn't create the MP4 muxer\n");
+        return -1;
+    }
+
+    m_stream = avformat_new_stream(m_format_context, nullptr);
+    m_codec_context = avcodec_alloc_context3(codec);
+    m_frame = av_frame_alloc();
+    m_packet = av_packet_alloc();
+    if((m_stream == nullptr) || (m_codec_context == nullptr) || (m_frame == nullptr) || (m_packet == nullptr))
+    {
+        LOG(LOG_ERR, "IntrusionRecorder: couldn't allocate the encoder\n");
+        return -1;
+    }
+
+    /* One time unit per frame number, with full range luma as in the JPEG frames */
+    m_codec_context->width        = width;
+    m_codec_context->height       = height;
+    m_codec_context->time_base    = AVRational{static_cast<int>(m_frame_interval_ms), 1000};
+    m_codec_context->framerate    = AVRational{1000, static_cast<int>(m_frame_interval_ms)};
+    m_codec_context->pix_fmt      = AV_PIX_FMT_YUV420P;
+    m_codec_context->color_range  = AVCOL_RANGE_JPEG;
+    m_codec_context->gop_size     = RECORDER_GOP_SIZE;
+    m_codec_context->max_b_frames = 0;
+
+    if(codec->id == AV_CODEC_ID_H264)
+    {
+        av_opt_set(m_codec_context->priv_data, "preset", RECORDER_H264_PRESET, 0);
+        av_opt_set(m_codec_context->priv_data, "crf", RECORDER_H264_CRF, 0);
+    }
+    else
+    {
+        m_codec_context->flags |= AV_CODEC_FLAG_QSCALE;
+        m_codec_context->global_quality = FF_QP2LAMBDA * RECORDER_MJPEG_QSCALE;
+    }
+
+    if(m_format_context->oformat->flags & AVFMT_GLOBALHEADER)
+    {
+        m_codec_context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    if(avcodec_open2(m_codec_context, codec, nullptr) < 0)
+    {
+        LOG(LOG_ERR, "IntrusionRecorder: couldn't open the %s encoder\n", codec->name);
+        return -1;
+    }
+
+    if(avcodec_parameters_from_context(m_stream->codecpar, m_codec_context) < 0)
+    {
+        LOG(LOG_ERR, "IntrusionRecorder: couldn't set the stream parameters\n");
+        return -1;
+    }
+    m_stream->time_base = m_codec_context->time_base;
+
+    m_frame->format = m_codec_context->pix_fmt;
+    m_frame->width  = width;
+    m_frame->height = height;
+    if(av_frame_get_buffer(m_frame, 0) < 0)
+    {
+        LOG(LOG_ERR, "IntrusionRecorder: couldn't allocate the frame\n");
+        return -1;
+    }
+
+    if(avio_open(&m_format_context->pb, m_path.c_str(), AVIO_FLAG_WRITE) < 0)
+    {
+        LOG(LOG_ERR, "IntrusionRecorder: couldn't open %s\n", m_path.c_str());
+        return -1;
+    }
+
+    if(avformat_write_header(m_format_context, nullptr) < 0)
+    {
+        LOG(LOG_ERR, "IntrusionRecorder: couldn't write the header of %s\n", m_path.c_str());
+        return -1;
+    }
+    m_header_written = true;
+
+    LOG(LOG_INFO, "IntrusionRecorder: recording %s with %s\n", m_path.c_str(), codec->name);
+
+    return 0;
+}
+
+int IntrusionRecorder::EncodeFrame(const KinectVideoFrame& frame, uint32_t frame_num)
+{
+    KinectFrameView view = frame.GetView();
+    uint32_t width = m_codec_context->width;
+    uint32_t height = m_codec_context->height;
+
+    if((view.width < width) || (view.height < height))
+    {
+        LOG(LOG_ERR, "IntrusionRecorder: frame size changed during the recording\n");
+        return -1;
+    }
+
+    /* The encoder may still reference the previous frame */
+    if(av_frame_make_writable(m_frame) < 0)
+    {
+        return -1;
+    }
+
+    for(uint32_t row = 0; row < height; row++)
+    {
+        m_tone_map(view.Row(row), m_frame->data[0] + row * m_frame->linesize[0], width, m_lut.data());
+    }
+    for(uint32_t row = 0; row < height / 2; row++)
+    {
+        std::memset(m_frame->data[1] + row * m_frame->linesize[1], 128, width / 2);
+        std::memset(m_frame->data[2] + row * m_frame->linesize[2], 128, width / 2);
+    }
+
+    /* Frame numbers are relative to the first one recorded, and must increase */
+    if(m_first_frame_num < 0)
+    {
+        m_first_frame_num = frame_num;
+    }
+    m_last_pts = std::max(m_last_pts + 1, static_cast<int64_t>(frame_num) - m_first_frame_num);
+    m_frame->pts = m_last_pts;
+
+    if(0 != WritePackets(m_frame))
+    {
+        return -1;
+    }
+    m_frames_encoded++;
+
+    return 0;
+}
+
+int IntrusionRecorder::WritePackets(const AVFrame* frame)
+{
+    int ret_val = avcodec_send_frame(m_codec_context, frame);
+
+    while(ret_val >= 0)
+    {
+        ret_val = avcodec_receive_packet(m_codec_context, m_packet);
+        if((ret_val == AVERROR(EAGAIN)) || (ret_val == AVERROR_EOF))
+        {
+            return 0;
+        }
+        else if(ret_val < 0)
+        {
+            break;
+        }
+
+        /* Not every encoder sets it, without it the muxer gives no duration to the last frame and it is dropped */
+        if(m_packet->duration == 0)
+        {
+            m_packet->duration = 1;
+        }
+        av_packet_rescale_ts(m_packet, m_codec_context->time_base, m_stream->time_base);
+        m_packet->stream_index = m_stream->index;
+
+        /* Takes the reference of the packet */
+        ret_val = av_interleaved_write_frame(m_format_context, m_packet);
+    }
+
+    return -1;
+}
+
+void IntrusionRecorder::Close()
+{
+    if(m_header_written)
+    {
+        /* Drain the frames held by the encoder and write the index */
+        if(0 != WritePackets(nullptr))
+        {
+            LOG(LOG_ERR, "IntrusionRecorder: error flushing the encoder\n");
+        }
+        if(av_write_trailer(m_format_context) < 0)
+        {
+            LOG(LOG_ERR, "IntrusionRecorder: couldn't finalize %s\n", m_path.c_str());
+        }
+        LOG(LOG_INFO, "IntrusionRecorder: %u frames recorded in %s\n", m_frames_encoded, m_path.c_str());
+        m_header_written = false;
+    }
+
+    if(m_format_context != nullptr)
+    {
+        avio_closep(&m_format_context->pb);
+        avformat_free_context(m_format_context);
+        m_format_context = nullptr;
+        m_stream = nullptr;
+    }
+
+    avcodec_free_context(&m_codec_context);
+    av_frame_free(&m_frame);
+    av_packet_free(&m_packet);
+}
@@ -0,0 +1,23 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file intrusion_recorder_factory.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <memory>
+
+#include "intrusion_recorder_factory.hpp"
+#include "intrusion_recorder.hpp"
+
+/*******************************************************************
+ * Class definition
+ *******************************************************************/
+
+std::shared_ptr<IIntrusionRecorder> IntrusionRecorderFactory::Create(RecorderCodec codec, uint32_t queue_size)
+{
+    return std::make_shared<IntrusionRecorder>(codec, queue_size);
+}
@@ -0,0 +1,358 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file jpeg_encoder.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <exception>
+
+#include "jpeg_encoder.hpp"
+#include "log.hpp"
+
+/*******************************************************************
+ * Defines
+ *******************************************************************/
+/* Initial size of an output vector without capacity, a 640x480 IR frame usually takes less */
+#define JPEG_MIN_OUTPUT_SIZE 65536U
+
+/*******************************************************************
+ * Class definition
+ *******************************************************************/
+JpegEncoder::JpegEncoder(int quality, bool fast_dct, float gamma) :
+    m_quality(std::clamp(quality, 1, 100)),
+    m_fast_dct(fast_dct),
+    m_gamma(gamma),
+    m_tone_map(GetBestToneMapKernel()),
+    m_lut_valid(false),
+    m_lut_brightness(0),
+    m_lut_contrast(0),
+    m_lut_gamma(0.0f),
+    m_lut_builds(0)
+{
+    BuildDepthLut(m_depth_lut);
+
+    /* libjpeg reports the errors through error_exit, which must not return */
+    m_compressor.err = jpeg_std_error(&m_error_manager.pub);
+    m_error_manager.pub.error_exit = ErrorExit;
+
+    if(setjmp(m_error_manager.jump_buffer))
+    {
+        LOG(LOG_ERR, "JpegEncoder: jpeg_create_compress() failed\n");
+        throw std::exception();
+    }
+    jpeg_create_compress(&m_compressor);
+
+    m_destination.pub.init_destination    = InitDestination;
+    m_destination.pub.empty_output_buffer = EmptyOutputBuffer;
+    m_destination.pub.term_destination    = TermDestination;
+    m_destination.buffer = nullptr;
+    m_compressor.dest = &m_destination.pub;
+}
+
+JpegEncoder::~JpegEncoder()
+{
+    jpeg_destroy_compress(&m_compressor);
+}
+
+void JpegEncoder::SetQuality(int quality, bool fast_dct)
+{
+    m_quality = std::clamp(quality, 1, 100);
+    m_fast_dct = fast_dct;
+}
+
+void JpegEncoder::SetGamma(float gamma)
+{
+    m_gamma = gamma;
+}
+
+uint32_t JpegEncoder::GetToneLutBuilds() const
+{
+    return m_lut_builds;
+}
+
+void JpegEncoder::UpdateToneLut(int32_t brightness, int32_t contrast)
+{
+    if(!m_lut_valid || brightness != m_lut_brightness || contrast != m_lut_contrast || m_gamma != m_lut_gamma)
+    {
+        BuildToneLut(brightness, contrast, m_gamma, m_lut);
+        m_lut_valid = true;
+        m_lut_brightness = brightness;
+        m_lut_contrast = contrast;
+        m_lut_gamma = m_gamma;
+        m_lut_builds++;
+    }
+}
+
+int JpegEncoder::Encode(const KinectFrameView& view, int32_t brightness, int32_t contrast, std::vector<uint8_t>& jpeg)
+{
+    if(view.data == nullptr || view.width == 0 || view.height == 0)
+    {
+        LOG(LOG_ERR, "JpegEncoder: empty frame\n");
+        return -1;
+    }
+
+    UpdateToneLut(brightness, contrast);
+
+    /* The lookup writes the 8 bits rows the compressor reads, no other pass over the frame is made */
+    return Compress(view.width, view.height, false, [&](uint32_t row, uint8_t* samples)
+    {
+        m_tone_map(view.Row(row), samples, view.width, m_lut.data());
+    }, jpeg);
+}
+
+int JpegEncoder::EncodeToFile(const KinectFrameView& view, int32_t brightness, int32_t contrast, const std::string& path)
+{
+    if(0 != Encode(view, brightness, contrast, m_file_buffer))
+    {
+        LOG(LOG_ERR, "JpegEncoder: couldn't encode %s\n", path.c_str());
+        return -1;
+    }
+
+    return WriteFile(m_file_buffer, path);
+}
+
+int JpegEncoder::EncodeDepth(const KinectFrameView& view, std::vector<uint8_t>& jpeg)
+{
+    if(view.data == nullptr || view.width == 0 || view.height == 0)
+    {
+        LOG(LOG_ERR, "JpegEncoder: empty frame\n");
+        return -1;
+    }
+
+    return Compress(view.width, view.height, true, [&](uint32_t row, uint8_t* samples)
+    {
+        ColormapDepthRow(view.Row(row), view.width, samples);
+    }, jpeg);
+}
+
+int JpegEncoder::EncodeDepthToFile(const KinectFrameView& view, const std::string& path)
+{
+    if(0 != EncodeDepth(view, m_file_buffer))
+    {
+        LOG(LOG_ERR, "JpegEncoder: couldn't encode %s\n", path.c_str());
+        return -1;
+    }
+
+    return WriteFile(m_file_buffer, path);
+}
+
+int JpegEncoder::EncodeSideBySide(const KinectFrameView& depth_view, const KinectFrameView& video_view, int32_t brightness,
+                                  int32_t contrast, std::vector<uint8_t>& jpeg)
+{
+    if(depth_view.data == nullptr || depth_view.width == 0 || depth_view.height == 0 ||
+       video_view.data == nullptr || video_view.width == 0 || video_view.height == 0)
+    {
+        LOG(LOG_ERR, "JpegEncoder: empty frame\n");
+        return -1;
+    }
+
+    UpdateToneLut(brightness, contrast);
+    if(m_gray_row.size() < video_view.width)
+    {
+        m_gray_row.resize(video_view.width);
+    }
+
+    return Compress(depth_view.width + video_view.width, std::max(depth_view.height, video_view.height), true,
+                    [&](uint32_t row, uint8_t* samples)
+    {
+        uint8_t* video_samples = samples + 3 * depth_view.width;
+
+        if(row < depth_view.height)
+        {
+            ColormapDepthRow(depth_view.Row(row), depth_view.width, samples);
+        }
+        else
+        {
+            std::fill_n(samples, 3 * depth_view.width, 0);
+        }
+
+        if(row < video_view.height)
+        {
+            m_tone_map(video_view.Row(row), m_gray_row.data(), video_view.width, m_lut.data());
+            for(uint32_t x = 0; x < video_view.width; x++)
+            {
+                video_samples[3 * x]     = m_gray_row[x];
+                video_samples[3 * x + 1] = m_gray_row[x];
+                video_samples[3 * x + 2] = m_gray_row[x];
+            }
+        }
+        else
+        {
+            std::fill_n(video_samples, 3 * video_view.width, 0);
+        }
+    }, jpeg);
+}
+
+template<class RowConverter>
+int JpegEncoder::Compress(uint32_t width, uint32_t height, bool color, RowConverter convert_row, std::vector<uint8_t>& jpeg)
+{
+    const uint32_t row_size = width * (color ? 3 : 1);
+
+    if(m_rows.size() < row_size * JPEG_ROWS_PER_BATCH)
+    {
+        m_rows.resize(row_size * JPEG_ROWS_PER_BATCH);
+    }
+    m_destination.buffer = &jpeg;
+
+    if(setjmp(m_error_manager.jump_buffer))
+    {
+        char message[JMSG_LENGTH_MAX];
+        (*m_compressor.err->format_message)(reinterpret_cast<j_common_ptr>(&m_compressor), message);
+        LOG(LOG_ERR, "JpegEncoder: %s\n", message);
+        jpeg_abort_compress(&m_compressor);
+        return -1;
+    }
+
+    m_compressor.image_width      = width;
+    m_compressor.image_height     = height;
+    m_compressor.input_components = color ? 3 : 1;
+    m_compressor.in_color_space   = color ? JCS_RGB : JCS_GRAYSCALE;
+    jpeg_set_defaults(&m_compressor);
+    jpeg_set_quality(&m_compressor, m_quality, TRUE);
+    m_compressor.dct_method = m_fast_dct ? JDCT_IFAST : JDCT_ISLOW;
+
+    jpeg_start_compress(&m_compressor, TRUE);
+
+    JSAMPROW rows[JPEG_ROWS_PER_BATCH];
+    while(m_compressor.next_scanline < m_compressor.image_height)
+    {
+        uint32_t first_row = m_compressor.next_scanline;
+        uint32_t num_rows = std::min(JPEG_ROWS_PER_BATCH, height - first_row);
+
+        for(uint32_t row = 0; row < num_rows; row++)
+        {
+            rows[row] = m_rows.data() + row * row_size;
+            convert_row(first_row + row, rows[row]);
+        }
+
+        jpeg_write_scanlines(&m_compressor, rows, num_rows);
+    }
+
+    jpeg_finish_compress(&m_compressor);
+
+    return 0;
+}
+
+void JpegEncoder::ColormapDepthRow(const uint16_t* src, uint32_t width, uint8_t* dst) const
+{
+    for(uint32_t x = 0; x < width; x++)
+    {
+        const uint8_t* color = m_depth_lut.data() + 3 * (src[x] & (JPEG_DEPTH_LUT_SIZE - 1));
+
+        dst[3 * x]     = color[0];
+        dst[3 * x + 1] = color[1];
+        dst[3 * x + 2] = color[2];
+    }
+}
+
+int JpegEncoder::WriteFile(const std::vector<uint8_t>& jpeg, const std::string& path)
+{
+    int retval = -1;
+    FILE* file = fopen(path.c_str(), "wb");
+
+    if(nullptr == file)
+    {
+        LOG(LOG_ERR, "JpegEncoder: couldn't open %s\n", path.c_str());
+    }
+    else
+    {
+        if(jpeg.size() != fwrite(jpeg.data(), 1, jpeg.size(), file))
+        {
+            LOG(LOG_ERR, "JpegEncoder: couldn't write %s\n", path.c_str());
+        }
+        else
+        {
+            retval = 0;
+        }
+        fclose(file);
+    }
+
+    return retval;
+}
+
+void JpegEncoder::BuildToneLut(int32_t brightness, int32_t contrast, float gamma, JpegToneLut& lut)
+{
+    const double brightness_scale = (100.0 + brightness) / 100.0;
+    const double contrast_scale = (100.0 + contrast) / 100.0;
+    const double gamma_exponent = (gamma > 0.0f) ? 1.0 / gamma : 1.0;
+
+    for(uint32_t i = 0; i < JPEG_TONE_LUT_SIZE; i++)
+    {
+        double value = std::clamp((i >> 2) * brightness_scale, 0.0, 255.0);
+        value = std::floor(value + 0.5);
+        value = std::clamp(128.0 + (value - 128.0) * contrast_scale, 0.0, 255.0);
+        value = std::floor(value + 0.5);
+        if(gamma_exponent != 1.0)
+        {
+            value = std::floor(255.0 * std::pow(value / 255.0, gamma_exponent) + 0.5);
+        }
+        lut[i] = static_cast<uint8_t>(value);
+    }
+}
+
+void JpegEncoder::BuildDepthLut(JpegDepthLut& lut)
+{
+    for(uint32_t i = 0; i < JPEG_DEPTH_LUT_SIZE; i++)
+    {
+        if(i == BLANK_DEPTH_PIXEL)
+        {
+            lut[3 * i] = lut[3 * i + 1] = lut[3 * i + 2] = 0;
+            continue;
+        }
+
+        /* Position in the colormap, 1 (red) for the nearest values and 0 (blue) for the farthest ones */
+        double x = std::clamp((static_cast<double>(JPEG_DEPTH_FAR) - i) / (JPEG_DEPTH_FAR - JPEG_DEPTH_NEAR), 0.0, 1.0);
+
+        /* Polynomial fit of the turbo colormap */
+        double r = 0.13572138 + x * (4.61539260 + x * (-42.66032258 + x * (132.13108234 + x * (-152.94239396 + x * 59.28637943))));
+        double g = 0.09140261 + x * (2.19418839 + x * (4.84296658 + x * (-14.18503333 + x * (4.27729857 + x * 2.82956604))));
+        double b = 0.10667330 + x * (12.64194608 + x * (-60.58204836 + x * (110.36276771 + x * (-89.90310912 + x * 27.34824973))));
+
+        lut[3 * i]     = static_cast<uint8_t>(std::floor(std::clamp(r, 0.0, 1.0) * 255.0 + 0.5));
+        lut[3 * i + 1] = static_cast<uint8_t>(std::floor(std::clamp(g, 0.0, 1.0) * 255.0 + 0.5));
+        lut[3 * i + 2] = static_cast<uint8_t>(std::floor(std::clamp(b, 0.0, 1.0) * 255.0 + 0.5));
+    }
+}
+
+void JpegEncoder::ErrorExit(j_common_ptr common)
+{
+    ErrorManager* error_manager = reinterpret_cast<ErrorManager*>(common->err);
+    longjmp(error_manager->jump_buffer, 1);
+}
+
+void JpegEncoder::InitDestination(j_compress_ptr compressor)
+{
+    VectorDestination* destination = reinterpret_cast<VectorDestination*>(compressor->dest);
+    std::vector<uint8_t>& buffer = *destination->buffer;
+
+    /* The whole capacity is used, so a vector reused between frames is only grown by the first ones */
+    buffer.resize(std::max<size_t>(buffer.capacity(), JPEG_MIN_OUTPUT_SIZE));
+    destination->pub.next_output_byte = buffer.data();
+    destination->pub.free_in_buffer   = buffer.size();
+}
+
+boolean JpegEncoder::EmptyOutputBuffer(j_compress_ptr compressor)
+{
+    VectorDestination* destination = reinterpret_cast<VectorDestination*>(compressor->dest);
+    std::vector<uint8_t>& buffer = *destination->buffer;
+    size_t used = buffer.size();
+
+    buffer.resize(2 * used);
+    destination->pub.next_output_byte = buffer.data() + used;
+    destination->pub.free_in_buffer   = buffer.size() - used;
+
+    return TRUE;
+}
+
+void JpegEncoder::TermDestination(j_compress_ptr compressor)
+{
+    VectorDestination* destination = reinterpret_cast<VectorDestination*>(compressor->dest);
+
+    destination->buffer->resize(destination->buffer->size() - destination->pub.free_in_buffer);
+}
@@ -16,26 +16,23 @@
 /*******************************************************************
  * Static variables
  *******************************************************************/
-std::unique_ptr<KinectDepthFrame> Kinect::m_depth_frame;
-std::unique_ptr<KinectVideoFrame> Kinect::m_video_frame;
-
-std::mutex Kinect::m_depth_mutex, Kinect::m_video_mutex;
-std::condition_variable Kinect::m_depth_cv, Kinect::m_video_cv;
+std::unique_ptr<FrameExchange<KinectDepthFrame>> Kinect::m_depth_frames;
+std::unique_ptr<FrameExchange<KinectVideoFrame>> Kinect::m_video_frames;
 
 uint32_t Kinect::m_timeout_ms;
 
 /*******************************************************************
  * Class definition
  *******************************************************************/
-Kinect::Kinect(uint32_t timeout_ms) : CyclicTask("Kinect", 0)
+Kinect::Kinect(uint32_t timeout_ms) : CyclicTask("Kinect", 0), m_next_subscription(0)
 {
     /* Members initialization */
     m_timeout_ms            = timeout_ms;
     m_is_kinect_initialized = false;
     m_kinect_ctx            = NULL;
     m_kinect_dev            = NULL;
-    m_depth_frame = std::make_unique<KinectDepthFrame>(DEPTH_WIDTH, DEPTH_HEIGHT);
-    m_video_frame = std::make_unique<KinectVideoFrame>(VIDEO_WIDTH, VIDEO_HEIGHT);
+    m_depth_frames = std::make_unique<FrameExchange<KinectDepthFrame>>(DEPTH_WIDTH, DEPTH_HEIGHT);
+    m_video_frames = std::make_unique<FrameExchange<KinectVideoFrame>>(VIDEO_WIDTH, VIDEO_HEIGHT);
 }
 
 Kinect::~Kinect()
@@ -167,8 +164,8 @@ int Kinect::Start()
     int retval = -1;
 
     /* Initialize frame time-stamps */
-    m_depth_frame->SetTimestamp(0);
-    m_video_frame->SetTimestamp(0);
+    m_depth_frames->Reset();
+    m_video_frames->Reset();
 
     if(0 != freenect_start_video(m_kinect_dev))
     {
@@ -230,50 +227,90 @@ void Kinect::ExecutionCycle()
     freenect_process_events(m_kinect_ctx);
 }
 
-void Kinect::GetDepthFrame(KinectDepthFrame& frame)
+void Kinect::GetDepthFrame(std::shared_ptr<const KinectDepthFrame>& frame)
 {
-    std::unique_lock<std::mutex> ulock(m_depth_mutex);
+    if(!m_depth_frames->Get(frame, m_timeout_ms))
+    {
+        LOG(LOG_WARNING,"GetDepthFrame() failed to acquire a frame in %u ms\n", m_timeout_ms);
+    }
+}
 
-    /* Compare the given timestamp with the current, if it's the same must wait to the next frame */
-    if(frame.GetTimestamp() == m_depth_frame->GetTimestamp())
+void Kinect::GetVideoFrame(std::shared_ptr<const KinectVideoFrame>& frame)
+{
+    if(!m_video_frames->Get(frame, m_timeout_ms))
     {
-        if(m_depth_cv.wait_for(ulock, std::chrono::milliseconds(m_timeout_ms)) == std::cv_status::timeout)
-        {
-            LOG(LOG_WARNING,"GetDepthFrame() failed to acquire a frame in %u ms\n", m_timeout_ms);
-        }
+        LOG(LOG_WARNING,"GetVideoFrame() failed to acquire a frame in %u ms\n", m_timeout_ms);
     }
+}
 
-    frame = *m_depth_frame;
+int Kinect::SubscribeDepthFrames(DepthFrameCallback callback, uint32_t decimation, FrameQueueConfig queue_config)
+{
+    int subscription = m_next_subscription++;
+
+    if(0 != m_depth_frames->Subscribe(subscription, callback, decimation, queue_config))
+    {
+        LOG(LOG_ERR,"SubscribeDepthFrames() failed\n");
+        return -1;
+    }
+
+    return subscription;
 }
 
-void Kinect::GetVideoFrame(KinectVideoFrame& frame)
+int Kinect::SubscribeVideoFrames(VideoFrameCallback callback, uint32_t decimation, FrameQueueConfig queue_config)
 {
-    std::unique_lock<std::mutex> ulock(m_video_mutex);
+    int subscription = m_next_subscription++;
 
-    /*  Compare the given timestamp with the current, if it's the same must wait to the next frame */
-    if(frame.GetTimestamp() == m_video_frame->GetTimestamp())
+    if(0 != m_video_frames->Subscribe(subscription, callback, decimation, queue_config))
     {
-        if(m_video_cv.wait_for(ulock, std::chrono::milliseconds(m_timeout_ms)) == std::cv_status::timeout)
-        {
-            LOG(LOG_WARNING,"GetVideoFrame() failed to acquire a frame in %u ms\n", m_timeout_ms);
-        }
+        LOG(LOG_ERR,"SubscribeVideoFrames() failed\n");
+        return -1;
     }
 
-    frame = *m_video_frame;
+    return subscription;
+}
+
+int Kinect::ChangeDecimation(int subscription, uint32_t decimation)
+{
+    if(0 != m_depth_frames->ChangeDecimation(subscription, decimation) &&
+       0 != m_video_frames->ChangeDecimation(subscription, decimation))
+    {
+        LOG(LOG_WARNING,"ChangeDecimation() subscription %d not found\n", subscription);
+        return -1;
+    }
+
+    return 0;
+}
+
+int Kinect::Unsubscribe(int subscription)
+{
+    if(0 != m_depth_frames->Unsubscribe(subscription) &&
+       0 != m_video_frames->Unsubscribe(subscription))
+    {
+        LOG(LOG_WARNING,"Unsubscribe() subscription %d not found\n", subscription);
+        return -1;
+    }
+
+    return 0;
+}
+
+FrameStreamStats Kinect::GetDepthFrameStats()
+{
+    return m_depth_frames->GetStats();
+}
+
+FrameStreamStats Kinect::GetVideoFrameStats()
+{
+    return m_video_frames->GetStats();
 }
 
 void Kinect::DepthCallback(freenect_device* dev, void* data, uint32_t timestamp)
 {
-    std::unique_lock<std::mutex> ulock(m_depth_mutex);
-    m_depth_frame->Fill(static_cast<uint16_t*>(data), timestamp);
-    m_depth_cv.notify_all();
+    m_depth_frames->Publish(static_cast<uint16_t*>(data), timestamp);
 }
 
 void Kinect::VideoCallback(freenect_device* dev, void* data, uint32_t timestamp)
 {
-    std::unique_lock<std::mutex> ulock(m_video_mutex);
-    m_video_frame->Fill(static_cast<uint16_t*>(data), timestamp);
-    m_video_cv.notify_all();
+    m_video_frames->Publish(static_cast<uint16_t*>(data), timestamp);
 }
 
 int Kinect::ChangeTilt(double tilt_angle)
@@ -8,11 +8,32 @@
 /*******************************************************************
  * Includes
  *******************************************************************/
-#include <FreeImage.h>
+#include <algorithm>
+#include <typeinfo>
 
 #include "kinect_frame.hpp"
+#include "kinect_frame_kernels.hpp"
+#include "jpeg_encoder.hpp"
+#include "global_parameters.hpp"
 #include "log.hpp"
 
+/*******************************************************************
+ * Defines
+ *******************************************************************/
+/* Rows compared between two checks of the limit, 16 depth rows of both frames take 40KB */
+#define DIFFERENCES_BAND_ROWS 16U
+
+/*******************************************************************
+ * Function definition
+ *******************************************************************/
+/* The compressor of each thread is created by its first frame and then reused */
+static JpegEncoder& GetJpegEncoder()
+{
+    thread_local JpegEncoder jpeg_encoder(JPEG_QUALITY, JPEG_FAST_DCT, JPEG_GAMMA);
+
+    return jpeg_encoder;
+}
+
 /*******************************************************************
  * Class definition
  *******************************************************************/
@@ -29,6 +50,12 @@ KinectFrame::KinectFrame(const KinectFrame& kinect_frame) :
     *this = kinect_frame;
 }
 
+KinectFrame::KinectFrame(KinectFrame&& kinect_frame) noexcept :
+    m_timestamp(0), m_width(0), m_height(0)
+{
+    *this = std::move(kinect_frame);
+}
+
 KinectFrame::~KinectFrame()
 {
 }
@@ -36,13 +63,75 @@ KinectFrame::~KinectFrame()
 KinectFrame& KinectFrame::operator=(const KinectFrame& other)
 {
     this->Fill(other.GetDataPointer(), other.GetTimestamp());
+    m_capture_time = other.m_capture_time;
     return *this;
 }
 
+KinectFrame& KinectFrame::operator=(KinectFrame&& other) noexcept
+{
+    if(this != &other)
+    {
+        std::scoped_lock lock(m_mutex, other.m_mutex);
+
+        m_data         = std::move(other.m_data);
+        m_timestamp    = other.m_timestamp;
+        m_capture_time = other.m_capture_time;
+        m_width        = other.m_width;
+        m_height       = other.m_height;
+
+        other.m_data.clear();
+        other.m_timestamp = 0;
+        other.m_width     = 0;
+        other.m_height    = 0;
+    }
+    return *this;
+}
+
+int KinectFrame::Swap(KinectFrame& other)
+{
+    if(this == &other)
+    {
+        return 0;
+    }
+    if(typeid(*this) != typeid(other) || m_width != other.m_width || m_height != other.m_height)
+    {
+        LOG(LOG_ERR,"KinectFrame::Swap: frames of different type or size\n");
+        return -1;
+    }
+
+    std::scoped_lock lock(m_mutex, other.m_mutex);
+
+    m_data.swap(other.m_data);
+    std::swap(m_timestamp, other.m_timestamp);
+    std::swap(m_capture_time, other.m_capture_time);
+    SwapDerived(other);
+
+    return 0;
+}
+
+void KinectFrame::SwapDerived(KinectFrame& other)
+{
+}
+
+int KinectFrame::SwapData(AlignedVector<uint16_t>& frame_data, uint32_t timestamp)
+{
+    if(frame_data.size() != m_width * m_height)
+    {
+        LOG(LOG_ERR,"KinectFrame::SwapData: buffer of %zu pixels for a %ux%u frame\n", frame_data.size(), m_width, m_height);
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+    m_data.swap(frame_data);
+    m_timestamp = timestamp;
+
+    return 0;
+}
+
 void KinectFrame::Fill(const uint16_t* frame_data, uint32_t timestamp)
 {
     std::lock_guard<std::mutex> lock_guard(m_mutex);
-    m_data.assign(frame_data, frame_data + (m_width * m_height));
+    std::copy_n(frame_data, m_width * m_height, m_data.begin());
     m_timestamp = timestamp;
 }
 
@@ -51,6 +140,21 @@ const uint16_t* KinectFrame::GetDataPointer() const
     return m_data.data();
 }
 
+KinectFrameView KinectFrame::GetView() const
+{
+    return {m_data.data(), m_width, m_height, m_width, GetPixelFormat()};
+}
+
+uint32_t KinectFrame::GetWidth() const
+{
+    return m_width;
+}
+
+uint32_t KinectFrame::GetHeight() const
+{
+    return m_height;
+}
+
 uint32_t KinectFrame::GetTimestamp() const
 {
     return m_timestamp;
@@ -61,140 +165,452 @@ void KinectFrame::SetTimestamp(uint32_t timestamp)
     m_timestamp = timestamp;
 }
 
+std::chrono::steady_clock::time_point KinectFrame::GetCaptureTime() const
+{
+    return m_capture_time;
+}
+
+void KinectFrame::SetCaptureTime(std::chrono::steady_clock::time_point capture_time)
+{
+    m_capture_time = capture_time;
+}
+
 KinectDepthFrame::KinectDepthFrame(uint32_t width, uint32_t height) : KinectFrame(width, height)
 {
+    m_pyramid_row.resize(m_width);
+    for(uint32_t level = 1; level < DEPTH_PYRAMID_LEVELS; level++)
+    {
+        m_levels[level - 1].resize((m_width >> level) * (m_height >> level));
+    }
+    BuildPyramid();
 }
 
 KinectDepthFrame::KinectDepthFrame(const KinectDepthFrame& kinect_depth_frame) : KinectFrame(kinect_depth_frame)
 {
+    /* The base copy constructor fills the data without reaching the override */
+    m_pyramid_row.resize(m_width);
+    for(uint32_t level = 1; level < DEPTH_PYRAMID_LEVELS; level++)
+    {
+        m_levels[level - 1].resize((m_width >> level) * (m_height >> level));
+    }
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+    BuildPyramid();
 }
 
-KinectDepthFrame::~KinectDepthFrame()
+KinectDepthFrame::KinectDepthFrame(KinectDepthFrame&& kinect_depth_frame) noexcept : KinectFrame(std::move(kinect_depth_frame))
 {
+    std::scoped_lock lock(m_mutex, kinect_depth_frame.m_mutex);
+    for(uint32_t level = 1; level < DEPTH_PYRAMID_LEVELS; level++)
+    {
+        m_levels[level - 1] = std::move(kinect_depth_frame.m_levels[level - 1]);
+        kinect_depth_frame.m_levels[level - 1].clear();
+    }
+    m_pyramid_row = std::move(kinect_depth_frame.m_pyramid_row);
+    kinect_depth_frame.m_pyramid_row.clear();
 }
 
-uint32_t KinectDepthFrame::ComputeDifferences(KinectDepthFrame& other, uint32_t tolerance)
+KinectDepthFrame& KinectDepthFrame::operator=(const KinectDepthFrame& kinect_depth_frame)
 {
-    std::lock_guard<std::mutex> lock_guard(m_mutex);
-    uint32_t count = 0;
+    /* The base copy fills the data through the override, which builds the pyramid */
+    KinectFrame::operator=(kinect_depth_frame);
+    return *this;
+}
 
-    for(uint32_t i = 0; i < (m_width * m_height); i++)
+KinectDepthFrame& KinectDepthFrame::operator=(KinectDepthFrame&& kinect_depth_frame) noexcept
+{
+    if(this != &kinect_depth_frame)
     {
-        if((m_data[i] != BLANK_DEPTH_PIXEL) && (other.m_data[i] != BLANK_DEPTH_PIXEL))
+        KinectFrame::operator=(std::move(kinect_depth_frame));
+
+        std::scoped_lock lock(m_mutex, kinect_depth_frame.m_mutex);
+        for(uint32_t level = 1; level < DEPTH_PYRAMID_LEVELS; level++)
         {
-            if((std::abs(static_cast<int32_t>(m_data[i]) - other.m_data[i])) > tolerance)
-            {
-                count++;
-            }
+            m_levels[level - 1] = std::move(kinect_depth_frame.m_levels[level - 1]);
+            kinect_depth_frame.m_levels[level - 1].clear();
         }
+        m_pyramid_row = std::move(kinect_depth_frame.m_pyramid_row);
+        kinect_depth_frame.m_pyramid_row.clear();
     }
-    return count;
+    return *this;
 }
 
-int KinectDepthFrame::SaveToJpegInFile(std::string path, int32_t brightness, int32_t contrast)
+PixelFormat KinectDepthFrame::GetPixelFormat() const
 {
+    return PixelFormat::Depth11Bit;
+}
+
+void KinectDepthFrame::Fill(const uint16_t* frame_data, uint32_t timestamp)
+{
+    KinectFrame::Fill(frame_data, timestamp);
+
     std::lock_guard<std::mutex> lock_guard(m_mutex);
-    int retval = 0;
-    FIBITMAP *depth_bitmap;
-    std::vector<uint8_t> bmap(m_width * m_height);
+    BuildPyramid();
+}
 
-    for(uint32_t i = 0; i <  m_width * m_height; i++)
+int KinectDepthFrame::SwapData(AlignedVector<uint16_t>& frame_data, uint32_t timestamp)
+{
+    if(0 != KinectFrame::SwapData(frame_data, timestamp))
     {
-        bmap[i] = (m_data[i] >> 2);
+        return -1;
     }
 
-    depth_bitmap = FreeImage_ConvertFromRawBits(reinterpret_cast<BYTE *>(m_data.data()), m_width, m_height, m_width, 8, 0xFF, 0xFF, 0xFF, true);
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+    BuildPyramid();
+
+    return 0;
+}
 
-    FreeImage_FlipVertical(depth_bitmap);
-    FreeImage_AdjustBrightness(depth_bitmap, brightness);
-    FreeImage_AdjustContrast(depth_bitmap, contrast);
+void KinectDepthFrame::SwapDerived(KinectFrame& other)
+{
+    /* Swap checks that both frames are of the same type */
+    KinectDepthFrame& other_depth = static_cast<KinectDepthFrame&>(other);
 
-    if(!FreeImage_Save(FIF_BMP, depth_bitmap, path.c_str(), 0))
+    for(uint32_t level = 1; level < DEPTH_PYRAMID_LEVELS; level++)
     {
-        retval = 1;
+        m_levels[level - 1].swap(other_depth.m_levels[level - 1]);
     }
+}
 
-    FreeImage_Unload(depth_bitmap);
+void KinectDepthFrame::BuildPyramid()
+{
+    const uint16_t* src = m_data.data();
+    uint32_t src_width = m_width;
 
-    return retval;
+    for(uint32_t level = 1; level < DEPTH_PYRAMID_LEVELS; level++)
+    {
+        uint16_t* dst = m_levels[level - 1].data();
+        uint32_t dst_width  = m_width >> level;
+        uint32_t dst_height = m_height >> level;
+
+        for(uint32_t y = 0; y < dst_height; y++)
+        {
+            const uint16_t* row_0 = src + (2 * y) * src_width;
+            const uint16_t* row_1 = row_0 + src_width;
+            uint16_t* dst_row = dst + y * dst_width;
+
+            /* Vertical minimum first, it's a plain element-wise loop the compiler vectorizes */
+            for(uint32_t x = 0; x < 2 * dst_width; x++)
+            {
+                m_pyramid_row[x] = std::min(row_0[x], row_1[x]);
+            }
+            for(uint32_t x = 0; x < dst_width; x++)
+            {
+                dst_row[x] = std::min(m_pyramid_row[2 * x], m_pyramid_row[2 * x + 1]);
+            }
+        }
+
+        src = dst;
+        src_width = dst_width;
+    }
 }
 
-int KinectDepthFrame::SaveToJpegInMemory(std::vector<uint8_t>& jpeg_frame, int32_t brightness, int32_t contrast)
+const uint16_t* KinectDepthFrame::GetLevelDataPointer(uint32_t level) const
 {
-    /* TODO */
-    return 1;
+    if(level == 0)
+    {
+        return m_data.data();
+    }
+    else if(level < DEPTH_PYRAMID_LEVELS)
+    {
+        return m_levels[level - 1].data();
+    }
+
+    return nullptr;
 }
 
-KinectVideoFrame::KinectVideoFrame(uint32_t width, uint32_t height) : KinectFrame(width, height)
+KinectFrameView KinectDepthFrame::GetLevelView(uint32_t level) const
 {
+    if(level >= DEPTH_PYRAMID_LEVELS)
+    {
+        return {nullptr, 0, 0, 0, PixelFormat::Depth11Bit};
+    }
+
+    return {GetLevelDataPointer(level), m_width >> level, m_height >> level, m_width >> level, PixelFormat::Depth11Bit};
 }
 
-KinectVideoFrame::KinectVideoFrame(const KinectVideoFrame& kinect_depth_frame) : KinectFrame(kinect_depth_frame)
+KinectDepthFrame::~KinectDepthFrame()
 {
 }
 
-KinectVideoFrame::~KinectVideoFrame()
+static CountDifferencesKernel GetCountDifferences()
+{
+    /* Select once the fastest implementation supported by the CPU */
+    static const CountDifferencesKernel count_differences = []
+    {
+        KernelVariant variant = GetBestKernelVariant();
+        LOG(LOG_INFO,"ComputeDifferences kernel: %s\n", GetKernelVariantName(variant));
+        return GetCountDifferencesKernel(variant);
+    }();
+
+    return count_differences;
+}
+
+static CountDifferencesPerPixelKernel GetCountDifferencesPerPixel()
 {
+    static const CountDifferencesPerPixelKernel count_differences = []
+    {
+        KernelVariant variant = GetBestKernelVariant();
+        LOG(LOG_INFO,"ComputeDifferencesWithTolerances kernel: %s\n", GetKernelVariantName(variant));
+        return GetCountDifferencesPerPixelKernel(variant);
+    }();
+
+    return count_differences;
 }
 
-int KinectVideoFrame::SaveToJpegInFile(std::string path, int32_t brightness, int32_t contrast)
+static uint32_t CountDifferencesInBands(const uint16_t* lhs, const uint16_t* rhs, uint32_t width, uint32_t height,
+                                        uint32_t tolerance, uint32_t limit)
+{
+    CountDifferencesKernel count_differences = GetCountDifferences();
+    uint32_t count = 0;
+
+    const uint32_t num_pixels  = width * height;
+    const uint32_t band_pixels = DIFFERENCES_BAND_ROWS * width;
+
+    /* Bands of rows small enough to stay in cache, checking the limit between them */
+    for(uint32_t offset = 0; offset < num_pixels && count <= limit; offset += band_pixels)
+    {
+        count += count_differences(lhs + offset, rhs + offset, std::min(band_pixels, num_pixels - offset), tolerance);
+    }
+
+    return count;
+}
+
+uint32_t KinectDepthFrame::ComputeDifferences(const KinectDepthFrame& other, uint32_t tolerance, uint32_t limit) const
 {
     std::lock_guard<std::mutex> lock_guard(m_mutex);
-    int retval = 0;
-    FIBITMAP *video_bitmap;
-    std::vector<uint8_t> bmap(m_width * m_height);
 
-    for(uint32_t i = 0; i <  m_width * m_height; i++)
+    return CountDifferencesInBands(m_data.data(), other.m_data.data(), m_width, m_height, tolerance, limit);
+}
+
+uint32_t KinectDepthFrame::ComputeDifferencesAtLevel(const KinectDepthFrame& other, uint32_t tolerance, uint32_t level, uint32_t limit) const
+{
+    if(level >= DEPTH_PYRAMID_LEVELS)
     {
-        bmap[i] = (m_data[i] >> 2);
+        LOG(LOG_ERR,"ComputeDifferencesAtLevel: level %u doesn't exist\n", level);
+        return 0;
     }
 
-    video_bitmap = FreeImage_ConvertFromRawBits(reinterpret_cast<BYTE *>(bmap.data()), m_width, m_height, m_width, 8, 0xFF, 0xFF, 0xFF, true);
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    return CountDifferencesInBands(GetLevelDataPointer(level), other.GetLevelDataPointer(level),
+                                   m_width >> level, m_height >> level, tolerance, limit);
+}
 
-    FreeImage_AdjustBrightness(video_bitmap, brightness);
-    FreeImage_AdjustContrast(video_bitmap, contrast);
+uint32_t KinectDepthFrame::ComputeDifferencesAtLevel(const KinectDepthFrame& other, uint32_t tolerance, uint32_t level,
+                                                     const RoiMask& mask, uint32_t limit) const
+{
+    CountDifferencesKernel count_differences = GetCountDifferences();
+    uint32_t count = 0;
 
-    if(!FreeImage_Save(FIF_JPEG, video_bitmap, path.c_str(), 0))
+    if(level >= DEPTH_PYRAMID_LEVELS)
+    {
+        LOG(LOG_ERR,"ComputeDifferencesAtLevel: level %u doesn't exist\n", level);
+        return 0;
+    }
+    else if(mask.GetWidth() != (m_width >> level) || mask.GetHeight() != (m_height >> level))
     {
-        retval = 1;
+        LOG(LOG_ERR,"ComputeDifferencesAtLevel: mask size %ux%u doesn't match the level\n", mask.GetWidth(), mask.GetHeight());
+        return 0;
     }
 
-    FreeImage_Unload(video_bitmap);
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    const uint16_t* data = GetLevelDataPointer(level);
+    const uint16_t* other_data = other.GetLevelDataPointer(level);
 
-    return retval;
+    for(const RoiSpan& span : mask.GetSpans())
+    {
+        uint32_t offset = span.row * mask.GetWidth() + span.begin;
+        count += count_differences(data + offset, other_data + offset, span.end - span.begin, tolerance);
+
+        if(count > limit)
+        {
+            break;
+        }
+    }
+
+    return count;
 }
 
-int KinectVideoFrame::SaveToJpegInMemory(std::vector<uint8_t>& jpeg_frame, int32_t brightness, int32_t contrast)
+uint32_t KinectDepthFrame::ComputeDifferences(const KinectDepthFrame& other, uint32_t tolerance, const RoiMask& mask, uint32_t limit) const
 {
+    CountDifferencesKernel count_differences = GetCountDifferences();
+    uint32_t count = 0;
+
+    if(mask.GetWidth() != m_width || mask.GetHeight() != m_height)
+    {
+        LOG(LOG_ERR,"ComputeDifferences: mask size %ux%u doesn't match the frame\n", mask.GetWidth(), mask.GetHeight());
+        return 0;
+    }
+
     std::lock_guard<std::mutex> lock_guard(m_mutex);
-    int retval = 0;
-    FIBITMAP *video_bitmap;
-    FIMEMORY *fi_memory = NULL;
-    BYTE *mem_buffer = NULL;
-    DWORD size_in_bytes = 0;
-    std::vector<uint8_t> bmap(m_width * m_height);
 
-    fi_memory = FreeImage_OpenMemory();
+    /* Only the spans of the mask are visited, rows outside the region are never read */
+    for(const RoiSpan& span : mask.GetSpans())
+    {
+        uint32_t offset = span.row * m_width + span.begin;
+        count += count_differences(m_data.data() + offset, other.m_data.data() + offset, span.end - span.begin, tolerance);
 
-    for(uint32_t i = 0;i <  m_width * m_height; i++)
+        if(count > limit)
+        {
+            break;
+        }
+    }
+
+    return count;
+}
+
+uint32_t KinectDepthFrame::ComputeDifferencesWithTolerances(const KinectDepthFrame& other, const uint16_t* tolerances,
+                                                            uint32_t tolerance, uint32_t limit) const
+{
+    CountDifferencesPerPixelKernel count_differences = GetCountDifferencesPerPixel();
+    uint32_t count = 0;
+
+    const uint32_t num_pixels  = m_width * m_height;
+    const uint32_t band_pixels = DIFFERENCES_BAND_ROWS * m_width;
+
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    for(uint32_t offset = 0; offset < num_pixels && count <= limit; offset += band_pixels)
+    {
+        count += count_differences(m_data.data() + offset, other.m_data.data() + offset, tolerances + offset,
+                                   std::min(band_pixels, num_pixels - offset), tolerance);
+    }
+
+    return count;
+}
+
+uint32_t KinectDepthFrame::ComputeDifferencesWithTolerances(const KinectDepthFrame& other, const uint16_t* tolerances,
+                                                            uint32_t tolerance, const RoiMask& mask, uint32_t limit) const
+{
+    CountDifferencesPerPixelKernel count_differences = GetCountDifferencesPerPixel();
+    uint32_t count = 0;
+
+    if(mask.GetWidth() != m_width || mask.GetHeight() != m_height)
     {
-        bmap[i] = (m_data[i] >> 2);
+        LOG(LOG_ERR,"ComputeDifferencesWithTolerances: mask size %ux%u doesn't match the frame\n", mask.GetWidth(), mask.GetHeight());
+        return 0;
     }
 
-    video_bitmap = FreeImage_ConvertFromRawBits(reinterpret_cast<BYTE *>(bmap.data()), m_width, m_height, m_width, 8, 0xFF, 0xFF, 0xFF, true);
-    FreeImage_AdjustBrightness(video_bitmap, brightness);
-    FreeImage_AdjustContrast(video_bitmap, contrast);
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
 
-    if(!FreeImage_SaveToMemory(FIF_JPEG, video_bitmap, fi_memory, 0))
+    for(const RoiSpan& span : mask.GetSpans())
     {
-        retval = true;
+        uint32_t offset = span.row * m_width + span.begin;
+        count += count_differences(m_data.data() + offset, other.m_data.data() + offset, tolerances + offset,
+                                   span.end - span.begin, tolerance);
+
+        if(count > limit)
+        {
+            break;
+        }
     }
 
-    FreeImage_AcquireMemory(fi_memory, &mem_buffer, &size_in_bytes);
-    jpeg_frame.assign(mem_buffer, mem_buffer + size_in_bytes);
+    return count;
+}
 
-    FreeImage_CloseMemory(fi_memory);
-    FreeImage_Unload(video_bitmap);
+uint32_t KinectDepthFrame::ComputeDifferenceMap(const KinectDepthFrame& other, uint32_t tolerance, uint32_t block_size, DifferenceMap& map) const
+{
+    CountDifferencesKernel count_differences = GetCountDifferences();
+    uint32_t count = 0;
+
+    if(block_size == 0)
+    {
+        LOG(LOG_ERR,"ComputeDifferenceMap: invalid block size\n");
+        return 0;
+    }
+
+    map.block_size = block_size;
+    map.columns    = (m_width + block_size - 1) / block_size;
+    map.rows       = (m_height + block_size - 1) / block_size;
+    map.counts.assign(map.columns * map.rows, 0);
+
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    for(uint32_t row = 0; row < m_height; row++)
+    {
+        uint32_t* block_counts = map.counts.data() + (row / block_size) * map.columns;
+        uint32_t offset = row * m_width;
+
+        for(uint32_t column = 0; column < map.columns; column++)
+        {
+            uint32_t begin = column * block_size;
+            uint32_t block_count = count_differences(m_data.data() + offset + begin, other.m_data.data() + offset + begin,
+                                                     std::min(block_size, m_width - begin), tolerance);
+            block_counts[column] += block_count;
+            count += block_count;
+        }
+    }
+
+    return count;
+}
+
+int KinectDepthFrame::SaveToJpegInFile(std::string path, int32_t brightness, int32_t contrast) const
+{
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    /* The colormap shows the distance, brightness and contrast only apply to the video frames */
+    return (0 == GetJpegEncoder().EncodeDepthToFile(GetView(), path)) ? 0 : 1;
+}
+
+int KinectDepthFrame::SaveToJpegInMemory(std::vector<uint8_t>& jpeg_frame, int32_t brightness, int32_t contrast) const
+{
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    return (0 == GetJpegEncoder().EncodeDepth(GetView(), jpeg_frame)) ? 0 : 1;
+}
+
+KinectVideoFrame::KinectVideoFrame(uint32_t width, uint32_t height) : KinectFrame(width, height)
+{
+}
+
+KinectVideoFrame::KinectVideoFrame(const KinectVideoFrame& kinect_depth_frame) : KinectFrame(kinect_depth_frame)
+{
+}
+
+KinectVideoFrame::KinectVideoFrame(KinectVideoFrame&& kinect_video_frame) noexcept : KinectFrame(std::move(kinect_video_frame))
+{
+}
+
+KinectVideoFrame::~KinectVideoFrame()
+{
+}
+
+KinectVideoFrame& KinectVideoFrame::operator=(const KinectVideoFrame& kinect_video_frame)
+{
+    KinectFrame::operator=(kinect_video_frame);
+    return *this;
+}
+
+KinectVideoFrame& KinectVideoFrame::operator=(KinectVideoFrame&& kinect_video_frame) noexcept
+{
+    KinectFrame::operator=(std::move(kinect_video_frame));
+    return *this;
+}
+
+PixelFormat KinectVideoFrame::GetPixelFormat() const
+{
+    return PixelFormat::Ir10Bit;
+}
+
+int KinectVideoFrame::SaveToJpegInFile(std::string path, int32_t brightness, int32_t contrast) const
+{
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    return (0 == GetJpegEncoder().EncodeToFile(GetView(), brightness, contrast, path)) ? 0 : 1;
+}
+
+int KinectVideoFrame::SaveToJpegInMemory(std::vector<uint8_t>& jpeg_frame, int32_t brightness, int32_t contrast) const
+{
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    return (0 == GetJpegEncoder().Encode(GetView(), brightness, contrast, jpeg_frame)) ? 0 : 1;
+}
+
+int SaveSideBySideToJpegInMemory(const KinectDepthFrame& depth_frame, const KinectVideoFrame& video_frame,
+                                 std::vector<uint8_t>& jpeg_frame, int32_t brightness, int32_t contrast)
+{
+    std::scoped_lock lock(depth_frame.m_mutex, video_frame.m_mutex);
 
-    return retval;
+    return (0 == GetJpegEncoder().EncodeSideBySide(depth_frame.GetView(), video_frame.GetView(), brightness, contrast, jpeg_frame)) ? 0 : 1;
 }
@@ -0,0 +1,648 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file kinect_frame_kernels.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNELS_X86
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define KERNELS_NEON
+#endif
+
+#include "kinect_frame_kernels.hpp"
+#include "kinect_frame.hpp"
+#include "log.hpp"
+
+/*******************************************************************
+ * Function definition
+ *******************************************************************/
+uint32_t CountDifferencesScalar(const uint16_t* lhs, const uint16_t* rhs, uint32_t num_pixels, uint32_t tolerance)
+{
+    uint32_t count = 0;
+
+    for(uint32_t i = 0; i < num_pixels; i++)
+    {
+        if((lhs[i] != BLANK_DEPTH_PIXEL) && (rhs[i] != BLANK_DEPTH_PIXEL))
+        {
+            if(static_cast<uint32_t>(std::abs(static_cast<int32_t>(lhs[i]) - rhs[i])) > tolerance)
+            {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+#if defined(KERNELS_X86)
+__attribute__((target("sse4.1,popcnt")))
+static uint32_t CountDifferencesSse41(const uint16_t* lhs, const uint16_t* rhs, uint32_t num_pixels, uint32_t tolerance)
+{
+    /* No 16 bits difference can exceed it */
+    if(tolerance >= UINT16_MAX)
+    {
+        return 0;
+    }
+
+    const __m128i blank = _mm_set1_epi16(BLANK_DEPTH_PIXEL);
+    const __m128i tol   = _mm_set1_epi16(static_cast<int16_t>(tolerance));
+    uint32_t mask_bits  = 0;
+    uint32_t i          = 0;
+
+    for(; i + 8 <= num_pixels; i += 8)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i));
+
+        /* Unsigned absolute difference, it can't overflow */
+        __m128i diff = _mm_sub_epi16(_mm_max_epu16(a, b), _mm_min_epu16(a, b));
+
+        /* diff <= tolerance when max(diff, tolerance) == tolerance */
+        __m128i within = _mm_cmpeq_epi16(_mm_max_epu16(diff, tol), tol);
+        __m128i skip   = _mm_or_si128(within, _mm_or_si128(_mm_cmpeq_epi16(a, blank), _mm_cmpeq_epi16(b, blank)));
+
+        /* Two mask bits per pixel */
+        mask_bits += _mm_popcnt_u32(~_mm_movemask_epi8(skip) & 0xFFFF);
+    }
+
+    return (mask_bits / 2) + CountDifferencesScalar(lhs + i, rhs + i, num_pixels - i, tolerance);
+}
+
+__attribute__((target("avx2,popcnt")))
+static uint32_t CountDifferencesAvx2(const uint16_t* lhs, const uint16_t* rhs, uint32_t num_pixels, uint32_t tolerance)
+{
+    /* No 16 bits difference can exceed it */
+    if(tolerance >= UINT16_MAX)
+    {
+        return 0;
+    }
+
+    const __m256i blank = _mm256_set1_epi16(BLANK_DEPTH_PIXEL);
+    const __m256i tol   = _mm256_set1_epi16(static_cast<int16_t>(tolerance));
+    uint32_t mask_bits  = 0;
+    uint32_t i          = 0;
+
+    for(; i + 16 <= num_pixels; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+
+        /* Unsigned absolute difference, it can't overflow */
+        __m256i diff = _mm256_sub_epi16(_mm256_max_epu16(a, b), _mm256_min_epu16(a, b));
+
+        /* diff <= tolerance when max(diff, tolerance) == tolerance */
+        __m256i within = _mm256_cmpeq_epi16(_mm256_max_epu16(diff, tol), tol);
+        __m256i skip   = _mm256_or_si256(within, _mm256_or_si256(_mm256_cmpeq_epi16(a, blank), _mm256_cmpeq_epi16(b, blank)));
+
+        /* Two mask bits per pixel */
+        mask_bits += _mm_popcnt_u32(~static_cast<uint32_t>(_mm256_movemask_epi8(skip)));
+    }
+
+    return (mask_bits / 2) + CountDifferencesScalar(lhs + i, rhs + i, num_pixels - i, tolerance);
+}
+#endif
+
+#if defined(KERNELS_NEON)
+static uint32_t CountDifferencesNeon(const uint16_t* lhs, const uint16_t* rhs, uint32_t num_pixels, uint32_t tolerance)
+{
+    /* No 16 bits difference can exceed it */
+    if(tolerance >= UINT16_MAX)
+    {
+        return 0;
+    }
+
+    const uint16x8_t blank = vdupq_n_u16(BLANK_DEPTH_PIXEL);
+    const uint16x8_t tol   = vdupq_n_u16(static_cast<uint16_t>(tolerance));
+    uint32x4_t counters    = vdupq_n_u32(0);
+    uint32_t i             = 0;
+
+    for(; i + 8 <= num_pixels; i += 8)
+    {
+        uint16x8_t a = vld1q_u16(lhs + i);
+        uint16x8_t b = vld1q_u16(rhs + i);
+
+        uint16x8_t exceeded = vcgtq_u16(vabdq_u16(a, b), tol);
+        uint16x8_t blanks   = vorrq_u16(vceqq_u16(a, blank), vceqq_u16(b, blank));
+
+        /* Each exceeding pixel adds 1 to the pairwise accumulated counters */
+        counters = vpadalq_u16(counters, vshrq_n_u16(vbicq_u16(exceeded, blanks), 15));
+    }
+
+    uint32_t count = vgetq_lane_u32(counters, 0) + vgetq_lane_u32(counters, 1) +
+                     vgetq_lane_u32(counters, 2) + vgetq_lane_u32(counters, 3);
+
+    return count + CountDifferencesScalar(lhs + i, rhs + i, num_pixels - i, tolerance);
+}
+#endif
+
+CountDifferencesKernel GetCountDifferencesKernel(KernelVariant variant)
+{
+    CountDifferencesKernel kernel = nullptr;
+
+    switch(variant)
+    {
+        case KernelVariant::Scalar:
+            kernel = CountDifferencesScalar;
+            break;
+#if defined(KERNELS_X86)
+        case KernelVariant::Sse41:
+            if(__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("popcnt"))
+            {
+                kernel = CountDifferencesSse41;
+            }
+            break;
+        case KernelVariant::Avx2:
+            if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+            {
+                kernel = CountDifferencesAvx2;
+            }
+            break;
+#endif
+#if defined(KERNELS_NEON)
+        case KernelVariant::Neon:
+            kernel = CountDifferencesNeon;
+            break;
+#endif
+        default:
+            break;
+    }
+
+    return kernel;
+}
+
+uint32_t CountDifferencesPerPixelScalar(const uint16_t* lhs, const uint16_t* rhs, const uint16_t* tolerances,
+                                        uint32_t num_pixels, uint32_t tolerance)
+{
+    uint32_t count = 0;
+
+    for(uint32_t i = 0; i < num_pixels; i++)
+    {
+        if((lhs[i] != BLANK_DEPTH_PIXEL) && (rhs[i] != BLANK_DEPTH_PIXEL))
+        {
+            uint32_t pixel_tolerance = (tolerances[i] > tolerance) ? tolerances[i] : tolerance;
+
+            if(static_cast<uint32_t>(std::abs(static_cast<int32_t>(lhs[i]) - rhs[i])) > pixel_tolerance)
+            {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+#if defined(KERNELS_X86)
+__attribute__((target("sse4.1,popcnt")))
+static uint32_t CountDifferencesPerPixelSse41(const uint16_t* lhs, const uint16_t* rhs, const uint16_t* tolerances,
+                                              uint32_t num_pixels, uint32_t tolerance)
+{
+    /* No 16 bits difference can exceed it */
+    if(tolerance >= UINT16_MAX)
+    {
+        return 0;
+    }
+
+    const __m128i blank = _mm_set1_epi16(BLANK_DEPTH_PIXEL);
+    const __m128i tol   = _mm_set1_epi16(static_cast<int16_t>(tolerance));
+    uint32_t mask_bits  = 0;
+    uint32_t i          = 0;
+
+    for(; i + 8 <= num_pixels; i += 8)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i));
+        __m128i t = _mm_max_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tolerances + i)), tol);
+
+        __m128i diff   = _mm_sub_epi16(_mm_max_epu16(a, b), _mm_min_epu16(a, b));
+        __m128i within = _mm_cmpeq_epi16(_mm_max_epu16(diff, t), t);
+        __m128i skip   = _mm_or_si128(within, _mm_or_si128(_mm_cmpeq_epi16(a, blank), _mm_cmpeq_epi16(b, blank)));
+
+        mask_bits += _mm_popcnt_u32(~_mm_movemask_epi8(skip) & 0xFFFF);
+    }
+
+    return (mask_bits / 2) + CountDifferencesPerPixelScalar(lhs + i, rhs + i, tolerances + i, num_pixels - i, tolerance);
+}
+
+__attribute__((target("avx2,popcnt")))
+static uint32_t CountDifferencesPerPixelAvx2(const uint16_t* lhs, const uint16_t* rhs, const uint16_t* tolerances,
+                                             uint32_t num_pixels, uint32_t tolerance)
+{
+    /* No 16 bits difference can exceed it */
+    if(tolerance >= UINT16_MAX)
+    {
+        return 0;
+    }
+
+    const __m256i blank = _mm256_set1_epi16(BLANK_DEPTH_PIXEL);
+    const __m256i tol   = _mm256_set1_epi16(static_cast<int16_t>(tolerance));
+    uint32_t mask_bits  = 0;
+    uint32_t i          = 0;
+
+    for(; i + 16 <= num_pixels; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+        __m256i t = _mm256_max_epu16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(tolerances + i)), tol);
+
+        __m256i diff   = _mm256_sub_epi16(_mm256_max_epu16(a, b), _mm256_min_epu16(a, b));
+        __m256i within = _mm256_cmpeq_epi16(_mm256_max_epu16(diff, t), t);
+        __m256i skip   = _mm256_or_si256(within, _mm256_or_si256(_mm256_cmpeq_epi16(a, blank), _mm256_cmpeq_epi16(b, blank)));
+
+        mask_bits += _mm_popcnt_u32(~static_cast<uint32_t>(_mm256_movemask_epi8(skip)));
+    }
+
+    return (mask_bits / 2) + CountDifferencesPerPixelScalar(lhs + i, rhs + i, tolerances + i, num_pixels - i, tolerance);
+}
+#endif
+
+#if defined(KERNELS_NEON)
+static uint32_t CountDifferencesPerPixelNeon(const uint16_t* lhs, const uint16_t* rhs, const uint16_t* tolerances,
+                                             uint32_t num_pixels, uint32_t tolerance)
+{
+    /* No 16 bits difference can exceed it */
+    if(tolerance >= UINT16_MAX)
+    {
+        return 0;
+    }
+
+    const uint16x8_t blank = vdupq_n_u16(BLANK_DEPTH_PIXEL);
+    const uint16x8_t tol   = vdupq_n_u16(static_cast<uint16_t>(tolerance));
+    uint32x4_t counters    = vdupq_n_u32(0);
+    uint32_t i             = 0;
+
+    for(; i + 8 <= num_pixels; i += 8)
+    {
+        uint16x8_t a = vld1q_u16(lhs + i);
+        uint16x8_t b = vld1q_u16(rhs + i);
+        uint16x8_t t = vmaxq_u16(vld1q_u16(tolerances + i), tol);
+
+        uint16x8_t exceeded = vcgtq_u16(vabdq_u16(a, b), t);
+        uint16x8_t blanks   = vorrq_u16(vceqq_u16(a, blank), vceqq_u16(b, blank));
+
+        counters = vpadalq_u16(counters, vshrq_n_u16(vbicq_u16(exceeded, blanks), 15));
+    }
+
+    uint32_t count = vgetq_lane_u32(counters, 0) + vgetq_lane_u32(counters, 1) +
+                     vgetq_lane_u32(counters, 2) + vgetq_lane_u32(counters, 3);
+
+    return count + CountDifferencesPerPixelScalar(lhs + i, rhs + i, tolerances + i, num_pixels - i, tolerance);
+}
+#endif
+
+CountDifferencesPerPixelKernel GetCountDifferencesPerPixelKernel(KernelVariant variant)
+{
+    CountDifferencesPerPixelKernel kernel = nullptr;
+
+    switch(variant)
+    {
+        case KernelVariant::Scalar:
+            kernel = CountDifferencesPerPixelScalar;
+            break;
+#if defined(KERNELS_X86)
+        case KernelVariant::Sse41:
+            if(__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("popcnt"))
+            {
+                kernel = CountDifferencesPerPixelSse41;
+            }
+            break;
+        case KernelVariant::Avx2:
+            if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+            {
+                kernel = CountDifferencesPerPixelAvx2;
+            }
+            break;
+#endif
+#if defined(KERNELS_NEON)
+        case KernelVariant::Neon:
+            kernel = CountDifferencesPerPixelNeon;
+            break;
+#endif
+        default:
+            break;
+    }
+
+    return kernel;
+}
+
+void UpdateBackgroundScalar(const uint16_t* frame, float* mean, float* variance, uint16_t* mean_out,
+                            uint16_t* tolerances_out, uint32_t num_pixels, float learning_rate, float k_sigma,
+                            float min_tolerance)
+{
+    const float keep_rate = 1.0f - learning_rate;
+    const float k_sigma_2 = k_sigma * k_sigma;
+    const float min_tolerance_2 = min_tolerance * min_tolerance;
+
+    for(uint32_t i = 0; i < num_pixels; i++)
+    {
+        float m = mean[i];
+        float v = variance[i];
+
+        if(frame[i] != BLANK_DEPTH_PIXEL)
+        {
+            float x = frame[i];
+
+            if(m < 0.0f)
+            {
+                /* First measure of the pixel */
+                m = x;
+                v = 0.0f;
+            }
+            else
+            {
+                float d = x - m;
+                float d_2 = d * d;
+                float bound_2 = k_sigma_2 * v;
+
+                m = m + learning_rate * d;
+                if(d_2 <= ((bound_2 > min_tolerance_2) ? bound_2 : min_tolerance_2))
+                {
+                    v = keep_rate * (v + learning_rate * d_2);
+                }
+            }
+            mean[i]     = m;
+            variance[i] = v;
+        }
+
+        if(m < 0.0f)
+        {
+            mean_out[i]       = BLANK_DEPTH_PIXEL;
+            tolerances_out[i] = 0;
+        }
+        else
+        {
+            float t = k_sigma * std::sqrt(v) + 0.5f;
+
+            mean_out[i]       = static_cast<uint16_t>(m + 0.5f);
+            tolerances_out[i] = (t < static_cast<float>(UINT16_MAX)) ? static_cast<uint16_t>(t) : UINT16_MAX;
+        }
+    }
+}
+
+#if defined(KERNELS_X86)
+__attribute__((target("avx2")))
+static void UpdateBackgroundAvx2(const uint16_t* frame, float* mean, float* variance, uint16_t* mean_out,
+                                 uint16_t* tolerances_out, uint32_t num_pixels, float learning_rate, float k_sigma,
+                                 float min_tolerance)
+{
+    const __m256 rate  = _mm256_set1_ps(learning_rate);
+    const __m256 keep  = _mm256_set1_ps(1.0f - learning_rate);
+    const __m256 k     = _mm256_set1_ps(k_sigma);
+    const __m256 k_2   = _mm256_set1_ps(k_sigma * k_sigma);
+    const __m256 min_2 = _mm256_set1_ps(min_tolerance * min_tolerance);
+    const __m256 zero  = _mm256_setzero_ps();
+    const __m256 half  = _mm256_set1_ps(0.5f);
+    const __m256 limit = _mm256_set1_ps(static_cast<float>(UINT16_MAX));
+    const __m256 blank = _mm256_set1_ps(static_cast<float>(BLANK_DEPTH_PIXEL));
+    const __m256i blank_out = _mm256_set1_epi32(BLANK_DEPTH_PIXEL);
+    uint32_t i = 0;
+
+    for(; i + 8 <= num_pixels; i += 8)
+    {
+        __m256 x = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(frame + i))));
+        __m256 m = _mm256_loadu_ps(mean + i);
+        __m256 v = _mm256_loadu_ps(variance + i);
+
+        __m256 measured = _mm256_cmp_ps(x, blank, _CMP_NEQ_OQ);
+        __m256 first    = _mm256_cmp_ps(m, zero, _CMP_LT_OQ);
+
+        /* Same operation order as the scalar kernel */
+        __m256 d     = _mm256_sub_ps(x, m);
+        __m256 d_2   = _mm256_mul_ps(d, d);
+        __m256 inner = _mm256_cmp_ps(d_2, _mm256_max_ps(_mm256_mul_ps(k_2, v), min_2), _CMP_LE_OQ);
+        __m256 m_upd = _mm256_add_ps(m, _mm256_mul_ps(rate, d));
+        __m256 v_upd = _mm256_blendv_ps(v, _mm256_mul_ps(keep, _mm256_add_ps(v, _mm256_mul_ps(rate, d_2))), inner);
+
+        m_upd = _mm256_blendv_ps(m_upd, x, first);
+        v_upd = _mm256_blendv_ps(v_upd, zero, first);
+        m     = _mm256_blendv_ps(m, m_upd, measured);
+        v     = _mm256_blendv_ps(v, v_upd, measured);
+
+        _mm256_storeu_ps(mean + i, m);
+        _mm256_storeu_ps(variance + i, v);
+
+        __m256i unknown = _mm256_castps_si256(_mm256_cmp_ps(m, zero, _CMP_LT_OQ));
+        __m256i m_out   = _mm256_cvttps_epi32(_mm256_add_ps(m, half));
+        __m256i t_out   = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_add_ps(_mm256_mul_ps(k, _mm256_sqrt_ps(v)), half), limit));
+
+        m_out = _mm256_blendv_epi8(m_out, blank_out, unknown);
+        t_out = _mm256_andnot_si256(unknown, t_out);
+
+        /* packus works per 128 bits lane, the permutation joins the two halves */
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(m_out, t_out), 0xD8);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mean_out + i), _mm256_castsi256_si128(packed));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(tolerances_out + i), _mm256_extracti128_si256(packed, 1));
+    }
+
+    UpdateBackgroundScalar(frame + i, mean + i, variance + i, mean_out + i, tolerances_out + i, num_pixels - i,
+                           learning_rate, k_sigma, min_tolerance);
+}
+#endif
+
+#if defined(KERNELS_NEON) && defined(__aarch64__)
+static void UpdateBackgroundNeon(const uint16_t* frame, float* mean, float* variance, uint16_t* mean_out,
+                                 uint16_t* tolerances_out, uint32_t num_pixels, float learning_rate, float k_sigma,
+                                 float min_tolerance)
+{
+    const float32x4_t rate  = vdupq_n_f32(learning_rate);
+    const float32x4_t keep  = vdupq_n_f32(1.0f - learning_rate);
+    const float32x4_t k     = vdupq_n_f32(k_sigma);
+    const float32x4_t k_2   = vdupq_n_f32(k_sigma * k_sigma);
+    const float32x4_t min_2 = vdupq_n_f32(min_tolerance * min_tolerance);
+    const float32x4_t zero  = vdupq_n_f32(0.0f);
+    const float32x4_t half  = vdupq_n_f32(0.5f);
+    const uint32x4_t blank  = vdupq_n_u32(BLANK_DEPTH_PIXEL);
+    uint32_t i = 0;
+
+    for(; i + 4 <= num_pixels; i += 4)
+    {
+        uint32x4_t raw = vmovl_u16(vld1_u16(frame + i));
+        float32x4_t x  = vcvtq_f32_u32(raw);
+        float32x4_t m  = vld1q_f32(mean + i);
+        float32x4_t v  = vld1q_f32(variance + i);
+
+        uint32x4_t measured = vmvnq_u32(vceqq_u32(raw, blank));
+        uint32x4_t first    = vcltq_f32(m, zero);
+
+        float32x4_t d     = vsubq_f32(x, m);
+        float32x4_t d_2   = vmulq_f32(d, d);
+        uint32x4_t inner  = vcleq_f32(d_2, vmaxq_f32(vmulq_f32(k_2, v), min_2));
+        float32x4_t m_upd = vaddq_f32(m, vmulq_f32(rate, d));
+        float32x4_t v_upd = vbslq_f32(inner, vmulq_f32(keep, vaddq_f32(v, vmulq_f32(rate, d_2))), v);
+
+        m_upd = vbslq_f32(first, x, m_upd);
+        v_upd = vbslq_f32(first, zero, v_upd);
+        m     = vbslq_f32(measured, m_upd, m);
+        v     = vbslq_f32(measured, v_upd, v);
+
+        vst1q_f32(mean + i, m);
+        vst1q_f32(variance + i, v);
+
+        uint32x4_t unknown = vcltq_f32(m, zero);
+        uint32x4_t m_out   = vbslq_u32(unknown, blank, vcvtq_u32_f32(vaddq_f32(m, half)));
+        uint32x4_t t_out   = vbicq_u32(vcvtq_u32_f32(vaddq_f32(vmulq_f32(k, vsqrtq_f32(v)), half)), unknown);
+
+        vst1_u16(mean_out + i, vqmovn_u32(m_out));
+        vst1_u16(tolerances_out + i, vqmovn_u32(t_out));
+    }
+
+    UpdateBackgroundScalar(frame + i, mean + i, variance + i, mean_out + i, tolerances_out + i, num_pixels - i,
+                           learning_rate, k_sigma, min_tolerance);
+}
+#endif
+
+UpdateBackgroundKernel GetUpdateBackgroundKernel(KernelVariant variant)
+{
+    UpdateBackgroundKernel kernel = nullptr;
+
+    switch(variant)
+    {
+        case KernelVariant::Scalar:
+            kernel = UpdateBackgroundScalar;
+            break;
+#if defined(KERNELS_X86)
+        case KernelVariant::Avx2:
+            if(__builtin_cpu_supports("avx2"))
+            {
+                kernel = UpdateBackgroundAvx2;
+            }
+            break;
+#endif
+#if defined(KERNELS_NEON) && defined(__aarch64__)
+        case KernelVariant::Neon:
+            kernel = UpdateBackgroundNeon;
+            break;
+#endif
+        default:
+            break;
+    }
+
+    return kernel;
+}
+
+void ToneMapScalar(const uint16_t* src, uint8_t* dst, uint32_t num_pixels, const uint8_t* lut)
+{
+    for(uint32_t i = 0; i < num_pixels; i++)
+    {
+        dst[i] = lut[src[i] & 0x3FF];
+    }
+}
+
+#if defined(KERNELS_X86)
+__attribute__((target("avx2")))
+static inline __m256i ToneMapLookupAvx2(const uint8_t* lut, __m256i index)
+{
+    const __m256i word_mask = _mm256_set1_epi32(~3);
+    const __m256i byte_mask = _mm256_set1_epi32(3);
+
+    /* Gather the aligned 32 bits word holding each entry, so no lane reads past the table, and shift its byte down */
+    __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(lut), _mm256_and_si256(index, word_mask), 1);
+    __m256i shift = _mm256_slli_epi32(_mm256_and_si256(index, byte_mask), 3);
+
+    return _mm256_and_si256(_mm256_srlv_epi32(words, shift), _mm256_set1_epi32(0xFF));
+}
+
+__attribute__((target("avx2")))
+static void ToneMapAvx2(const uint16_t* src, uint8_t* dst, uint32_t num_pixels, const uint8_t* lut)
+{
+    const __m256i index_mask = _mm256_set1_epi32(0x3FF);
+    uint32_t i = 0;
+
+    for(; i + 16 <= num_pixels; i += 16)
+    {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+
+        __m256i low  = _mm256_and_si256(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(pixels)), index_mask);
+        __m256i high = _mm256_and_si256(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(pixels, 1)), index_mask);
+
+        /* packus works per 128 bits lane, the permutation puts the 16 samples in order */
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(ToneMapLookupAvx2(lut, low), ToneMapLookupAvx2(lut, high)), 0xD8);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         _mm_packus_epi16(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1)));
+    }
+
+    ToneMapScalar(src + i, dst + i, num_pixels - i, lut);
+}
+#endif
+
+ToneMapKernel GetToneMapKernel(KernelVariant variant)
+{
+    ToneMapKernel kernel = nullptr;
+
+    switch(variant)
+    {
+        case KernelVariant::Scalar:
+            kernel = ToneMapScalar;
+            break;
+#if defined(KERNELS_X86)
+        case KernelVariant::Avx2:
+            if(__builtin_cpu_supports("avx2"))
+            {
+                kernel = ToneMapAvx2;
+            }
+            break;
+#endif
+        default:
+            break;
+    }
+
+    return kernel;
+}
+
+ToneMapKernel GetBestToneMapKernel()
+{
+    /* Not every variant has this kernel, the scalar one is always available */
+    static const ToneMapKernel tone_map = []
+    {
+        KernelVariant variant = GetBestKernelVariant();
+        if(GetToneMapKernel(variant) == nullptr)
+        {
+            variant = KernelVariant::Scalar;
+        }
+        LOG(LOG_INFO,"Tone map kernel: %s\n", GetKernelVariantName(variant));
+        return GetToneMapKernel(variant);
+    }();
+
+    return tone_map;
+}
+
+KernelVariant GetBestKernelVariant()
+{
+    KernelVariant variant = KernelVariant::Scalar;
+
+    for(KernelVariant candidate : {KernelVariant::Avx2, KernelVariant::Sse41, KernelVariant::Neon})
+    {
+        if(GetCountDifferencesKernel(candidate) != nullptr)
+        {
+            variant = candidate;
+            break;
+        }
+    }
+
+    return variant;
+}
+
+const char* GetKernelVariantName(KernelVariant variant)
+{
+    switch(variant)
+    {
+        case KernelVariant::Sse41:
+            return "SSE4.1";
+        case KernelVariant::Avx2:
+            return "AVX2";
+        case KernelVariant::Neon:
+            return "NEON";
+        case KernelVariant::Scalar:
+        default:
+            return "Scalar";
+    }
+}
@@ -15,44 +15,189 @@
  * Class definition
  *******************************************************************/
 Liveview::Liveview(std::shared_ptr<IKinect> kinect, std::shared_ptr<LiveviewObserver> liveview_observer, LiveviewConfig liveview_config) :
-    CyclicTask("Liveview", liveview_config.video_frame_interval_ms),
     m_liveview_config(liveview_config),
+    m_mode(liveview_config.mode),
     m_kinect(kinect),
-    m_liveview_observer(liveview_observer)
+    m_liveview_observer(liveview_observer),
+    m_subscription(-1),
+    m_depth_subscription(-1)
 {
-    m_frame = std::make_unique<KinectVideoFrame>(VIDEO_WIDTH,VIDEO_HEIGHT);
 }
 
 Liveview::~Liveview()
 {
+    Stop();
 }
 
 int Liveview::Start()
 {
-    return CyclicTask::Start();
+    int retval = 0;
+
+    if(IsRunning())
+    {
+        LOG(LOG_INFO,"Liveview is already started\n");
+    }
+    else if(0 != Subscribe())
+    {
+        retval = -1;
+    }
+    else
+    {
+        LOG(LOG_INFO,"Liveview started successfully\n");
+    }
+
+    return retval;
 }
 
 int Liveview::Stop()
 {
-    return CyclicTask::Stop();
+    int retval = 0;
+    bool running = IsRunning();
+
+    if(m_subscription >= 0)
+    {
+        if(0 != m_kinect->Unsubscribe(m_subscription))
+        {
+            LOG(LOG_ERR,"Liveview: Unsubscribe() failed\n");
+            retval = -1;
+        }
+        m_subscription = -1;
+    }
+
+    if(m_depth_subscription >= 0)
+    {
+        if(0 != m_kinect->Unsubscribe(m_depth_subscription))
+        {
+            LOG(LOG_ERR,"Liveview: Unsubscribe() failed\n");
+            retval = -1;
+        }
+        m_depth_subscription = -1;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock_guard(m_depth_frame_mutex);
+        m_last_depth_frame.reset();
+    }
+
+    if(running)
+    {
+        LOG(LOG_INFO,"Liveview stopped successfully\n");
+    }
+
+    return retval;
 }
 
 bool Liveview::IsRunning()
 {
-    return CyclicTask::IsRunning();
+    return (m_subscription >= 0) || (m_depth_subscription >= 0);
 }
 
 void Liveview::UpdateConfig(AlarmModuleConfig& config)
 {
-    m_liveview_config = dynamic_cast<LiveviewConfig&>(config);
+    LiveviewConfig& liveview_config = dynamic_cast<LiveviewConfig&>(config);
+
+    if(IsRunning() && (liveview_config.mode != m_liveview_config.mode))
+    {
+        /* Other streams are needed, the callbacks must be stopped before the mode changes */
+        Stop();
+        m_liveview_config = liveview_config;
+        Start();
+    }
+    else
+    {
+        m_liveview_config = liveview_config;
 
-    CyclicTask::ChangeLoopInterval(m_liveview_config.video_frame_interval_ms);
+        if(m_subscription >= 0)
+        {
+            m_kinect->ChangeDecimation(m_subscription, FrameDecimation(m_liveview_config.video_frame_interval_ms));
+        }
+        if(m_depth_subscription >= 0)
+        {
+            m_kinect->ChangeDecimation(m_depth_subscription, FrameDecimation(m_liveview_config.video_frame_interval_ms));
+        }
+    }
 }
 
-void Liveview::ExecutionCycle()
+int Liveview::Subscribe()
 {
-    m_kinect->GetVideoFrame(*m_frame);
-    LOG(LOG_DEBUG,"Liveview cycle: frame taken\n");
+    LiveviewMode mode = m_liveview_config.mode;
+    uint32_t decimation = FrameDecimation(m_liveview_config.video_frame_interval_ms);
+
+    /* Fixed until the next Start, a change of mode stops the subscriptions first */
+    m_mode = mode;
 
-    m_liveview_observer->NewFrame(*m_frame);
-}
\ No newline at end of file
+    /* Driven by the arrival of frames, one of each decimation */
+    if(mode == LiveviewMode::Video || mode == LiveviewMode::SideBySide)
+    {
+        m_subscription = m_kinect->SubscribeVideoFrames([this](std::shared_ptr<const KinectVideoFrame> frame){ NewVideoFrame(frame); },
+                                                        decimation, {LIVEVIEW_QUEUE_SIZE, FrameDropPolicy::DropOldest});
+        if(m_subscription < 0)
+        {
+            LOG(LOG_ERR,"Liveview: SubscribeVideoFrames() failed\n");
+            return -1;
+        }
+    }
+
+    if(mode == LiveviewMode::Depth || mode == LiveviewMode::SideBySide)
+    {
+        m_depth_subscription = m_kinect->SubscribeDepthFrames([this](std::shared_ptr<const KinectDepthFrame> frame){ NewDepthFrame(frame); },
+                                                              decimation, {LIVEVIEW_QUEUE_SIZE, FrameDropPolicy::DropOldest});
+        if(m_depth_subscription < 0)
+        {
+            LOG(LOG_ERR,"Liveview: SubscribeDepthFrames() failed\n");
+            Stop();
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void Liveview::NewVideoFrame(std::shared_ptr<const KinectVideoFrame> frame)
+{
+    LOG(LOG_DEBUG,"Liveview: frame received\n");
+
+    if(frame == nullptr)
+    {
+        return;
+    }
+
+    if(m_mode == LiveviewMode::SideBySide)
+    {
+        std::shared_ptr<const KinectDepthFrame> depth_frame;
+        {
+            std::lock_guard<std::mutex> lock_guard(m_depth_frame_mutex);
+            depth_frame = m_last_depth_frame;
+        }
+
+        /* Paired with the latest depth frame, nothing is sent until the first one arrives */
+        if(depth_frame != nullptr)
+        {
+            m_liveview_observer->NewSideBySideFrame(*depth_frame, *frame);
+        }
+    }
+    else
+    {
+        m_liveview_observer->NewFrame(*frame);
+    }
+}
+
+void Liveview::NewDepthFrame(std::shared_ptr<const KinectDepthFrame> frame)
+{
+    LOG(LOG_DEBUG,"Liveview: depth frame received\n");
+
+    if(frame == nullptr)
+    {
+        return;
+    }
+
+    if(m_mode == LiveviewMode::SideBySide)
+    {
+        std::lock_guard<std::mutex> lock_guard(m_depth_frame_mutex);
+        m_last_depth_frame = frame;
+    }
+    else
+    {
+        m_liveview_observer->NewDepthFrame(*frame);
+    }
+}
@@ -0,0 +1,232 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file local_message_broker.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <algorithm>
+
+#include "local_message_broker.hpp"
+#include "global_parameters.hpp"
+#include "log.hpp"
+
+/*******************************************************************
+ * Class definition
+ *******************************************************************/
+LocalMessageBroker::LocalMessageBroker() :
+    m_observer_map(std::make_shared<const ObserverMap>()),
+    m_outbound_queue(MESSAGE_BROKER_QUEUE_SIZE)
+{
+    m_delivery_thread = std::make_unique<std::thread>(&LocalMessageBroker::ProccessDelivery, this);
+
+    LOG(LOG_INFO,"Local message broker created\n");
+}
+
+LocalMessageBroker::~LocalMessageBroker()
+{
+    /* Deliver what is still queued */
+    if(0 != Flush(MESSAGE_BROKER_FLUSH_TIMEOUT_MS))
+    {
+        LOG(LOG_WARNING,"Messages not delivered before closing\n");
+    }
+    m_outbound_queue.Close();
+    m_delivery_thread->join();
+}
+
+void LocalMessageBroker::ProccessDelivery()
+{
+    std::vector<OutboundCommand> batch;
+
+    while(0 == m_outbound_queue.PopBatch(batch, MESSAGE_BROKER_PIPELINE_DEPTH, 1000))
+    {
+        for(const OutboundCommand& command : batch)
+        {
+            Deliver(command);
+            m_outbound_queue.Complete(command, true);
+        }
+    }
+}
+
+void LocalMessageBroker::Deliver(const OutboundCommand& command)
+{
+    /* Without the lock, a (un)subscription in progress only delays the delivery to the new snapshot */
+    std::shared_ptr<const ObserverMap> observer_map = std::atomic_load(&m_observer_map);
+
+    auto it = observer_map->find(command.channel);
+    if(it != observer_map->end())
+    {
+        for(const auto& observer : it->second)
+        {
+            observer->ChannelMessageListener(command.commands[0][2]);
+        }
+    }
+}
+
+int LocalMessageBroker::QueueMessage(const std::string& channel, std::string message)
+{
+    bool stream = IsStreamChannel(channel);
+
+    if(0 != m_outbound_queue.Push({channel, {{"PUBLISH", channel, std::move(message)}},
+                                   stream ? OutboundPriority::Liveview : OutboundPriority::Alarm, stream, {}}))
+    {
+        LOG(LOG_WARNING,"Delivery queue full, message to %s dropped\n", channel.c_str());
+        return -1;
+    }
+
+    return 0;
+}
+
+int LocalMessageBroker::StoreVariables(const std::vector<Variable>& variables, int livetime_seconds)
+{
+    std::vector<std::string> values(variables.size());
+    std::chrono::steady_clock::time_point expiration = std::chrono::steady_clock::now() + std::chrono::seconds(livetime_seconds);
+
+    /* All or none of them are set */
+    for(size_t i = 0; i < variables.size(); i++)
+    {
+        if(0 != VariableToString(variables[i], values[i]))
+        {
+            return -1;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_variables_mutex);
+
+    for(size_t i = 0; i < variables.size(); i++)
+    {
+        m_variables[variables[i].name] = {std::move(values[i]), livetime_seconds > 0, expiration};
+    }
+
+    return 0;
+}
+
+int LocalMessageBroker::Flush(uint32_t timeout_ms)
+{
+    return m_outbound_queue.WaitEmpty(timeout_ms) ? 0 : -1;
+}
+
+std::vector<OutboundChannelStats> LocalMessageBroker::GetOutboundStats() const
+{
+    return m_outbound_queue.GetStats();
+}
+
+int LocalMessageBroker::Subscribe(const std::string& channel, const std::shared_ptr<IChannelMessageObserver> observer)
+{
+    if(observer == nullptr)
+    {
+        LOG(LOG_ERR,"Subscribe() failed: obs null\n");
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(m_observer_mutex);
+    std::shared_ptr<ObserverMap> observer_map = std::make_shared<ObserverMap>(*m_observer_map);
+
+    (*observer_map)[channel].push_back(observer);
+    std::atomic_store(&m_observer_map, std::shared_ptr<const ObserverMap>(observer_map));
+
+    LOG(LOG_INFO,"Local subscription success: channel %s observer %p\n", channel.c_str(), observer.get());
+
+    return 0;
+}
+
+int LocalMessageBroker::Unsubscribe(const std::string& channel, const std::shared_ptr<IChannelMessageObserver> observer)
+{
+    std::lock_guard<std::mutex> lock(m_observer_mutex);
+    std::shared_ptr<ObserverMap> observer_map = std::make_shared<ObserverMap>(*m_observer_map);
+
+    auto map_it = observer_map->find(channel);
+    if(map_it == observer_map->end())
+    {
+        return -1;
+    }
+
+    Observers& observers = map_it->second;
+    auto vec_it = std::find(observers.begin(), observers.end(), observer);
+    if(vec_it == observers.end())
+    {
+        return -1;
+    }
+
+    observers.erase(vec_it);
+    if(observers.empty())
+    {
+        observer_map->erase(map_it);
+    }
+    std::atomic_store(&m_observer_map, std::shared_ptr<const ObserverMap>(observer_map));
+
+    LOG(LOG_INFO,"Local unsubscription success: channel %s observer %p\n", channel.c_str(), observer.get());
+
+    return 0;
+}
+
+int LocalMessageBroker::Publish(const std::string& channel, const std::string& message)
+{
+    return QueueMessage(channel, message);
+}
+
+int LocalMessageBroker::PublishBinary(const std::string& channel, const uint8_t* data, size_t size)
+{
+    return QueueMessage(channel, std::string(reinterpret_cast<const char*>(data), size));
+}
+
+int LocalMessageBroker::GetVariable(Variable& variable)
+{
+    std::shared_lock<std::shared_mutex> lock(m_variables_mutex);
+
+    auto it = m_variables.find(variable.name);
+    if(it == m_variables.end())
+    {
+        return -1;
+    }
+    /* Expired variables are left until they are set again or cleared */
+    else if(it->second.expires && std::chrono::steady_clock::now() >= it->second.expiration)
+    {
+        return -1;
+    }
+
+    return StringToVariable(it->second.value, variable);
+}
+
+int LocalMessageBroker::SetVariable(const Variable& variable)
+{
+    return StoreVariables({variable}, 0);
+}
+
+int LocalMessageBroker::SetVariableExpiration(const Variable& variable, int livetime_seconds)
+{
+    if(livetime_seconds <= 0)
+    {
+        return -1;
+    }
+
+    return StoreVariables({variable}, livetime_seconds);
+}
+
+int LocalMessageBroker::SetVariables(const std::vector<Variable>& variables)
+{
+    return StoreVariables(variables, 0);
+}
+
+int LocalMessageBroker::SetVariablesAndPublish(const std::vector<Variable>& variables, const std::string& channel, const std::string& message)
+{
+    /* The variables are set before the message is queued, the observers read the new values */
+    if(0 != StoreVariables(variables, 0))
+    {
+        return -1;
+    }
+
+    return QueueMessage(channel, message);
+}
+
+int LocalMessageBroker::Clear()
+{
+    std::unique_lock<std::shared_mutex> lock(m_variables_mutex);
+
+    m_variables.clear();
+
+    return 0;
+}
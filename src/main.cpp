@@ -33,11 +33,15 @@ enum class Target
 {
     Detection,
     Liveview,
+    LiveviewMode,
+    LiveviewBase64,
     Tilt,
     Brightness,
     Contrast,
     Threshold,
-    Sensitivity
+    Sensitivity,
+    Zone,
+    HeatMap
 };
 
 enum class Action
@@ -45,18 +49,30 @@ enum class Action
     Start,
     Stop,
     Reset,
-    Delete
+    Delete,
+    Set
 };
 
 const std::map<std::string, Target> parameter_map
 {
     {"det",         Target::Detection},
     {"lvw",         Target::Liveview},
+    {"lvwmode",     Target::LiveviewMode},
+    {"lvwb64",      Target::LiveviewBase64},
     {"tilt",        Target::Tilt},
     {"brightness",  Target::Brightness},
     {"contrast",    Target::Contrast},
     {"threshold",   Target::Threshold},
     {"sensitivity", Target::Sensitivity},
+    {"zone",        Target::Zone},
+    {"heatmap",     Target::HeatMap},
+};
+
+const std::map<std::string, LiveviewMode> liveview_mode_map
+{
+    {"video", LiveviewMode::Video},
+    {"depth", LiveviewMode::Depth},
+    {"sbs",   LiveviewMode::SideBySide},
 };
 
 const std::map<std::string, Action> action_map
@@ -65,6 +81,7 @@ const std::map<std::string, Action> action_map
     {"stop",  Action::Stop},
     {"rst",   Action::Reset},
     {"del",   Action::Delete},
+    {"set",   Action::Set},
 };
 
 /*******************************************************************
@@ -111,7 +128,7 @@ Main::Main() :
         throw std::exception();
     }
     /* Create Redis DB object */
-    else if(nullptr == (m_message_broker = MessageBrokerFactory::Create(REDIS_DB_PATH)))
+    else if(nullptr == (m_message_broker = MessageBrokerFactory::Create(REDIS_DB_PATH, MESSAGE_BROKER_TYPE)))
     {
         LOG(LOG_ERR, "Error creating MessageBroker object on path: %s\n", REDIS_DB_PATH);
         throw std::exception();
@@ -201,6 +218,9 @@ int Main::Term()
 void Main::ExecutionCycle()
 {
     m_message_broker->SetVariableExpiration({"kinectalarm_watchdog",  DataType::Integer, 1}, WATCHDOG_TIMEOUT_S);
+
+    /* Frame drops and latency over the last watchdog period */
+    m_alarm->PublishFrameStats();
 }
 
 void signalHandler(int signal)
@@ -337,6 +357,23 @@ void MessageListener::ChannelMessageListener(const std::string& message)
                         break;
                 }
                 break;
+            case Target::LiveviewMode:
+                m_main.m_alarm->ChangeLiveviewMode(liveview_mode_map.at(command_words.at(1)));
+                break;
+            case Target::LiveviewBase64:
+                action = action_map.at(command_words.at(1));
+                switch(action)
+                {
+                    case Action::Start:
+                        m_main.m_alarm->EnableLiveviewBase64(true);
+                        break;
+                    case Action::Stop:
+                        m_main.m_alarm->EnableLiveviewBase64(false);
+                        break;
+                    default:
+                        break;
+                }
+                break;
             case Target::Tilt:
                 value = std::stoi(command_words.at(1));
                 m_main.m_alarm->ChangeTilt(value);
@@ -357,6 +394,47 @@ void MessageListener::ChannelMessageListener(const std::string& message)
                 value = std::stoi(command_words.at(1));
                 m_main.m_alarm->ChangeSensitivity(value);
                 break;
+            case Target::Zone:
+                /* zone set {id} {threshold} {sensitivity} {x1} {y1} {x2} {y2} {x3} {y3} ... */
+                action = action_map.at(command_words.at(1));
+                switch(action)
+                {
+                    case Action::Set:
+                    {
+                        std::vector<RoiPoint> polygon;
+                        for(size_t i = 5; i + 1 < command_words.size(); i += 2)
+                        {
+                            polygon.push_back({std::stoi(command_words.at(i)), std::stoi(command_words.at(i + 1))});
+                        }
+                        m_main.m_alarm->SetDetectionZone(std::stoi(command_words.at(2)), std::stoi(command_words.at(3)),
+                                                         std::stoi(command_words.at(4)), polygon);
+                        break;
+                    }
+                    case Action::Delete:
+                        value = std::stoi(command_words.at(2));
+                        m_main.m_alarm->DeleteDetectionZone(value);
+                        break;
+                    case Action::Reset:
+                        m_main.m_alarm->ResetDetectionZones();
+                        break;
+                    default:
+                        break;
+                }
+                break;
+            case Target::HeatMap:
+                action = action_map.at(command_words.at(1));
+                switch(action)
+                {
+                    case Action::Start:
+                        m_main.m_alarm->EnableHeatMap(true);
+                        break;
+                    case Action::Stop:
+                        m_main.m_alarm->EnableHeatMap(false);
+                        break;
+                    default:
+                        break;
+                }
+                break;
             default:
                 break;
         }
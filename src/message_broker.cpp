@@ -14,6 +14,7 @@
 #include <signal.h>
 
 #include "message_broker.hpp"
+#include "global_parameters.hpp"
 
 /*******************************************************************
  * Static functions
@@ -58,7 +59,7 @@ static void OnMessage(redisAsyncContext *redis_context, void *replay, void *data
                reply->element[2]->type == REDIS_REPLY_STRING)
             {
                 std::string channel(reply->element[1]->str);
-                std::string messsage(reply->element[2]->str);
+                std::string messsage(reply->element[2]->str, reply->element[2]->len);
                 if(0 != message_broker->CallObservers(channel, messsage))
                 {
                     LOG(LOG_ERR, "Failed to call observers\n");
@@ -72,10 +73,54 @@ static void OnMessage(redisAsyncContext *redis_context, void *replay, void *data
     }
 }
 
+/* Intrusions go before the watchdog and the state. The variables published with them aren't written from the
+   State lane, so they can't be reordered with it */
+static bool IsAlarmEventChannel(const std::string& channel)
+{
+    return channel == REDIS_DET_INTRUSION_CHANNEL;
+}
+
+/* Key of a set of variables, a newer write of the same ones replaces the queued one */
+static std::string VariablesKey(const std::vector<Variable>& variables)
+{
+    std::string key;
+
+    for(const Variable& variable : variables)
+    {
+        if(!key.empty())
+        {
+            key += ",";
+        }
+        key += variable.name;
+    }
+
+    return key;
+}
+
+static int VariablesToMset(const std::vector<Variable>& variables, std::vector<std::string>& mset)
+{
+    mset = {"MSET"};
+
+    for(const Variable& variable : variables)
+    {
+        std::string value;
+
+        if(0 != VariableToString(variable, value))
+        {
+            return -1;
+        }
+        mset.push_back(variable.name);
+        mset.push_back(value);
+    }
+
+    return 0;
+}
+
 /*******************************************************************
  * Class definition
  *******************************************************************/
-MessageBroker::MessageBroker(const std::string path)
+MessageBroker::MessageBroker(const std::string path) :
+    m_outbound_queue(MESSAGE_BROKER_QUEUE_SIZE)
 {
     /* Init sync context*/
     m_context = redisConnectUnix(path.c_str());
@@ -92,6 +137,16 @@ MessageBroker::MessageBroker(const std::string path)
         throw std::exception();
     }
 
+    /* Init outbound context */
+    m_outbound_context = redisConnectUnix(path.c_str());
+    if(m_outbound_context == NULL || m_outbound_context->err)
+    {
+        LOG(LOG_ERR,"redisConnectUnix() failed for the outbound context\n");
+        redisFree(m_outbound_context);
+        redisFree(m_context);
+        throw std::exception();
+    }
+
     /* Init Async context*/
 
     /* TODO: Received SIGPIPE */
@@ -122,6 +177,9 @@ MessageBroker::MessageBroker(const std::string path)
         LOG(LOG_ERR,"redisLibeventAttach() failed: %s\n", m_async_context->errstr);
         throw std::exception();
     }
+
+    m_last_stats_report = std::chrono::steady_clock::now();
+    m_outbound_thread = std::make_unique<std::thread>(&MessageBroker::ProccessOutbound, this);
 }
 
 MessageBroker::~MessageBroker()
@@ -137,9 +195,151 @@ MessageBroker::~MessageBroker()
         m_proccess_async_events_thread->join();
     }
 
+    /* Send what is still queued */
+    if(0 != Flush(MESSAGE_BROKER_FLUSH_TIMEOUT_MS))
+    {
+        LOG(LOG_WARNING,"Outbound commands not sent before closing\n");
+    }
+    m_outbound_queue.Close();
+    m_outbound_thread->join();
+    ReportOutboundStats();
+
+    redisFree(m_outbound_context);
     redisFree(m_context);
 }
 
+void MessageBroker::ProccessOutbound()
+{
+    std::vector<OutboundCommand> batch;
+
+    /* Wakes up on timeout to report the statistics */
+    while(0 == m_outbound_queue.PopBatch(batch, MESSAGE_BROKER_PIPELINE_DEPTH, 1000))
+    {
+        SendOutbound(batch);
+
+        if(std::chrono::steady_clock::now() - m_last_stats_report >= std::chrono::seconds(MESSAGE_BROKER_STATS_INTERVAL_S))
+        {
+            ReportOutboundStats();
+            m_last_stats_report = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+void MessageBroker::SendOutbound(std::vector<OutboundCommand>& batch)
+{
+    bool connected = true;
+
+    /* Write the whole batch and then read the replies, a single round trip */
+    for(const OutboundCommand& command : batch)
+    {
+        bool transaction = command.commands.size() > 1;
+
+        if(transaction)
+        {
+            connected = connected && (0 == AppendOutbound({"MULTI"}));
+        }
+        for(const auto& args : command.commands)
+        {
+            connected = connected && (0 == AppendOutbound(args));
+        }
+        if(transaction)
+        {
+            connected = connected && (0 == AppendOutbound({"EXEC"}));
+        }
+    }
+
+    for(const OutboundCommand& command : batch)
+    {
+        bool success = false;
+
+        /* Once a reply can't be read the ones left can't either */
+        connected = connected && (0 == ReadOutboundReplies(command, success));
+
+        m_outbound_queue.Complete(command, connected && success);
+    }
+
+    if(!connected)
+    {
+        LOG(LOG_ERR,"Outbound connection failed: %s, reconnecting\n", m_outbound_context->errstr);
+        if(REDIS_OK != redisReconnect(m_outbound_context))
+        {
+            LOG(LOG_ERR,"redisReconnect() failed\n");
+        }
+    }
+}
+
+int MessageBroker::AppendOutbound(const std::vector<std::string>& args)
+{
+    std::vector<const char*> argv;
+    std::vector<size_t> argv_len;
+
+    for(const std::string& arg : args)
+    {
+        argv.push_back(arg.data());
+        argv_len.push_back(arg.size());
+    }
+
+    return (REDIS_OK == redisAppendCommandArgv(m_outbound_context, argv.size(), argv.data(), argv_len.data())) ? 0 : -1;
+}
+
+int MessageBroker::ReadOutboundReplies(const OutboundCommand& command, bool& success)
+{
+    /* A transaction replies to MULTI, queues each command and replies to EXEC with all the results */
+    size_t num_replies = (command.commands.size() > 1) ? command.commands.size() + 2 : 1;
+
+    success = true;
+    for(size_t i = 0; i < num_replies; i++)
+    {
+        redisReply *reply = nullptr;
+
+        if(REDIS_OK != redisGetReply(m_outbound_context, reinterpret_cast<void**>(&reply)))
+        {
+            return -1;
+        }
+
+        /* EXEC replies nil if the transaction was aborted */
+        if(reply == nullptr || reply->type == REDIS_REPLY_ERROR || ((i == num_replies - 1) && reply->type == REDIS_REPLY_NIL))
+        {
+            success = false;
+        }
+        freeReplyObject(reply);
+    }
+
+    return 0;
+}
+
+void MessageBroker::ReportOutboundStats()
+{
+    for(const OutboundChannelStats& stats : m_outbound_queue.GetStats())
+    {
+        LOG(LOG_INFO,"Outbound %s: %u queued, %llu sent, %llu failed, %llu dropped, %llu coalesced, %.2f ms average, %.2f ms max\n",
+            stats.channel.c_str(), stats.depth, static_cast<unsigned long long>(stats.sent),
+            static_cast<unsigned long long>(stats.failed), static_cast<unsigned long long>(stats.dropped),
+            static_cast<unsigned long long>(stats.coalesced), stats.average_latency_ms, stats.max_latency_ms);
+    }
+}
+
+int MessageBroker::QueueCommands(const std::string& channel, std::vector<std::vector<std::string>> commands, OutboundPriority priority, bool coalesce)
+{
+    if(0 != m_outbound_queue.Push({channel, std::move(commands), priority, coalesce, {}}))
+    {
+        LOG(LOG_WARNING,"Outbound queue full, command to %s dropped\n", channel.c_str());
+        return -1;
+    }
+
+    return 0;
+}
+
+int MessageBroker::Flush(uint32_t timeout_ms)
+{
+    return m_outbound_queue.WaitEmpty(timeout_ms) ? 0 : -1;
+}
+
+std::vector<OutboundChannelStats> MessageBroker::GetOutboundStats() const
+{
+    return m_outbound_queue.GetStats();
+}
+
 void MessageBroker::ProccessAsyncEvents()
 {
     event_base_dispatch(m_event_base);
@@ -282,25 +482,27 @@ int MessageBroker::Unsubscribe(const std::string& channel, const std::shared_ptr
 
 int MessageBroker::Publish(const std::string& channel, const std::string& message)
 {
-    int retval = 0;
+    bool stream = IsStreamChannel(channel);
 
-    std::lock_guard<std::mutex> lock(m_context_mutex);
-
-    redisReply* reply = (redisReply *) redisCommand(m_context, "PUBLISH %s %s", channel.c_str(), message.c_str());
-    if(reply != nullptr && reply->type == REDIS_REPLY_ERROR)
-    {
-        retval = -1;
-    }
+    return QueueCommands(channel, {{"PUBLISH", channel, message}}, stream ? OutboundPriority::Liveview : OutboundPriority::Alarm, stream);
+}
 
-    freeReplyObject(reply);
+int MessageBroker::PublishBinary(const std::string& channel, const uint8_t* data, size_t size)
+{
+    /* Sent with its length, the data may hold any byte */
+    bool stream = IsStreamChannel(channel);
 
-    return retval;
+    return QueueCommands(channel, {{"PUBLISH", channel, std::string(reinterpret_cast<const char*>(data), size)}},
+                         stream ? OutboundPriority::Liveview : OutboundPriority::Alarm, stream);
 }
 
 int MessageBroker::GetVariable(Variable& variable)
 {
     int retval = 0;
 
+    /* Read after the queued writes */
+    Flush(MESSAGE_BROKER_FLUSH_TIMEOUT_MS);
+
     std::lock_guard<std::mutex> lock(m_context_mutex);
 
     redisReply *reply = (redisReply *) redisCommand(m_context,"GET %s",variable.name.c_str());
@@ -310,28 +512,7 @@ int MessageBroker::GetVariable(Variable& variable)
     }
     else
     {
-        try
-        {
-            switch(variable.data_type)
-            {
-                case DataType::Integer:
-                    variable.value = std::stoi(std::string(reply->str), nullptr);
-                    break;
-                case DataType::Float:
-                    variable.value = std::stof(std::string(reply->str), nullptr);
-                    break;
-                case DataType::String:
-                    variable.value = std::string(reply->str);
-                    break;
-                case DataType::Boolean:
-                    variable.value = std::string(reply->str) == "true" ? true : false;
-                    break;
-            }
-        }
-        catch(...)
-        {
-            retval = -1;
-        }
+        retval = StringToVariable(std::string(reply->str, reply->len), variable);
     }
 
     freeReplyObject(reply);
@@ -340,91 +521,74 @@ int MessageBroker::GetVariable(Variable& variable)
 
 int MessageBroker::SetVariable(const Variable& variable)
 {
-    int retval = 0;
+    std::string value;
+
+    if(0 != VariableToString(variable, value))
+    {
+        return -1;
+    }
 
+    /* Only the last value of a variable matters */
+    return QueueCommands(variable.name, {{"SET", variable.name, value}}, OutboundPriority::State, true);
+}
+
+int MessageBroker::SetVariableExpiration(const Variable& variable, int livetime_seconds)
+{
     std::string value;
-    try
+
+    if(0 != VariableToString(variable, value))
     {
-        switch(variable.data_type)
-        {
-            /*TODO unify conversion to from string to value and viceversa*/
-            case DataType::Integer:
-            value = std::to_string(std::get<int>(variable.value));
-            break;
-            case DataType::Float:
-            value = std::to_string(std::get<float>(variable.value));
-            break;
-            case DataType::String:
-            value = std::get<std::string>(variable.value);
-            break;
-            case DataType::Boolean:
-            value = std::get<bool>(variable.value) == true ? "true" : "false";
-            break;
-        }
-        std::lock_guard<std::mutex> lock(m_context_mutex);
+        return -1;
+    }
 
-        redisReply *reply = (redisReply *) redisCommand(m_context,"SET %s %s", variable.name.c_str(), value.c_str());
-        if(reply->type == REDIS_REPLY_ERROR)
-        {
-            retval = -1;
-        }
+    /* Expiring variables are keep-alives, e.g. the watchdog */
+    return QueueCommands(variable.name, {{"SETEX", variable.name, std::to_string(livetime_seconds), value}}, OutboundPriority::Watchdog, true);
+}
 
-        freeReplyObject(reply);
+int MessageBroker::SetVariables(const std::vector<Variable>& variables)
+{
+    std::vector<std::string> mset;
+
+    if(variables.empty())
+    {
+        return 0;
     }
-    catch(...)
+    else if(0 != VariablesToMset(variables, mset))
     {
-        LOG(LOG_INFO,"Exception raised\n");
-        retval = -1;
+        return -1;
     }
 
-    return retval;
+    /* Only the last values matter, e.g. the periodic statistics don't pile up if Redis stalls */
+    return QueueCommands(VariablesKey(variables), {mset}, OutboundPriority::State, true);
 }
 
-int MessageBroker::SetVariableExpiration(const Variable& variable, int livetime_seconds)
+int MessageBroker::SetVariablesAndPublish(const std::vector<Variable>& variables, const std::string& channel, const std::string& message)
 {
-    int retval = 0;
+    std::vector<std::vector<std::string>> commands;
+    std::vector<std::string> mset;
 
-    std::string value;
-    try
+    if(!variables.empty())
     {
-        switch(variable.data_type)
+        if(0 != VariablesToMset(variables, mset))
         {
-            case DataType::Integer:
-            value = std::to_string(std::get<int>(variable.value));
-            break;
-            case DataType::Float:
-            value = std::to_string(std::get<float>(variable.value));
-            break;
-            case DataType::String:
-            value = std::get<std::string>(variable.value);
-            break;
-            case DataType::Boolean:
-            value = std::get<bool>(variable.value) == true ? "true" : "false";
-            break;
+            return -1;
         }
-        std::lock_guard<std::mutex> lock(m_context_mutex);
-
-        redisReply *reply = (redisReply *) redisCommand(m_context,"SETEX %s %d %s", variable.name.c_str(), livetime_seconds, value.c_str());
-        if(reply->type == REDIS_REPLY_ERROR)
-        {
-            retval = -1;
-        }
-
-        freeReplyObject(reply);
-    }
-    catch(...)
-    {
-        LOG(LOG_INFO,"Exception raised\n");
-        retval = -1;
+        commands.push_back(mset);
     }
+    commands.push_back({"PUBLISH", channel, message});
 
-    return retval;
+    /* The message never arrives before the variables, they are a single transaction. Besides the alarm events it
+       goes in the lane of the variables set one by one, so it isn't reordered with them */
+    return QueueCommands(channel, commands, IsAlarmEventChannel(channel) ? OutboundPriority::Alarm : OutboundPriority::State, false);
 }
 
 int MessageBroker::Clear()
 {
     int retval = 0;
 
+    /* Don't let queued writes land after the flush */
+    Flush(MESSAGE_BROKER_FLUSH_TIMEOUT_MS);
+
     std::lock_guard<std::mutex> lock(m_context_mutex);
 
     redisReply *reply = (redisReply *) redisCommand(m_context,"flushall");
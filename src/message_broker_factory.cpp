@@ -12,12 +12,18 @@
 
 #include "message_broker_factory.hpp"
 #include "message_broker.hpp"
+#include "local_message_broker.hpp"
 
 /*******************************************************************
  * Class definition
  *******************************************************************/
 
-std::shared_ptr<IMessageBroker> MessageBrokerFactory::Create(std::string path)
+std::shared_ptr<IMessageBroker> MessageBrokerFactory::Create(std::string path, MessageBrokerType type)
 {
+    if(type == MessageBrokerType::Local)
+    {
+        return std::make_shared<LocalMessageBroker>();
+    }
+
     return std::make_shared<MessageBroker>(path);
 }
@@ -0,0 +1,187 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file outbound_queue.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <algorithm>
+
+#include "outbound_queue.hpp"
+
+/*******************************************************************
+ * Class definition
+ *******************************************************************/
+OutboundQueue::OutboundQueue(uint32_t max_size) :
+    m_max_size(max_size),
+    m_size(0),
+    m_in_flight(0),
+    m_closed(false)
+{
+}
+
+int OutboundQueue::Push(OutboundCommand command)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Stats& stats = GetChannelStats(command.channel);
+        size_t priority = static_cast<size_t>(command.priority);
+        std::deque<OutboundCommand>& lane = m_lanes[priority];
+
+        if(m_closed)
+        {
+            stats.stats.dropped++;
+            return -1;
+        }
+
+        command.queued_time = std::chrono::steady_clock::now();
+
+        /* Latest value, sent in the place of the one it replaces. Not past a command that doesn't coalesce, it may
+           write the same channel and must keep its order */
+        if(command.coalesce)
+        {
+            for(auto it = lane.rbegin(); it != lane.rend() && it->coalesce; it++)
+            {
+                if(it->channel == command.channel)
+                {
+                    *it = std::move(command);
+                    stats.stats.coalesced++;
+                    return 0;
+                }
+            }
+        }
+
+        if(m_size >= m_max_size)
+        {
+            /* Make room evicting the oldest command of the lowest lane */
+            size_t lowest = OUTBOUND_PRIORITIES - 1;
+
+            while(lowest > priority && m_lanes[lowest].empty())
+            {
+                lowest--;
+            }
+            if(lowest == priority)
+            {
+                stats.stats.dropped++;
+                return -1;
+            }
+
+            Stats& evicted_stats = GetChannelStats(m_lanes[lowest].front().channel);
+            evicted_stats.stats.dropped++;
+            evicted_stats.stats.depth--;
+            m_lanes[lowest].pop_front();
+            m_size--;
+        }
+
+        stats.stats.depth++;
+        lane.push_back(std::move(command));
+        m_size++;
+    }
+    m_condition_variable.notify_one();
+
+    return 0;
+}
+
+int OutboundQueue::PopBatch(std::vector<OutboundCommand>& batch, uint32_t max_commands, uint32_t timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    batch.clear();
+
+    m_condition_variable.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]{ return m_size > 0 || m_closed; });
+
+    if(m_size == 0 && m_closed)
+    {
+        return -1;
+    }
+
+    for(auto& lane : m_lanes)
+    {
+        while(!lane.empty() && batch.size() < max_commands)
+        {
+            GetChannelStats(lane.front().channel).stats.depth--;
+            batch.push_back(std::move(lane.front()));
+            lane.pop_front();
+            m_size--;
+        }
+    }
+    m_in_flight += batch.size();
+
+    return 0;
+}
+
+void OutboundQueue::Complete(const OutboundCommand& command, bool success)
+{
+    double latency_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - command.queued_time).count();
+    bool empty;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Stats& stats = GetChannelStats(command.channel);
+
+        stats.stats.sent++;
+        if(!success)
+        {
+            stats.stats.failed++;
+        }
+        stats.total_latency_ms += latency_ms;
+        stats.stats.average_latency_ms = stats.total_latency_ms / stats.stats.sent;
+        stats.stats.max_latency_ms = std::max(stats.stats.max_latency_ms, latency_ms);
+
+        if(m_in_flight > 0)
+        {
+            m_in_flight--;
+        }
+        empty = (m_size == 0) && (m_in_flight == 0);
+    }
+
+    if(empty)
+    {
+        m_empty_condition_variable.notify_all();
+    }
+}
+
+bool OutboundQueue::WaitEmpty(uint32_t timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    return m_empty_condition_variable.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                                               [this]{ return (m_size == 0) && (m_in_flight == 0); });
+}
+
+void OutboundQueue::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+    m_condition_variable.notify_all();
+}
+
+std::vector<OutboundChannelStats> OutboundQueue::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<OutboundChannelStats> stats;
+
+    for(const auto& channel_stats : m_stats)
+    {
+        stats.push_back(channel_stats.second.stats);
+    }
+
+    return stats;
+}
+
+OutboundQueue::Stats& OutboundQueue::GetChannelStats(const std::string& channel)
+{
+    auto it = m_stats.find(channel);
+
+    if(it == m_stats.end())
+    {
+        it = m_stats.emplace(channel, Stats{{channel, 0, 0, 0, 0, 0, 0.0, 0.0}, 0.0}).first;
+    }
+
+    return it->second;
+}
@@ -0,0 +1,224 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file roi_mask.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "roi_mask.hpp"
+
+/*******************************************************************
+ * Class definition
+ *******************************************************************/
+RoiMask::RoiMask(uint32_t width, uint32_t height) :
+    m_width(width),
+    m_height(height)
+{
+}
+
+RoiMask RoiMask::FromFullFrame(uint32_t width, uint32_t height)
+{
+    RoiMask mask(width, height);
+
+    for(uint32_t row = 0; row < height; row++)
+    {
+        mask.AddSpan(row, 0, width);
+    }
+
+    return mask;
+}
+
+RoiMask RoiMask::FromBitmap(uint32_t width, uint32_t height, const std::vector<uint8_t>& bitmap)
+{
+    RoiMask mask(width, height);
+
+    if(bitmap.size() < static_cast<size_t>(width) * height)
+    {
+        return mask;
+    }
+
+    for(uint32_t row = 0; row < height; row++)
+    {
+        const uint8_t* line = bitmap.data() + static_cast<size_t>(row) * width;
+        uint32_t col = 0;
+
+        while(col < width)
+        {
+            while(col < width && line[col] == 0)
+            {
+                col++;
+            }
+            uint32_t begin = col;
+            while(col < width && line[col] != 0)
+            {
+                col++;
+            }
+            mask.AddSpan(row, begin, col);
+        }
+    }
+
+    return mask;
+}
+
+RoiMask RoiMask::FromPolygon(uint32_t width, uint32_t height, const std::vector<RoiPoint>& polygon)
+{
+    RoiMask mask(width, height);
+    std::vector<double> crossings;
+    size_t num_vertices = polygon.size();
+
+    if(num_vertices < 3)
+    {
+        return mask;
+    }
+
+    for(uint32_t row = 0; row < height; row++)
+    {
+        /* Sample on the pixel centers */
+        double y = row + 0.5;
+
+        crossings.clear();
+        for(size_t i = 0; i < num_vertices; i++)
+        {
+            const RoiPoint& a = polygon[i];
+            const RoiPoint& b = polygon[(i + 1) % num_vertices];
+
+            /* Half-open test, a vertex shared by two edges is counted once */
+            if((a.y <= y) != (b.y <= y))
+            {
+                crossings.push_back(a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y));
+            }
+        }
+
+        std::sort(crossings.begin(), crossings.end());
+
+        for(size_t i = 0; i + 1 < crossings.size(); i += 2)
+        {
+            /* Pixels whose center lies in [x0, x1) */
+            double begin = std::clamp(std::ceil(crossings[i] - 0.5), 0.0, static_cast<double>(width));
+            double end   = std::clamp(std::ceil(crossings[i + 1] - 0.5), 0.0, static_cast<double>(width));
+
+            mask.AddSpan(row, static_cast<uint32_t>(begin), static_cast<uint32_t>(end));
+        }
+    }
+
+    return mask;
+}
+
+RoiMask RoiMask::Downsample(uint32_t level) const
+{
+    uint32_t width = m_width >> level;
+    uint32_t height = m_height >> level;
+    std::vector<uint8_t> bitmap(static_cast<size_t>(width) * height, 0);
+
+    /* Several rows fall into each row of the level, their spans are merged in a bitmap */
+    for(const RoiSpan& span : m_spans)
+    {
+        uint32_t row = span.row >> level;
+        uint32_t begin = span.begin >> level;
+        uint32_t end = std::min(width, ((span.end - 1U) >> level) + 1U);
+
+        if(row < height && begin < end)
+        {
+            std::fill(bitmap.begin() + static_cast<size_t>(row) * width + begin, bitmap.begin() + static_cast<size_t>(row) * width + end, 1);
+        }
+    }
+
+    return FromBitmap(width, height, bitmap);
+}
+
+void RoiMask::AddSpan(uint32_t row, uint32_t begin, uint32_t end)
+{
+    if(begin >= end)
+    {
+        return;
+    }
+
+    /* Merge with the previous span of the row when they touch */
+    if(!m_spans.empty() && m_spans.back().row == row && m_spans.back().end >= begin)
+    {
+        m_spans.back().end = std::max<uint16_t>(m_spans.back().end, end);
+    }
+    else
+    {
+        m_spans.push_back({static_cast<uint16_t>(row), static_cast<uint16_t>(begin), static_cast<uint16_t>(end)});
+    }
+}
+
+const std::vector<RoiSpan>& RoiMask::GetSpans() const
+{
+    return m_spans;
+}
+
+uint32_t RoiMask::GetWidth() const
+{
+    return m_width;
+}
+
+uint32_t RoiMask::GetHeight() const
+{
+    return m_height;
+}
+
+uint32_t RoiMask::GetNumPixels() const
+{
+    uint32_t num_pixels = 0;
+
+    for(const RoiSpan& span : m_spans)
+    {
+        num_pixels += span.end - span.begin;
+    }
+
+    return num_pixels;
+}
+
+/*******************************************************************
+ * Function definition
+ *******************************************************************/
+std::string RoiPolygonToString(const std::vector<RoiPoint>& polygon)
+{
+    std::string string_value;
+
+    for(const RoiPoint& point : polygon)
+    {
+        if(!string_value.empty())
+        {
+            string_value += " ";
+        }
+        string_value += std::to_string(point.x) + " " + std::to_string(point.y);
+    }
+
+    return string_value;
+}
+
+int RoiPolygonFromString(const std::string& string_value, std::vector<RoiPoint>& polygon)
+{
+    std::istringstream input_string_stream(string_value);
+    std::vector<int32_t> coordinates;
+    int32_t coordinate;
+
+    while(input_string_stream >> coordinate)
+    {
+        coordinates.push_back(coordinate);
+    }
+
+    /* Everything must have been consumed as pairs of coordinates */
+    if(!input_string_stream.eof() || (coordinates.size() % 2) != 0 || coordinates.size() < 6)
+    {
+        return -1;
+    }
+
+    polygon.clear();
+    for(size_t i = 0; i < coordinates.size(); i += 2)
+    {
+        polygon.push_back({coordinates[i], coordinates[i + 1]});
+    }
+
+    return 0;
+}
@@ -0,0 +1,380 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file shm_frame_ring.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "shm_frame_ring.hpp"
+#include "log.hpp"
+
+/*******************************************************************
+ * Defines
+ *******************************************************************/
+/* Attempts of CopyLatest when the writer overwrites the frame being copied */
+#define SHM_FRAME_RING_COPY_ATTEMPTS 4U
+
+/*******************************************************************
+ * Function definition
+ *******************************************************************/
+static size_t AlignTo64(size_t size)
+{
+    return (size + 63) & ~static_cast<size_t>(63);
+}
+
+static size_t HeaderSize()
+{
+    return AlignTo64(sizeof(ShmFrameRingHeader));
+}
+
+/* Shared between processes, not FUTEX_PRIVATE_FLAG */
+static long Futex(const std::atomic<uint32_t>& word, int operation, uint32_t value, const struct timespec* timeout)
+{
+    return syscall(SYS_futex, reinterpret_cast<const uint32_t*>(&word), operation, value, timeout, nullptr, 0);
+}
+
+/* The writer holds a lock on the ring while it is open, the kernel releases it however the writer ends */
+static bool IsAbandoned(const std::string& name)
+{
+    bool abandoned = false;
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+
+    if(fd != -1)
+    {
+        abandoned = (0 == flock(fd, LOCK_EX | LOCK_NB));
+        close(fd);
+    }
+
+    return abandoned;
+}
+
+/*******************************************************************
+ * Class definition
+ *******************************************************************/
+ShmFrameRing::ShmFrameRing(const std::string& name, uint32_t slot_count, uint32_t max_frame_size) :
+    m_name(name),
+    m_slot_count(slot_count),
+    m_slot_size(AlignTo64(sizeof(ShmFrameSlot) + max_frame_size)),
+    m_size(HeaderSize() + static_cast<size_t>(m_slot_count) * m_slot_size),
+    m_fd(-1),
+    m_header(nullptr)
+{
+}
+
+ShmFrameRing::~ShmFrameRing()
+{
+    Close();
+}
+
+int ShmFrameRing::Open()
+{
+    int fd;
+    void* memory;
+
+    if(m_header != nullptr)
+    {
+        return 0;
+    }
+    else if(m_slot_count == 0)
+    {
+        LOG(LOG_ERR,"Frame ring %s without slots\n", m_name.c_str());
+        return -1;
+    }
+
+    /* An existing one is only replaced if its writer is gone, e.g. it crashed */
+    fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(fd == -1 && errno == EEXIST && IsAbandoned(m_name))
+    {
+        LOG(LOG_WARNING,"Frame ring %s left by a previous run, replacing it\n", m_name.c_str());
+        shm_unlink(m_name.c_str());
+        fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+
+    if(fd == -1)
+    {
+        if(errno == EEXIST)
+        {
+            LOG(LOG_ERR,"Frame ring %s already in use by another writer\n", m_name.c_str());
+        }
+        else
+        {
+            LOG(LOG_ERR,"shm_open() failed for %s: %s\n", m_name.c_str(), strerror(errno));
+        }
+        return -1;
+    }
+    else if(-1 == flock(fd, LOCK_EX | LOCK_NB))
+    {
+        LOG(LOG_ERR,"flock() failed for %s: %s\n", m_name.c_str(), strerror(errno));
+        close(fd);
+        return -1;
+    }
+    else if(-1 == ftruncate(fd, m_size))
+    {
+        LOG(LOG_ERR,"ftruncate() failed for %s: %s\n", m_name.c_str(), strerror(errno));
+        close(fd);
+        shm_unlink(m_name.c_str());
+        return -1;
+    }
+
+    memory = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(memory == MAP_FAILED)
+    {
+        LOG(LOG_ERR,"mmap() failed for %s: %s\n", m_name.c_str(), strerror(errno));
+        close(fd);
+        shm_unlink(m_name.c_str());
+        return -1;
+    }
+
+    /* Kept open while the ring is, it holds the lock */
+    m_fd = fd;
+
+    /* The memory is zeroed: no frames and every slot empty */
+    m_header = new(memory) ShmFrameRingHeader{SHM_FRAME_RING_MAGIC, SHM_FRAME_RING_VERSION, m_slot_count, m_slot_size, {0}, {0}};
+    for(uint32_t i = 0; i < m_slot_count; i++)
+    {
+        new(reinterpret_cast<uint8_t*>(memory) + HeaderSize() + static_cast<size_t>(i) * m_slot_size) ShmFrameSlot{{0}, 0, 0, ShmFrameFormat::Jpeg};
+    }
+
+    LOG(LOG_INFO,"Frame ring %s created: %u slots of %u bytes\n", m_name.c_str(), m_slot_count, m_slot_size);
+
+    return 0;
+}
+
+void ShmFrameRing::Close()
+{
+    if(m_header != nullptr)
+    {
+        munmap(m_header, m_size);
+        shm_unlink(m_name.c_str());
+        close(m_fd);
+        m_fd = -1;
+        m_header = nullptr;
+    }
+}
+
+int ShmFrameRing::Write(const uint8_t* data, size_t size, ShmFrameFormat format)
+{
+    if(m_header == nullptr)
+    {
+        return -1;
+    }
+    else if(size > m_slot_size - sizeof(ShmFrameSlot))
+    {
+        LOG(LOG_WARNING,"Frame of %zu bytes doesn't fit in the frame ring %s\n", size, m_name.c_str());
+        return -1;
+    }
+
+    uint64_t number = m_header->frames.load(std::memory_order_relaxed);
+    uint8_t* slot_memory = reinterpret_cast<uint8_t*>(m_header) + HeaderSize() + (number % m_slot_count) * m_slot_size;
+    ShmFrameSlot* slot = reinterpret_cast<ShmFrameSlot*>(slot_memory);
+
+    /* Odd while written, the readers of the previous frame in this slot see it changed */
+    slot->sequence.store(2 * number + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    slot->size = size;
+    slot->format = format;
+    memcpy(slot_memory + sizeof(ShmFrameSlot), data, size);
+
+    slot->sequence.store(2 * number + 2, std::memory_order_release);
+    m_header->frames.store(number + 1, std::memory_order_release);
+
+    /* Wake up the readers, a system call per frame is negligible at the sensor rate */
+    m_header->notify.fetch_add(1, std::memory_order_release);
+    Futex(m_header->notify, FUTEX_WAKE, INT_MAX, nullptr);
+
+    return 0;
+}
+
+bool ShmFrameRing::IsOpen() const
+{
+    return m_header != nullptr;
+}
+
+const std::string& ShmFrameRing::GetName() const
+{
+    return m_name;
+}
+
+uint64_t ShmFrameRing::GetFrames() const
+{
+    return (m_header != nullptr) ? m_header->frames.load(std::memory_order_relaxed) : 0;
+}
+
+ShmFrameRingReader::ShmFrameRingReader(const std::string& name) :
+    m_name(name),
+    m_size(0),
+    m_header(nullptr)
+{
+}
+
+ShmFrameRingReader::~ShmFrameRingReader()
+{
+    if(m_header != nullptr)
+    {
+        munmap(const_cast<ShmFrameRingHeader*>(m_header), m_size);
+    }
+}
+
+int ShmFrameRingReader::Open()
+{
+    int fd;
+    struct stat file_stat;
+    void* memory;
+
+    if(m_header != nullptr)
+    {
+        return 0;
+    }
+    else if(-1 == (fd = shm_open(m_name.c_str(), O_RDONLY, 0)))
+    {
+        LOG(LOG_ERR,"shm_open() failed for %s: %s\n", m_name.c_str(), strerror(errno));
+        return -1;
+    }
+    else if(-1 == fstat(fd, &file_stat) || static_cast<size_t>(file_stat.st_size) < HeaderSize())
+    {
+        LOG(LOG_ERR,"Frame ring %s too small\n", m_name.c_str());
+        close(fd);
+        return -1;
+    }
+
+    memory = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(memory == MAP_FAILED)
+    {
+        LOG(LOG_ERR,"mmap() failed for %s: %s\n", m_name.c_str(), strerror(errno));
+        return -1;
+    }
+
+    const ShmFrameRingHeader* header = reinterpret_cast<const ShmFrameRingHeader*>(memory);
+
+    if(header->magic != SHM_FRAME_RING_MAGIC || header->version != SHM_FRAME_RING_VERSION || header->slot_count == 0 ||
+       HeaderSize() + static_cast<size_t>(header->slot_count) * header->slot_size > static_cast<size_t>(file_stat.st_size))
+    {
+        LOG(LOG_ERR,"%s is not a frame ring\n", m_name.c_str());
+        munmap(memory, file_stat.st_size);
+        return -1;
+    }
+
+    m_header = header;
+    m_size = file_stat.st_size;
+
+    return 0;
+}
+
+int ShmFrameRingReader::WaitFrame(uint64_t frames, uint32_t timeout_ms)
+{
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    if(m_header == nullptr)
+    {
+        return -1;
+    }
+
+    while(true)
+    {
+        /* Read before the frames, a frame written in between changes it and the wait returns at once */
+        uint32_t notify = m_header->notify.load(std::memory_order_acquire);
+
+        if(m_header->frames.load(std::memory_order_acquire) > frames)
+        {
+            return 0;
+        }
+
+        std::chrono::nanoseconds remaining = deadline - std::chrono::steady_clock::now();
+        if(remaining.count() <= 0)
+        {
+            return -1;
+        }
+
+        struct timespec timeout{static_cast<time_t>(remaining.count() / 1000000000), static_cast<long>(remaining.count() % 1000000000)};
+        Futex(m_header->notify, FUTEX_WAIT, notify, &timeout);
+    }
+}
+
+const ShmFrameSlot* ShmFrameRingReader::GetSlot(uint64_t number) const
+{
+    return reinterpret_cast<const ShmFrameSlot*>(reinterpret_cast<const uint8_t*>(m_header) + HeaderSize() +
+                                                 (number % m_header->slot_count) * m_header->slot_size);
+}
+
+int ShmFrameRingReader::GetLatest(ShmFrame& frame) const
+{
+    if(m_header == nullptr)
+    {
+        return -1;
+    }
+
+    uint64_t frames = m_header->frames.load(std::memory_order_acquire);
+    if(frames == 0)
+    {
+        return -1;
+    }
+
+    const ShmFrameSlot* slot = GetSlot(frames - 1);
+
+    if(slot->sequence.load(std::memory_order_acquire) != 2 * (frames - 1) + 2)
+    {
+        return -1;
+    }
+
+    frame.number = frames - 1;
+    frame.timestamp_us = slot->timestamp_us;
+    frame.format = slot->format;
+    frame.size = slot->size;
+    frame.data = reinterpret_cast<const uint8_t*>(slot) + sizeof(ShmFrameSlot);
+
+    /* The size is only trusted if the frame is still there */
+    if(!IsValid(frame) || frame.size > m_header->slot_size - sizeof(ShmFrameSlot))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+bool ShmFrameRingReader::IsValid(const ShmFrame& frame) const
+{
+    /* The reads of the frame happen before the check */
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return GetSlot(frame.number)->sequence.load(std::memory_order_relaxed) == 2 * frame.number + 2;
+}
+
+int ShmFrameRingReader::CopyLatest(ShmFrame& frame, std::vector<uint8_t>& buffer) const
+{
+    for(uint32_t i = 0; i < SHM_FRAME_RING_COPY_ATTEMPTS; i++)
+    {
+        if(0 != GetLatest(frame))
+        {
+            continue;
+        }
+
+        buffer.assign(frame.data, frame.data + frame.size);
+
+        if(IsValid(frame))
+        {
+            frame.data = buffer.data();
+            return 0;
+        }
+    }
+
+    return -1;
+}
@@ -366,6 +366,76 @@ int DataTable::HandleGetItemResponse(sqlite3_stmt **response, Entry& item)
     return ret_val;
 }
 
+int DataTable::GetAllItems(std::vector<Entry>& items)
+{
+    int ret_val = -1;
+    std::string command;
+    sqlite3_stmt *response;
+
+    if(0 != FormGetAllItemsMessage(command))
+    {
+        LOG(LOG_ERR,"Error forming GetAllItems message\n");
+    }
+    else if(0 != ExecuteSqlRequest(command, &response))
+    {
+        LOG(LOG_ERR,"Failed to request all items\n");
+    }
+    else if (0 != HandleGetAllItemsResponse(&response, items))
+    {
+        LOG(LOG_ERR,"Failed to parse the response\n");
+    }
+    else
+    {
+        ret_val = 0;
+    }
+
+    return ret_val;
+}
+
+int DataTable::FormGetAllItemsMessage(std::string& command)
+{
+    int ret_val = 0;
+
+    /*
+     * SELECT * FROM {table} ORDER BY {var1}
+     */
+
+    command = "SELECT * FROM " + m_name + " ORDER BY " + m_list_variables.front().name;
+
+    return ret_val;
+}
+
+int DataTable::HandleGetAllItemsResponse(sqlite3_stmt **response, std::vector<Entry>& items)
+{
+    int ret_val = 0;
+    int step = SQLITE_ROW;
+
+    items.clear();
+
+    while(SQLITE_ROW == (step = sqlite3_step(*response)))
+    {
+        Entry item = m_list_variables;
+        int i = 0;
+
+        for(auto it = item.begin(); it != item.end(); std::advance(it,1), i++)
+        {
+            std::string string_value = reinterpret_cast<const char *>(sqlite3_column_text(*response, i));
+            StringToVariable(string_value, *it);
+        }
+        items.push_back(item);
+    }
+
+    if(SQLITE_DONE != step)
+    {
+        LOG(LOG_ERR,"Failed sqlite3_step\n");
+        ret_val = -1;
+    }
+
+    sqlite3_finalize(*response);
+
+    return ret_val;
+}
+
 std::string DataTable::VariableToString(const Variable& variable)
 {
     std::string string_value;
@@ -0,0 +1,255 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file zip_writer.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <limits>
+#include <zlib.h>
+
+#include "zip_writer.hpp"
+#include "log.hpp"
+
+/*******************************************************************
+ * Defines
+ *******************************************************************/
+#define ZIP_LOCAL_HEADER_SIGNATURE       0x04034B50U
+#define ZIP_CENTRAL_HEADER_SIGNATURE     0x02014B50U
+#define ZIP_END_OF_DIRECTORY_SIGNATURE   0x06054B50U
+
+/* 1.0, enough for stored entries, made by a unix host so the permissions are kept */
+#define ZIP_VERSION_NEEDED   10U
+#define ZIP_VERSION_MADE_BY  ((3U << 8) | 20U)
+
+/* Bit 11 of the flags: the names are UTF-8 */
+#define ZIP_FLAG_UTF8        (1U << 11)
+#define ZIP_METHOD_STORED    0U
+
+/* -rw-r--r-- */
+#define ZIP_EXTERNAL_ATTRIBUTES (0100644U << 16)
+
+/* Without the zip64 extensions */
+#define ZIP_MAX_ENTRIES      0xFFFFU
+#define ZIP_MAX_OFFSET       0xFFFFFFFFU
+
+/*******************************************************************
+ * Function definition
+ *******************************************************************/
+static void Put16(std::vector<uint8_t>& buffer, uint16_t value)
+{
+    buffer.push_back(value & 0xFF);
+    buffer.push_back(value >> 8);
+}
+
+static void Put32(std::vector<uint8_t>& buffer, uint32_t value)
+{
+    Put16(buffer, value & 0xFFFF);
+    Put16(buffer, value >> 16);
+}
+
+static void DosDateTime(time_t time, uint16_t& dos_time, uint16_t& dos_date)
+{
+    struct tm local;
+
+    localtime_r(&time, &local);
+
+    /* The DOS format starts in 1980 and has a resolution of 2 seconds */
+    if(local.tm_year < 80)
+    {
+        dos_time = 0;
+        dos_date = (1U << 5) | 1U;
+    }
+    else
+    {
+        dos_time = (local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2);
+        dos_date = ((local.tm_year - 80) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday;
+    }
+}
+
+/*******************************************************************
+ * Class definition
+ *******************************************************************/
+ZipWriter::ZipWriter() :
+    m_file(nullptr),
+    m_num_entries(0),
+    m_offset(0),
+    m_failed(false)
+{
+}
+
+ZipWriter::~ZipWriter()
+{
+    if(m_file != nullptr)
+    {
+        Close();
+    }
+}
+
+int ZipWriter::Open(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    if(m_file != nullptr)
+    {
+        LOG(LOG_ERR, "ZipWriter: %s is already open\n", m_path.c_str());
+        return -1;
+    }
+
+    m_file = fopen(path.c_str(), "wb");
+    if(m_file == nullptr)
+    {
+        LOG(LOG_ERR, "ZipWriter: couldn't open %s\n", path.c_str());
+        return -1;
+    }
+
+    m_path = path;
+    m_central_directory.clear();
+    m_num_entries = 0;
+    m_offset = 0;
+    m_failed = false;
+
+    return 0;
+}
+
+int ZipWriter::AddFile(const std::string& name, const uint8_t* data, size_t size, time_t modification_time)
+{
+    /* Computed before taking the lock, several entries can be checksummed at the same time */
+    uint32_t crc = crc32_z(crc32(0L, Z_NULL, 0), data, size);
+    uint16_t dos_time, dos_date;
+
+    DosDateTime(modification_time, dos_time, dos_date);
+
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    if(m_file == nullptr)
+    {
+        LOG(LOG_ERR, "ZipWriter: archive not open\n");
+        return -1;
+    }
+    else if(m_failed)
+    {
+        return -1;
+    }
+
+    if((m_num_entries >= ZIP_MAX_ENTRIES) || (name.size() > std::numeric_limits<uint16_t>::max()) ||
+       (static_cast<uint64_t>(m_offset) + 30 + name.size() + size > ZIP_MAX_OFFSET))
+    {
+        LOG(LOG_ERR, "ZipWriter: %s doesn't fit in %s\n", name.c_str(), m_path.c_str());
+        return -1;
+    }
+
+    /* Local file header, the CRC and the sizes are known so no data descriptor follows the data */
+    m_header.clear();
+    Put32(m_header, ZIP_LOCAL_HEADER_SIGNATURE);
+    Put16(m_header, ZIP_VERSION_NEEDED);
+    Put16(m_header, ZIP_FLAG_UTF8);
+    Put16(m_header, ZIP_METHOD_STORED);
+    Put16(m_header, dos_time);
+    Put16(m_header, dos_date);
+    Put32(m_header, crc);
+    Put32(m_header, size);
+    Put32(m_header, size);
+    Put16(m_header, name.size());
+    Put16(m_header, 0);
+    m_header.insert(m_header.end(), name.begin(), name.end());
+
+    if((0 != Write(m_header.data(), m_header.size())) || (0 != Write(data, size)))
+    {
+        return -1;
+    }
+
+    /* Central directory entry, written when the archive is closed */
+    Put32(m_central_directory, ZIP_CENTRAL_HEADER_SIGNATURE);
+    Put16(m_central_directory, ZIP_VERSION_MADE_BY);
+    Put16(m_central_directory, ZIP_VERSION_NEEDED);
+    Put16(m_central_directory, ZIP_FLAG_UTF8);
+    Put16(m_central_directory, ZIP_METHOD_STORED);
+    Put16(m_central_directory, dos_time);
+    Put16(m_central_directory, dos_date);
+    Put32(m_central_directory, crc);
+    Put32(m_central_directory, size);
+    Put32(m_central_directory, size);
+    Put16(m_central_directory, name.size());
+    Put16(m_central_directory, 0); /* extra field length */
+    Put16(m_central_directory, 0); /* comment length */
+    Put16(m_central_directory, 0); /* disk number */
+    Put16(m_central_directory, 0); /* internal attributes */
+    Put32(m_central_directory, ZIP_EXTERNAL_ATTRIBUTES);
+    Put32(m_central_directory, m_offset);
+    m_central_directory.insert(m_central_directory.end(), name.begin(), name.end());
+
+    m_offset += m_header.size() + size;
+    m_num_entries++;
+
+    return 0;
+}
+
+int ZipWriter::Close()
+{
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+    int retval = -1;
+
+    if(m_file == nullptr)
+    {
+        LOG(LOG_ERR, "ZipWriter: archive not open\n");
+        return -1;
+    }
+
+    if(!m_failed && (static_cast<uint64_t>(m_offset) + m_central_directory.size() <= ZIP_MAX_OFFSET))
+    {
+        /* End of central directory record */
+        m_header.clear();
+        Put32(m_header, ZIP_END_OF_DIRECTORY_SIGNATURE);
+        Put16(m_header, 0); /* disk number */
+        Put16(m_header, 0); /* disk with the central directory */
+        Put16(m_header, m_num_entries);
+        Put16(m_header, m_num_entries);
+        Put32(m_header, m_central_directory.size());
+        Put32(m_header, m_offset);
+        Put16(m_header, 0); /* comment length */
+
+        if((0 == Write(m_central_directory.data(), m_central_directory.size())) &&
+           (0 == Write(m_header.data(), m_header.size())))
+        {
+            retval = 0;
+        }
+    }
+
+    if(0 != fclose(m_file))
+    {
+        LOG(LOG_ERR, "ZipWriter: couldn't close %s\n", m_path.c_str());
+        retval = -1;
+    }
+    m_file = nullptr;
+
+    if(0 != retval)
+    {
+        LOG(LOG_ERR, "ZipWriter: couldn't finalize %s\n", m_path.c_str());
+    }
+
+    return retval;
+}
+
+uint32_t ZipWriter::GetNumEntries() const
+{
+    std::lock_guard<std::mutex> lock_guard(m_mutex);
+
+    return m_num_entries;
+}
+
+int ZipWriter::Write(const void* data, size_t size)
+{
+    if(size != fwrite(data, 1, size, m_file))
+    {
+        /* The archive is unusable after a partial write */
+        LOG(LOG_ERR, "ZipWriter: couldn't write %s\n", m_path.c_str());
+        m_failed = true;
+        return -1;
+    }
+
+    return 0;
+}
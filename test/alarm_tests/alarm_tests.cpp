@@ -11,11 +11,15 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <future>
+#include <unistd.h>
+
 #include "../common/mocks/kinect_mock.hpp"
 #include "../common/mocks/message_broker_mock.hpp"
 #include "../common/mocks/state_persistence_mock.hpp"
 #include "../common/mocks/state_persistence_factory_mock.hpp"
 #include "mocks/alarm_module_mock.hpp"
+#include "mocks/intrusion_recorder_mock.hpp"
 #include "../../inc/alarm.hpp"
 
 /*******************************************************************
@@ -30,6 +34,14 @@ using ::testing::Ref;
 using ::testing::DoAll;
 using ::testing::Invoke;
 using testing::InSequence;
+using ::testing::Sequence;
+using ::testing::InvokeWithoutArgs;
+using ::testing::NotNull;
+using ::testing::Gt;
+using ::testing::SaveArg;
+using ::testing::HasSubstr;
+using ::testing::SizeIs;
+using ::testing::InvokeArgument;
 
 std::shared_ptr<IDataTable> g_data_table_mock;
 std::shared_ptr<KinectMock> g_kinect_mock;
@@ -38,6 +50,8 @@ std::shared_ptr<AlarmModuleMock> g_liveview_mock;
 std::shared_ptr<StatePersistenceFactoryMock> g_state_persistence_factory_mock;
 std::shared_ptr<DataTableMock> g_detection_datatable_mock;
 std::shared_ptr<DataTableMock> g_status_datatable_mock;
+std::shared_ptr<DataTableMock> g_zones_datatable_mock;
+std::shared_ptr<IntrusionRecorderMock> g_intrusion_recorder_mock;
 
 class AlarmTest : public ::testing::Test
 {
@@ -45,6 +59,8 @@ protected:
     std::shared_ptr<MessageBrokerMock> m_message_broker_mock;
     std::shared_ptr<DatabaseMock> m_data_base_mock;
     std::shared_ptr<Alarm> m_alarm;
+    /* Own frame ring, the tests don't clash with a running alarm or with each other */
+    const std::string m_liveview_shm_name = "/kinectalarm_alarm_test_" + std::to_string(getpid());
     const Entry m_status_table_definition = {
         {"ID",              DataType::Integer,},
         {"TILT",            DataType::Integer,},
@@ -61,6 +77,12 @@ protected:
         {"DET_TAKE_VIDEO_FRAME_INTERVAL_MS",  DataType::Integer,},
         {"LVW_VIDEO_FRAME_INTERVAL_MS",       DataType::Integer,}
     };
+    const Entry m_zones_table_definition = {
+        {"ID",          DataType::Integer,},
+        {"THRESHOLD",   DataType::Integer,},
+        {"SENSITIVITY", DataType::Integer,},
+        {"POLYGON",     DataType::String,}
+    };
 
 public:
     AlarmTest()
@@ -72,10 +94,12 @@ public:
         g_state_persistence_factory_mock = std::make_shared<StrictMock<StatePersistenceFactoryMock>>();
         g_detection_datatable_mock       = std::make_shared<StrictMock<DataTableMock>>();
         g_status_datatable_mock          = std::make_shared<StrictMock<DataTableMock>>();
+        g_zones_datatable_mock           = std::make_shared<StrictMock<DataTableMock>>();
+        g_intrusion_recorder_mock        = std::make_shared<StrictMock<IntrusionRecorderMock>>();
         m_data_base_mock                 = std::make_shared<StrictMock<DatabaseMock>>();
         m_message_broker_mock            = std::make_shared<StrictMock<MessageBrokerMock>>();
 
-        m_alarm = std::make_shared<Alarm>(m_message_broker_mock, m_data_base_mock);
+        m_alarm = std::make_shared<Alarm>(m_message_broker_mock, m_data_base_mock, m_liveview_shm_name);
     }
 
     ~AlarmTest()
@@ -87,6 +111,8 @@ public:
         g_state_persistence_factory_mock.reset();
         g_detection_datatable_mock.reset();
         g_status_datatable_mock.reset();
+        g_zones_datatable_mock.reset();
+        g_intrusion_recorder_mock.reset();
     }
 
     void AlarmInit()
@@ -98,12 +124,17 @@ public:
             WillOnce(Return(g_detection_datatable_mock));
         EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "STATUS", _)).
             WillOnce(Return(g_status_datatable_mock));
+        EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "DETECTION_ZONES", _)).
+            WillOnce(Return(g_zones_datatable_mock));
         EXPECT_CALL(*g_status_datatable_mock, GetItem(_)).
             WillOnce(Return(0));
+        EXPECT_CALL(*g_zones_datatable_mock, GetAllItems(_)).
+            WillOnce(Return(0));
+        EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
 
         /* InitVarsRedis */
-        EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).Times(8).
-            WillRepeatedly(Return(0));
+        EXPECT_CALL(*m_message_broker_mock, SetVariables(SizeIs(9))).
+            WillOnce(Return(0));
 
         EXPECT_CALL(*g_kinect_mock, Init).
             WillOnce(Return(0));
@@ -139,27 +170,46 @@ public:
 
     void FakeIntrusion()
     {
-        InSequence seq;
         AlarmDetectionObserver detection_observer(*m_alarm);
+        std::future<void> published = ExpectIntrusionJobs();
 
-        /* UpdateLed */
-        EXPECT_CALL(*g_detection_mock, IsRunning).
-            WillRepeatedly(Return(false));
-        EXPECT_CALL(*g_liveview_mock, IsRunning).
-            WillRepeatedly(Return(false));
-        EXPECT_CALL(*g_kinect_mock, ChangeLedColor(_)).
-            WillOnce(Return(0));
+        {
+            InSequence seq;
+
+            EXPECT_CALL(*g_intrusion_recorder_mock, Stop).
+                WillOnce(DoAll(InvokeArgument<0>(), Return(0)));
+
+            /* UpdateLed */
+            EXPECT_CALL(*g_detection_mock, IsRunning).
+                WillRepeatedly(Return(false));
+            EXPECT_CALL(*g_liveview_mock, IsRunning).
+                WillRepeatedly(Return(false));
+            EXPECT_CALL(*g_kinect_mock, ChangeLedColor(_)).
+                WillOnce(Return(0));
+
+            EXPECT_CALL(*g_status_datatable_mock, SetItem(_)).
+                WillOnce(Return(0));
+        }
+
+        detection_observer.IntrusionStopped(1);
+
+        ASSERT_EQ(published.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+    }
+
+    /* The database row, the detection count and the event are written by the pool, in their own sequence */
+    std::future<void> ExpectIntrusionJobs()
+    {
+        Sequence jobs;
+        std::shared_ptr<std::promise<void>> published = std::make_shared<std::promise<void>>();
 
-        EXPECT_CALL(*m_message_broker_mock, Publish("new_det", _)).
-            WillOnce(Return(0));
         EXPECT_CALL(*g_detection_datatable_mock, InsertItem(_)).
+            InSequence(jobs).
             WillOnce(Return(0));
-        EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).
-            WillOnce(Return(0));
-        EXPECT_CALL(*g_status_datatable_mock, SetItem(_)).
-            WillOnce(Return(0));
+        EXPECT_CALL(*m_message_broker_mock, SetVariablesAndPublish(SizeIs(1), "new_det", _)).
+            InSequence(jobs).
+            WillOnce(DoAll(InvokeWithoutArgs([published]{ published->set_value(); }), Return(0)));
 
-        detection_observer.IntrusionStopped(1);
+        return published->get_future();
     }
 
 };
@@ -195,9 +245,14 @@ TEST_F(AlarmTest, InitStatusVarsRead)
         WillOnce(Return(g_detection_datatable_mock));
     EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "STATUS", _)).
         WillOnce(Return(g_status_datatable_mock));
+    EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "DETECTION_ZONES", _)).
+        WillOnce(Return(g_zones_datatable_mock));
     EXPECT_CALL(*g_status_datatable_mock, GetItem(_)).
         WillOnce(Return(0));
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).
+    EXPECT_CALL(*g_zones_datatable_mock, GetAllItems(_)).
+        WillOnce(Return(0));
+    EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
+    EXPECT_CALL(*m_message_broker_mock, SetVariables(_)).
         WillRepeatedly(Return(0));
 
     EXPECT_EQ(0, alarm.Init());
@@ -234,11 +289,16 @@ TEST_F(AlarmTest, InitFailedReadingStatusTable)
         WillOnce(Return(g_detection_datatable_mock));
     EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "STATUS", _)).
         WillOnce(Return(g_status_datatable_mock));
+    EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "DETECTION_ZONES", _)).
+        WillOnce(Return(g_zones_datatable_mock));
     EXPECT_CALL(*g_status_datatable_mock, GetItem(_)).
         WillOnce(Return(-1));
     EXPECT_CALL(*g_status_datatable_mock, InsertItem(_)).
         WillOnce(Return(0));
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).
+    EXPECT_CALL(*g_zones_datatable_mock, GetAllItems(_)).
+        WillOnce(Return(0));
+    EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
+    EXPECT_CALL(*m_message_broker_mock, SetVariables(_)).
         WillRepeatedly(Return(0));
 
     EXPECT_CALL(*g_kinect_mock, Init).
@@ -263,11 +323,16 @@ TEST_F(AlarmTest, InitFailedKinectInit)
         WillOnce(Return(g_detection_datatable_mock));
     EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "STATUS", _)).
         WillOnce(Return(g_status_datatable_mock));
+    EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "DETECTION_ZONES", _)).
+        WillOnce(Return(g_zones_datatable_mock));
     EXPECT_CALL(*g_status_datatable_mock, GetItem(_)).
         WillOnce(Return(-1));
     EXPECT_CALL(*g_status_datatable_mock, InsertItem(_)).
         WillOnce(Return(0));
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).
+    EXPECT_CALL(*g_zones_datatable_mock, GetAllItems(_)).
+        WillOnce(Return(0));
+    EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
+    EXPECT_CALL(*m_message_broker_mock, SetVariables(_)).
         WillRepeatedly(Return(0));
 
     EXPECT_CALL(*g_kinect_mock, Init).
@@ -289,12 +354,17 @@ TEST_F(AlarmTest, InitDetectionIsActive)
         WillOnce(Return(g_detection_datatable_mock));
     EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "STATUS", _)).
         WillOnce(Return(g_status_datatable_mock));
+    EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "DETECTION_ZONES", _)).
+        WillOnce(Return(g_zones_datatable_mock));
     EXPECT_CALL(*g_status_datatable_mock, GetItem(_)).
         WillOnce(DoAll(SetArgReferee<0>(status_variables), Return(0)));
+    EXPECT_CALL(*g_zones_datatable_mock, GetAllItems(_)).
+        WillOnce(Return(0));
+    EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
 
     /* InitVarsRedis */
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).Times(8).
-        WillRepeatedly(Return(0));
+    EXPECT_CALL(*m_message_broker_mock, SetVariables(SizeIs(9))).
+        WillOnce(Return(0));
 
     EXPECT_CALL(*g_kinect_mock, Init).
         WillOnce(Return(0));
@@ -318,8 +388,6 @@ TEST_F(AlarmTest, InitDetectionIsActive)
         WillOnce(Return(0));
     EXPECT_CALL(*g_status_datatable_mock, SetItem(_)).
         WillOnce(Return(0));
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).
-        WillOnce(Return(0));
 
     /* UpdateLed */
     EXPECT_CALL(*g_detection_mock, IsRunning).
@@ -327,7 +395,7 @@ TEST_F(AlarmTest, InitDetectionIsActive)
     EXPECT_CALL(*g_kinect_mock, ChangeLedColor(_)).
         WillOnce(Return(0));
 
-    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_INFO_CHANNEL, "Detection started")).
+    EXPECT_CALL(*m_message_broker_mock, SetVariablesAndPublish(SizeIs(1), REDIS_EVENT_INFO_CHANNEL, "Detection started")).
         WillOnce(Return(0));
 
     EXPECT_CALL(*g_kinect_mock, ChangeTilt(_)).
@@ -349,12 +417,17 @@ TEST_F(AlarmTest, InitLiveviewIsActive)
         WillOnce(Return(g_detection_datatable_mock));
     EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "STATUS", _)).
         WillOnce(Return(g_status_datatable_mock));
+    EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "DETECTION_ZONES", _)).
+        WillOnce(Return(g_zones_datatable_mock));
     EXPECT_CALL(*g_status_datatable_mock, GetItem(_)).
         WillOnce(DoAll(SetArgReferee<0>(status_variables), Return(0)));
+    EXPECT_CALL(*g_zones_datatable_mock, GetAllItems(_)).
+        WillOnce(Return(0));
+    EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
 
     /* InitVarsRedis */
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).Times(8).
-        WillRepeatedly(Return(0));
+    EXPECT_CALL(*m_message_broker_mock, SetVariables(SizeIs(9))).
+        WillOnce(Return(0));
 
     EXPECT_CALL(*g_kinect_mock, Init).
         WillOnce(Return(0));
@@ -378,8 +451,6 @@ TEST_F(AlarmTest, InitLiveviewIsActive)
         WillOnce(Return(0));
     EXPECT_CALL(*g_status_datatable_mock, SetItem(_)).
         WillOnce(Return(0));
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).
-        WillOnce(Return(0));
 
     /* UpdateLed */
     EXPECT_CALL(*g_detection_mock, IsRunning).
@@ -389,7 +460,7 @@ TEST_F(AlarmTest, InitLiveviewIsActive)
     EXPECT_CALL(*g_kinect_mock, ChangeLedColor(_)).
         WillOnce(Return(0));
 
-    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_INFO_CHANNEL, "Liveview started")).
+    EXPECT_CALL(*m_message_broker_mock, SetVariablesAndPublish(SizeIs(1), REDIS_EVENT_INFO_CHANNEL, "Liveview started")).
         WillOnce(Return(0));
 
     EXPECT_CALL(*g_kinect_mock, ChangeTilt(_)).
@@ -413,8 +484,6 @@ TEST_F(AlarmTest, StartDetection)
         WillOnce(Return(0));
     EXPECT_CALL(*g_status_datatable_mock, SetItem(_)).
         WillOnce(Return(0));
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).
-        WillOnce(Return(0));
 
     /* UpdateLed */
     EXPECT_CALL(*g_detection_mock, IsRunning).
@@ -422,7 +491,7 @@ TEST_F(AlarmTest, StartDetection)
     EXPECT_CALL(*g_kinect_mock, ChangeLedColor(_)).
         WillOnce(Return(0));
 
-    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_INFO_CHANNEL, "Detection started")).
+    EXPECT_CALL(*m_message_broker_mock, SetVariablesAndPublish(SizeIs(1), REDIS_EVENT_INFO_CHANNEL, "Detection started")).
         WillOnce(Return(0));
 
     EXPECT_EQ(0, m_alarm->StartDetection());
@@ -439,8 +508,6 @@ TEST_F(AlarmTest, StopDetection)
         WillOnce(Return(0));
     EXPECT_CALL(*g_status_datatable_mock, SetItem(_)).
         WillOnce(Return(0));
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).
-        WillOnce(Return(0));
 
     /* UpdateLed */
     EXPECT_CALL(*g_detection_mock, IsRunning).
@@ -450,7 +517,7 @@ TEST_F(AlarmTest, StopDetection)
     EXPECT_CALL(*g_kinect_mock, ChangeLedColor(_)).
         WillOnce(Return(0));
 
-    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_INFO_CHANNEL, "Detection stopped")).
+    EXPECT_CALL(*m_message_broker_mock, SetVariablesAndPublish(SizeIs(1), REDIS_EVENT_INFO_CHANNEL, "Detection stopped")).
         WillOnce(Return(0));
 
     EXPECT_CALL(*g_detection_mock, IsRunning).
@@ -478,8 +545,6 @@ TEST_F(AlarmTest, StartLiveview)
         WillOnce(Return(0));
     EXPECT_CALL(*g_status_datatable_mock, SetItem(_)).
         WillOnce(Return(0));
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).
-        WillOnce(Return(0));
 
     /* UpdateLed */
     EXPECT_CALL(*g_detection_mock, IsRunning).
@@ -489,7 +554,7 @@ TEST_F(AlarmTest, StartLiveview)
     EXPECT_CALL(*g_kinect_mock, ChangeLedColor(_)).
         WillOnce(Return(0));
 
-    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_INFO_CHANNEL, "Liveview started")).
+    EXPECT_CALL(*m_message_broker_mock, SetVariablesAndPublish(SizeIs(1), REDIS_EVENT_INFO_CHANNEL, "Liveview started")).
         WillOnce(Return(0));
 
     EXPECT_EQ(0, m_alarm->StartLiveview());
@@ -506,8 +571,6 @@ TEST_F(AlarmTest, StopLiveview)
         WillOnce(Return(0));
     EXPECT_CALL(*g_status_datatable_mock, SetItem(_)).
         WillOnce(Return(0));
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).
-        WillOnce(Return(0));
 
     /* UpdateLed */
     EXPECT_CALL(*g_detection_mock, IsRunning).
@@ -517,7 +580,7 @@ TEST_F(AlarmTest, StopLiveview)
     EXPECT_CALL(*g_kinect_mock, ChangeLedColor(_)).
         WillOnce(Return(0));
 
-    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_INFO_CHANNEL, "Liveview stopped")).
+    EXPECT_CALL(*m_message_broker_mock, SetVariablesAndPublish(SizeIs(1), REDIS_EVENT_INFO_CHANNEL, "Liveview stopped")).
         WillOnce(Return(0));
 
     EXPECT_CALL(*g_detection_mock, IsRunning).
@@ -533,7 +596,7 @@ TEST_F(AlarmTest, StopLiveview)
 
 TEST_F(AlarmTest, GetNumDetections)
 {
-    InSequence seq;
+    /* Each intrusion orders its own expectations, part of them are met from the pool */
     AlarmInit();
 
     EXPECT_EQ(0, m_alarm->GetNumDetections());
@@ -597,11 +660,9 @@ TEST_F(AlarmTest, ChangeThreshold)
     AlarmInit();
 
     EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).
-        WillOnce(Return(0));
     EXPECT_CALL(*g_status_datatable_mock, SetItem(_)).
         WillOnce(Return(0));
-    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_SUCCESS_CHANNEL, _)).
+    EXPECT_CALL(*m_message_broker_mock, SetVariablesAndPublish(SizeIs(1), REDIS_EVENT_SUCCESS_CHANNEL, _)).
         WillOnce(Return(0));
 
     EXPECT_EQ(0, m_alarm->ChangeThreshold(value));
@@ -614,26 +675,264 @@ TEST_F(AlarmTest, ChangeSensitivity)
     AlarmInit();
 
     EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).
-        WillOnce(Return(0));
     EXPECT_CALL(*g_status_datatable_mock, SetItem(_)).
         WillOnce(Return(0));
-    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_SUCCESS_CHANNEL, _)).
+    EXPECT_CALL(*m_message_broker_mock, SetVariablesAndPublish(SizeIs(1), REDIS_EVENT_SUCCESS_CHANNEL, _)).
         WillOnce(Return(0));
 
     EXPECT_EQ(0, m_alarm->ChangeSensitivity(value));
 }
 
+TEST_F(AlarmTest, InitReadsDetectionZones)
+{
+    Alarm alarm(m_message_broker_mock, m_data_base_mock);
+    std::vector<Entry> zones(2, m_zones_table_definition);
+    size_t num_zones = 0;
+
+    zones[0][0].value = 1;
+    zones[0][1].value = 100;
+    zones[0][2].value = 10;
+    zones[0][3].value = std::string("0 0 100 0 100 100");
+    zones[1][0].value = 2;
+    zones[1][1].value = 100;
+    zones[1][2].value = 10;
+    zones[1][3].value = std::string("0 0 100"); /* Invalid, discarded */
+
+    EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "DETECTIONS", _)).
+        WillOnce(Return(g_detection_datatable_mock));
+    EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "STATUS", _)).
+        WillOnce(Return(g_status_datatable_mock));
+    EXPECT_CALL(*g_state_persistence_factory_mock, CreateDatatable(_, "DETECTION_ZONES", _)).
+        WillOnce(Return(g_zones_datatable_mock));
+    EXPECT_CALL(*g_status_datatable_mock, GetItem(_)).
+        WillOnce(Return(0));
+    EXPECT_CALL(*g_zones_datatable_mock, GetAllItems(_)).
+        WillOnce(DoAll(SetArgReferee<0>(zones), Return(0)));
+    EXPECT_CALL(*g_detection_mock, UpdateConfig(_)).
+        WillOnce(Invoke([&num_zones](AlarmModuleConfig& config){ num_zones = dynamic_cast<DetectionConfig&>(config).zones.size(); }));
+    EXPECT_CALL(*m_message_broker_mock, SetVariables(_)).
+        WillRepeatedly(Return(0));
+    EXPECT_CALL(*g_kinect_mock, Init).
+        WillOnce(Return(0));
+    EXPECT_CALL(*g_detection_mock, IsRunning).
+        WillRepeatedly(Return(false));
+    EXPECT_CALL(*g_liveview_mock, IsRunning).
+        WillRepeatedly(Return(false));
+    EXPECT_CALL(*g_kinect_mock, ChangeLedColor(_)).
+        WillOnce(Return(0));
+    EXPECT_CALL(*g_kinect_mock, ChangeTilt(_)).
+        WillOnce(Return(0));
+
+    EXPECT_EQ(0, alarm.Init());
+    EXPECT_EQ(1U, num_zones);
+}
+
+TEST_F(AlarmTest, SetDetectionZone)
+{
+    InSequence seq;
+    AlarmInit();
+
+    /* New zone */
+    EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
+    EXPECT_CALL(*g_zones_datatable_mock, InsertItem(_)).
+        WillOnce(Return(0));
+    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_SUCCESS_CHANNEL, _)).
+        WillOnce(Return(0));
+
+    EXPECT_EQ(0, m_alarm->SetDetectionZone(1, 100, 10, {{0, 0}, {100, 0}, {100, 100}}));
+
+    /* Same id, the zone is replaced */
+    EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
+    EXPECT_CALL(*g_zones_datatable_mock, SetItem(_)).
+        WillOnce(Return(0));
+    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_SUCCESS_CHANNEL, _)).
+        WillOnce(Return(0));
+
+    EXPECT_EQ(0, m_alarm->SetDetectionZone(1, 200, 10, {{0, 0}, {100, 0}, {100, 100}}));
+}
+
+TEST_F(AlarmTest, SetDetectionZoneInvalid)
+{
+    AlarmInit();
+
+    EXPECT_NE(0, m_alarm->SetDetectionZone(1, 100, 10, {{0, 0}, {100, 0}}));
+    EXPECT_NE(0, m_alarm->SetDetectionZone(-1, 100, 10, {{0, 0}, {100, 0}, {100, 100}}));
+    EXPECT_NE(0, m_alarm->SetDetectionZone(1, 100, 70000, {{0, 0}, {100, 0}, {100, 100}}));
+}
+
+TEST_F(AlarmTest, DeleteDetectionZone)
+{
+    InSequence seq;
+    AlarmInit();
+
+    EXPECT_NE(0, m_alarm->DeleteDetectionZone(1));
+
+    EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
+    EXPECT_CALL(*g_zones_datatable_mock, InsertItem(_)).
+        WillOnce(Return(0));
+    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_SUCCESS_CHANNEL, _)).
+        WillOnce(Return(0));
+
+    EXPECT_EQ(0, m_alarm->SetDetectionZone(1, 100, 10, {{0, 0}, {100, 0}, {100, 100}}));
+
+    EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
+    EXPECT_CALL(*g_zones_datatable_mock, DeleteItem(_)).
+        WillOnce(Return(0));
+    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_SUCCESS_CHANNEL, _)).
+        WillOnce(Return(0));
+
+    EXPECT_EQ(0, m_alarm->DeleteDetectionZone(1));
+}
+
+TEST_F(AlarmTest, ResetDetectionZones)
+{
+    InSequence seq;
+    AlarmInit();
+
+    EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
+    EXPECT_CALL(*g_zones_datatable_mock, DeleteAllItems()).
+        WillOnce(Return(0));
+    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_SUCCESS_CHANNEL, _)).
+        WillOnce(Return(0));
+
+    EXPECT_EQ(0, m_alarm->ResetDetectionZones());
+}
+
+TEST_F(AlarmTest, EnableHeatMap)
+{
+    InSequence seq;
+    AlarmInit();
+
+    EXPECT_CALL(*g_detection_mock, UpdateConfig(_));
+    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_SUCCESS_CHANNEL, "Heat map enabled")).
+        WillOnce(Return(0));
+
+    EXPECT_EQ(0, m_alarm->EnableHeatMap(true));
+}
+
+TEST_F(AlarmTest, ChangeLiveviewMode)
+{
+    InSequence seq;
+    AlarmInit();
+
+    EXPECT_CALL(*g_liveview_mock, UpdateConfig(_));
+    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_SUCCESS_CHANNEL, "Liveview mode changed to depth")).
+        WillOnce(Return(0));
+
+    EXPECT_EQ(0, m_alarm->ChangeLiveviewMode(LiveviewMode::Depth));
+}
+
+TEST_F(AlarmTest, PublishFrameStats)
+{
+    std::map<std::string, int32_t> variables;
+    AlarmInit();
+
+    EXPECT_CALL(*g_kinect_mock, GetDepthFrameStats).
+        WillOnce(Return(FrameStreamStats{300, 290, 10, 1500, 40000}));
+    EXPECT_CALL(*g_kinect_mock, GetVideoFrameStats).
+        WillOnce(Return(FrameStreamStats{0x100000000ULL, 30, 0, 2000, 3000}));
+    EXPECT_CALL(*m_message_broker_mock, SetVariables(SizeIs(8))).
+        WillOnce(Invoke([&variables](const std::vector<Variable>& batch)
+        {
+            for(const Variable& variable : batch)
+            {
+                variables[variable.name] = std::get<int32_t>(variable.value);
+            }
+            return 0;
+        }));
+
+    EXPECT_EQ(0, m_alarm->PublishFrameStats());
+
+    EXPECT_EQ(variables["kinect_depth_frames"], 300);
+    EXPECT_EQ(variables["kinect_depth_drops"], 10);
+    EXPECT_EQ(variables["kinect_depth_latency_us"], 1500);
+    EXPECT_EQ(variables["kinect_depth_latency_max_us"], 40000);
+    EXPECT_EQ(variables["kinect_video_frames"], INT32_MAX);
+    EXPECT_EQ(variables["kinect_video_drops"], 0);
+}
+
 TEST_F(AlarmTest, NewFrame)
 {
     KinectVideoFrame frame(1080, 1080);
     Alarm alarm(m_message_broker_mock, m_data_base_mock);
     AlarmLiveviewObserver liveview_observer(alarm);
 
-    EXPECT_CALL(*m_message_broker_mock, Publish("liveview", _)).
+    EXPECT_CALL(*m_message_broker_mock, PublishBinary("liveview_bin", NotNull(), Gt(0U))).
+        WillOnce(Return(0));
+
+    liveview_observer.NewFrame(frame);
+}
+
+TEST_F(AlarmTest, NewFrameWithBase64)
+{
+    KinectVideoFrame frame(1080, 1080);
+    Alarm alarm(m_message_broker_mock, m_data_base_mock);
+    AlarmLiveviewObserver liveview_observer(alarm);
+    const uint8_t* binary_data = nullptr;
+    size_t binary_size = 0;
+    std::string base64_frame;
+
+    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_EVENT_SUCCESS_CHANNEL, "Liveview base64 enabled")).
         WillOnce(Return(0));
+    EXPECT_CALL(*m_message_broker_mock, PublishBinary("liveview_bin", _, _)).
+        WillOnce(DoAll(SaveArg<1>(&binary_data), SaveArg<2>(&binary_size), Return(0)));
+    EXPECT_CALL(*m_message_broker_mock, Publish("liveview", _)).
+        WillOnce(DoAll(SaveArg<1>(&base64_frame), Return(0)));
+
+    EXPECT_EQ(0, alarm.EnableLiveviewBase64(true));
+    liveview_observer.NewFrame(frame);
+
+    /* Four base64 characters for each three bytes */
+    EXPECT_GE(base64_frame.size(), 4 * (binary_size / 3));
+}
 
+TEST_F(AlarmTest, NewFrameInFrameRing)
+{
+    KinectVideoFrame frame(640, 480);
+    ShmFrameRingReader reader(m_liveview_shm_name);
+    size_t binary_size = 0;
+    ShmFrame shm_frame;
+
+    AlarmInit();
+    AlarmLiveviewObserver liveview_observer(*m_alarm);
+
+    EXPECT_CALL(*m_message_broker_mock, PublishBinary("liveview_bin", NotNull(), Gt(0U))).
+        WillOnce(DoAll(SaveArg<2>(&binary_size), Return(0)));
+
+    ASSERT_EQ(0, reader.Open());
     liveview_observer.NewFrame(frame);
+
+    ASSERT_EQ(0, reader.WaitFrame(0, 1000));
+    ASSERT_EQ(0, reader.GetLatest(shm_frame));
+    EXPECT_EQ(shm_frame.number, 0U);
+    EXPECT_EQ(shm_frame.format, ShmFrameFormat::Jpeg);
+    EXPECT_EQ(shm_frame.size, binary_size);
+    EXPECT_TRUE(reader.IsValid(shm_frame));
+}
+
+TEST_F(AlarmTest, NewDepthFrame)
+{
+    KinectDepthFrame frame(640, 480);
+    Alarm alarm(m_message_broker_mock, m_data_base_mock);
+    AlarmLiveviewObserver liveview_observer(alarm);
+
+    EXPECT_CALL(*m_message_broker_mock, PublishBinary("liveview_bin", NotNull(), Gt(0U))).
+        WillOnce(Return(0));
+
+    liveview_observer.NewDepthFrame(frame);
+}
+
+TEST_F(AlarmTest, NewSideBySideFrame)
+{
+    KinectDepthFrame depth_frame(640, 480);
+    KinectVideoFrame video_frame(640, 480);
+    Alarm alarm(m_message_broker_mock, m_data_base_mock);
+    AlarmLiveviewObserver liveview_observer(alarm);
+
+    EXPECT_CALL(*m_message_broker_mock, PublishBinary("liveview_bin", NotNull(), Gt(0U))).
+        WillOnce(Return(0));
+
+    liveview_observer.NewSideBySideFrame(depth_frame, video_frame);
 }
 
 TEST_F(AlarmTest, IntrusionStarted)
@@ -647,6 +946,8 @@ TEST_F(AlarmTest, IntrusionStarted)
         WillOnce(Return(0));
     EXPECT_CALL(*g_kinect_mock, ChangeLedColor(LED_RED)).
         WillOnce(Return(0));
+    EXPECT_CALL(*g_intrusion_recorder_mock, Start(HasSubstr("0_capture_vid.mp4"), _, _, _)).
+        WillOnce(Return(0));
 
     detection_observer.IntrusionStarted();
 }
@@ -661,19 +962,51 @@ TEST_F(AlarmTest, IntrusionStopped)
         WillRepeatedly(Return(false));
     EXPECT_CALL(*g_liveview_mock, IsRunning).
         WillRepeatedly(Return(false));
+    EXPECT_CALL(*g_intrusion_recorder_mock, Stop).
+        WillOnce(DoAll(InvokeArgument<0>(), Return(0)));
     EXPECT_CALL(*g_kinect_mock, ChangeLedColor(_)).
         WillOnce(Return(0));
 
-    EXPECT_CALL(*m_message_broker_mock, Publish("new_det", _)).
-        WillOnce(Return(0));
-    EXPECT_CALL(*m_message_broker_mock, SetVariable(_)).
+    EXPECT_CALL(*g_status_datatable_mock, SetItem(_)).
         WillOnce(Return(0));
-    EXPECT_CALL(*g_detection_datatable_mock, InsertItem(_)).
+
+    std::future<void> published = ExpectIntrusionJobs();
+
+    detection_observer.IntrusionStopped(1);
+
+    EXPECT_EQ(published.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+}
+
+TEST_F(AlarmTest, IntrusionStoppedWaitsForVideo)
+{
+    AlarmInit();
+    AlarmDetectionObserver detection_observer(*m_alarm);
+    std::function<void()> video_finalized;
+
+    /* UpdateLed */
+    EXPECT_CALL(*g_detection_mock, IsRunning).
+        WillRepeatedly(Return(false));
+    EXPECT_CALL(*g_liveview_mock, IsRunning).
+        WillRepeatedly(Return(false));
+    EXPECT_CALL(*g_intrusion_recorder_mock, Stop).
+        WillOnce(DoAll(SaveArg<0>(&video_finalized), Return(0)));
+    EXPECT_CALL(*g_kinect_mock, ChangeLedColor(_)).
         WillOnce(Return(0));
+
     EXPECT_CALL(*g_status_datatable_mock, SetItem(_)).
         WillOnce(Return(0));
 
+    std::future<void> published = ExpectIntrusionJobs();
+
     detection_observer.IntrusionStopped(1);
+
+    /* Nothing is written while the video is being finalized */
+    EXPECT_EQ(published.wait_for(std::chrono::milliseconds(100)), std::future_status::timeout);
+    ASSERT_TRUE(video_finalized);
+
+    video_finalized();
+
+    EXPECT_EQ(published.wait_for(std::chrono::seconds(1)), std::future_status::ready);
 }
 
 TEST_F(AlarmTest, IntrusionFrame)
@@ -682,5 +1015,20 @@ TEST_F(AlarmTest, IntrusionFrame)
     AlarmInit();
     AlarmDetectionObserver detection_observer(*m_alarm);
 
+    EXPECT_CALL(*g_intrusion_recorder_mock, AddFrame(std::shared_ptr<const KinectVideoFrame>(frame), 1)).
+        WillOnce(Return(0));
+
     detection_observer.IntrusionFrame(frame, 1);
 }
+
+TEST_F(AlarmTest, IntrusionHeatMap)
+{
+    DifferenceMap heat_map{16, 2, 1, {5, 0}};
+    AlarmInit();
+    AlarmDetectionObserver detection_observer(*m_alarm);
+
+    EXPECT_CALL(*m_message_broker_mock, Publish(REDIS_DET_HEAT_MAP_CHANNEL, "2 1 5 0")).
+        WillOnce(Return(0));
+
+    detection_observer.IntrusionHeatMap(heat_map);
+}
@@ -0,0 +1,24 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file intrusion_recorder_factory_fake.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <memory>
+
+#include "../../../inc/intrusion_recorder_factory.hpp"
+#include "../mocks/intrusion_recorder_mock.hpp"
+
+/*******************************************************************
+ * Class definition
+ *******************************************************************/
+extern std::shared_ptr<IntrusionRecorderMock> g_intrusion_recorder_mock;
+
+std::shared_ptr<IIntrusionRecorder> IntrusionRecorderFactory::Create(RecorderCodec codec, uint32_t queue_size)
+{
+    return g_intrusion_recorder_mock;
+}
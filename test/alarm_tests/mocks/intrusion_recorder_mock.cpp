@@ -0,0 +1,9 @@
+#include "intrusion_recorder_mock.hpp"
+
+IntrusionRecorderMock::IntrusionRecorderMock()
+{
+}
+
+IntrusionRecorderMock::~IntrusionRecorderMock()
+{
+}
@@ -0,0 +1,15 @@
+#include <gmock/gmock.h>
+
+#include "../../../inc/intrusion_recorder_interface.hpp"
+
+class IntrusionRecorderMock : public IIntrusionRecorder
+{
+public:
+
+    IntrusionRecorderMock();
+    virtual ~IntrusionRecorderMock();
+
+    MOCK_METHOD(int, Start, (const std::string& path, uint32_t frame_interval_ms, int32_t brightness, int32_t contrast));
+    MOCK_METHOD(int, AddFrame, (std::shared_ptr<const KinectVideoFrame> frame, uint32_t frame_num));
+    MOCK_METHOD(int, Stop, (std::function<void()> finalized));
+};
@@ -0,0 +1,191 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file background_model_tests.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdlib>
+
+#include "../../inc/background_model.hpp"
+
+/*******************************************************************
+ * Test class definition
+ *******************************************************************/
+class DepthBackgroundModelTest : public ::testing::Test
+{
+public:
+    DepthBackgroundModelTest()
+    {
+        frame_data.resize(width * height);
+    }
+
+    ~DepthBackgroundModelTest()
+    {
+    }
+
+    void UpdateWithValue(DepthBackgroundModel& model, uint16_t value)
+    {
+        KinectDepthFrame frame(width, height);
+        frame_data.assign(frame_data.size(), value);
+        frame.Fill(frame_data.data(), 0);
+        model.Update(frame);
+    }
+
+protected:
+    uint32_t width = 64, height = 48;
+    float learning_rate = 0.5f;
+    float k_sigma = 3.0f;
+    float min_tolerance = 200.0f;
+    std::vector<uint16_t> frame_data;
+};
+
+/*******************************************************************
+ * Test cases
+ *******************************************************************/
+TEST_F(DepthBackgroundModelTest, EmptyUntilFirstUpdate)
+{
+    DepthBackgroundModel model(learning_rate, k_sigma, min_tolerance);
+
+    EXPECT_EQ(model.GetBackground(), nullptr);
+
+    UpdateWithValue(model, 1000);
+
+    std::shared_ptr<const DepthBackground> background = model.GetBackground();
+    ASSERT_NE(background, nullptr);
+    EXPECT_EQ(background->mean.GetWidth(), width);
+    EXPECT_EQ(background->mean.GetHeight(), height);
+    EXPECT_EQ(background->mean.GetDataPointer()[0], 1000);
+    EXPECT_EQ(background->tolerances[0], 0);
+
+    model.Reset();
+    EXPECT_EQ(model.GetBackground(), nullptr);
+}
+
+TEST_F(DepthBackgroundModelTest, MeanConvergesAndSpreadFollowsTheNoise)
+{
+    DepthBackgroundModel model(learning_rate, k_sigma, min_tolerance);
+
+    UpdateWithValue(model, 1000);
+    UpdateWithValue(model, 1100);
+
+    /* mean = 1000 + 0.5 * 100, variance = 0.5 * (0 + 0.5 * 100^2) */
+    std::shared_ptr<const DepthBackground> background = model.GetBackground();
+    EXPECT_EQ(background->mean.GetDataPointer()[0], 1050);
+    EXPECT_EQ(background->tolerances[0], 150);
+
+    /* Without noise the spread vanishes */
+    for(int i = 0; i < 30; i++)
+    {
+        UpdateWithValue(model, 1100);
+    }
+    background = model.GetBackground();
+    EXPECT_EQ(background->mean.GetDataPointer()[0], 1100);
+    EXPECT_EQ(background->tolerances[0], 0);
+}
+
+TEST_F(DepthBackgroundModelTest, ForegroundDoesNotWidenTheSpread)
+{
+    DepthBackgroundModel model(learning_rate, k_sigma, 10.0f);
+
+    UpdateWithValue(model, 1000);
+    UpdateWithValue(model, 1100);
+
+    /* The mean moves towards the change but the tolerance stays */
+    std::shared_ptr<const DepthBackground> background = model.GetBackground();
+    EXPECT_EQ(background->mean.GetDataPointer()[0], 1050);
+    EXPECT_EQ(background->tolerances[0], 0);
+}
+
+TEST_F(DepthBackgroundModelTest, BlankPixelsAreNotLearned)
+{
+    DepthBackgroundModel model(learning_rate, k_sigma, min_tolerance);
+
+    UpdateWithValue(model, BLANK_DEPTH_PIXEL);
+    EXPECT_EQ(model.GetBackground()->mean.GetDataPointer()[0], BLANK_DEPTH_PIXEL);
+
+    UpdateWithValue(model, 800);
+    UpdateWithValue(model, BLANK_DEPTH_PIXEL);
+    EXPECT_EQ(model.GetBackground()->mean.GetDataPointer()[0], 800);
+}
+
+TEST_F(DepthBackgroundModelTest, HeldBackgroundIsNotModified)
+{
+    DepthBackgroundModel model(learning_rate, k_sigma, min_tolerance);
+
+    UpdateWithValue(model, 1000);
+    std::shared_ptr<const DepthBackground> held = model.GetBackground();
+
+    UpdateWithValue(model, 2000);
+    UpdateWithValue(model, 2000);
+
+    EXPECT_EQ(held->mean.GetDataPointer()[0], 1000);
+    EXPECT_NE(model.GetBackground(), held);
+}
+
+TEST_F(DepthBackgroundModelTest, SizeChangeResetsTheModel)
+{
+    DepthBackgroundModel model(learning_rate, k_sigma, min_tolerance);
+
+    UpdateWithValue(model, 1000);
+
+    KinectDepthFrame frame(width / 2, height / 2);
+    std::vector<uint16_t> data((width / 2) * (height / 2), 500);
+    frame.Fill(data.data(), 0);
+    model.Update(frame);
+
+    std::shared_ptr<const DepthBackground> background = model.GetBackground();
+    EXPECT_EQ(background->mean.GetWidth(), width / 2);
+    EXPECT_EQ(background->mean.GetDataPointer()[0], 500);
+    EXPECT_EQ(background->tolerances.size(), data.size());
+}
+
+TEST_F(DepthBackgroundModelTest, UpdateBackgroundKernelsMatchScalar)
+{
+    const uint32_t num_pixels = 1027;
+    std::vector<uint16_t> frame(num_pixels);
+    std::vector<float> mean_init(num_pixels);
+    std::vector<float> variance_init(num_pixels);
+
+    /* Never measured pixels, blank pixels and extreme values */
+    std::srand(1234);
+    for(uint32_t i = 0; i < num_pixels; i++)
+    {
+        frame[i] = (std::rand() % 8 == 0) ? BLANK_DEPTH_PIXEL : ((std::rand() % 16 == 0) ? 0xFFFF : std::rand() % 2048);
+        mean_init[i] = (std::rand() % 8 == 0) ? -1.0f : static_cast<float>(std::rand() % 2048);
+        variance_init[i] = static_cast<float>(std::rand() % 100000);
+    }
+
+    for(KernelVariant variant : {KernelVariant::Scalar, KernelVariant::Sse41, KernelVariant::Avx2, KernelVariant::Neon})
+    {
+        UpdateBackgroundKernel kernel = GetUpdateBackgroundKernel(variant);
+        if(kernel == nullptr)
+        {
+            continue;
+        }
+
+        std::vector<float> mean = mean_init, mean_ref = mean_init;
+        std::vector<float> variance = variance_init, variance_ref = variance_init;
+        std::vector<uint16_t> mean_out(num_pixels), mean_out_ref(num_pixels);
+        std::vector<uint16_t> tolerances(num_pixels), tolerances_ref(num_pixels);
+
+        kernel(frame.data(), mean.data(), variance.data(), mean_out.data(), tolerances.data(), num_pixels, 0.05f, 3.0f, 10.0f);
+        UpdateBackgroundScalar(frame.data(), mean_ref.data(), variance_ref.data(), mean_out_ref.data(), tolerances_ref.data(),
+                               num_pixels, 0.05f, 3.0f, 10.0f);
+
+        /* Floating point contraction may differ between kernels, the rounded outputs can differ by one */
+        for(uint32_t i = 0; i < num_pixels; i++)
+        {
+            EXPECT_FLOAT_EQ(mean[i], mean_ref[i]) << GetKernelVariantName(variant) << " pixel " << i;
+            EXPECT_NEAR(variance[i], variance_ref[i], variance_ref[i] * 1e-5f) << GetKernelVariantName(variant) << " pixel " << i;
+            EXPECT_NEAR(mean_out[i], mean_out_ref[i], 1) << GetKernelVariantName(variant) << " pixel " << i;
+            EXPECT_NEAR(tolerances[i], tolerances_ref[i], 1) << GetKernelVariantName(variant) << " pixel " << i;
+        }
+    }
+}
@@ -0,0 +1,121 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file base64_encoder_tests.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../../inc/base64_encoder.hpp"
+
+/*******************************************************************
+ * Test class definition
+ *******************************************************************/
+class Base64EncoderTest : public ::testing::Test
+{
+public:
+    Base64EncoderTest()
+    {
+    }
+
+    ~Base64EncoderTest()
+    {
+    }
+
+    std::string Encode(const std::string& input)
+    {
+        std::string output;
+        encoder.Encode(reinterpret_cast<const uint8_t*>(input.data()), input.size(), output);
+        return output;
+    }
+
+protected:
+    Base64Encoder encoder;
+};
+
+/*******************************************************************
+ * Test cases
+ *******************************************************************/
+TEST_F(Base64EncoderTest, Rfc4648Vectors)
+{
+    EXPECT_EQ(Encode(""), "");
+    EXPECT_EQ(Encode("f"), "Zg==");
+    EXPECT_EQ(Encode("fo"), "Zm8=");
+    EXPECT_EQ(Encode("foo"), "Zm9v");
+    EXPECT_EQ(Encode("foob"), "Zm9vYg==");
+    EXPECT_EQ(Encode("fooba"), "Zm9vYmE=");
+    EXPECT_EQ(Encode("foobar"), "Zm9vYmFy");
+}
+
+TEST_F(Base64EncoderTest, LongInputUsesTheWholeAlphabet)
+{
+    std::string input;
+
+    /* Every 6 bits index in order: 0x00 0x10 0x83 0x10 0x51 0x87 ... */
+    for(uint32_t i = 0; i < 64; i += 4)
+    {
+        uint32_t group = (i << 18) | ((i + 1) << 12) | ((i + 2) << 6) | (i + 3);
+        input.push_back(static_cast<char>(group >> 16));
+        input.push_back(static_cast<char>(group >> 8));
+        input.push_back(static_cast<char>(group));
+    }
+
+    EXPECT_EQ(Encode(input), "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/");
+}
+
+TEST_F(Base64EncoderTest, OutputBufferIsReused)
+{
+    std::vector<uint8_t> input(3000, 0xAB);
+    std::string output;
+
+    encoder.Encode(input.data(), input.size(), output);
+    const char* output_data = output.data();
+    encoder.Encode(input.data(), input.size() / 2, output);
+
+    EXPECT_EQ(output.size(), Base64Encoder::EncodedSize(input.size() / 2));
+    EXPECT_EQ(output.data(), output_data);
+}
+
+TEST_F(Base64EncoderTest, KernelsBitExact)
+{
+    std::vector<uint8_t> input(1000);
+    std::vector<char> expected(Base64Encoder::EncodedSize(input.size()));
+    std::vector<char> result(Base64Encoder::EncodedSize(input.size()));
+
+    std::srand(1234);
+    for(auto& byte : input)
+    {
+        byte = std::rand() % 256;
+    }
+
+    for(KernelVariant variant : {KernelVariant::Scalar, KernelVariant::Sse41, KernelVariant::Avx2, KernelVariant::Neon})
+    {
+        Base64Encoder::Kernel kernel = Base64Encoder::GetKernel(variant);
+        if(kernel == nullptr)
+        {
+            continue;
+        }
+
+        for(size_t length : {0, 1, 2, 3, 23, 24, 27, 28, 29, 47, 48, 49, 52, 95, 96, 100, 1000})
+        {
+            for(size_t offset : {0, 1})
+            {
+                size_t size = (length > offset) ? length - offset : 0;
+                Base64Encoder::EncodeScalar(input.data() + offset, size, expected.data());
+                kernel(input.data() + offset, size, result.data());
+                EXPECT_EQ(std::string(result.data(), Base64Encoder::EncodedSize(size)),
+                          std::string(expected.data(), Base64Encoder::EncodedSize(size)))
+                    << GetKernelVariantName(variant) << " length " << size;
+            }
+        }
+    }
+}
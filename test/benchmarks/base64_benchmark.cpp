@@ -0,0 +1,121 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file base64_benchmark.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <openssl/pem.h>
+
+#include "../../inc/base64_encoder.hpp"
+
+/*******************************************************************
+ * Class definition
+ *******************************************************************/
+/* Previous encoder: input copied by value, OpenSSL base64 filter BIO over a memory BIO, then copied out */
+class BioBase64Encoder
+{
+public:
+    BioBase64Encoder()
+    {
+        m_b64_bio = BIO_new(BIO_f_base64());
+        m_mem_bio = BIO_new(BIO_s_mem());
+        BIO_push(m_b64_bio, m_mem_bio);
+        BIO_set_flags(m_b64_bio, BIO_FLAGS_BASE64_NO_NL);
+        BIO_get_mem_ptr(m_mem_bio, &m_mem_buffer);
+    }
+
+    ~BioBase64Encoder()
+    {
+        BIO_free_all(m_b64_bio);
+    }
+
+    std::string& Encode(std::string input)
+    {
+        BIO_reset(m_b64_bio);
+        BIO_reset(m_mem_bio);
+        BIO_write(m_b64_bio, input.data(), input.length());
+        BIO_flush(m_b64_bio);
+        BUF_MEM_grow(m_mem_buffer, (*m_mem_buffer).length + 1);
+        (*m_mem_buffer).data[(*m_mem_buffer).length] = '\0';
+        m_output = (*m_mem_buffer).data;
+
+        return m_output;
+    }
+
+private:
+    BIO *m_b64_bio = nullptr, *m_mem_bio = nullptr;
+    BUF_MEM *m_mem_buffer = nullptr;
+    std::string m_output;
+};
+
+/*******************************************************************
+ * Function definition
+ *******************************************************************/
+template<class Function>
+static double MeasureUsPerIteration(uint32_t iterations, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for(uint32_t i = 0; i < iterations; i++)
+    {
+        function();
+    }
+
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / iterations;
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t iterations = (argc > 1) ? std::atoi(argv[1]) : 1000;
+    volatile size_t sink = 0;
+
+    /* Sizes of 640x480 JPEG frames, from a dark IR frame to a detailed side by side one */
+    for(size_t size : {16384U, 49152U, 131072U})
+    {
+        std::vector<uint8_t> jpeg(size);
+        std::string jpeg_string;
+        std::string output;
+        BioBase64Encoder bio_encoder;
+        Base64Encoder encoder;
+
+        std::srand(1234);
+        for(auto& byte : jpeg)
+        {
+            byte = std::rand() % 256;
+        }
+        jpeg_string.assign(jpeg.begin(), jpeg.end());
+
+        printf("Payload %zu bytes, %u iterations\n", size, iterations);
+        printf("%-40s %10.2f us\n", "OpenSSL BIO (previous path)",
+               MeasureUsPerIteration(iterations, [&]{ sink = sink + bio_encoder.Encode(std::string(jpeg.begin(), jpeg.end())).size(); }));
+
+        for(KernelVariant variant : {KernelVariant::Scalar, KernelVariant::Avx2, KernelVariant::Neon})
+        {
+            Base64Encoder::Kernel kernel = Base64Encoder::GetKernel(variant);
+            if(kernel == nullptr)
+            {
+                continue;
+            }
+
+            output.resize(Base64Encoder::EncodedSize(size));
+            printf("%-40s %10.2f us\n", GetKernelVariantName(variant),
+                   MeasureUsPerIteration(iterations, [&]{ kernel(jpeg.data(), jpeg.size(), output.data()); sink = sink + output[0]; }));
+        }
+
+        printf("%-40s %10.2f us\n", "Base64Encoder::Encode",
+               MeasureUsPerIteration(iterations, [&]{ encoder.Encode(jpeg.data(), jpeg.size(), output); sink = sink + output.size(); }));
+    }
+
+    return 0;
+}
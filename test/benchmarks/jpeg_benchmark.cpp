@@ -0,0 +1,124 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file jpeg_benchmark.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <FreeImage.h>
+
+#include "../../inc/global_parameters.hpp"
+#include "../../inc/kinect_frame.hpp"
+#include "../../inc/jpeg_encoder.hpp"
+#include "../../inc/kinect_frame_kernels.hpp"
+
+/*******************************************************************
+ * Function definition
+ *******************************************************************/
+template<class Function>
+static double MeasureUsPerIteration(uint32_t iterations, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for(uint32_t i = 0; i < iterations; i++)
+    {
+        function();
+    }
+
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / iterations;
+}
+
+/* Previous path: 8 bits copy, FreeImage bitmap, brightness and contrast passes and FreeImage JPEG plugin */
+static int FreeImageSaveToJpegInMemory(const KinectFrameView& view, int32_t brightness, int32_t contrast, std::vector<uint8_t>& jpeg)
+{
+    int retval = 0;
+    std::vector<uint8_t> bmap(view.NumPixels());
+    FIMEMORY* fi_memory = FreeImage_OpenMemory();
+    BYTE* mem_buffer = NULL;
+    DWORD size_in_bytes = 0;
+
+    for(uint32_t i = 0; i < view.NumPixels(); i++)
+    {
+        bmap[i] = (view.data[i] >> 2);
+    }
+
+    FIBITMAP* bitmap = FreeImage_ConvertFromRawBits(bmap.data(), view.width, view.height, view.width, 8, 0xFF, 0xFF, 0xFF, true);
+    FreeImage_AdjustBrightness(bitmap, brightness);
+    FreeImage_AdjustContrast(bitmap, contrast);
+
+    if(!FreeImage_SaveToMemory(FIF_JPEG, bitmap, fi_memory, 0))
+    {
+        retval = 1;
+    }
+
+    FreeImage_AcquireMemory(fi_memory, &mem_buffer, &size_in_bytes);
+    jpeg.assign(mem_buffer, mem_buffer + size_in_bytes);
+
+    FreeImage_CloseMemory(fi_memory);
+    FreeImage_Unload(bitmap);
+
+    return retval;
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t iterations = (argc > 1) ? std::atoi(argv[1]) : 200;
+    const int32_t brightness = 20;
+    const int32_t contrast = 10;
+    std::vector<uint16_t> data(VIDEO_WIDTH * VIDEO_HEIGHT);
+    std::vector<uint8_t> jpeg;
+    volatile size_t sink = 0;
+
+    /* IR scene: gradient with speckle noise */
+    std::srand(1234);
+    for(uint32_t i = 0; i < data.size(); i++)
+    {
+        data[i] = ((i % VIDEO_WIDTH) + (i / VIDEO_WIDTH)) % 1024 + (std::rand() % 8);
+        data[i] = (data[i] > 1023) ? 1023 : data[i];
+    }
+
+    KinectVideoFrame frame(VIDEO_WIDTH, VIDEO_HEIGHT);
+    frame.Fill(data.data(), 1);
+    KinectFrameView view = frame.GetView();
+
+    printf("IR frame %ux%u, %u iterations\n", VIDEO_WIDTH, VIDEO_HEIGHT, iterations);
+    printf("%-40s %10.2f us/frame\n", "FreeImage (copy + adjusts + encode)",
+           MeasureUsPerIteration(iterations, [&]{ FreeImageSaveToJpegInMemory(view, brightness, contrast, jpeg); sink = sink + jpeg.size(); }));
+
+    JpegToneLut lut;
+    std::vector<uint8_t> samples(view.NumPixels());
+    JpegEncoder::BuildToneLut(brightness, contrast, JPEG_GAMMA, lut);
+    for(KernelVariant variant : {KernelVariant::Scalar, KernelVariant::Avx2})
+    {
+        ToneMapKernel kernel = GetToneMapKernel(variant);
+        if(kernel == nullptr)
+        {
+            continue;
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "ToneMap %s", GetKernelVariantName(variant));
+        printf("%-40s %10.2f us/frame\n", name,
+               MeasureUsPerIteration(iterations, [&]{ kernel(view.data, samples.data(), view.NumPixels(), lut.data()); sink = sink + samples[0]; }));
+    }
+
+    for(bool fast_dct : {false, true})
+    {
+        JpegEncoder encoder(JPEG_QUALITY, fast_dct, JPEG_GAMMA);
+
+        printf("%-40s %10.2f us/frame\n", fast_dct ? "JpegEncoder (fast DCT)" : "JpegEncoder",
+               MeasureUsPerIteration(iterations, [&]{ encoder.Encode(view, brightness, contrast, jpeg); sink = sink + jpeg.size(); }));
+    }
+    printf("%-40s %10zu bytes\n", "JpegEncoder output", jpeg.size());
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file kinect_frame_benchmark.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../../inc/global_parameters.hpp"
+#include "../../inc/kinect_frame.hpp"
+#include "../../inc/background_model.hpp"
+
+/*******************************************************************
+ * Function definition
+ *******************************************************************/
+template<class Function>
+static double MeasureUsPerIteration(uint32_t iterations, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for(uint32_t i = 0; i < iterations; i++)
+    {
+        function();
+    }
+
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / iterations;
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t iterations = (argc > 1) ? std::atoi(argv[1]) : 1000;
+    const uint32_t tolerance = DETECTION_SENSITIVITY;
+    std::vector<uint16_t> data_1(DEPTH_WIDTH * DEPTH_HEIGHT);
+    std::vector<uint16_t> data_2(DEPTH_WIDTH * DEPTH_HEIGHT);
+    volatile uint32_t sink = 0;
+
+    /* Depth scene with sensor noise and some blank pixels */
+    std::srand(1234);
+    for(uint32_t i = 0; i < data_1.size(); i++)
+    {
+        data_1[i] = (std::rand() % 16 == 0) ? BLANK_DEPTH_PIXEL : 600 + (i % DEPTH_WIDTH) / 4;
+        data_2[i] = (data_1[i] == BLANK_DEPTH_PIXEL) ? BLANK_DEPTH_PIXEL : data_1[i] + (std::rand() % 5) - 2;
+    }
+
+    KinectDepthFrame frame_1(DEPTH_WIDTH, DEPTH_HEIGHT);
+    KinectDepthFrame frame_2(DEPTH_WIDTH, DEPTH_HEIGHT);
+    frame_1.Fill(data_1.data(), 1);
+    frame_2.Fill(data_2.data(), 2);
+
+    printf("Depth frame %ux%u, %u iterations\n", DEPTH_WIDTH, DEPTH_HEIGHT, iterations);
+    printf("%-40s %10.2f us/frame\n", "Fill (copy + pyramid)",
+           MeasureUsPerIteration(iterations, [&]{ frame_2.Fill(data_2.data(), 2); }));
+
+    for(uint32_t level = 0; level < DEPTH_PYRAMID_LEVELS; level++)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "ComputeDifferencesAtLevel %u (%ux%u)", level, DEPTH_WIDTH >> level, DEPTH_HEIGHT >> level);
+        printf("%-40s %10.2f us/frame\n", name,
+               MeasureUsPerIteration(iterations, [&]{ sink = sink + frame_1.ComputeDifferencesAtLevel(frame_2, tolerance, level); }));
+    }
+
+    DepthBackgroundModel background_model(DETECTION_BACKGROUND_LEARNING_RATE, DETECTION_BACKGROUND_K_SIGMA, tolerance);
+    background_model.Update(frame_1);
+    std::shared_ptr<const DepthBackground> background = background_model.GetBackground();
+
+    printf("%-40s %10.2f us/frame\n", "DepthBackgroundModel::Update",
+           MeasureUsPerIteration(iterations, [&]{ background_model.Update(frame_2); }));
+    printf("%-40s %10.2f us/frame\n", "ComputeDifferencesWithTolerances",
+           MeasureUsPerIteration(iterations, [&]{ sink = sink + frame_2.ComputeDifferencesWithTolerances(background->mean,
+                                                                      background->tolerances.data(), tolerance); }));
+
+    return 0;
+}
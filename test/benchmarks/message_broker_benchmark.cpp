@@ -0,0 +1,110 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file message_broker_benchmark.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "../../inc/message_broker_factory.hpp"
+
+/*******************************************************************
+ * Class definition
+ *******************************************************************/
+/* Counts the received messages so the publisher can wait for each one */
+class CountingObserver : public IChannelMessageObserver
+{
+public:
+    void ChannelMessageListener(const std::string& message) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_received++;
+        }
+        m_condition_variable.notify_one();
+    }
+
+    bool WaitFor(uint64_t received)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        return m_condition_variable.wait_for(lock, std::chrono::seconds(1), [&]{ return m_received >= received; });
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition_variable;
+    uint64_t m_received = 0;
+};
+
+/*******************************************************************
+ * Function definition
+ *******************************************************************/
+template<class Function>
+static double MeasureUsPerIteration(uint32_t iterations, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for(uint32_t i = 0; i < iterations; i++)
+    {
+        function();
+    }
+
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / iterations;
+}
+
+static void Benchmark(const char* name, std::shared_ptr<IMessageBroker> message_broker, uint32_t iterations)
+{
+    std::shared_ptr<CountingObserver> observer = std::make_shared<CountingObserver>();
+    std::string frame(49152, 'x');
+    Variable variable{"benchmark_var", DataType::Integer, 0};
+    uint64_t published = 0;
+
+    message_broker->Subscribe("benchmark", observer);
+
+    printf("%s, %u iterations\n", name, iterations);
+    printf("%-40s %10.2f us\n", "SetVariable",
+           MeasureUsPerIteration(iterations, [&]{ message_broker->SetVariable({"benchmark_var", DataType::Integer, 1}); }));
+    printf("%-40s %10.2f us\n", "GetVariable",
+           MeasureUsPerIteration(iterations, [&]{ message_broker->GetVariable(variable); }));
+    printf("%-40s %10.2f us\n", "Publish to delivery (16 bytes)",
+           MeasureUsPerIteration(iterations, [&]{ message_broker->Publish("benchmark", "0123456789abcdef"); observer->WaitFor(++published); }));
+    printf("%-40s %10.2f us\n", "Publish to delivery (48 KiB frame)",
+           MeasureUsPerIteration(iterations, [&]{ message_broker->Publish("benchmark", frame); observer->WaitFor(++published); }));
+
+    message_broker->Unsubscribe("benchmark", observer);
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t iterations = (argc > 1) ? std::atoi(argv[1]) : 1000;
+
+    Benchmark("Local broker", MessageBrokerFactory::Create("", MessageBrokerType::Local), iterations);
+
+    /* Compared against a Redis server if its socket is given */
+    if(argc > 2)
+    {
+        try
+        {
+            Benchmark("Redis broker", MessageBrokerFactory::Create(argv[2], MessageBrokerType::Redis), iterations);
+        }
+        catch(...)
+        {
+            printf("Error connecting to %s\n", argv[2]);
+        }
+    }
+
+    return 0;
+}
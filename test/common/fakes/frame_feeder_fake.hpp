@@ -0,0 +1,105 @@
+#ifndef FRAME_FEEDER_FAKE__H_
+#define FRAME_FEEDER_FAKE__H_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "../../../inc/frame_exchange.hpp"
+
+/* Emulates a Kinect frame subscription: delivers the first frame and then the next one repeatedly from its own
+ * thread, one of each decimation, until it's cancelled. The callback is called synchronously so the queue
+ * configuration is ignored */
+template<class FrameType>
+class FrameFeederFake
+{
+public:
+    using Callback = std::function<void(std::shared_ptr<const FrameType>)>;
+
+    FrameFeederFake(int subscription, uint32_t period_ms) :
+        m_subscription(subscription), m_period_ms(period_ms), m_running(false)
+    {
+    }
+
+    ~FrameFeederFake()
+    {
+        Unsubscribe(m_subscription);
+    }
+
+    /* The next frame can be changed while the frames are being delivered */
+    void SetFrames(std::shared_ptr<const FrameType> first_frame, std::shared_ptr<const FrameType> next_frame)
+    {
+        std::lock_guard<std::mutex> lock_guard(m_mutex);
+        m_first_frame = first_frame;
+        m_next_frame = next_frame;
+    }
+
+    int Subscribe(Callback callback, uint32_t decimation, FrameQueueConfig queue_config)
+    {
+        Unsubscribe(m_subscription);
+
+        m_running = true;
+        m_thread = std::thread([this, callback, decimation]
+        {
+            uint32_t counter = 0;
+            std::shared_ptr<const FrameType> frame = GetFirstFrame();
+
+            while(m_running)
+            {
+                if((counter++ % std::max(decimation, 1U)) == 0)
+                {
+                    callback(frame);
+                }
+                frame = GetNextFrame();
+                std::this_thread::sleep_for(std::chrono::milliseconds(m_period_ms));
+            }
+        });
+
+        return m_subscription;
+    }
+
+    int Unsubscribe(int subscription)
+    {
+        if(subscription != m_subscription || !m_thread.joinable())
+        {
+            return -1;
+        }
+
+        m_running = false;
+        m_thread.join();
+
+        return 0;
+    }
+
+    /* Only from the thread that (un)subscribes */
+    bool IsSubscribed() const
+    {
+        return m_thread.joinable();
+    }
+
+private:
+    std::shared_ptr<const FrameType> GetFirstFrame()
+    {
+        std::lock_guard<std::mutex> lock_guard(m_mutex);
+        return m_first_frame ? m_first_frame : m_next_frame;
+    }
+
+    std::shared_ptr<const FrameType> GetNextFrame()
+    {
+        std::lock_guard<std::mutex> lock_guard(m_mutex);
+        return m_next_frame;
+    }
+
+    int m_subscription;
+    uint32_t m_period_ms;
+    std::atomic<bool> m_running;
+    std::shared_ptr<const FrameType> m_first_frame;
+    std::shared_ptr<const FrameType> m_next_frame;
+    std::mutex m_mutex;
+    std::thread m_thread;
+};
+
+#endif
@@ -17,7 +17,7 @@
  *******************************************************************/
 extern std::shared_ptr<IMessageBroker> message_broker_mock;
 
-std::shared_ptr<IMessageBroker> MessageBrokerFactory::Create(std::string path)
+std::shared_ptr<IMessageBroker> MessageBrokerFactory::Create(std::string path, MessageBrokerType type)
 {
     return nullptr;
 }
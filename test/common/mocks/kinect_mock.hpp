@@ -27,8 +27,14 @@ public:
     MOCK_METHOD(int, Start, ());
     MOCK_METHOD(int, Stop, ());
     MOCK_METHOD(bool, IsRunning, ());
-    MOCK_METHOD(void, GetDepthFrame, (KinectDepthFrame& frame));
-    MOCK_METHOD(void, GetVideoFrame, (KinectVideoFrame& frame));
+    MOCK_METHOD(void, GetDepthFrame, (std::shared_ptr<const KinectDepthFrame>& frame));
+    MOCK_METHOD(void, GetVideoFrame, (std::shared_ptr<const KinectVideoFrame>& frame));
+    MOCK_METHOD(int, SubscribeDepthFrames, (DepthFrameCallback callback, uint32_t decimation, FrameQueueConfig queue_config));
+    MOCK_METHOD(int, SubscribeVideoFrames, (VideoFrameCallback callback, uint32_t decimation, FrameQueueConfig queue_config));
+    MOCK_METHOD(int, ChangeDecimation, (int subscription, uint32_t decimation));
+    MOCK_METHOD(int, Unsubscribe, (int subscription));
+    MOCK_METHOD(FrameStreamStats, GetDepthFrameStats, ());
+    MOCK_METHOD(FrameStreamStats, GetVideoFrameStats, ());
     MOCK_METHOD(int, ChangeTilt, (double tilt_angle));
     MOCK_METHOD(int, ChangeLedColor, (freenect_led_options color));
 };
@@ -23,9 +23,12 @@ public:
     MOCK_METHOD(int, Subscribe, (const std::string& channel, const std::shared_ptr<IChannelMessageObserver> observer));
     MOCK_METHOD(int, Unsubscribe, (const std::string& channel, const std::shared_ptr<IChannelMessageObserver> observer));
     MOCK_METHOD(int, Publish, (const std::string& channel, const std::string& message));
+    MOCK_METHOD(int, PublishBinary, (const std::string& channel, const uint8_t* data, size_t size));
     MOCK_METHOD(int, GetVariable, (Variable& variable));
     MOCK_METHOD(int, SetVariable, (const Variable& variable));
     MOCK_METHOD(int, SetVariableExpiration, (const Variable& variable, int livetime_seconds));
+    MOCK_METHOD(int, SetVariables, (const std::vector<Variable>& variables));
+    MOCK_METHOD(int, SetVariablesAndPublish, (const std::vector<Variable>& variables, const std::string& channel, const std::string& message));
     MOCK_METHOD(int, Clear, ());
 };
 
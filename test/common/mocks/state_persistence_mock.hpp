@@ -27,6 +27,7 @@ public:
     MOCK_METHOD(int, NumberItems, (int& number_items));
     MOCK_METHOD(int, InsertItem, (const Entry& item));
     MOCK_METHOD(int, GetItem, (Entry& item));
+    MOCK_METHOD(int, GetAllItems, (std::vector<Entry>& items));
     MOCK_METHOD(int, SetItem, (const Entry& item));
     MOCK_METHOD(int, DeleteItem, (const Entry& item));
     MOCK_METHOD(int, DeleteAllItems, ());
@@ -12,6 +12,7 @@
 #include <gmock/gmock.h>
 
 #include "../common/mocks/kinect_mock.hpp"
+#include "../common/fakes/frame_feeder_fake.hpp"
 #include "mocks/detection_observer_mock.hpp"
 #include "../../inc/detection.hpp"
 
@@ -25,6 +26,7 @@ using ::testing::StrictMock;
 using ::testing::SetArgReferee;
 using ::testing::Ref;
 using ::testing::AtLeast;
+using ::testing::Invoke;
 
 class DetectionTest : public ::testing::Test
 {
@@ -37,6 +39,10 @@ public:
         detection_config.refresh_reference_interval_ms = 40;
         detection_config.take_depth_frame_interval_ms = 10;
         detection_config.take_video_frame_interval_ms = 20;
+        /* Snapshot reference unless the test enables the background model */
+        detection_config.background_model = false;
+        /* Video frames only taken during intrusions unless the test enables the pre-roll */
+        detection_config.preroll_ms = 0;
 
         kinect_mock = std::make_shared<StrictMock<KinectMock>>();
         detection_observer_mock = std::make_shared<StrictMock<DetectionObserverMock>>();
@@ -46,12 +52,46 @@ public:
     {
     }
 
-    void FillFrameWithValue(KinectFrame& frame, uint16_t value, uint32_t timestamp)
+    /* The Kinect delivers the first frame and then the next one every 10 ms */
+    void ExpectDepthFrames(std::shared_ptr<const KinectDepthFrame> first_frame, std::shared_ptr<const KinectDepthFrame> next_frame)
     {
+        depth_feeder.SetFrames(first_frame, next_frame);
+        EXPECT_CALL(*kinect_mock, SubscribeDepthFrames(_, _, _)).
+            WillRepeatedly(Invoke(&depth_feeder, &FrameFeederFake<KinectDepthFrame>::Subscribe));
+        EXPECT_CALL(*kinect_mock, Unsubscribe(depth_subscription)).
+            WillRepeatedly(Invoke(&depth_feeder, &FrameFeederFake<KinectDepthFrame>::Unsubscribe));
+    }
+
+    /* The Kinect delivers the same video frame every 20 ms */
+    void ExpectVideoFrames(std::shared_ptr<const KinectVideoFrame> frame)
+    {
+        video_feeder.SetFrames(nullptr, frame);
+        EXPECT_CALL(*kinect_mock, SubscribeVideoFrames(_, _, _)).
+            WillRepeatedly(Invoke(&video_feeder, &FrameFeederFake<KinectVideoFrame>::Subscribe));
+        EXPECT_CALL(*kinect_mock, Unsubscribe(video_subscription)).
+            WillRepeatedly(Invoke(&video_feeder, &FrameFeederFake<KinectVideoFrame>::Unsubscribe));
+    }
+
+    std::shared_ptr<const KinectDepthFrame> CreateDepthFrameWithValueOnLeftHalf(uint16_t value, uint16_t left_value, uint32_t timestamp)
+    {
+        std::shared_ptr<KinectDepthFrame> frame = std::make_shared<KinectDepthFrame>(DEPTH_WIDTH, DEPTH_HEIGHT);
+        std::vector<uint16_t> frame_data(DEPTH_WIDTH * DEPTH_HEIGHT, value);
+        for(uint32_t row = 0; row < DEPTH_HEIGHT; row++)
+        {
+            std::fill_n(frame_data.begin() + row * DEPTH_WIDTH, DEPTH_WIDTH / 2, left_value);
+        }
+        frame->Fill(frame_data.data(), timestamp);
+        return frame;
+    }
+
+    std::shared_ptr<const KinectDepthFrame> CreateDepthFrameWithValue(uint16_t value, uint32_t timestamp)
+    {
+        std::shared_ptr<KinectDepthFrame> frame = std::make_shared<KinectDepthFrame>(1920,1080);
         std::vector<uint16_t> frame_data;
         frame_data.resize(1920*1080);
         frame_data.assign(frame_data.size(), value);
-        frame.Fill(frame_data.data(), timestamp);
+        frame->Fill(frame_data.data(), timestamp);
+        return frame;
     }
 
 protected:
@@ -59,6 +99,10 @@ protected:
     std::shared_ptr<KinectMock> kinect_mock;
     std::shared_ptr<DetectionObserverMock> detection_observer_mock;
     uint32_t loop_period_ms = 100;
+    const int depth_subscription = 1;
+    const int video_subscription = 2;
+    FrameFeederFake<KinectDepthFrame> depth_feeder{depth_subscription, 10};
+    FrameFeederFake<KinectVideoFrame> video_feeder{video_subscription, 20};
 };
 
 /*******************************************************************
@@ -74,10 +118,9 @@ TEST_F(DetectionTest, Contructor)
 TEST_F(DetectionTest, StartsTakingDepthFrames)
 {
     Detection detection(kinect_mock, detection_observer_mock, detection_config);
-    KinectDepthFrame kinect_frame_ref(1920,1080);
+    std::shared_ptr<const KinectDepthFrame> kinect_frame_ref = std::make_shared<KinectDepthFrame>(1920,1080);
 
-    EXPECT_CALL(*kinect_mock, GetDepthFrame(_)).
-        WillRepeatedly(SetArgReferee<0>(kinect_frame_ref));
+    ExpectDepthFrames(nullptr, kinect_frame_ref);
 
     ASSERT_EQ(detection.Start(), 0);
 
@@ -89,21 +132,15 @@ TEST_F(DetectionTest, StartsTakingDepthFrames)
 TEST_F(DetectionTest, DetectionOccursSuccess)
 {
     Detection detection(kinect_mock, detection_observer_mock, detection_config);
-    KinectDepthFrame kinect_depth_frame_ref(1920,1080);
-    KinectDepthFrame kinect_depth_frame_1(1920,1080);
-    KinectVideoFrame kinect_video_frame_1(1920,1080);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_ref = CreateDepthFrameWithValue(100, 1);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_1 = CreateDepthFrameWithValue(200, 2);
+    std::shared_ptr<const KinectVideoFrame> kinect_video_frame_1 = std::make_shared<KinectVideoFrame>(1920,1080);
 
-    FillFrameWithValue(kinect_depth_frame_ref, 100, 1);
-    FillFrameWithValue(kinect_depth_frame_1, 200, 2);
-
-    EXPECT_CALL(*kinect_mock, GetDepthFrame(_)).
-        WillOnce(SetArgReferee<0>(kinect_depth_frame_ref)).
-        WillRepeatedly(SetArgReferee<0>(kinect_depth_frame_1));
+    ExpectDepthFrames(kinect_depth_frame_ref, kinect_depth_frame_1);
 
     EXPECT_CALL(*detection_observer_mock, IntrusionStarted()).Times(1);
 
-    EXPECT_CALL(*kinect_mock, GetVideoFrame(_)).
-        WillRepeatedly(SetArgReferee<0>(kinect_video_frame_1));
+    ExpectVideoFrames(kinect_video_frame_1);
 
     EXPECT_CALL(*detection_observer_mock, IntrusionFrame(_, _)).Times(AtLeast(1));
 
@@ -114,4 +151,349 @@ TEST_F(DetectionTest, DetectionOccursSuccess)
     std::this_thread::sleep_for(std::chrono::milliseconds(150));
 
     ASSERT_EQ(detection.Stop(), 0);
-}
\ No newline at end of file
+}
+TEST_F(DetectionTest, DetectionIgnoresChangesOutsideZones)
+{
+    /* Zone on the right half, changes only on the left half */
+    detection_config.zones.push_back({1, 100, 10, {{320, 0}, {640, 0}, {640, 480}, {320, 480}}});
+
+    Detection detection(kinect_mock, detection_observer_mock, detection_config);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_ref = CreateDepthFrameWithValueOnLeftHalf(100, 100, 1);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_1 = CreateDepthFrameWithValueOnLeftHalf(100, 200, 2);
+
+    ExpectDepthFrames(kinect_depth_frame_ref, kinect_depth_frame_1);
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionStarted()).Times(0);
+
+    ASSERT_EQ(detection.Start(), 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    ASSERT_EQ(detection.Stop(), 0);
+}
+
+TEST_F(DetectionTest, DetectionOccursInsideZone)
+{
+    /* The first zone doesn't see the changes, the second one does */
+    detection_config.zones.push_back({1, 100, 10, {{320, 0}, {640, 0}, {640, 480}, {320, 480}}});
+
+    Detection detection(kinect_mock, detection_observer_mock, detection_config);
+    detection_config.zones.push_back({2, 100, 10, {{0, 0}, {50, 0}, {50, 50}, {0, 50}}});
+    detection.UpdateConfig(detection_config);
+
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_ref = CreateDepthFrameWithValueOnLeftHalf(100, 100, 1);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_1 = CreateDepthFrameWithValueOnLeftHalf(100, 200, 2);
+    std::shared_ptr<const KinectVideoFrame> kinect_video_frame_1 = std::make_shared<KinectVideoFrame>(VIDEO_WIDTH, VIDEO_HEIGHT);
+
+    ExpectDepthFrames(kinect_depth_frame_ref, kinect_depth_frame_1);
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionStarted()).Times(1);
+
+    ExpectVideoFrames(kinect_video_frame_1);
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionFrame(_, _)).Times(AtLeast(0));
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionStopped(_)).Times(AtLeast(0));
+
+    ASSERT_EQ(detection.Start(), 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    ASSERT_EQ(detection.Stop(), 0);
+}
+
+TEST_F(DetectionTest, HeatMapPublishedDuringIntrusion)
+{
+    detection_config.heat_map = true;
+
+    Detection detection(kinect_mock, detection_observer_mock, detection_config);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_ref = CreateDepthFrameWithValueOnLeftHalf(100, 100, 1);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_1 = CreateDepthFrameWithValueOnLeftHalf(100, 200, 2);
+    std::shared_ptr<const KinectVideoFrame> kinect_video_frame_1 = std::make_shared<KinectVideoFrame>(VIDEO_WIDTH, VIDEO_HEIGHT);
+    DifferenceMap heat_map;
+
+    ExpectDepthFrames(kinect_depth_frame_ref, kinect_depth_frame_1);
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionStarted()).Times(1);
+
+    ExpectVideoFrames(kinect_video_frame_1);
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionFrame(_, _)).Times(AtLeast(0));
+
+    /* The first one is computed against the reference that triggered the intrusion */
+    EXPECT_CALL(*detection_observer_mock, IntrusionHeatMap(_)).
+        Times(AtLeast(1)).
+        WillOnce(SaveArg<0>(&heat_map)).
+        WillRepeatedly(Return());
+
+    ASSERT_EQ(detection.Start(), 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    ASSERT_EQ(detection.Stop(), 0);
+
+    /* Only the blocks of the left half changed */
+    ASSERT_EQ(heat_map.columns, DEPTH_WIDTH / DETECTION_HEAT_MAP_BLOCK_SIZE);
+    ASSERT_EQ(heat_map.counts.size(), heat_map.columns * heat_map.rows);
+    EXPECT_EQ(heat_map.counts.front(), DETECTION_HEAT_MAP_BLOCK_SIZE * DETECTION_HEAT_MAP_BLOCK_SIZE);
+    EXPECT_EQ(heat_map.counts.back(), 0U);
+}
+
+TEST_F(DetectionTest, CoarseLevelFiltersSmallChanges)
+{
+    /* Half of the coarse level changes, below the coarse threshold */
+    detection_config.coarse_level = 2;
+    detection_config.coarse_threshold = (DEPTH_WIDTH >> 2) * (DEPTH_HEIGHT >> 2);
+
+    Detection detection(kinect_mock, detection_observer_mock, detection_config);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_ref = CreateDepthFrameWithValueOnLeftHalf(100, 100, 1);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_1 = CreateDepthFrameWithValueOnLeftHalf(100, 200, 2);
+
+    ExpectDepthFrames(kinect_depth_frame_ref, kinect_depth_frame_1);
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionStarted()).Times(0);
+
+    ASSERT_EQ(detection.Start(), 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    ASSERT_EQ(detection.Stop(), 0);
+}
+
+TEST_F(DetectionTest, CoarseLevelEscalatesToFullResolution)
+{
+    detection_config.coarse_level = 2;
+    detection_config.coarse_threshold = 10;
+
+    Detection detection(kinect_mock, detection_observer_mock, detection_config);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_ref = CreateDepthFrameWithValueOnLeftHalf(100, 100, 1);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_1 = CreateDepthFrameWithValueOnLeftHalf(100, 200, 2);
+    std::shared_ptr<const KinectVideoFrame> kinect_video_frame_1 = std::make_shared<KinectVideoFrame>(VIDEO_WIDTH, VIDEO_HEIGHT);
+
+    ExpectDepthFrames(kinect_depth_frame_ref, kinect_depth_frame_1);
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionStarted()).Times(1);
+
+    ExpectVideoFrames(kinect_video_frame_1);
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionFrame(_, _)).Times(AtLeast(0));
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionStopped(_)).Times(AtLeast(0));
+
+    ASSERT_EQ(detection.Start(), 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    ASSERT_EQ(detection.Stop(), 0);
+}
+
+TEST_F(DetectionTest, CoarseLevelUsesZoneSensitivity)
+{
+    /* The changes are below the global sensitivity and within the one of the zone */
+    detection_config.coarse_level = 2;
+    detection_config.coarse_threshold = 10;
+    detection_config.sensitivity = 200;
+    detection_config.zones.push_back({1, 100, 10, {{0, 0}, {320, 0}, {320, 480}, {0, 480}}});
+
+    Detection detection(kinect_mock, detection_observer_mock, detection_config);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_ref = CreateDepthFrameWithValueOnLeftHalf(100, 100, 1);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_1 = CreateDepthFrameWithValueOnLeftHalf(100, 200, 2);
+    std::shared_ptr<const KinectVideoFrame> kinect_video_frame_1 = std::make_shared<KinectVideoFrame>(VIDEO_WIDTH, VIDEO_HEIGHT);
+
+    ExpectDepthFrames(kinect_depth_frame_ref, kinect_depth_frame_1);
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionStarted()).Times(1);
+
+    ExpectVideoFrames(kinect_video_frame_1);
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionFrame(_, _)).Times(AtLeast(0));
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionStopped(_)).Times(AtLeast(0));
+
+    ASSERT_EQ(detection.Start(), 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    ASSERT_EQ(detection.Stop(), 0);
+}
+
+TEST_F(DetectionTest, DetectionOccursWithBackgroundModel)
+{
+    detection_config.background_model = true;
+
+    Detection detection(kinect_mock, detection_observer_mock, detection_config);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_ref = CreateDepthFrameWithValue(100, 1);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_1 = CreateDepthFrameWithValue(200, 2);
+    std::shared_ptr<const KinectVideoFrame> kinect_video_frame_1 = std::make_shared<KinectVideoFrame>(1920,1080);
+
+    ExpectDepthFrames(kinect_depth_frame_ref, kinect_depth_frame_1);
+
+    /* The change is absorbed slowly, the intrusion lasts the whole test */
+    EXPECT_CALL(*detection_observer_mock, IntrusionStarted()).Times(1);
+
+    ExpectVideoFrames(kinect_video_frame_1);
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionFrame(_, _)).Times(AtLeast(1));
+
+    ASSERT_EQ(detection.Start(), 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+
+    ASSERT_EQ(detection.Stop(), 0);
+}
+
+TEST_F(DetectionTest, BackgroundModelFrozenDuringIntrusion)
+{
+    detection_config.background_model = true;
+    detection_config.background_learning_rate = 0.5f;
+    detection_config.refresh_reference_interval_ms = 10;
+
+    Detection detection(kinect_mock, detection_observer_mock, detection_config);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_ref = CreateDepthFrameWithValue(100, 1);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_1 = CreateDepthFrameWithValue(200, 2);
+    std::shared_ptr<const KinectVideoFrame> kinect_video_frame_1 = std::make_shared<KinectVideoFrame>(1920,1080);
+
+    ExpectDepthFrames(kinect_depth_frame_ref, kinect_depth_frame_1);
+
+    ExpectVideoFrames(kinect_video_frame_1);
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionFrame(_, _)).Times(AtLeast(0));
+
+    /* Even with a fast learning rate the intruder doesn't become part of the background */
+    EXPECT_CALL(*detection_observer_mock, IntrusionStarted()).Times(1);
+    EXPECT_CALL(*detection_observer_mock, IntrusionStopped(_)).Times(0);
+
+    ASSERT_EQ(detection.Start(), 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    ASSERT_EQ(detection.Stop(), 0);
+}
+
+TEST_F(DetectionTest, PrerollFramesHandedWhenIntrusionStarts)
+{
+    /* Up to 3 frames of 20 ms, the memory budget doesn't limit them */
+    detection_config.preroll_ms = 60;
+    detection_config.preroll_max_bytes = 16 * 1920 * 1080 * sizeof(uint16_t);
+
+    Detection detection(kinect_mock, detection_observer_mock, detection_config);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_ref = CreateDepthFrameWithValue(100, 1);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_1 = CreateDepthFrameWithValue(200, 2);
+    std::shared_ptr<const KinectVideoFrame> kinect_video_frame_1 = std::make_shared<KinectVideoFrame>(1920,1080);
+    std::atomic<std::thread::id> detection_thread;
+    std::atomic<uint32_t> preroll_frames(0);
+
+    ExpectDepthFrames(kinect_depth_frame_ref, kinect_depth_frame_ref);
+    ExpectVideoFrames(kinect_video_frame_1);
+
+    /* The pre-roll frames are handed right after IntrusionStarted, from the detection thread */
+    EXPECT_CALL(*detection_observer_mock, IntrusionStarted()).
+        WillOnce(Invoke([&]{ detection_thread = std::this_thread::get_id(); }));
+    EXPECT_CALL(*detection_observer_mock, IntrusionFrame(_, _)).
+        WillRepeatedly(Invoke([&](std::shared_ptr<const KinectVideoFrame> frame, uint32_t frame_num)
+        {
+            if(std::this_thread::get_id() == detection_thread)
+            {
+                EXPECT_EQ(frame_num, preroll_frames.load());
+                preroll_frames++;
+            }
+        }));
+
+    ASSERT_EQ(detection.Start(), 0);
+
+    /* Idle long enough to fill the pre-roll, then the scene changes */
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    depth_feeder.SetFrames(kinect_depth_frame_ref, kinect_depth_frame_1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    ASSERT_EQ(detection.Stop(), 0);
+
+    EXPECT_EQ(preroll_frames, 3U);
+}
+
+TEST_F(DetectionTest, PrerollLimitedByMemoryBudget)
+{
+    /* Room for 2 frames of 1920x1080 */
+    detection_config.preroll_ms = 1000;
+    detection_config.preroll_max_bytes = 2 * 1920 * 1080 * sizeof(uint16_t);
+
+    Detection detection(kinect_mock, detection_observer_mock, detection_config);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_ref = CreateDepthFrameWithValue(100, 1);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_1 = CreateDepthFrameWithValue(200, 2);
+    std::shared_ptr<const KinectVideoFrame> kinect_video_frame_1 = std::make_shared<KinectVideoFrame>(1920,1080);
+    std::atomic<std::thread::id> detection_thread;
+    std::atomic<uint32_t> preroll_frames(0);
+
+    ExpectDepthFrames(kinect_depth_frame_ref, kinect_depth_frame_ref);
+    ExpectVideoFrames(kinect_video_frame_1);
+
+    EXPECT_CALL(*detection_observer_mock, IntrusionStarted()).
+        WillOnce(Invoke([&]{ detection_thread = std::this_thread::get_id(); }));
+    EXPECT_CALL(*detection_observer_mock, IntrusionFrame(_, _)).
+        WillRepeatedly(Invoke([&](std::shared_ptr<const KinectVideoFrame> frame, uint32_t frame_num)
+        {
+            if(std::this_thread::get_id() == detection_thread)
+            {
+                preroll_frames++;
+            }
+        }));
+
+    ASSERT_EQ(detection.Start(), 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    depth_feeder.SetFrames(kinect_depth_frame_ref, kinect_depth_frame_1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    ASSERT_EQ(detection.Stop(), 0);
+
+    EXPECT_EQ(preroll_frames, 2U);
+}
+
+TEST_F(DetectionTest, PrerollStoppedIfStartFails)
+{
+    detection_config.preroll_ms = 60;
+    detection_config.preroll_max_bytes = 16 * 1920 * 1080 * sizeof(uint16_t);
+
+    Detection detection(kinect_mock, detection_observer_mock, detection_config);
+
+    EXPECT_CALL(*kinect_mock, SubscribeVideoFrames(_, _, _)).
+        WillOnce(Return(video_subscription));
+    EXPECT_CALL(*kinect_mock, SubscribeDepthFrames(_, _, _)).
+        WillOnce(Return(-1));
+    EXPECT_CALL(*kinect_mock, Unsubscribe(video_subscription)).
+        WillOnce(Return(0));
+
+    EXPECT_EQ(detection.Start(), -1);
+    EXPECT_FALSE(detection.IsRunning());
+}
+
+TEST_F(DetectionTest, PrerollDisabledWhileRunning)
+{
+    detection_config.preroll_ms = 60;
+    detection_config.preroll_max_bytes = 16 * 1920 * 1080 * sizeof(uint16_t);
+
+    Detection detection(kinect_mock, detection_observer_mock, detection_config);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame_ref = CreateDepthFrameWithValue(100, 1);
+    std::shared_ptr<const KinectVideoFrame> kinect_video_frame_1 = std::make_shared<KinectVideoFrame>(1920,1080);
+
+    ExpectDepthFrames(kinect_depth_frame_ref, kinect_depth_frame_ref);
+    ExpectVideoFrames(kinect_video_frame_1);
+    EXPECT_CALL(*kinect_mock, ChangeDecimation(_, _)).
+        WillRepeatedly(Return(0));
+
+    ASSERT_EQ(detection.Start(), 0);
+    EXPECT_TRUE(video_feeder.IsSubscribed());
+
+    /* The idle video frames are no longer taken */
+    detection_config.preroll_ms = 0;
+    detection.UpdateConfig(detection_config);
+    EXPECT_FALSE(video_feeder.IsSubscribed());
+
+    /* And taken again once it is enabled */
+    detection_config.preroll_ms = 60;
+    detection.UpdateConfig(detection_config);
+    EXPECT_TRUE(video_feeder.IsSubscribed());
+
+    ASSERT_EQ(detection.Stop(), 0);
+    EXPECT_FALSE(video_feeder.IsSubscribed());
+}
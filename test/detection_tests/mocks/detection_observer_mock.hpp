@@ -20,5 +20,6 @@ public:
 
     MOCK_METHOD(void, IntrusionStarted, ());
     MOCK_METHOD(void, IntrusionStopped, (uint32_t frame_num));
-    MOCK_METHOD(void, IntrusionFrame, (std::shared_ptr<KinectVideoFrame> frame, uint32_t frame_num));
+    MOCK_METHOD(void, IntrusionFrame, (std::shared_ptr<const KinectVideoFrame> frame, uint32_t frame_num));
+    MOCK_METHOD(void, IntrusionHeatMap, (const DifferenceMap& heat_map));
 };
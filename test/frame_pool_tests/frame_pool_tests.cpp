@@ -0,0 +1,235 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file frame_pool_tests.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#include "../../inc/frame_pool.hpp"
+#include "../../inc/frame_exchange.hpp"
+#include "../../inc/kinect_frame.hpp"
+#include "../../inc/background_model.hpp"
+
+/*******************************************************************
+ * Allocation counting
+ *******************************************************************/
+/* Every heap allocation of the test binary, from any thread */
+static std::atomic<uint64_t> g_allocations(0);
+
+void* operator new(std::size_t size)
+{
+    g_allocations++;
+    if(void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    g_allocations++;
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if(void* p = std::aligned_alloc(align, ((size + align - 1) / align) * align))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+/*******************************************************************
+ * Test class definition
+ *******************************************************************/
+class FramePoolTest : public ::testing::Test
+{
+public:
+    FramePoolTest()
+    {
+        frame_data.resize(width * height);
+    }
+
+    ~FramePoolTest()
+    {
+    }
+
+    void FillWithValue(uint16_t value)
+    {
+        std::fill(frame_data.begin(), frame_data.end(), value);
+    }
+
+protected:
+    uint32_t width = 64, height = 48;
+    std::vector<uint16_t> frame_data;
+};
+
+/*******************************************************************
+ * Test cases
+ *******************************************************************/
+TEST_F(FramePoolTest, AcquireRecyclesReleasedFrames)
+{
+    FramePool<KinectDepthFrame> pool(width, height, 2);
+
+    const KinectDepthFrame* first = pool.Acquire().get();
+    const KinectDepthFrame* second = pool.Acquire().get();
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(pool.GetSize(), 2U);
+}
+
+TEST_F(FramePoolTest, AcquireGrowsWhenEveryFrameIsHeld)
+{
+    FramePool<KinectDepthFrame> pool(width, height, 2);
+
+    std::shared_ptr<KinectDepthFrame> first = pool.Acquire();
+    std::shared_ptr<KinectDepthFrame> second = pool.Acquire();
+    std::shared_ptr<KinectDepthFrame> third = pool.Acquire();
+
+    EXPECT_NE(first, second);
+    EXPECT_NE(second, third);
+    EXPECT_NE(first, third);
+    EXPECT_EQ(pool.GetSize(), 3U);
+}
+
+TEST_F(FramePoolTest, FrameBuffersAreAligned)
+{
+    KinectDepthFrame frame(width, height);
+
+    for(uint32_t level = 0; level < DEPTH_PYRAMID_LEVELS; level++)
+    {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(frame.GetLevelDataPointer(level)) % FRAME_BUFFER_ALIGNMENT, 0U);
+    }
+}
+
+TEST_F(FramePoolTest, SteadyStateDetectionPathDoesNotAllocate)
+{
+    FrameExchange<KinectDepthFrame> exchange(width, height);
+    KinectDepthFrame reference(width, height);
+    DifferenceMap map;
+    std::atomic<uint32_t> consumed(0);
+    std::atomic<uint32_t> differences(0);
+
+    FillWithValue(1000);
+    reference.Fill(frame_data.data(), 1);
+    reference.ComputeDifferenceMap(reference, 10, 16, map);
+
+    ASSERT_EQ(exchange.Subscribe(1, [&](std::shared_ptr<const KinectDepthFrame> frame)
+    {
+        differences += frame->ComputeDifferences(reference, 10);
+        frame->ComputeDifferenceMap(reference, 10, 16, map);
+        consumed++;
+    }, 1, {2, FrameDropPolicy::DropOldest}), 0);
+
+    auto publish_and_wait = [&](uint32_t timestamp)
+    {
+        uint32_t expected = consumed + 1;
+        exchange.Publish(frame_data.data(), timestamp);
+        while(consumed != expected)
+        {
+            std::this_thread::yield();
+        }
+    };
+
+    /* Warm up: the pool settles at the number of frames in flight */
+    FillWithValue(2000);
+    for(uint32_t timestamp = 2; timestamp < 10; timestamp++)
+    {
+        publish_and_wait(timestamp);
+    }
+    uint32_t pool_size = exchange.GetPoolSize();
+
+    uint64_t allocations = g_allocations;
+    for(uint32_t timestamp = 10; timestamp < 110; timestamp++)
+    {
+        publish_and_wait(timestamp);
+    }
+
+    EXPECT_EQ(g_allocations - allocations, 0U);
+    EXPECT_EQ(exchange.GetPoolSize(), pool_size);
+    EXPECT_EQ(differences, 108 * width * height);
+
+    EXPECT_EQ(exchange.Unsubscribe(1), 0);
+}
+
+TEST_F(FramePoolTest, SteadyStateBackgroundModelDoesNotAllocate)
+{
+    DepthBackgroundModel model(0.05f, 3.0f, 10.0f);
+    KinectDepthFrame frame(width, height);
+    std::shared_ptr<const DepthBackground> background;
+
+    FillWithValue(1000);
+    frame.Fill(frame_data.data(), 1);
+    model.Update(frame);
+    background = model.GetBackground();
+
+    uint64_t allocations = g_allocations;
+    for(uint32_t i = 0; i < 100; i++)
+    {
+        /* The reader keeps the previous background while the next one is written */
+        model.Update(frame);
+        background = model.GetBackground();
+    }
+
+    EXPECT_EQ(g_allocations - allocations, 0U);
+    EXPECT_NE(background, nullptr);
+}
@@ -0,0 +1,204 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file intrusion_recorder_tests.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <future>
+
+#include "../../inc/intrusion_recorder.hpp"
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+/*******************************************************************
+ * Test class definition
+ *******************************************************************/
+class IntrusionRecorderTest : public ::testing::Test
+{
+public:
+    IntrusionRecorderTest()
+    {
+        path = std::filesystem::temp_directory_path() / "intrusion_recorder_test.mp4";
+        std::filesystem::remove(path);
+
+        std::vector<uint16_t> frame_data(width * height);
+        for(uint32_t i = 0; i < frame_data.size(); i++)
+        {
+            frame_data[i] = (i * 7) & 0x3FF;
+        }
+        frame = std::make_shared<KinectVideoFrame>(width, height);
+        frame->Fill(frame_data.data(), 1);
+    }
+
+    ~IntrusionRecorderTest()
+    {
+        std::filesystem::remove(path);
+    }
+
+    void Record(RecorderCodec codec, uint32_t num_frames)
+    {
+        IntrusionRecorder recorder(codec, num_frames);
+
+        ASSERT_EQ(recorder.Start(path, 200, 0, 0), 0);
+        for(uint32_t frame_num = 0; frame_num < num_frames; frame_num++)
+        {
+            ASSERT_EQ(recorder.AddFrame(frame, frame_num), 0);
+        }
+        ASSERT_EQ(recorder.Stop(), 0);
+
+        /* The destructor waits for the file to be finalized */
+    }
+
+    std::string ReadBoxType(size_t offset)
+    {
+        std::ifstream file(path, std::ios::binary);
+        char type[4] = {};
+
+        file.seekg(offset + 4);
+        file.read(type, sizeof(type));
+
+        return std::string(type, sizeof(type));
+    }
+
+    /* Read the file back, it can only be demuxed once the moov box has been written */
+    int Demux(uint32_t& num_packets, double& duration_s)
+    {
+        AVFormatContext* format_context = nullptr;
+        AVPacket* packet = av_packet_alloc();
+
+        num_packets = 0;
+        duration_s = 0.0;
+
+        if(packet == nullptr || 0 != avformat_open_input(&format_context, path.c_str(), nullptr, nullptr))
+        {
+            av_packet_free(&packet);
+            return -1;
+        }
+        else if(0 > avformat_find_stream_info(format_context, nullptr) || format_context->nb_streams != 1)
+        {
+            avformat_close_input(&format_context);
+            av_packet_free(&packet);
+            return -1;
+        }
+
+        while(0 == av_read_frame(format_context, packet))
+        {
+            num_packets++;
+            av_packet_unref(packet);
+        }
+
+        if(format_context->duration != AV_NOPTS_VALUE)
+        {
+            duration_s = static_cast<double>(format_context->duration) / AV_TIME_BASE;
+        }
+
+        avformat_close_input(&format_context);
+        av_packet_free(&packet);
+
+        return 0;
+    }
+
+protected:
+    uint32_t width = 64, height = 48;
+    std::string path;
+    std::shared_ptr<KinectVideoFrame> frame;
+};
+
+/*******************************************************************
+ * Test cases
+ *******************************************************************/
+TEST_F(IntrusionRecorderTest, RecordsMjpegToMp4)
+{
+    uint32_t num_packets;
+    double duration_s;
+
+    Record(RecorderCodec::Mjpeg, 10);
+
+    ASSERT_TRUE(std::filesystem::exists(path));
+    EXPECT_GT(std::filesystem::file_size(path), 0U);
+    EXPECT_EQ(ReadBoxType(0), "ftyp");
+
+    /* A frame every 200 ms, the duration of the last one may not be accounted */
+    ASSERT_EQ(Demux(num_packets, duration_s), 0);
+    EXPECT_EQ(num_packets, 10U);
+    EXPECT_GE(duration_s, 1.79);
+    EXPECT_LE(duration_s, 2.01);
+}
+
+TEST_F(IntrusionRecorderTest, RecordsH264ToMp4)
+{
+    /* Falls back to MJPEG if there is no H.264 encoder */
+    uint32_t num_packets;
+    double duration_s;
+
+    Record(RecorderCodec::H264, 10);
+
+    ASSERT_TRUE(std::filesystem::exists(path));
+    EXPECT_EQ(ReadBoxType(0), "ftyp");
+
+    /* The delayed frames are flushed before the trailer */
+    ASSERT_EQ(Demux(num_packets, duration_s), 0);
+    EXPECT_EQ(num_packets, 10U);
+    EXPECT_GE(duration_s, 1.79);
+    EXPECT_LE(duration_s, 2.01);
+}
+
+TEST_F(IntrusionRecorderTest, FinalizedCalledOnceTheFileIsComplete)
+{
+    IntrusionRecorder recorder(RecorderCodec::Mjpeg, 4);
+    std::promise<void> finalized;
+    std::future<void> finalized_future = finalized.get_future();
+    uint32_t num_packets;
+    double duration_s;
+
+    ASSERT_EQ(recorder.Start(path, 200, 0, 0), 0);
+    ASSERT_EQ(recorder.AddFrame(frame, 0), 0);
+    ASSERT_EQ(recorder.AddFrame(frame, 1), 0);
+    ASSERT_EQ(recorder.Stop([&finalized]{ finalized.set_value(); }), 0);
+
+    /* Readable without waiting for the recorder to be destroyed */
+    ASSERT_EQ(finalized_future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    ASSERT_EQ(Demux(num_packets, duration_s), 0);
+    EXPECT_EQ(num_packets, 2U);
+}
+
+TEST_F(IntrusionRecorderTest, StartWhileRecordingFails)
+{
+    IntrusionRecorder recorder(RecorderCodec::Mjpeg, 4);
+
+    EXPECT_EQ(recorder.Start(path, 200, 0, 0), 0);
+    EXPECT_EQ(recorder.Start(path, 200, 0, 0), -1);
+    EXPECT_EQ(recorder.Stop(), 0);
+}
+
+TEST_F(IntrusionRecorderTest, AddFrameAndStopWithoutRecordingFail)
+{
+    IntrusionRecorder recorder(RecorderCodec::Mjpeg, 4);
+
+    EXPECT_EQ(recorder.AddFrame(frame, 0), -1);
+    EXPECT_EQ(recorder.Stop(), -1);
+}
+
+TEST_F(IntrusionRecorderTest, NoFileWithoutFrames)
+{
+    {
+        IntrusionRecorder recorder(RecorderCodec::Mjpeg, 4);
+
+        EXPECT_EQ(recorder.Start(path, 200, 0, 0), 0);
+        EXPECT_EQ(recorder.Stop(), 0);
+    }
+
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
@@ -0,0 +1,298 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file jpeg_encoder_tests.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+#include <jpeglib.h>
+
+#include "../../inc/jpeg_encoder.hpp"
+#include "../../inc/kinect_frame.hpp"
+#include "../../inc/kinect_frame_kernels.hpp"
+
+/*******************************************************************
+ * Test class definition
+ *******************************************************************/
+class JpegEncoderTest : public ::testing::Test
+{
+public:
+    JpegEncoderTest() : frame(width, height)
+    {
+        std::vector<uint16_t> frame_data(width * height);
+
+        /* Smooth gradient, so the JPEG losses stay small */
+        for(uint32_t y = 0; y < height; y++)
+        {
+            for(uint32_t x = 0; x < width; x++)
+            {
+                frame_data[y * width + x] = (x * 1023) / (width - 1);
+            }
+        }
+        frame.Fill(frame_data.data(), 1);
+    }
+
+    ~JpegEncoderTest()
+    {
+    }
+
+    static int Decode(const std::vector<uint8_t>& jpeg, uint32_t& decoded_width, uint32_t& decoded_height, std::vector<uint8_t>& pixels)
+    {
+        jpeg_decompress_struct decompressor;
+        jpeg_error_mgr error_manager;
+
+        decompressor.err = jpeg_std_error(&error_manager);
+        jpeg_create_decompress(&decompressor);
+        jpeg_mem_src(&decompressor, jpeg.data(), jpeg.size());
+        jpeg_read_header(&decompressor, TRUE);
+        jpeg_start_decompress(&decompressor);
+
+        decoded_width = decompressor.output_width;
+        decoded_height = decompressor.output_height;
+        pixels.resize(decoded_width * decoded_height * decompressor.output_components);
+        while(decompressor.output_scanline < decompressor.output_height)
+        {
+            JSAMPROW row = pixels.data() + decompressor.output_scanline * decoded_width * decompressor.output_components;
+            jpeg_read_scanlines(&decompressor, &row, 1);
+        }
+        int components = decompressor.output_components;
+
+        jpeg_finish_decompress(&decompressor);
+        jpeg_destroy_decompress(&decompressor);
+
+        return components;
+    }
+
+protected:
+    uint32_t width = 64, height = 48;
+    KinectVideoFrame frame;
+};
+
+/*******************************************************************
+ * Test cases
+ *******************************************************************/
+TEST_F(JpegEncoderTest, ToneLutWithoutAdjustsDropsTheTwoLowBits)
+{
+    JpegToneLut lut;
+
+    JpegEncoder::BuildToneLut(0, 0, 1.0f, lut);
+
+    for(uint32_t i = 0; i < JPEG_TONE_LUT_SIZE; i++)
+    {
+        EXPECT_EQ(lut[i], i >> 2);
+    }
+}
+
+TEST_F(JpegEncoderTest, ToneLutAppliesBrightnessAndContrast)
+{
+    JpegToneLut lut;
+
+    JpegEncoder::BuildToneLut(100, 0, 1.0f, lut);
+    EXPECT_EQ(lut[0], 0);
+    EXPECT_EQ(lut[100 << 2], 200);
+    EXPECT_EQ(lut[200 << 2], 255);
+
+    JpegEncoder::BuildToneLut(0, -100, 1.0f, lut);
+    for(uint32_t i = 0; i < JPEG_TONE_LUT_SIZE; i++)
+    {
+        EXPECT_EQ(lut[i], 128);
+    }
+}
+
+TEST_F(JpegEncoderTest, ToneLutAppliesGamma)
+{
+    JpegToneLut lut;
+
+    JpegEncoder::BuildToneLut(0, 0, 2.0f, lut);
+
+    EXPECT_EQ(lut[0], 0);
+    EXPECT_EQ(lut[64 << 2], 128);
+    EXPECT_EQ(lut[255 << 2], 255);
+}
+
+TEST_F(JpegEncoderTest, ToneLutIsOnlyRebuiltWhenTheAdjustsChange)
+{
+    JpegEncoder encoder(75, false, 1.0f);
+    std::vector<uint8_t> jpeg;
+
+    ASSERT_EQ(encoder.Encode(frame.GetView(), 10, 20, jpeg), 0);
+    ASSERT_EQ(encoder.Encode(frame.GetView(), 10, 20, jpeg), 0);
+    EXPECT_EQ(encoder.GetToneLutBuilds(), 1U);
+
+    ASSERT_EQ(encoder.Encode(frame.GetView(), 15, 20, jpeg), 0);
+    ASSERT_EQ(encoder.Encode(frame.GetView(), 15, 25, jpeg), 0);
+    EXPECT_EQ(encoder.GetToneLutBuilds(), 3U);
+
+    encoder.SetGamma(1.5f);
+    ASSERT_EQ(encoder.Encode(frame.GetView(), 15, 25, jpeg), 0);
+    ASSERT_EQ(encoder.Encode(frame.GetView(), 15, 25, jpeg), 0);
+    EXPECT_EQ(encoder.GetToneLutBuilds(), 4U);
+}
+
+TEST_F(JpegEncoderTest, ToneMapKernelsBitExact)
+{
+    const std::vector<uint32_t> lengths = {0, 1, 15, 16, 17, 33, 640};
+    std::vector<uint16_t> pixels(640);
+    std::vector<uint8_t> expected(640);
+    std::vector<uint8_t> result(640);
+    JpegToneLut lut;
+
+    /* Values above 10 bits only use their low bits */
+    std::srand(1234);
+    for(uint32_t i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] = std::rand() % 0x10000;
+    }
+    JpegEncoder::BuildToneLut(30, -20, 0.8f, lut);
+
+    for(KernelVariant variant : {KernelVariant::Scalar, KernelVariant::Sse41, KernelVariant::Avx2, KernelVariant::Neon})
+    {
+        ToneMapKernel kernel = GetToneMapKernel(variant);
+        if(kernel == nullptr)
+        {
+            continue;
+        }
+
+        for(uint32_t length : lengths)
+        {
+            for(uint32_t offset : {0, 1})
+            {
+                uint32_t num_pixels = (length > offset) ? length - offset : 0;
+                std::fill(result.begin(), result.end(), 0);
+                ToneMapScalar(pixels.data() + offset, expected.data(), num_pixels, lut.data());
+                kernel(pixels.data() + offset, result.data(), num_pixels, lut.data());
+                EXPECT_TRUE(std::equal(expected.begin(), expected.begin() + num_pixels, result.begin()))
+                    << GetKernelVariantName(variant) << " length " << num_pixels;
+            }
+        }
+    }
+}
+
+TEST_F(JpegEncoderTest, EncodedFrameDecodesToTheSamePixels)
+{
+    JpegEncoder encoder(100, false, 1.0f);
+    std::vector<uint8_t> jpeg;
+    std::vector<uint8_t> pixels;
+    uint32_t decoded_width = 0, decoded_height = 0;
+
+    ASSERT_EQ(encoder.Encode(frame.GetView(), 0, 0, jpeg), 0);
+    ASSERT_EQ(Decode(jpeg, decoded_width, decoded_height, pixels), 1);
+
+    EXPECT_EQ(decoded_width, width);
+    EXPECT_EQ(decoded_height, height);
+    KinectFrameView view = frame.GetView();
+    for(uint32_t y = 0; y < height; y++)
+    {
+        for(uint32_t x = 0; x < width; x++)
+        {
+            EXPECT_NEAR(pixels[y * width + x], view.Row(y)[x] >> 2, 1);
+        }
+    }
+}
+
+TEST_F(JpegEncoderTest, RepeatedEncodesReuseTheOutputAndMatch)
+{
+    JpegEncoder encoder(75, true, 1.0f);
+    std::vector<uint8_t> first;
+    std::vector<uint8_t> second;
+
+    ASSERT_EQ(encoder.Encode(frame.GetView(), 10, 20, first), 0);
+    ASSERT_EQ(encoder.Encode(frame.GetView(), 10, 20, second), 0);
+    const uint8_t* second_data = second.data();
+    ASSERT_EQ(encoder.Encode(frame.GetView(), 10, 20, second), 0);
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(second.data(), second_data);
+}
+
+TEST_F(JpegEncoderTest, DepthLutGoesFromRedToBlueAndBlankIsBlack)
+{
+    JpegDepthLut lut;
+
+    JpegEncoder::BuildDepthLut(lut);
+
+    const uint8_t* near = lut.data() + 3 * JPEG_DEPTH_NEAR;
+    const uint8_t* far = lut.data() + 3 * JPEG_DEPTH_FAR;
+    const uint8_t* far_blue = lut.data() + 3 * (JPEG_DEPTH_FAR - (JPEG_DEPTH_FAR - JPEG_DEPTH_NEAR) / 8);
+    const uint8_t* blank = lut.data() + 3 * BLANK_DEPTH_PIXEL;
+    EXPECT_GT(near[0], near[2]);
+    EXPECT_GT(far_blue[2], far_blue[0]);
+    EXPECT_TRUE(std::equal(lut.data(), lut.data() + 3, near));
+    EXPECT_TRUE(std::equal(lut.data() + 3 * (BLANK_DEPTH_PIXEL - 1), lut.data() + 3 * BLANK_DEPTH_PIXEL, far));
+    EXPECT_EQ(blank[0] + blank[1] + blank[2], 0);
+}
+
+TEST_F(JpegEncoderTest, EncodedDepthFrameDecodesInColor)
+{
+    JpegEncoder encoder(100, false, 1.0f);
+    KinectDepthFrame depth_frame(width, height);
+    std::vector<uint16_t> depth_data(width * height, BLANK_DEPTH_PIXEL);
+    std::vector<uint8_t> jpeg;
+    std::vector<uint8_t> pixels;
+    uint32_t decoded_width = 0, decoded_height = 0;
+
+    /* Left half at the near end, right half blank */
+    for(uint32_t y = 0; y < height; y++)
+    {
+        std::fill_n(depth_data.begin() + y * width, width / 2, JPEG_DEPTH_NEAR);
+        std::fill_n(depth_data.begin() + y * width + width / 2, width / 2, BLANK_DEPTH_PIXEL);
+    }
+    depth_frame.Fill(depth_data.data(), 1);
+
+    ASSERT_EQ(encoder.EncodeDepth(depth_frame.GetView(), jpeg), 0);
+    ASSERT_EQ(Decode(jpeg, decoded_width, decoded_height, pixels), 3);
+
+    EXPECT_EQ(decoded_width, width);
+    EXPECT_EQ(decoded_height, height);
+    const uint8_t* near = pixels.data() + 3 * (height / 2 * width + width / 8);
+    const uint8_t* blank = pixels.data() + 3 * (height / 2 * width + width - width / 8);
+    EXPECT_GT(near[0], near[2] + 64);
+    EXPECT_LT(blank[0] + blank[1] + blank[2], 12);
+}
+
+TEST_F(JpegEncoderTest, SideBySidePutsDepthOnTheLeft)
+{
+    JpegEncoder encoder(90, false, 1.0f);
+    KinectDepthFrame depth_frame(width / 2, height / 2);
+    std::vector<uint16_t> depth_data(width * height / 4, JPEG_DEPTH_NEAR);
+    std::vector<uint8_t> jpeg;
+    std::vector<uint8_t> pixels;
+    uint32_t decoded_width = 0, decoded_height = 0;
+
+    depth_frame.Fill(depth_data.data(), 1);
+
+    ASSERT_EQ(encoder.EncodeSideBySide(depth_frame.GetView(), frame.GetView(), 0, 0, jpeg), 0);
+    ASSERT_EQ(Decode(jpeg, decoded_width, decoded_height, pixels), 3);
+
+    EXPECT_EQ(decoded_width, width + width / 2);
+    EXPECT_EQ(decoded_height, height);
+
+    /* Depth on the left, black below it, and the gray IR frame on the right */
+    const uint8_t* depth = pixels.data() + 3 * (height / 4 * decoded_width + width / 4);
+    const uint8_t* padding = pixels.data() + 3 * ((height - 4) * decoded_width + width / 4);
+    const uint8_t* video = pixels.data() + 3 * (height / 2 * decoded_width + width / 2 + width - 1);
+    EXPECT_GT(depth[0], depth[2] + 64);
+    EXPECT_LT(padding[0] + padding[1] + padding[2], 12);
+    EXPECT_NEAR(video[0], 255, 4);
+    EXPECT_NEAR(video[0], video[1], 4);
+    EXPECT_NEAR(video[0], video[2], 4);
+}
+
+TEST_F(JpegEncoderTest, EncodeEmptyFrameFails)
+{
+    JpegEncoder encoder(75, false, 1.0f);
+    KinectVideoFrame moved_frame(std::move(frame));
+    std::vector<uint8_t> jpeg;
+
+    EXPECT_EQ(encoder.Encode(frame.GetView(), 0, 0, jpeg), -1);
+}
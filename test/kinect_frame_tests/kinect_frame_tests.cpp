@@ -11,7 +11,10 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <algorithm>
+
 #include "../../inc/kinect_frame.hpp"
+#include "../../inc/kinect_frame_kernels.hpp"
 
 /*******************************************************************
  * Test class definition
@@ -97,6 +100,98 @@ TEST_F(KinectFrameTest, TimestampGetAndSet)
     EXPECT_EQ(kinect_frame.GetTimestamp(),timestamp);
 }
 
+TEST_F(KinectFrameTest, MoveTakesTheBuffer)
+{
+    KinectDepthFrame kinect_frame(width, height);
+    FillWithValue(test_data_1, pix_value);
+    kinect_frame.Fill(test_data_1.data(), timestamp);
+    const uint16_t* data = kinect_frame.GetDataPointer();
+    const uint16_t* level_data = kinect_frame.GetLevelDataPointer(1);
+
+    KinectDepthFrame moved_frame(std::move(kinect_frame));
+
+    EXPECT_EQ(moved_frame.GetDataPointer(), data);
+    EXPECT_EQ(moved_frame.GetLevelDataPointer(1), level_data);
+    EXPECT_EQ(moved_frame.GetTimestamp(), timestamp);
+    EXPECT_EQ(moved_frame.GetWidth(), width);
+    EXPECT_EQ(kinect_frame.GetWidth(), 0U);
+    EXPECT_EQ(kinect_frame.GetHeight(), 0U);
+
+    KinectDepthFrame assigned_frame(2, 2);
+    assigned_frame = std::move(moved_frame);
+
+    EXPECT_EQ(assigned_frame.GetDataPointer(), data);
+    EXPECT_EQ(assigned_frame.GetLevelDataPointer(1), level_data);
+    EXPECT_EQ(assigned_frame.GetHeight(), height);
+    EXPECT_EQ(moved_frame.GetWidth(), 0U);
+}
+
+TEST_F(KinectFrameTest, SwapExchangesTheBuffers)
+{
+    KinectDepthFrame kinect_frame_1(width, height);
+    KinectDepthFrame kinect_frame_2(width, height);
+    KinectDepthFrame smaller_frame(width / 2, height / 2);
+    KinectVideoFrame video_frame(width, height);
+    FillWithValue(test_data_1, 100);
+    FillWithValue(test_data_2, 200);
+    kinect_frame_1.Fill(test_data_1.data(), 1);
+    kinect_frame_2.Fill(test_data_2.data(), 2);
+    const uint16_t* data_1 = kinect_frame_1.GetDataPointer();
+    const uint16_t* data_2 = kinect_frame_2.GetDataPointer();
+
+    ASSERT_EQ(kinect_frame_1.Swap(kinect_frame_2), 0);
+
+    EXPECT_EQ(kinect_frame_1.GetDataPointer(), data_2);
+    EXPECT_EQ(kinect_frame_2.GetDataPointer(), data_1);
+    EXPECT_EQ(kinect_frame_1.GetTimestamp(), 2U);
+    EXPECT_EQ(kinect_frame_2.GetTimestamp(), 1U);
+    EXPECT_EQ(kinect_frame_1.GetLevelDataPointer(2)[0], 200);
+    EXPECT_EQ(kinect_frame_2.GetLevelDataPointer(2)[0], 100);
+
+    EXPECT_NE(kinect_frame_1.Swap(smaller_frame), 0);
+    EXPECT_NE(kinect_frame_1.Swap(video_frame), 0);
+    EXPECT_EQ(kinect_frame_1.GetDataPointer(), data_2);
+}
+
+TEST_F(KinectFrameTest, SwapDataRebuildsThePyramid)
+{
+    KinectDepthFrame kinect_frame(width, height);
+    AlignedVector<uint16_t> buffer(width * height, 300);
+    AlignedVector<uint16_t> wrong_buffer(10, 300);
+    const uint16_t* data = buffer.data();
+
+    ASSERT_EQ(kinect_frame.SwapData(buffer, timestamp), 0);
+
+    EXPECT_EQ(kinect_frame.GetDataPointer(), data);
+    EXPECT_EQ(kinect_frame.GetTimestamp(), timestamp);
+    EXPECT_EQ(kinect_frame.GetLevelDataPointer(1)[0], 300);
+    EXPECT_EQ(buffer.size(), width * height);
+
+    EXPECT_NE(kinect_frame.SwapData(wrong_buffer, timestamp), 0);
+    EXPECT_EQ(kinect_frame.GetDataPointer(), data);
+}
+
+TEST_F(KinectFrameTest, GetViewDescribesThePixels)
+{
+    KinectDepthFrame depth_frame(width, height);
+    KinectVideoFrame video_frame(width, height);
+
+    KinectFrameView view = depth_frame.GetView();
+    EXPECT_EQ(view.data, depth_frame.GetDataPointer());
+    EXPECT_EQ(view.width, width);
+    EXPECT_EQ(view.height, height);
+    EXPECT_EQ(view.stride, width);
+    EXPECT_EQ(view.format, PixelFormat::Depth11Bit);
+    EXPECT_EQ(view.Row(2), depth_frame.GetDataPointer() + 2 * width);
+    EXPECT_EQ(video_frame.GetView().format, PixelFormat::Ir10Bit);
+
+    KinectFrameView level_view = depth_frame.GetLevelView(1);
+    EXPECT_EQ(level_view.data, depth_frame.GetLevelDataPointer(1));
+    EXPECT_EQ(level_view.width, width / 2);
+    EXPECT_EQ(level_view.NumPixels(), (width / 2) * (height / 2));
+    EXPECT_EQ(depth_frame.GetLevelView(DEPTH_PYRAMID_LEVELS).data, nullptr);
+}
+
 TEST_F(KinectFrameTest, ComputeDifferences1)
 {
     FillWithValue(test_data_1, pix_value);
@@ -143,6 +238,163 @@ TEST_F(KinectFrameTest, ComputeDifferences3)
     EXPECT_EQ(kinect_depth_frame_2.ComputeDifferences(kinect_depth_frame_1, tolerance), num_differences);
 }
 
+TEST_F(KinectFrameTest, ComputeDifferencesInsideMask)
+{
+    FillWithValue(test_data_1, pix_value);
+    FillWithValue(test_data_2, pix_value);
+
+    /* Differences in the first rows only */
+    ChangeWithValue(test_data_2.begin(), test_data_2.begin() + (width * 10), pix_value + tolerance + 1);
+
+    KinectDepthFrame kinect_depth_frame_1(width, height);
+    KinectDepthFrame kinect_depth_frame_2(width, height);
+
+    kinect_depth_frame_1.Fill(test_data_1.data(),0);
+    kinect_depth_frame_2.Fill(test_data_2.data(),0);
+
+    RoiMask top_mask = RoiMask::FromPolygon(width, height, {{0, 0}, {100, 0}, {100, 20}, {0, 20}});
+    RoiMask bottom_mask = RoiMask::FromPolygon(width, height, {{0, 20}, {100, 20}, {100, 40}, {0, 40}});
+    RoiMask wrong_size_mask = RoiMask::FromFullFrame(width / 2, height / 2);
+
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferences(kinect_depth_frame_2, tolerance, top_mask), 100U * 10U);
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferences(kinect_depth_frame_2, tolerance, bottom_mask), 0U);
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferences(kinect_depth_frame_2, tolerance, RoiMask::FromFullFrame(width, height)),
+              kinect_depth_frame_1.ComputeDifferences(kinect_depth_frame_2, tolerance));
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferences(kinect_depth_frame_2, tolerance, wrong_size_mask), 0U);
+}
+
+TEST_F(KinectFrameTest, ComputeDifferencesEarlyExit)
+{
+    FillWithValue(test_data_1, pix_value);
+    FillWithValue(test_data_2, pix_value + tolerance + 1);
+
+    KinectDepthFrame kinect_depth_frame_1(width, height);
+    KinectDepthFrame kinect_depth_frame_2(width, height);
+
+    kinect_depth_frame_1.Fill(test_data_1.data(),0);
+    kinect_depth_frame_2.Fill(test_data_2.data(),0);
+
+    uint32_t limit = num_differences;
+    uint32_t diff = kinect_depth_frame_1.ComputeDifferences(kinect_depth_frame_2, tolerance, limit);
+    EXPECT_GT(diff, limit);
+    EXPECT_LT(diff, width * height);
+
+    /* Not reached, full count */
+    limit = width * height;
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferences(kinect_depth_frame_2, tolerance, limit), width * height);
+
+    RoiMask mask = RoiMask::FromFullFrame(width, height);
+    diff = kinect_depth_frame_1.ComputeDifferences(kinect_depth_frame_2, tolerance, mask, num_differences);
+    EXPECT_GT(diff, num_differences);
+    EXPECT_LT(diff, width * height);
+}
+
+TEST_F(KinectFrameTest, ComputeDifferenceMap)
+{
+    const uint32_t block_size = 16;
+    DifferenceMap map;
+
+    FillWithValue(test_data_1, pix_value);
+    FillWithValue(test_data_2, pix_value);
+
+    /* Differences in the first block and in the last (partial) block */
+    for(uint32_t row = 0; row < 4; row++)
+    {
+        ChangeWithValue(test_data_2.begin() + row * width, test_data_2.begin() + row * width + 3, pix_value + tolerance + 1);
+    }
+    ChangeWithValue(test_data_2.end() - 5, test_data_2.end(), pix_value + tolerance + 1);
+
+    KinectDepthFrame kinect_depth_frame_1(width, height);
+    KinectDepthFrame kinect_depth_frame_2(width, height);
+
+    kinect_depth_frame_1.Fill(test_data_1.data(),0);
+    kinect_depth_frame_2.Fill(test_data_2.data(),0);
+
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferenceMap(kinect_depth_frame_2, tolerance, block_size, map), 4U * 3U + 5U);
+
+    EXPECT_EQ(map.block_size, block_size);
+    EXPECT_EQ(map.columns, width / block_size);
+    EXPECT_EQ(map.rows, (height + block_size - 1) / block_size);
+    ASSERT_EQ(map.counts.size(), map.columns * map.rows);
+    EXPECT_EQ(map.counts.front(), 4U * 3U);
+    EXPECT_EQ(map.counts.back(), 5U);
+    EXPECT_EQ(std::count(map.counts.begin(), map.counts.end(), 0U), static_cast<long>(map.counts.size() - 2));
+}
+
+TEST_F(KinectFrameTest, PyramidKeepsNearestDepth)
+{
+    FillWithValue(test_data_1, BLANK_DEPTH_PIXEL);
+
+    /* One measured pixel in the first 4x4 block, the rest blank */
+    test_data_1[width + 1] = 500;
+    /* Different depths in the second 2x2 block of the first row */
+    test_data_1[2] = 900;
+    test_data_1[3] = 800;
+    test_data_1[width + 2] = 700;
+    test_data_1[width + 3] = 600;
+
+    KinectDepthFrame kinect_frame(width, height);
+    kinect_frame.Fill(test_data_1.data(), timestamp);
+
+    ASSERT_NE(kinect_frame.GetLevelDataPointer(1), nullptr);
+    ASSERT_NE(kinect_frame.GetLevelDataPointer(2), nullptr);
+    EXPECT_EQ(kinect_frame.GetLevelDataPointer(DEPTH_PYRAMID_LEVELS), nullptr);
+    EXPECT_EQ(kinect_frame.GetLevelDataPointer(0), kinect_frame.GetDataPointer());
+
+    EXPECT_EQ(kinect_frame.GetLevelDataPointer(1)[0], 500);
+    EXPECT_EQ(kinect_frame.GetLevelDataPointer(1)[1], 600);
+    EXPECT_EQ(kinect_frame.GetLevelDataPointer(1)[2], BLANK_DEPTH_PIXEL);
+    EXPECT_EQ(kinect_frame.GetLevelDataPointer(2)[0], 500);
+    EXPECT_EQ(kinect_frame.GetLevelDataPointer(2)[1], BLANK_DEPTH_PIXEL);
+
+    /* Copies keep the levels */
+    KinectDepthFrame kinect_frame_copy(kinect_frame);
+    EXPECT_EQ(kinect_frame_copy.GetLevelDataPointer(2)[0], 500);
+}
+
+TEST_F(KinectFrameTest, ComputeDifferencesAtLevel)
+{
+    FillWithValue(test_data_1, pix_value);
+    FillWithValue(test_data_2, pix_value + tolerance + 1);
+
+    KinectDepthFrame kinect_depth_frame_1(width, height);
+    KinectDepthFrame kinect_depth_frame_2(width, height);
+
+    kinect_depth_frame_1.Fill(test_data_1.data(),0);
+    kinect_depth_frame_2.Fill(test_data_2.data(),0);
+
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferencesAtLevel(kinect_depth_frame_2, tolerance, 0), width * height);
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferencesAtLevel(kinect_depth_frame_2, tolerance, 1), (width / 2) * (height / 2));
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferencesAtLevel(kinect_depth_frame_2, tolerance, 2), (width / 4) * (height / 4));
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferencesAtLevel(kinect_depth_frame_2, tolerance, DEPTH_PYRAMID_LEVELS), 0U);
+
+    uint32_t diff = kinect_depth_frame_1.ComputeDifferencesAtLevel(kinect_depth_frame_2, tolerance, 2, num_differences);
+    EXPECT_GT(diff, num_differences);
+    EXPECT_LT(diff, (width / 4) * (height / 4));
+}
+
+TEST_F(KinectFrameTest, ComputeDifferencesAtLevelInsideMask)
+{
+    FillWithValue(test_data_1, pix_value);
+    FillWithValue(test_data_2, pix_value);
+
+    /* Differences in the first rows only */
+    ChangeWithValue(test_data_2.begin(), test_data_2.begin() + (width * 8), pix_value + tolerance + 1);
+
+    KinectDepthFrame kinect_depth_frame_1(width, height);
+    KinectDepthFrame kinect_depth_frame_2(width, height);
+
+    kinect_depth_frame_1.Fill(test_data_1.data(),0);
+    kinect_depth_frame_2.Fill(test_data_2.data(),0);
+
+    RoiMask top_mask = RoiMask::FromPolygon(width, height, {{0, 0}, {100, 0}, {100, 20}, {0, 20}}).Downsample(2);
+    RoiMask bottom_mask = RoiMask::FromPolygon(width, height, {{0, 20}, {100, 20}, {100, 40}, {0, 40}}).Downsample(2);
+
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferencesAtLevel(kinect_depth_frame_2, tolerance, 2, top_mask), 25U * 2U);
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferencesAtLevel(kinect_depth_frame_2, tolerance, 2, bottom_mask), 0U);
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferencesAtLevel(kinect_depth_frame_2, tolerance, 1, top_mask), 0U);
+}
+
 TEST_F(KinectFrameTest, SaveToJpegInFileDepthFrame)
 {
     KinectDepthFrame kinect_frame(width, height);
@@ -158,3 +410,136 @@ TEST_F(KinectFrameTest, SaveToJpegInFileVideoFrame)
     kinect_frame.Fill(test_data_1.data(),0);
     kinect_frame.SaveToJpegInFile("video_frame_test.jpeg",1,1);
 }
+
+TEST_F(KinectFrameTest, ComputeDifferencesIgnoresBlankPixels)
+{
+    FillWithValue(test_data_1, pix_value);
+    FillWithValue(test_data_2, pix_value + tolerance + 1);
+    ChangeWithValue(test_data_1.begin(), test_data_1.begin() + num_differences, BLANK_DEPTH_PIXEL);
+    ChangeWithValue(test_data_2.end() - num_differences, test_data_2.end(), BLANK_DEPTH_PIXEL);
+
+    KinectDepthFrame kinect_depth_frame_1(width, height);
+    KinectDepthFrame kinect_depth_frame_2(width, height);
+
+    kinect_depth_frame_1.Fill(test_data_1.data(),0);
+    kinect_depth_frame_2.Fill(test_data_2.data(),0);
+
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferences(kinect_depth_frame_2, tolerance), (width * height) - (2 * num_differences));
+}
+
+TEST_F(KinectFrameTest, CountDifferencesKernelsBitExact)
+{
+    const std::vector<uint32_t> tolerances = {0, 1, 10, 255, 2047, 40000, 65534, 65535, 70000};
+    const std::vector<uint32_t> lengths = {0, 1, 7, 8, 15, 16, 17, 31, 33, 640 * 480, width * height};
+
+    /* Random depth values, with blank pixels and extreme values */
+    std::srand(1234);
+    for(uint32_t i = 0; i < test_data_1.size(); i++)
+    {
+        switch(std::rand() % 8)
+        {
+            case 0:  test_data_1[i] = BLANK_DEPTH_PIXEL; break;
+            case 1:  test_data_1[i] = 0xFFFF; break;
+            case 2:  test_data_1[i] = 0; break;
+            default: test_data_1[i] = std::rand() % 2048; break;
+        }
+        switch(std::rand() % 8)
+        {
+            case 0:  test_data_2[i] = BLANK_DEPTH_PIXEL; break;
+            case 1:  test_data_2[i] = std::rand() % 0x10000; break;
+            default: test_data_2[i] = test_data_1[i] + (std::rand() % 64) - 32; break;
+        }
+    }
+
+    for(KernelVariant variant : {KernelVariant::Scalar, KernelVariant::Sse41, KernelVariant::Avx2, KernelVariant::Neon})
+    {
+        CountDifferencesKernel kernel = GetCountDifferencesKernel(variant);
+        if(kernel == nullptr)
+        {
+            continue;
+        }
+
+        for(uint32_t length : lengths)
+        {
+            for(uint32_t tol : tolerances)
+            {
+                /* Unaligned start as well */
+                for(uint32_t offset : {0, 1})
+                {
+                    uint32_t num_pixels = (length > offset) ? length - offset : 0;
+                    EXPECT_EQ(kernel(test_data_1.data() + offset, test_data_2.data() + offset, num_pixels, tol),
+                              CountDifferencesScalar(test_data_1.data() + offset, test_data_2.data() + offset, num_pixels, tol))
+                        << GetKernelVariantName(variant) << " length " << num_pixels << " tolerance " << tol;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(KinectFrameTest, BestKernelVariantIsSupported)
+{
+    EXPECT_NE(GetCountDifferencesKernel(GetBestKernelVariant()), nullptr);
+    EXPECT_NE(GetCountDifferencesKernel(KernelVariant::Scalar), nullptr);
+}
+
+TEST_F(KinectFrameTest, ComputeDifferencesWithTolerances)
+{
+    std::vector<uint16_t> pixel_tolerances(width * height, 0);
+
+    FillWithValue(test_data_1, pix_value);
+    FillWithValue(test_data_2, pix_value + 50);
+
+    /* The first pixels tolerate the change, the rest only the minimum tolerance */
+    std::fill_n(pixel_tolerances.begin(), width * height - num_differences, 50);
+
+    KinectDepthFrame kinect_depth_frame_1(width, height);
+    KinectDepthFrame kinect_depth_frame_2(width, height);
+
+    kinect_depth_frame_1.Fill(test_data_1.data(),0);
+    kinect_depth_frame_2.Fill(test_data_2.data(),0);
+
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferencesWithTolerances(kinect_depth_frame_2, pixel_tolerances.data(), tolerance), num_differences);
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferencesWithTolerances(kinect_depth_frame_2, pixel_tolerances.data(), 50), 0U);
+
+    RoiMask mask = RoiMask::FromBitmap(width, height, std::vector<uint8_t>(width * height, 1));
+    EXPECT_EQ(kinect_depth_frame_1.ComputeDifferencesWithTolerances(kinect_depth_frame_2, pixel_tolerances.data(), tolerance, mask), num_differences);
+}
+
+TEST_F(KinectFrameTest, CountDifferencesPerPixelKernelsBitExact)
+{
+    const std::vector<uint32_t> tolerances = {0, 10, 2047, 65534, 65535, 70000};
+    const std::vector<uint32_t> lengths = {0, 1, 7, 8, 15, 16, 17, 33, width * height};
+    std::vector<uint16_t> pixel_tolerances(width * height);
+
+    std::srand(4321);
+    for(uint32_t i = 0; i < test_data_1.size(); i++)
+    {
+        test_data_1[i] = (std::rand() % 8 == 0) ? BLANK_DEPTH_PIXEL : std::rand() % 0x10000;
+        test_data_2[i] = (std::rand() % 8 == 0) ? BLANK_DEPTH_PIXEL : test_data_1[i] + (std::rand() % 128) - 64;
+        pixel_tolerances[i] = (std::rand() % 16 == 0) ? 0xFFFF : std::rand() % 64;
+    }
+
+    for(KernelVariant variant : {KernelVariant::Scalar, KernelVariant::Sse41, KernelVariant::Avx2, KernelVariant::Neon})
+    {
+        CountDifferencesPerPixelKernel kernel = GetCountDifferencesPerPixelKernel(variant);
+        if(kernel == nullptr)
+        {
+            continue;
+        }
+
+        for(uint32_t length : lengths)
+        {
+            for(uint32_t tol : tolerances)
+            {
+                for(uint32_t offset : {0, 1})
+                {
+                    uint32_t num_pixels = (length > offset) ? length - offset : 0;
+                    EXPECT_EQ(kernel(test_data_1.data() + offset, test_data_2.data() + offset, pixel_tolerances.data() + offset, num_pixels, tol),
+                              CountDifferencesPerPixelScalar(test_data_1.data() + offset, test_data_2.data() + offset,
+                                                             pixel_tolerances.data() + offset, num_pixels, tol))
+                        << GetKernelVariantName(variant) << " length " << num_pixels << " tolerance " << tol;
+                }
+            }
+        }
+    }
+}
@@ -78,6 +78,46 @@ public:
         update_frames_thread.join();
     }
 
+    /* Publishes depth frames 1 to 5 while the consumer is still busy with the first one, then releases it */
+    std::vector<uint32_t> DeliverToBusyConsumer(FrameQueueConfig queue_config)
+    {
+        std::vector<uint16_t> data(DEPTH_WIDTH * DEPTH_HEIGHT, 100);
+        std::promise<void> first_frame_taken;
+        std::promise<void> release_consumer;
+        std::shared_future<void> released = release_consumer.get_future().share();
+        std::promise<void> all_delivered;
+        std::vector<uint32_t> timestamps;
+
+        int subscription = kinect.SubscribeDepthFrames([&](std::shared_ptr<const KinectDepthFrame> frame)
+        {
+            timestamps.push_back(frame->GetTimestamp());
+            if(timestamps.size() == 1)
+            {
+                first_frame_taken.set_value();
+                released.wait();
+            }
+            else if(timestamps.size() == 1 + queue_config.size)
+            {
+                all_delivered.set_value();
+            }
+        }, 1, queue_config);
+
+        libfreenect_mock->m_depth_cb(libfreenect_mock->m_dev, data.data(), 1);
+        first_frame_taken.get_future().wait();
+        for(uint32_t timestamp = 2; timestamp <= 5; timestamp++)
+        {
+            libfreenect_mock->m_depth_cb(libfreenect_mock->m_dev, data.data(), timestamp);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        release_consumer.set_value();
+
+        auto future = all_delivered.get_future();
+        EXPECT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+        kinect.Unsubscribe(subscription);
+
+        return timestamps;
+    }
+
 private:
 };
 
@@ -228,10 +268,10 @@ TEST_F(KinectTest, StopFailsOnFreenectStopVideo)
 
 TEST_F(KinectTest, GetDepthFrameWithDifferentTimestamp)
 {
-    KinectDepthFrame depth_frame(DEPTH_WIDTH, DEPTH_HEIGHT);
+    std::shared_ptr<KinectDepthFrame> depth_frame = std::make_shared<KinectDepthFrame>(DEPTH_WIDTH, DEPTH_HEIGHT);
     KinectDepthFrame test_depth_frame(DEPTH_WIDTH, DEPTH_HEIGHT);
 
-    depth_frame.SetTimestamp(1111);
+    depth_frame->SetTimestamp(1111);
     test_depth_frame.SetTimestamp(2222);
 
     ASSERT_EQ(kinect.Init(), 0);
@@ -239,19 +279,20 @@ TEST_F(KinectTest, GetDepthFrameWithDifferentTimestamp)
 
     SetKinectsLastDepthFrame(test_depth_frame);
 
-    kinect.GetDepthFrame(depth_frame);
+    std::shared_ptr<const KinectDepthFrame> frame = depth_frame;
+    kinect.GetDepthFrame(frame);
 
-    EXPECT_EQ(depth_frame.GetTimestamp(), 2222);
+    EXPECT_EQ(frame->GetTimestamp(), 2222);
 
     ASSERT_EQ(kinect.Stop(), 0);
 }
 
 TEST_F(KinectTest, GetDepthFrameWithSameTimestampTimeout)
 {
-    KinectDepthFrame depth_frame(DEPTH_WIDTH, DEPTH_HEIGHT);
+    std::shared_ptr<KinectDepthFrame> depth_frame = std::make_shared<KinectDepthFrame>(DEPTH_WIDTH, DEPTH_HEIGHT);
     KinectDepthFrame test_depth_frame(DEPTH_WIDTH, DEPTH_HEIGHT);
 
-    depth_frame.SetTimestamp(1111);
+    depth_frame->SetTimestamp(1111);
     test_depth_frame.SetTimestamp(1111);
 
     ASSERT_EQ(kinect.Init(), 0);
@@ -259,18 +300,19 @@ TEST_F(KinectTest, GetDepthFrameWithSameTimestampTimeout)
 
     SetKinectsLastDepthFrame(test_depth_frame);
 
-    kinect.GetDepthFrame(depth_frame);
+    std::shared_ptr<const KinectDepthFrame> frame = depth_frame;
+    kinect.GetDepthFrame(frame);
 
     ASSERT_EQ(kinect.Stop(), 0);
 }
 
 TEST_F(KinectTest, GetDepthFrameWithSameTimestampWaitsNextFrame)
 {
-    KinectDepthFrame depth_frame(DEPTH_WIDTH, DEPTH_HEIGHT);
+    std::shared_ptr<KinectDepthFrame> depth_frame = std::make_shared<KinectDepthFrame>(DEPTH_WIDTH, DEPTH_HEIGHT);
     KinectDepthFrame initial_depth_frame(DEPTH_WIDTH, DEPTH_HEIGHT);
     KinectDepthFrame updated_depth_frame(DEPTH_WIDTH, DEPTH_HEIGHT);
 
-    depth_frame.SetTimestamp(1111);
+    depth_frame->SetTimestamp(1111);
     initial_depth_frame.SetTimestamp(1111);
     updated_depth_frame.SetTimestamp(2222);
 
@@ -284,15 +326,180 @@ TEST_F(KinectTest, GetDepthFrameWithSameTimestampWaitsNextFrame)
 
     StartUpdatingKinectsLastDepthFrame(updated_depth_frame);
 
-    kinect.GetDepthFrame(depth_frame);
+    std::shared_ptr<const KinectDepthFrame> frame = depth_frame;
+    kinect.GetDepthFrame(frame);
 
     StopUpdatingKinectsLastDepthFrame();
 
-    EXPECT_EQ(depth_frame.GetTimestamp(), 2222);
+    EXPECT_EQ(frame->GetTimestamp(), 2222);
 
     EXPECT_EQ(kinect.Stop(), 0);
 }
 
+TEST_F(KinectTest, GetDepthFrameSharedBetweenConsumers)
+{
+    KinectDepthFrame test_depth_frame(DEPTH_WIDTH, DEPTH_HEIGHT);
+    std::shared_ptr<const KinectDepthFrame> frame_1, frame_2;
+
+    test_depth_frame.SetTimestamp(1111);
+
+    ASSERT_EQ(kinect.Init(), 0);
+    ASSERT_EQ(kinect.Start(), 0);
+
+    SetKinectsLastDepthFrame(test_depth_frame);
+
+    kinect.GetDepthFrame(frame_1);
+    kinect.GetDepthFrame(frame_2);
+
+    /* Both consumers get the same buffer, no copies */
+    EXPECT_EQ(frame_1.get(), frame_2.get());
+    EXPECT_EQ(frame_1->GetTimestamp(), 1111);
+
+    ASSERT_EQ(kinect.Stop(), 0);
+}
+
+TEST_F(KinectTest, GetDepthFrameSnapshotNotOverwritten)
+{
+    std::vector<uint16_t> data(DEPTH_WIDTH * DEPTH_HEIGHT);
+    std::shared_ptr<const KinectDepthFrame> frame;
+
+    ASSERT_EQ(kinect.Init(), 0);
+    ASSERT_EQ(kinect.Start(), 0);
+
+    data.assign(data.size(), 100);
+    libfreenect_mock->m_depth_cb(libfreenect_mock->m_dev, data.data(), 1);
+
+    kinect.GetDepthFrame(frame);
+
+    /* Keep publishing frames while the snapshot is held */
+    for(uint32_t timestamp = 2; timestamp < 10; timestamp++)
+    {
+        data.assign(data.size(), timestamp);
+        libfreenect_mock->m_depth_cb(libfreenect_mock->m_dev, data.data(), timestamp);
+    }
+
+    EXPECT_EQ(frame->GetTimestamp(), 1);
+    EXPECT_EQ(frame->GetDataPointer()[0], 100);
+
+    kinect.GetDepthFrame(frame);
+
+    EXPECT_EQ(frame->GetTimestamp(), 9);
+    EXPECT_EQ(frame->GetDataPointer()[0], 9);
+
+    ASSERT_EQ(kinect.Stop(), 0);
+}
+
+TEST_F(KinectTest, SubscribeDepthFramesDeliversEachDecimation)
+{
+    std::vector<uint16_t> data(DEPTH_WIDTH * DEPTH_HEIGHT, 100);
+    std::promise<std::vector<uint32_t>> delivered;
+    std::vector<uint32_t> timestamps;
+
+    ASSERT_EQ(kinect.Init(), 0);
+    ASSERT_EQ(kinect.Start(), 0);
+
+    int subscription = kinect.SubscribeDepthFrames([&](std::shared_ptr<const KinectDepthFrame> frame)
+    {
+        timestamps.push_back(frame->GetTimestamp());
+        if(timestamps.size() == 3)
+        {
+            delivered.set_value(timestamps);
+        }
+    }, 2, {1, FrameDropPolicy::DropOldest});
+    ASSERT_GE(subscription, 0);
+
+    /* The consumer must be idle when each frame arrives, otherwise only the newest is kept */
+    for(uint32_t timestamp = 1; timestamp <= 5; timestamp++)
+    {
+        libfreenect_mock->m_depth_cb(libfreenect_mock->m_dev, data.data(), timestamp);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    auto future = delivered.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+    EXPECT_EQ(future.get(), std::vector<uint32_t>({1, 3, 5}));
+
+    EXPECT_EQ(kinect.Unsubscribe(subscription), 0);
+    ASSERT_EQ(kinect.Stop(), 0);
+}
+
+TEST_F(KinectTest, UnsubscribeStopsTheDelivery)
+{
+    std::vector<uint16_t> data(DEPTH_WIDTH * DEPTH_HEIGHT, 100);
+    std::atomic<uint32_t> num_frames(0);
+
+    ASSERT_EQ(kinect.Init(), 0);
+    ASSERT_EQ(kinect.Start(), 0);
+
+    int depth_subscription = kinect.SubscribeDepthFrames([&](std::shared_ptr<const KinectDepthFrame> frame){ num_frames++; }, 1, {1, FrameDropPolicy::DropOldest});
+    int video_subscription = kinect.SubscribeVideoFrames([&](std::shared_ptr<const KinectVideoFrame> frame){ num_frames++; }, 1, {1, FrameDropPolicy::DropOldest});
+    ASSERT_NE(depth_subscription, video_subscription);
+
+    EXPECT_EQ(kinect.Unsubscribe(depth_subscription), 0);
+    EXPECT_EQ(kinect.Unsubscribe(video_subscription), 0);
+    EXPECT_NE(kinect.Unsubscribe(depth_subscription), 0);
+    EXPECT_NE(kinect.ChangeDecimation(video_subscription, 2), 0);
+
+    libfreenect_mock->m_depth_cb(libfreenect_mock->m_dev, data.data(), 1);
+    libfreenect_mock->m_video_cb(libfreenect_mock->m_dev, data.data(), 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    EXPECT_EQ(num_frames, 0U);
+
+    ASSERT_EQ(kinect.Stop(), 0);
+}
+
+TEST_F(KinectTest, FullQueueDropsOldestFrames)
+{
+    ASSERT_EQ(kinect.Init(), 0);
+    ASSERT_EQ(kinect.Start(), 0);
+
+    EXPECT_EQ(DeliverToBusyConsumer({2, FrameDropPolicy::DropOldest}), std::vector<uint32_t>({1, 4, 5}));
+
+    FrameStreamStats stats = kinect.GetDepthFrameStats();
+    EXPECT_EQ(stats.published, 5U);
+    EXPECT_EQ(stats.delivered, 3U);
+    EXPECT_EQ(stats.dropped, 2U);
+
+    ASSERT_EQ(kinect.Stop(), 0);
+}
+
+TEST_F(KinectTest, FullQueueDropsNewestFrames)
+{
+    ASSERT_EQ(kinect.Init(), 0);
+    ASSERT_EQ(kinect.Start(), 0);
+
+    EXPECT_EQ(DeliverToBusyConsumer({2, FrameDropPolicy::DropNewest}), std::vector<uint32_t>({1, 2, 3}));
+
+    FrameStreamStats stats = kinect.GetDepthFrameStats();
+    EXPECT_EQ(stats.delivered, 3U);
+    EXPECT_EQ(stats.dropped, 2U);
+
+    ASSERT_EQ(kinect.Stop(), 0);
+}
+
+TEST_F(KinectTest, FrameStatsMeasureCaptureToConsumeLatency)
+{
+    ASSERT_EQ(kinect.Init(), 0);
+    ASSERT_EQ(kinect.Start(), 0);
+
+    DeliverToBusyConsumer({2, FrameDropPolicy::DropOldest});
+
+    /* The queued frames waited at least the 20 ms the consumer was busy */
+    FrameStreamStats stats = kinect.GetDepthFrameStats();
+    EXPECT_GE(stats.latency_max_us, 20000U);
+    EXPECT_LE(stats.latency_mean_us, stats.latency_max_us);
+
+    /* A new measurement window starts on each read, the accumulated counters are kept */
+    stats = kinect.GetDepthFrameStats();
+    EXPECT_EQ(stats.latency_max_us, 0U);
+    EXPECT_EQ(stats.latency_mean_us, 0U);
+    EXPECT_EQ(stats.dropped, 2U);
+    EXPECT_EQ(kinect.GetVideoFrameStats().published, 0U);
+
+    ASSERT_EQ(kinect.Stop(), 0);
+}
+
 TEST_F(KinectTest, ChangeTiltSuccess)
 {
     ASSERT_EQ(kinect.Init(), 0);
@@ -12,6 +12,7 @@
 #include <gmock/gmock.h>
 
 #include "../common/mocks/kinect_mock.hpp"
+#include "../common/fakes/frame_feeder_fake.hpp"
 #include "mocks/liveview_observer_mock.hpp"
 #include "../../inc/liveview.hpp"
 
@@ -24,6 +25,9 @@ using ::testing::NiceMock;
 using ::testing::StrictMock;
 using ::testing::SetArgReferee;
 using ::testing::Ref;
+using ::testing::Invoke;
+using ::testing::AtLeast;
+using ::testing::InSequence;
 
 class LiveviewTest : public ::testing::Test
 {
@@ -43,6 +47,10 @@ protected:
     LiveviewConfig liveview_config;
     std::shared_ptr<KinectMock> kinect_mock;
     std::shared_ptr<LiveviewObserverMock> liveview_observer_mock;
+    const int video_subscription = 1;
+    const int depth_subscription = 2;
+    FrameFeederFake<KinectVideoFrame> video_feeder{video_subscription, 1};
+    FrameFeederFake<KinectDepthFrame> depth_feeder{depth_subscription, 1};
 };
 
 /*******************************************************************
@@ -58,16 +66,111 @@ TEST_F(LiveviewTest, Contructor)
 TEST_F(LiveviewTest, GetAndPushFrames)
 {
     Liveview liveview(kinect_mock, liveview_observer_mock, liveview_config);
-    KinectVideoFrame kinect_video_frame(1920,1080);
+    std::shared_ptr<const KinectVideoFrame> kinect_video_frame = std::make_shared<KinectVideoFrame>(1920,1080);
 
-    EXPECT_CALL(*kinect_mock, GetVideoFrame(_)).
-        WillRepeatedly(SetArgReferee<0>(kinect_video_frame));
-    EXPECT_CALL(*liveview_observer_mock, NewFrame(_));
+    video_feeder.SetFrames(nullptr, kinect_video_frame);
+    EXPECT_CALL(*kinect_mock, SubscribeVideoFrames(_, FrameDecimation(liveview_config.video_frame_interval_ms), _)).
+        WillOnce(Invoke(&video_feeder, &FrameFeederFake<KinectVideoFrame>::Subscribe));
+    EXPECT_CALL(*kinect_mock, Unsubscribe(video_subscription)).
+        WillOnce(Invoke(&video_feeder, &FrameFeederFake<KinectVideoFrame>::Unsubscribe));
+    EXPECT_CALL(*liveview_observer_mock, NewFrame(_)).Times(AtLeast(1));
         /* TODO: check the content of the argument passed */
 
     ASSERT_EQ(liveview.Start(), 0);
+    EXPECT_TRUE(liveview.IsRunning());
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
 
     ASSERT_EQ(liveview.Stop(), 0);
-}
\ No newline at end of file
+    EXPECT_FALSE(liveview.IsRunning());
+}
+
+TEST_F(LiveviewTest, UpdateConfigChangesDecimation)
+{
+    Liveview liveview(kinect_mock, liveview_observer_mock, liveview_config);
+
+    EXPECT_CALL(*kinect_mock, SubscribeVideoFrames(_, _, _)).
+        WillOnce(Return(video_subscription));
+    EXPECT_CALL(*kinect_mock, ChangeDecimation(video_subscription, 10U)).
+        WillOnce(Return(0));
+    EXPECT_CALL(*kinect_mock, Unsubscribe(video_subscription)).
+        WillOnce(Return(0));
+
+    ASSERT_EQ(liveview.Start(), 0);
+
+    liveview_config.video_frame_interval_ms = 10 * KINECT_FRAME_INTERVAL_MS;
+    liveview.UpdateConfig(liveview_config);
+
+    ASSERT_EQ(liveview.Stop(), 0);
+}
+
+TEST_F(LiveviewTest, DepthModeStreamsDepthFrames)
+{
+    liveview_config.mode = LiveviewMode::Depth;
+    Liveview liveview(kinect_mock, liveview_observer_mock, liveview_config);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame = std::make_shared<KinectDepthFrame>(640, 480);
+
+    depth_feeder.SetFrames(nullptr, kinect_depth_frame);
+    EXPECT_CALL(*kinect_mock, SubscribeDepthFrames(_, FrameDecimation(liveview_config.video_frame_interval_ms), _)).
+        WillOnce(Invoke(&depth_feeder, &FrameFeederFake<KinectDepthFrame>::Subscribe));
+    EXPECT_CALL(*kinect_mock, Unsubscribe(depth_subscription)).
+        WillOnce(Invoke(&depth_feeder, &FrameFeederFake<KinectDepthFrame>::Unsubscribe));
+    EXPECT_CALL(*liveview_observer_mock, NewDepthFrame(Ref(*kinect_depth_frame))).Times(AtLeast(1));
+
+    ASSERT_EQ(liveview.Start(), 0);
+    EXPECT_TRUE(liveview.IsRunning());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    ASSERT_EQ(liveview.Stop(), 0);
+    EXPECT_FALSE(liveview.IsRunning());
+}
+
+TEST_F(LiveviewTest, SideBySideModePairsVideoFramesWithTheLatestDepthFrame)
+{
+    liveview_config.mode = LiveviewMode::SideBySide;
+    Liveview liveview(kinect_mock, liveview_observer_mock, liveview_config);
+    std::shared_ptr<const KinectVideoFrame> kinect_video_frame = std::make_shared<KinectVideoFrame>(640, 480);
+    std::shared_ptr<const KinectDepthFrame> kinect_depth_frame = std::make_shared<KinectDepthFrame>(640, 480);
+
+    video_feeder.SetFrames(nullptr, kinect_video_frame);
+    depth_feeder.SetFrames(nullptr, kinect_depth_frame);
+    EXPECT_CALL(*kinect_mock, SubscribeVideoFrames(_, _, _)).
+        WillOnce(Invoke(&video_feeder, &FrameFeederFake<KinectVideoFrame>::Subscribe));
+    EXPECT_CALL(*kinect_mock, SubscribeDepthFrames(_, _, _)).
+        WillOnce(Invoke(&depth_feeder, &FrameFeederFake<KinectDepthFrame>::Subscribe));
+    EXPECT_CALL(*kinect_mock, Unsubscribe(video_subscription)).
+        WillOnce(Invoke(&video_feeder, &FrameFeederFake<KinectVideoFrame>::Unsubscribe));
+    EXPECT_CALL(*kinect_mock, Unsubscribe(depth_subscription)).
+        WillOnce(Invoke(&depth_feeder, &FrameFeederFake<KinectDepthFrame>::Unsubscribe));
+    EXPECT_CALL(*liveview_observer_mock, NewSideBySideFrame(Ref(*kinect_depth_frame), Ref(*kinect_video_frame))).Times(AtLeast(1));
+
+    ASSERT_EQ(liveview.Start(), 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    ASSERT_EQ(liveview.Stop(), 0);
+}
+
+TEST_F(LiveviewTest, UpdateConfigWithOtherModeResubscribes)
+{
+    Liveview liveview(kinect_mock, liveview_observer_mock, liveview_config);
+    InSequence seq;
+
+    EXPECT_CALL(*kinect_mock, SubscribeVideoFrames(_, _, _)).
+        WillOnce(Return(video_subscription));
+    EXPECT_CALL(*kinect_mock, Unsubscribe(video_subscription)).
+        WillOnce(Return(0));
+    EXPECT_CALL(*kinect_mock, SubscribeDepthFrames(_, _, _)).
+        WillOnce(Return(depth_subscription));
+    EXPECT_CALL(*kinect_mock, Unsubscribe(depth_subscription)).
+        WillOnce(Return(0));
+
+    ASSERT_EQ(liveview.Start(), 0);
+
+    liveview_config.mode = LiveviewMode::Depth;
+    liveview.UpdateConfig(liveview_config);
+    EXPECT_TRUE(liveview.IsRunning());
+
+    ASSERT_EQ(liveview.Stop(), 0);
+}
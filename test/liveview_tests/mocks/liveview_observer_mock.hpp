@@ -18,5 +18,7 @@ public:
     LiveviewObserverMock();
     virtual ~LiveviewObserverMock();
 
-    MOCK_METHOD(void, NewFrame, (KinectVideoFrame& frame));
+    MOCK_METHOD(void, NewFrame, (const KinectVideoFrame& frame));
+    MOCK_METHOD(void, NewDepthFrame, (const KinectDepthFrame& frame));
+    MOCK_METHOD(void, NewSideBySideFrame, (const KinectDepthFrame& depth_frame, const KinectVideoFrame& video_frame));
 };
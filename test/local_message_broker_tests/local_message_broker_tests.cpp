@@ -0,0 +1,201 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file local_message_broker_tests.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <future>
+#include <memory>
+
+#include "../../inc/local_message_broker.hpp"
+#include "../../inc/global_parameters.hpp"
+#include "../message_broker_tests/mocks/message_broker_observer_mock.hpp"
+
+/*******************************************************************
+ * Test class definition
+ *******************************************************************/
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::InSequence;
+
+class LocalMessageBrokerTest : public ::testing::Test
+{
+public:
+    LocalMessageBroker message_broker;
+    std::shared_ptr<ChannelMessageObserverMock> channel_observer_mock, channel_observer_mock_2;
+
+    LocalMessageBrokerTest()
+    {
+        channel_observer_mock = std::make_shared<ChannelMessageObserverMock>();
+        channel_observer_mock_2 = std::make_shared<ChannelMessageObserverMock>();
+    }
+};
+
+/*******************************************************************
+ * Test cases
+ *******************************************************************/
+TEST_F(LocalMessageBrokerTest, SubscribeAndPublish)
+{
+    std::string message("testing");
+
+    EXPECT_CALL(*channel_observer_mock, ChannelMessageListener(message)).Times(1);
+    EXPECT_EQ(0, message_broker.Subscribe("test", channel_observer_mock));
+    EXPECT_EQ(0, message_broker.Publish("test", message));
+    EXPECT_EQ(0, message_broker.Flush(1000));
+}
+
+TEST_F(LocalMessageBrokerTest, SubscribeAndPublishBinary)
+{
+    const uint8_t data[] = {0x00, 0xFF, 0x00, 0x10};
+    std::string message(reinterpret_cast<const char*>(data), sizeof(data));
+
+    EXPECT_CALL(*channel_observer_mock, ChannelMessageListener(message)).Times(1);
+    EXPECT_EQ(0, message_broker.Subscribe("test", channel_observer_mock));
+    EXPECT_EQ(0, message_broker.PublishBinary("test", data, sizeof(data)));
+    EXPECT_EQ(0, message_broker.Flush(1000));
+}
+
+TEST_F(LocalMessageBrokerTest, TwoSubscribersOneUnsubscribe)
+{
+    EXPECT_EQ(0, message_broker.Subscribe("test", channel_observer_mock));
+    EXPECT_EQ(0, message_broker.Subscribe("test", channel_observer_mock_2));
+    EXPECT_EQ(0, message_broker.Subscribe("other", channel_observer_mock));
+    EXPECT_EQ(0, message_broker.Unsubscribe("test", channel_observer_mock));
+    EXPECT_NE(0, message_broker.Unsubscribe("test", channel_observer_mock));
+
+    EXPECT_CALL(*channel_observer_mock, ChannelMessageListener("other")).Times(1);
+    EXPECT_CALL(*channel_observer_mock_2, ChannelMessageListener("test")).Times(1);
+    EXPECT_EQ(0, message_broker.Publish("test", "test"));
+    EXPECT_EQ(0, message_broker.Publish("other", "other"));
+    EXPECT_EQ(0, message_broker.Flush(1000));
+}
+
+TEST_F(LocalMessageBrokerTest, UnsubscribeFromListener)
+{
+    EXPECT_CALL(*channel_observer_mock, ChannelMessageListener("0")).
+        WillOnce(Invoke([this](const std::string& message)
+        {
+            EXPECT_EQ(0, message_broker.Unsubscribe("test", channel_observer_mock));
+        }));
+    EXPECT_EQ(0, message_broker.Subscribe("test", channel_observer_mock));
+    EXPECT_EQ(0, message_broker.Publish("test", "0"));
+    EXPECT_EQ(0, message_broker.Flush(1000));
+    EXPECT_EQ(0, message_broker.Publish("test", "1"));
+    EXPECT_EQ(0, message_broker.Flush(1000));
+}
+
+TEST_F(LocalMessageBrokerTest, MessagesInOrder)
+{
+    InSequence sequence;
+
+    for(uint32_t i = 0; i < 10; i++)
+    {
+        EXPECT_CALL(*channel_observer_mock, ChannelMessageListener(std::to_string(i))).Times(1);
+    }
+    EXPECT_EQ(0, message_broker.Subscribe("test", channel_observer_mock));
+    for(uint32_t i = 0; i < 10; i++)
+    {
+        EXPECT_EQ(0, message_broker.Publish("test", std::to_string(i)));
+    }
+    EXPECT_EQ(0, message_broker.Flush(1000));
+}
+
+TEST_F(LocalMessageBrokerTest, SetGetVariables)
+{
+    Variable var{"testvar", DataType::Integer, 0};
+    Variable var2{"testvar2", DataType::String, std::string()};
+    Variable var3{"testvar3", DataType::Boolean, false};
+
+    EXPECT_NE(0, message_broker.GetVariable(var));
+
+    EXPECT_EQ(0, message_broker.SetVariable({"testvar", DataType::Integer, 10}));
+    EXPECT_EQ(0, message_broker.SetVariables({{"testvar2", DataType::String, std::string("hello")},
+                                              {"testvar3", DataType::Boolean, true}}));
+    EXPECT_EQ(0, message_broker.GetVariable(var));
+    EXPECT_EQ(0, message_broker.GetVariable(var2));
+    EXPECT_EQ(0, message_broker.GetVariable(var3));
+
+    EXPECT_EQ(std::get<int>(var.value), 10);
+    EXPECT_EQ(std::get<std::string>(var2.value), "hello");
+    EXPECT_EQ(std::get<bool>(var3.value), true);
+
+    EXPECT_EQ(0, message_broker.Clear());
+    EXPECT_NE(0, message_broker.GetVariable(var));
+}
+
+TEST_F(LocalMessageBrokerTest, GetWithConvertError)
+{
+    Variable var{"testvar", DataType::Integer, 21};
+
+    EXPECT_EQ(0, message_broker.SetVariable({"testvar", DataType::String, std::string("asd")}));
+    EXPECT_NE(0, message_broker.GetVariable(var));
+    /* The value doesn't hold the data type */
+    EXPECT_NE(0, message_broker.SetVariable({"testvar", DataType::Integer, std::string("asd")}));
+}
+
+TEST_F(LocalMessageBrokerTest, SetGetVariableExpiration)
+{
+    Variable var{"testvar", DataType::Integer, 0};
+
+    EXPECT_EQ(0, message_broker.SetVariableExpiration({"testvar", DataType::Integer, 10}, 1));
+    EXPECT_EQ(0, message_broker.GetVariable(var));
+    EXPECT_EQ(std::get<int>(var.value), 10);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+    EXPECT_NE(0, message_broker.GetVariable(var));
+}
+
+TEST_F(LocalMessageBrokerTest, SetVariablesAndPublish)
+{
+    EXPECT_CALL(*channel_observer_mock, ChannelMessageListener("testing")).
+        WillOnce(Invoke([this](const std::string& message)
+        {
+            Variable var{"testvar", DataType::Integer, 0};
+
+            /* The new value is already set when the message arrives */
+            EXPECT_EQ(0, message_broker.GetVariable(var));
+            EXPECT_EQ(std::get<int>(var.value), 10);
+        }));
+    EXPECT_EQ(0, message_broker.Subscribe("test", channel_observer_mock));
+    EXPECT_EQ(0, message_broker.SetVariablesAndPublish({{"testvar", DataType::Integer, 10}}, "test", "testing"));
+    EXPECT_EQ(0, message_broker.Flush(1000));
+}
+
+TEST_F(LocalMessageBrokerTest, StreamsCoalesced)
+{
+    std::promise<void> release;
+    std::shared_future<void> release_future = release.get_future().share();
+
+    /* Hold the delivery thread so the frames queue up */
+    EXPECT_CALL(*channel_observer_mock, ChannelMessageListener("hold")).
+        WillOnce(Invoke([release_future](const std::string& message){ release_future.wait(); }));
+    EXPECT_CALL(*channel_observer_mock_2, ChannelMessageListener("frame 2")).Times(1);
+    EXPECT_EQ(0, message_broker.Subscribe("test", channel_observer_mock));
+    EXPECT_EQ(0, message_broker.Subscribe(REDIS_LIVEFRAMES_CHANNEL, channel_observer_mock_2));
+
+    EXPECT_EQ(0, message_broker.Publish("test", "hold"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(0, message_broker.Publish(REDIS_LIVEFRAMES_CHANNEL, "frame " + std::to_string(i)));
+    }
+    release.set_value();
+    EXPECT_EQ(0, message_broker.Flush(1000));
+
+    std::vector<OutboundChannelStats> stats = message_broker.GetOutboundStats();
+    auto it = std::find_if(stats.begin(), stats.end(), [](const OutboundChannelStats& channel_stats)
+                           { return channel_stats.channel == REDIS_LIVEFRAMES_CHANNEL; });
+
+    ASSERT_NE(it, stats.end());
+    EXPECT_EQ(it->sent, 1U);
+    EXPECT_EQ(it->coalesced, 2U);
+}
@@ -73,6 +73,17 @@ TEST_F(MessageBrokerTest, SubscribeAndPublish)
     std::this_thread::sleep_for (std::chrono::milliseconds(5));
 }
 
+TEST_F(MessageBrokerTest, SubscribeAndPublishBinary)
+{
+    const uint8_t data[] = {0xFF, 0xD8, 0x00, 0x25, 0x73, 0x00, 0xFF, 0xD9};
+    std::string message(reinterpret_cast<const char*>(data), sizeof(data));
+    EXPECT_CALL(*channel_observer_mock, ChannelMessageListener(message)).Times(1);
+    EXPECT_EQ(0, message_broker.Subscribe("test", channel_observer_mock));
+    std::this_thread::sleep_for (std::chrono::milliseconds(5));
+    EXPECT_EQ(0, message_broker.PublishBinary("test", data, sizeof(data)));
+    std::this_thread::sleep_for (std::chrono::milliseconds(5));
+}
+
 TEST_F(MessageBrokerTest, TwoSubscribers)
 {
     std::string message("testing");
@@ -205,4 +216,73 @@ TEST_F(MessageBrokerTest, SetGetVariableExpiration)
     std::this_thread::sleep_for (std::chrono::milliseconds(1100));
 
     EXPECT_NE(0, message_broker.GetVariable(var2));
-}
\ No newline at end of file
+}
+TEST_F(MessageBrokerTest, SetGetVariables)
+{
+    std::vector<Variable> vars{{"testvar", DataType::Integer, 10}, {"testvar2", DataType::String, std::string("hello")}};
+    Variable var{"testvar", DataType::Integer, 0};
+    Variable var2{"testvar2", DataType::String, std::string()};
+
+    EXPECT_EQ(0, message_broker.SetVariables(vars));
+    EXPECT_EQ(0, message_broker.GetVariable(var));
+    EXPECT_EQ(0, message_broker.GetVariable(var2));
+
+    EXPECT_EQ(std::get<int>(var.value), 10);
+    EXPECT_EQ(std::get<std::string>(var2.value), "hello");
+}
+
+TEST_F(MessageBrokerTest, SetVariablesCoalesce)
+{
+    std::vector<Variable> vars{{"testvar", DataType::Integer, 10}, {"testvar2", DataType::Integer, 20}};
+    Variable var{"testvar", DataType::Integer, 0};
+
+    EXPECT_EQ(0, message_broker.SetVariables(vars));
+    vars[0].value = 11;
+    EXPECT_EQ(0, message_broker.SetVariables(vars));
+    EXPECT_EQ(0, message_broker.Flush(1000));
+
+    std::vector<OutboundChannelStats> stats = message_broker.GetOutboundStats();
+
+    /* The second write replaces the first one unless it was already sent */
+    ASSERT_EQ(stats.size(), 1U);
+    EXPECT_EQ(stats[0].channel, "testvar,testvar2");
+    EXPECT_EQ(stats[0].sent + stats[0].coalesced, 2U);
+
+    EXPECT_EQ(0, message_broker.GetVariable(var));
+    EXPECT_EQ(std::get<int>(var.value), 11);
+}
+
+TEST_F(MessageBrokerTest, SetVariablesAndPublish)
+{
+    std::vector<Variable> vars{{"testvar", DataType::Integer, 10}};
+    Variable var{"testvar", DataType::Integer, 0};
+
+    EXPECT_CALL(*channel_observer_mock, ChannelMessageListener("testing")).Times(1);
+    EXPECT_EQ(0, message_broker.Subscribe("test", channel_observer_mock));
+    std::this_thread::sleep_for (std::chrono::milliseconds(5));
+    EXPECT_EQ(0, message_broker.SetVariablesAndPublish(vars, "test", "testing"));
+    std::this_thread::sleep_for (std::chrono::milliseconds(5));
+
+    EXPECT_EQ(0, message_broker.GetVariable(var));
+    EXPECT_EQ(std::get<int>(var.value), 10);
+}
+
+TEST_F(MessageBrokerTest, OutboundStatsPerChannel)
+{
+    Variable var{"testvar", DataType::Integer, 10};
+
+    EXPECT_EQ(0, message_broker.Publish("test1", "testing"));
+    EXPECT_EQ(0, message_broker.Publish("test1", "testing"));
+    EXPECT_EQ(0, message_broker.SetVariable(var));
+    EXPECT_EQ(0, message_broker.Flush(1000));
+
+    std::vector<OutboundChannelStats> stats = message_broker.GetOutboundStats();
+
+    ASSERT_EQ(stats.size(), 2U);
+    EXPECT_EQ(stats[0].channel, "test1");
+    EXPECT_EQ(stats[0].sent, 2U);
+    EXPECT_EQ(stats[0].failed, 0U);
+    EXPECT_EQ(stats[0].depth, 0U);
+    EXPECT_EQ(stats[1].channel, "testvar");
+    EXPECT_EQ(stats[1].sent, 1U);
+}
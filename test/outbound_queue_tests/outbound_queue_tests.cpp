@@ -0,0 +1,244 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file outbound_queue_tests.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+
+#include "../../inc/outbound_queue.hpp"
+
+/*******************************************************************
+ * Test class definition
+ *******************************************************************/
+class OutboundQueueTest : public ::testing::Test
+{
+public:
+    static OutboundCommand Command(const std::string& channel, const std::string& message,
+                                   OutboundPriority priority = OutboundPriority::Alarm, bool coalesce = false)
+    {
+        return {channel, {{"PUBLISH", channel, message}}, priority, coalesce, {}};
+    }
+
+    static const OutboundChannelStats* FindStats(const std::vector<OutboundChannelStats>& stats, const std::string& channel)
+    {
+        for(const OutboundChannelStats& channel_stats : stats)
+        {
+            if(channel_stats.channel == channel)
+            {
+                return &channel_stats;
+            }
+        }
+
+        return nullptr;
+    }
+};
+
+/*******************************************************************
+ * Test cases
+ *******************************************************************/
+TEST_F(OutboundQueueTest, BatchesInOrder)
+{
+    OutboundQueue queue(16);
+    std::vector<OutboundCommand> batch;
+
+    for(uint32_t i = 0; i < 5; i++)
+    {
+        ASSERT_EQ(queue.Push(Command("test", std::to_string(i))), 0);
+    }
+
+    ASSERT_EQ(queue.PopBatch(batch, 3, 0), 0);
+    ASSERT_EQ(batch.size(), 3U);
+    EXPECT_EQ(batch[0].commands[0][2], "0");
+    EXPECT_EQ(batch[2].commands[0][2], "2");
+
+    ASSERT_EQ(queue.PopBatch(batch, 3, 0), 0);
+    ASSERT_EQ(batch.size(), 2U);
+    EXPECT_EQ(batch[0].commands[0][2], "3");
+}
+
+TEST_F(OutboundQueueTest, FullQueueDropsCommands)
+{
+    OutboundQueue queue(2);
+
+    EXPECT_EQ(queue.Push(Command("test", "0")), 0);
+    EXPECT_EQ(queue.Push(Command("test", "1")), 0);
+    EXPECT_EQ(queue.Push(Command("test", "2")), -1);
+
+    const OutboundChannelStats* stats = FindStats(queue.GetStats(), "test");
+
+    ASSERT_NE(stats, nullptr);
+    EXPECT_EQ(stats->depth, 2U);
+    EXPECT_EQ(stats->dropped, 1U);
+}
+
+TEST_F(OutboundQueueTest, StatsPerChannel)
+{
+    OutboundQueue queue(16);
+    std::vector<OutboundCommand> batch;
+
+    queue.Push(Command("liveview", "frame"));
+    queue.Push(Command("new_det", "event"));
+    queue.Push(Command("new_det", "event"));
+
+    ASSERT_EQ(queue.PopBatch(batch, 2, 0), 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    queue.Complete(batch[0], true);
+    queue.Complete(batch[1], false);
+
+    std::vector<OutboundChannelStats> stats = queue.GetStats();
+    const OutboundChannelStats* liveview = FindStats(stats, "liveview");
+    const OutboundChannelStats* new_det = FindStats(stats, "new_det");
+
+    ASSERT_NE(liveview, nullptr);
+    ASSERT_NE(new_det, nullptr);
+    EXPECT_EQ(liveview->depth, 0U);
+    EXPECT_EQ(liveview->sent, 1U);
+    EXPECT_EQ(liveview->failed, 0U);
+    EXPECT_GE(liveview->average_latency_ms, 5.0);
+    EXPECT_GE(liveview->max_latency_ms, liveview->average_latency_ms);
+    EXPECT_EQ(new_det->depth, 1U);
+    EXPECT_EQ(new_det->sent, 1U);
+    EXPECT_EQ(new_det->failed, 1U);
+}
+
+TEST_F(OutboundQueueTest, WaitEmptyUntilCompleted)
+{
+    OutboundQueue queue(16);
+    std::vector<OutboundCommand> batch;
+
+    EXPECT_TRUE(queue.WaitEmpty(0));
+
+    queue.Push(Command("test", "0"));
+    ASSERT_EQ(queue.PopBatch(batch, 8, 0), 0);
+
+    /* Taken but not completed yet */
+    EXPECT_FALSE(queue.WaitEmpty(10));
+
+    std::thread sender([&]{ queue.Complete(batch[0], true); });
+
+    EXPECT_TRUE(queue.WaitEmpty(1000));
+    sender.join();
+}
+
+TEST_F(OutboundQueueTest, CloseWakesUpSender)
+{
+    OutboundQueue queue(16);
+    std::vector<OutboundCommand> batch;
+
+    queue.Push(Command("test", "0"));
+    queue.Close();
+
+    EXPECT_EQ(queue.Push(Command("test", "1")), -1);
+
+    /* The queued commands are still given */
+    ASSERT_EQ(queue.PopBatch(batch, 8, 1000), 0);
+    EXPECT_EQ(batch.size(), 1U);
+    EXPECT_EQ(queue.PopBatch(batch, 8, 1000), -1);
+}
+
+TEST_F(OutboundQueueTest, HigherLanesFirst)
+{
+    OutboundQueue queue(16);
+    std::vector<OutboundCommand> batch;
+
+    queue.Push(Command("liveview", "frame", OutboundPriority::Liveview));
+    queue.Push(Command("status", "1", OutboundPriority::State));
+    queue.Push(Command("watchdog", "1", OutboundPriority::Watchdog));
+    queue.Push(Command("new_det", "event", OutboundPriority::Alarm));
+    queue.Push(Command("email_send_det", "event", OutboundPriority::Alarm));
+
+    ASSERT_EQ(queue.PopBatch(batch, 8, 0), 0);
+    ASSERT_EQ(batch.size(), 5U);
+    EXPECT_EQ(batch[0].channel, "new_det");
+    EXPECT_EQ(batch[1].channel, "email_send_det");
+    EXPECT_EQ(batch[2].channel, "watchdog");
+    EXPECT_EQ(batch[3].channel, "status");
+    EXPECT_EQ(batch[4].channel, "liveview");
+}
+
+TEST_F(OutboundQueueTest, CoalescesToLatestValue)
+{
+    OutboundQueue queue(16);
+    std::vector<OutboundCommand> batch;
+
+    queue.Push(Command("liveview", "frame 0", OutboundPriority::Liveview, true));
+    queue.Push(Command("status", "0", OutboundPriority::State, true));
+    queue.Push(Command("liveview", "frame 1", OutboundPriority::Liveview, true));
+    queue.Push(Command("status", "1", OutboundPriority::State, true));
+    queue.Push(Command("liveview", "frame 2", OutboundPriority::Liveview, true));
+
+    ASSERT_EQ(queue.PopBatch(batch, 8, 0), 0);
+    ASSERT_EQ(batch.size(), 2U);
+    EXPECT_EQ(batch[0].commands[0][2], "1");
+    EXPECT_EQ(batch[1].commands[0][2], "frame 2");
+
+    const OutboundChannelStats* stats = FindStats(queue.GetStats(), "liveview");
+
+    ASSERT_NE(stats, nullptr);
+    EXPECT_EQ(stats->coalesced, 2U);
+    EXPECT_EQ(stats->depth, 0U);
+}
+
+TEST_F(OutboundQueueTest, NoCoalescingPastOtherCommands)
+{
+    OutboundQueue queue(16);
+    std::vector<OutboundCommand> batch;
+
+    queue.Push(Command("status", "0", OutboundPriority::State, true));
+    queue.Push(Command("status", "1", OutboundPriority::State, false));
+    queue.Push(Command("status", "2", OutboundPriority::State, true));
+    queue.Push(Command("status", "3", OutboundPriority::State, true));
+
+    ASSERT_EQ(queue.PopBatch(batch, 8, 0), 0);
+    ASSERT_EQ(batch.size(), 3U);
+    EXPECT_EQ(batch[0].commands[0][2], "0");
+    EXPECT_EQ(batch[1].commands[0][2], "1");
+    EXPECT_EQ(batch[2].commands[0][2], "3");
+}
+
+TEST_F(OutboundQueueTest, NoCoalescingWithoutFlag)
+{
+    OutboundQueue queue(16);
+    std::vector<OutboundCommand> batch;
+
+    queue.Push(Command("new_det", "0"));
+    queue.Push(Command("new_det", "1"));
+
+    ASSERT_EQ(queue.PopBatch(batch, 8, 0), 0);
+    EXPECT_EQ(batch.size(), 2U);
+}
+
+TEST_F(OutboundQueueTest, FullQueueEvictsLowerLanes)
+{
+    OutboundQueue queue(2);
+    std::vector<OutboundCommand> batch;
+
+    queue.Push(Command("liveview", "frame", OutboundPriority::Liveview));
+    queue.Push(Command("status", "0", OutboundPriority::State));
+
+    /* Takes the place of the frame, then of the status */
+    EXPECT_EQ(queue.Push(Command("new_det", "0")), 0);
+    EXPECT_EQ(queue.Push(Command("new_det", "1")), 0);
+    /* Nothing lower left */
+    EXPECT_EQ(queue.Push(Command("new_det", "2")), -1);
+    EXPECT_EQ(queue.Push(Command("liveview", "frame", OutboundPriority::Liveview)), -1);
+
+    ASSERT_EQ(queue.PopBatch(batch, 8, 0), 0);
+    ASSERT_EQ(batch.size(), 2U);
+    EXPECT_EQ(batch[0].commands[0][2], "0");
+    EXPECT_EQ(batch[1].commands[0][2], "1");
+
+    std::vector<OutboundChannelStats> stats = queue.GetStats();
+
+    EXPECT_EQ(FindStats(stats, "liveview")->dropped, 2U);
+    EXPECT_EQ(FindStats(stats, "status")->dropped, 1U);
+    EXPECT_EQ(FindStats(stats, "new_det")->dropped, 1U);
+}
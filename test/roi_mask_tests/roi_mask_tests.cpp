@@ -0,0 +1,133 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file roi_mask_tests.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "../../inc/roi_mask.hpp"
+
+/*******************************************************************
+ * Test class definition
+ *******************************************************************/
+class RoiMaskTest : public ::testing::Test
+{
+protected:
+    uint32_t width = 640, height = 480;
+};
+
+/*******************************************************************
+ * Test cases
+ *******************************************************************/
+TEST_F(RoiMaskTest, EmptyMask)
+{
+    RoiMask mask(width, height);
+
+    EXPECT_TRUE(mask.GetSpans().empty());
+    EXPECT_EQ(mask.GetNumPixels(), 0U);
+}
+
+TEST_F(RoiMaskTest, FullFrame)
+{
+    RoiMask mask = RoiMask::FromFullFrame(width, height);
+
+    EXPECT_EQ(mask.GetSpans().size(), height);
+    EXPECT_EQ(mask.GetNumPixels(), width * height);
+}
+
+TEST_F(RoiMaskTest, RectanglePolygon)
+{
+    RoiMask mask = RoiMask::FromPolygon(width, height, {{10, 20}, {110, 20}, {110, 70}, {10, 70}});
+
+    /* Rows 20..69, columns 10..109 */
+    ASSERT_EQ(mask.GetSpans().size(), 50U);
+    EXPECT_EQ(mask.GetSpans().front().row, 20U);
+    EXPECT_EQ(mask.GetSpans().back().row, 69U);
+    EXPECT_EQ(mask.GetSpans().front().begin, 10U);
+    EXPECT_EQ(mask.GetSpans().front().end, 110U);
+    EXPECT_EQ(mask.GetNumPixels(), 100U * 50U);
+}
+
+TEST_F(RoiMaskTest, PolygonClippedToFrame)
+{
+    RoiMask mask = RoiMask::FromPolygon(width, height, {{-100, -100}, {1000, -100}, {1000, 1000}, {-100, 1000}});
+
+    EXPECT_EQ(mask.GetNumPixels(), width * height);
+}
+
+TEST_F(RoiMaskTest, TrianglePolygon)
+{
+    RoiMask mask = RoiMask::FromPolygon(width, height, {{0, 0}, {100, 0}, {0, 100}});
+
+    /* Each row y covers the pixels whose center is left of x = 100 - (y + 0.5), the last row is empty */
+    ASSERT_EQ(mask.GetSpans().size(), 99U);
+    for(const RoiSpan& span : mask.GetSpans())
+    {
+        EXPECT_EQ(span.begin, 0U);
+        EXPECT_EQ(span.end, 100U - span.row - 1U);
+    }
+}
+
+TEST_F(RoiMaskTest, InvalidPolygon)
+{
+    RoiMask mask = RoiMask::FromPolygon(width, height, {{0, 0}, {100, 100}});
+
+    EXPECT_EQ(mask.GetNumPixels(), 0U);
+}
+
+TEST_F(RoiMaskTest, Bitmap)
+{
+    std::vector<uint8_t> bitmap(width * height, 0);
+
+    /* Two runs in row 3 and one in row 10 */
+    std::fill(bitmap.begin() + 3 * width + 5, bitmap.begin() + 3 * width + 15, 1);
+    std::fill(bitmap.begin() + 3 * width + 20, bitmap.begin() + 4 * width, 1);
+    std::fill(bitmap.begin() + 10 * width, bitmap.begin() + 10 * width + 1, 1);
+
+    RoiMask mask = RoiMask::FromBitmap(width, height, bitmap);
+
+    ASSERT_EQ(mask.GetSpans().size(), 3U);
+    EXPECT_EQ(mask.GetSpans()[1].begin, 20U);
+    EXPECT_EQ(mask.GetSpans()[1].end, width);
+    EXPECT_EQ(mask.GetSpans()[2].row, 10U);
+    EXPECT_EQ(mask.GetNumPixels(), 10U + (width - 20U) + 1U);
+}
+
+TEST_F(RoiMaskTest, Downsample)
+{
+    /* Rows 21..68, columns 10..108 */
+    RoiMask mask = RoiMask::FromPolygon(width, height, {{10, 21}, {109, 21}, {109, 69}, {10, 69}});
+    RoiMask level_mask = mask.Downsample(2);
+
+    /* Every pixel of the level touched by the region is inside: rows 5..17, columns 2..27 */
+    EXPECT_EQ(level_mask.GetWidth(), width / 4);
+    EXPECT_EQ(level_mask.GetHeight(), height / 4);
+    ASSERT_EQ(level_mask.GetSpans().size(), 13U);
+    EXPECT_EQ(level_mask.GetSpans().front().row, 5U);
+    EXPECT_EQ(level_mask.GetSpans().back().row, 17U);
+    EXPECT_EQ(level_mask.GetSpans().front().begin, 2U);
+    EXPECT_EQ(level_mask.GetSpans().front().end, 28U);
+    EXPECT_EQ(RoiMask::FromFullFrame(width, height).Downsample(1).GetNumPixels(), (width / 2) * (height / 2));
+}
+
+TEST_F(RoiMaskTest, PolygonStringConversion)
+{
+    std::vector<RoiPoint> polygon = {{1, 2}, {300, 4}, {5, 460}};
+    std::vector<RoiPoint> polygon_read;
+
+    EXPECT_EQ(RoiPolygonToString(polygon), "1 2 300 4 5 460");
+    ASSERT_EQ(RoiPolygonFromString(RoiPolygonToString(polygon), polygon_read), 0);
+    ASSERT_EQ(polygon_read.size(), polygon.size());
+    EXPECT_EQ(polygon_read[1].x, 300);
+    EXPECT_EQ(polygon_read[2].y, 460);
+
+    EXPECT_NE(RoiPolygonFromString("1 2 3 4 5", polygon_read), 0);
+    EXPECT_NE(RoiPolygonFromString("1 2 3 4", polygon_read), 0);
+    EXPECT_NE(RoiPolygonFromString("1 2 3 4 5 a", polygon_read), 0);
+}
@@ -0,0 +1,231 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file shm_frame_ring_tests.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../../inc/shm_frame_ring.hpp"
+
+/*******************************************************************
+ * Test class definition
+ *******************************************************************/
+class ShmFrameRingTest : public ::testing::Test
+{
+public:
+    /* Frame filled with the same byte, a torn frame mixes two of them */
+    static std::vector<uint8_t> Frame(size_t size, uint8_t value)
+    {
+        return std::vector<uint8_t>(size, value);
+    }
+
+protected:
+    const std::string name = "/kinectalarm_shm_frame_ring_test_" + std::to_string(getpid());
+    ShmFrameRing ring{name, 4, 4096};
+};
+
+/*******************************************************************
+ * Test cases
+ *******************************************************************/
+TEST_F(ShmFrameRingTest, ReaderNeedsTheRing)
+{
+    ShmFrameRingReader reader(name);
+
+    EXPECT_EQ(reader.Open(), -1);
+    ASSERT_EQ(ring.Open(), 0);
+    EXPECT_EQ(reader.Open(), 0);
+
+    ring.Close();
+
+    ShmFrameRingReader late_reader(name);
+    EXPECT_EQ(late_reader.Open(), -1);
+}
+
+TEST_F(ShmFrameRingTest, ExistingRingNotTakenOver)
+{
+    ShmFrameRing other_ring{name, 4, 4096};
+    ShmFrameRingReader reader(name);
+    std::vector<uint8_t> data = Frame(100, 1);
+    ShmFrame frame;
+
+    ASSERT_EQ(ring.Open(), 0);
+    ASSERT_EQ(ring.Write(data.data(), data.size(), ShmFrameFormat::Jpeg), 0);
+
+    /* The second writer fails and the frames of the first one are kept */
+    EXPECT_EQ(other_ring.Open(), -1);
+    EXPECT_FALSE(other_ring.IsOpen());
+    ASSERT_EQ(reader.Open(), 0);
+    ASSERT_EQ(reader.GetLatest(frame), 0);
+    EXPECT_EQ(frame.size, data.size());
+}
+
+TEST_F(ShmFrameRingTest, AbandonedRingReplaced)
+{
+    /* Left by a writer that ended without closing it */
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    ASSERT_NE(fd, -1);
+    close(fd);
+
+    EXPECT_EQ(ring.Open(), 0);
+    EXPECT_TRUE(ring.IsOpen());
+}
+
+TEST_F(ShmFrameRingTest, RingOfCrashedWriterReplaced)
+{
+    int status;
+    pid_t pid = fork();
+
+    ASSERT_NE(pid, -1);
+    if(pid == 0)
+    {
+        /* Ends without closing the ring */
+        _exit(ring.Open() == 0 ? 0 : 1);
+    }
+
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    EXPECT_EQ(ring.Open(), 0);
+}
+
+TEST_F(ShmFrameRingTest, WriteAndReadLatest)
+{
+    ShmFrameRingReader reader(name);
+    ShmFrame frame;
+
+    ASSERT_EQ(ring.Open(), 0);
+    ASSERT_EQ(reader.Open(), 0);
+
+    EXPECT_EQ(reader.GetLatest(frame), -1);
+
+    for(uint8_t i = 0; i < 6; i++)
+    {
+        std::vector<uint8_t> data = Frame(100 + i, i);
+        ASSERT_EQ(ring.Write(data.data(), data.size(), ShmFrameFormat::Jpeg), 0);
+    }
+
+    ASSERT_EQ(reader.GetLatest(frame), 0);
+    EXPECT_EQ(frame.number, 5U);
+    EXPECT_EQ(frame.size, 105U);
+    EXPECT_EQ(frame.format, ShmFrameFormat::Jpeg);
+    EXPECT_EQ(frame.data[0], 5);
+    EXPECT_EQ(frame.data[104], 5);
+    EXPECT_TRUE(reader.IsValid(frame));
+    EXPECT_EQ(ring.GetFrames(), 6U);
+}
+
+TEST_F(ShmFrameRingTest, OverwrittenFrameNotValid)
+{
+    ShmFrameRingReader reader(name);
+    std::vector<uint8_t> data = Frame(100, 1);
+    ShmFrame frame;
+
+    ASSERT_EQ(ring.Open(), 0);
+    ASSERT_EQ(reader.Open(), 0);
+
+    ring.Write(data.data(), data.size(), ShmFrameFormat::Rgb);
+    ASSERT_EQ(reader.GetLatest(frame), 0);
+
+    /* Three more fill the other slots, the fourth takes the one of the frame */
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        ring.Write(data.data(), data.size(), ShmFrameFormat::Rgb);
+        EXPECT_TRUE(reader.IsValid(frame));
+    }
+    ring.Write(data.data(), data.size(), ShmFrameFormat::Rgb);
+    EXPECT_FALSE(reader.IsValid(frame));
+}
+
+TEST_F(ShmFrameRingTest, FrameTooBig)
+{
+    std::vector<uint8_t> data = Frame(8192, 1);
+
+    EXPECT_EQ(ring.Write(data.data(), data.size(), ShmFrameFormat::Jpeg), -1);
+    ASSERT_EQ(ring.Open(), 0);
+    EXPECT_EQ(ring.Write(data.data(), data.size(), ShmFrameFormat::Jpeg), -1);
+    EXPECT_EQ(ring.Write(data.data(), 4096, ShmFrameFormat::Jpeg), 0);
+}
+
+TEST_F(ShmFrameRingTest, WaitFrame)
+{
+    ShmFrameRingReader reader(name);
+    std::vector<uint8_t> data = Frame(100, 1);
+
+    ASSERT_EQ(ring.Open(), 0);
+    ASSERT_EQ(reader.Open(), 0);
+
+    EXPECT_EQ(reader.WaitFrame(0, 10), -1);
+
+    std::thread writer([&]
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ring.Write(data.data(), data.size(), ShmFrameFormat::Jpeg);
+    });
+
+    EXPECT_EQ(reader.WaitFrame(0, 1000), 0);
+    writer.join();
+
+    /* Already there */
+    EXPECT_EQ(reader.WaitFrame(0, 0), 0);
+    EXPECT_EQ(reader.WaitFrame(1, 10), -1);
+}
+
+TEST_F(ShmFrameRingTest, NoTornFramesWhileWriting)
+{
+    ShmFrameRingReader reader(name);
+    std::atomic<bool> running{true};
+    std::vector<uint8_t> buffer;
+    uint32_t copied = 0;
+
+    ASSERT_EQ(ring.Open(), 0);
+    ASSERT_EQ(reader.Open(), 0);
+
+    std::thread writer([&]
+    {
+        for(uint32_t i = 0; running; i++)
+        {
+            std::vector<uint8_t> data = Frame(4096, i % 256);
+            ring.Write(data.data(), data.size(), ShmFrameFormat::Rgb);
+        }
+    });
+
+    /* Not ASSERT, the writer must be joined */
+    EXPECT_EQ(reader.WaitFrame(0, 1000), 0);
+    for(uint32_t i = 0; i < 10000; i++)
+    {
+        ShmFrame frame;
+
+        if(0 == reader.CopyLatest(frame, buffer))
+        {
+            EXPECT_EQ(frame.size, 4096U);
+            EXPECT_EQ(frame.data, buffer.data());
+            if(std::count(buffer.begin(), buffer.end(), frame.number % 256) != 4096)
+            {
+                ADD_FAILURE() << "Torn frame " << frame.number;
+                break;
+            }
+            copied++;
+        }
+    }
+
+    running = false;
+    writer.join();
+
+    EXPECT_GT(copied, 0U);
+}
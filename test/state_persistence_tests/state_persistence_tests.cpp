@@ -137,6 +137,25 @@ TEST_F(StatePersistenceTest, GetItems)
     EXPECT_EQ(val3, val3_read);
 }
 
+TEST_F(StatePersistenceTest, GetAllItems)
+{
+    std::vector<Entry> items;
+    DataTable data_table(m_database, "testtable", m_table1_item_def);
+
+    EXPECT_EQ(0, data_table.GetAllItems(items));
+    EXPECT_TRUE(items.empty());
+
+    EXPECT_EQ(0, data_table.InsertItem(m_table1_item_2));
+    EXPECT_EQ(0, data_table.InsertItem(m_table1_item_1));
+    EXPECT_EQ(0, data_table.GetAllItems(items));
+
+    ASSERT_EQ(2U, items.size());
+    EXPECT_EQ(10, std::get<int>(items[0][0].value));
+    EXPECT_EQ(std::string("test"), std::get<std::string>(items[0][1].value));
+    EXPECT_EQ(20, std::get<int>(items[1][0].value));
+    EXPECT_EQ(false, std::get<bool>(items[1][3].value));
+}
+
 TEST_F(StatePersistenceTest, SetItems)
 {
     DataTable data_table(m_database, "testtable", m_table1_item_def);
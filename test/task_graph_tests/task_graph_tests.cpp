@@ -0,0 +1,158 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file task_graph_tests.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <future>
+#include <mutex>
+#include <vector>
+
+#include "../../inc/task_graph.hpp"
+
+/*******************************************************************
+ * Test class definition
+ *******************************************************************/
+class TaskGraphTest : public ::testing::Test
+{
+public:
+    std::function<void()> Record(const std::string& name)
+    {
+        return [this, name]
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            record.push_back(name);
+        };
+    }
+
+    /* Finish the graph and wait for its report */
+    std::vector<StageTiming> FinishAndWait(TaskGraph& graph)
+    {
+        std::promise<std::vector<StageTiming>> timings;
+        std::future<std::vector<StageTiming>> future = timings.get_future();
+
+        EXPECT_EQ(graph.Finish([&timings](const std::vector<StageTiming>& stage_timings, double total_ms)
+        {
+            EXPECT_GE(total_ms, 0.0);
+            timings.set_value(stage_timings);
+        }), 0);
+
+        EXPECT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+
+        return future.get();
+    }
+
+protected:
+    ThreadPool pool{4};
+    std::vector<std::string> record;
+    std::mutex mutex;
+};
+
+/*******************************************************************
+ * Test cases
+ *******************************************************************/
+TEST_F(TaskGraphTest, NodesRunAfterTheirInputs)
+{
+    TaskGraph graph(pool, "Graph");
+
+    for(uint32_t i = 0; i < 20; i++)
+    {
+        graph.AddNode("encode", Record("encode"));
+    }
+    TaskGraph::Node archive = graph.AddNode("archive", Record("archive"), graph.GetNodes("encode"));
+    TaskGraph::Node database = graph.AddNode("database", Record("database"), {archive});
+    graph.AddNode("publish", Record("publish"), {database});
+
+    FinishAndWait(graph);
+
+    ASSERT_EQ(record.size(), 23U);
+    EXPECT_THAT(std::vector<std::string>(record.end() - 3, record.end()), ::testing::ElementsAre("archive", "database", "publish"));
+}
+
+TEST_F(TaskGraphTest, TimingsReportedPerStage)
+{
+    TaskGraph graph(pool, "Graph");
+
+    graph.AddNode("encode", []{ std::this_thread::sleep_for(std::chrono::milliseconds(10)); });
+    graph.AddNode("encode", []{ std::this_thread::sleep_for(std::chrono::milliseconds(10)); });
+    graph.AddNode("archive", Record("archive"), graph.GetNodes("encode"));
+
+    std::vector<StageTiming> timings = FinishAndWait(graph);
+
+    ASSERT_EQ(timings.size(), 2U);
+    EXPECT_EQ(timings[0].stage, "encode");
+    EXPECT_EQ(timings[0].nodes, 2U);
+    EXPECT_GE(timings[0].busy_ms, 20.0);
+    EXPECT_GE(timings[0].max_ms, 10.0);
+    EXPECT_LE(timings[0].max_ms, timings[0].busy_ms);
+    EXPECT_GE(timings[0].elapsed_ms, timings[0].max_ms);
+    EXPECT_EQ(timings[1].stage, "archive");
+    EXPECT_EQ(timings[1].nodes, 1U);
+}
+
+TEST_F(TaskGraphTest, AddNodeAfterFinishFails)
+{
+    TaskGraph graph(pool, "Graph");
+
+    FinishAndWait(graph);
+
+    EXPECT_EQ(graph.AddNode("encode", Record("encode")), nullptr);
+    EXPECT_EQ(graph.Finish(), -1);
+}
+
+TEST_F(TaskGraphTest, NodeReleasesItsFunctionOnceRun)
+{
+    std::shared_ptr<int> data = std::make_shared<int>(0);
+    TaskGraph graph(pool, "Graph");
+
+    TaskGraph::Node node = graph.AddNode("encode", [data]{ (*data)++; });
+
+    ASSERT_TRUE(node->Join(1000));
+    EXPECT_EQ(*data, 1);
+    EXPECT_EQ(data.use_count(), 1);
+}
+
+TEST_F(TaskGraphTest, GraphDestroyedWhileNodesPending)
+{
+    std::promise<void> release;
+    std::shared_future<void> release_future = release.get_future().share();
+    TaskGraph::Node last;
+
+    {
+        TaskGraph graph(pool, "Graph");
+        TaskGraph::Node first = graph.AddNode("first", [release_future]{ release_future.wait(); });
+
+        last = graph.AddNode("last", Record("last"), {first});
+        graph.Finish();
+    }
+
+    release.set_value();
+
+    ASSERT_TRUE(last->Join(1000));
+    EXPECT_THAT(record, ::testing::ElementsAre("last"));
+}
+
+TEST_F(TaskGraphTest, EventGatesItsDependents)
+{
+    TaskGraph graph(pool, "Graph");
+    TaskGraph::Trigger trigger;
+
+    TaskGraph::Node video = graph.AddEvent("video", trigger);
+    TaskGraph::Node database = graph.AddNode("database", Record("database"), {video});
+    graph.Finish();
+
+    EXPECT_FALSE(database->Join(100));
+    EXPECT_TRUE(record.empty());
+
+    trigger();
+
+    ASSERT_TRUE(database->Join(1000));
+    EXPECT_THAT(record, ::testing::ElementsAre("database"));
+}
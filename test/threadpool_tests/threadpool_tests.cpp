@@ -0,0 +1,255 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file threadpool_tests.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "../../inc/threadpool.hpp"
+
+/*******************************************************************
+ * Test class definition
+ *******************************************************************/
+class RecordTask : public Task
+{
+public:
+    RecordTask(std::string name, std::vector<std::string>& record, std::mutex& mutex,
+               TaskPriority priority = TaskPriority::Normal) :
+        Task(name, priority), m_record(record), m_mutex(mutex)
+    {
+    }
+
+    void operator() () override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_record.push_back(GetName());
+    }
+
+private:
+    std::vector<std::string>& m_record;
+    std::mutex& m_mutex;
+};
+
+/* Keeps a worker busy until released */
+class BlockingTask : public Task
+{
+public:
+    BlockingTask(std::shared_future<void> release) : Task("Blocking"), m_release(release)
+    {
+    }
+
+    void operator() () override
+    {
+        m_release.wait();
+    }
+
+private:
+    std::shared_future<void> m_release;
+};
+
+/*******************************************************************
+ * Test cases
+ *******************************************************************/
+TEST(ThreadPoolTest, ThreadCountSizedToHost)
+{
+    ThreadPool pool;
+
+    EXPECT_EQ(pool.GetNumberThreads(), std::max(std::thread::hardware_concurrency(), 1U));
+    EXPECT_EQ(ThreadPool(3).GetNumberThreads(), 3U);
+}
+
+TEST(ThreadPoolTest, ExecutesQueuedTasks)
+{
+    std::vector<std::string> record;
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Task>> tasks;
+    ThreadPool pool(4);
+
+    for(uint32_t i = 0; i < 100; i++)
+    {
+        tasks.push_back(std::make_shared<RecordTask>(std::to_string(i), record, mutex));
+        ASSERT_EQ(pool.QueueTask(tasks.back()), 0);
+    }
+    for(auto& task : tasks)
+    {
+        ASSERT_TRUE(task->Join(1000));
+    }
+
+    EXPECT_EQ(record.size(), 100U);
+}
+
+TEST(ThreadPoolTest, TaskQueuedTwiceFails)
+{
+    std::vector<std::string> record;
+    std::mutex mutex;
+    std::shared_ptr<Task> task = std::make_shared<RecordTask>("Task", record, mutex);
+    ThreadPool pool(1);
+
+    EXPECT_EQ(pool.QueueTask(task), 0);
+    EXPECT_EQ(pool.QueueTask(task), -1);
+    ASSERT_TRUE(task->Join(1000));
+
+    EXPECT_EQ(record.size(), 1U);
+}
+
+TEST(ThreadPoolTest, JoinTimesOut)
+{
+    std::promise<void> release;
+    std::shared_ptr<Task> task = std::make_shared<BlockingTask>(release.get_future().share());
+    ThreadPool pool(1);
+
+    pool.QueueTask(task);
+
+    EXPECT_FALSE(task->Join(50));
+    EXPECT_FALSE(task->IsEnded());
+
+    release.set_value();
+
+    EXPECT_TRUE(task->Join(1000));
+    EXPECT_TRUE(task->IsEnded());
+}
+
+TEST(ThreadPoolTest, HighPriorityTasksFirst)
+{
+    std::vector<std::string> record;
+    std::mutex mutex;
+    std::promise<void> release;
+    std::shared_ptr<Task> blocking = std::make_shared<BlockingTask>(release.get_future().share());
+    std::shared_ptr<Task> normal = std::make_shared<RecordTask>("Normal", record, mutex);
+    std::shared_ptr<Task> high = std::make_shared<RecordTask>("High", record, mutex, TaskPriority::High);
+    ThreadPool pool(1);
+
+    /* Both wait behind the blocking task */
+    pool.QueueTask(blocking);
+    pool.QueueTask(normal);
+    pool.QueueTask(high);
+    release.set_value();
+
+    ASSERT_TRUE(normal->Join(1000));
+    ASSERT_TRUE(high->Join(1000));
+
+    EXPECT_THAT(record, ::testing::ElementsAre("High", "Normal"));
+}
+
+TEST(ThreadPoolTest, IdleWorkersStealTasks)
+{
+    std::vector<std::string> record;
+    std::mutex mutex;
+    std::promise<void> release;
+    std::shared_future<void> release_future = release.get_future().share();
+    std::vector<std::shared_ptr<Task>> blocking, tasks;
+    ThreadPool pool(4);
+
+    /* Half the workers are kept busy, the tasks queued behind them are stolen by the others */
+    for(uint32_t i = 0; i < 2; i++)
+    {
+        blocking.push_back(std::make_shared<BlockingTask>(release_future));
+    }
+    for(uint32_t i = 0; i < 16; i++)
+    {
+        if(i % 8 == 0)
+        {
+            pool.QueueTask(blocking[i / 8]);
+        }
+        tasks.push_back(std::make_shared<RecordTask>(std::to_string(i), record, mutex));
+        pool.QueueTask(tasks.back());
+    }
+    for(auto& task : tasks)
+    {
+        EXPECT_TRUE(task->Join(1000));
+    }
+
+    release.set_value();
+    EXPECT_EQ(record.size(), 16U);
+}
+
+TEST(ThreadPoolTest, ThenRunsAfterDependency)
+{
+    std::vector<std::string> record;
+    std::mutex mutex;
+    std::promise<void> release;
+    std::shared_ptr<Task> first = std::make_shared<BlockingTask>(release.get_future().share());
+    std::shared_ptr<Task> second = std::make_shared<RecordTask>("Second", record, mutex);
+    ThreadPool pool(4);
+
+    pool.QueueTask(first);
+    ASSERT_EQ(pool.Then(first, second), 0);
+
+    EXPECT_FALSE(second->Join(50));
+
+    release.set_value();
+    EXPECT_TRUE(second->Join(1000));
+    EXPECT_TRUE(first->IsEnded());
+}
+
+TEST(ThreadPoolTest, WhenAllRunsAfterEveryDependency)
+{
+    std::vector<std::string> record;
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Task>> dependencies;
+    std::shared_ptr<Task> last = std::make_shared<RecordTask>("Last", record, mutex, TaskPriority::High);
+    ThreadPool pool(2);
+
+    for(uint32_t i = 0; i < 50; i++)
+    {
+        dependencies.push_back(std::make_shared<RecordTask>(std::to_string(i), record, mutex));
+        pool.QueueTask(dependencies.back());
+    }
+    /* Some dependencies have already ended when it's queued */
+    ASSERT_EQ(pool.WhenAll(dependencies, last), 0);
+    ASSERT_TRUE(last->Join(1000));
+
+    ASSERT_EQ(record.size(), 51U);
+    EXPECT_EQ(record.back(), "Last");
+}
+
+TEST(ThreadPoolTest, WhenAllWithoutDependenciesRunsImmediately)
+{
+    std::vector<std::string> record;
+    std::mutex mutex;
+    std::shared_ptr<Task> task = std::make_shared<RecordTask>("Task", record, mutex);
+    ThreadPool pool(1);
+
+    ASSERT_EQ(pool.WhenAll({}, task), 0);
+
+    EXPECT_TRUE(task->Join(1000));
+}
+
+TEST(ThreadPoolTest, SubmitReturnsFuture)
+{
+    ThreadPool pool(2);
+
+    std::future<int> result = pool.Submit("Sum", []{ return 40 + 2; });
+    std::future<void> failure = pool.Submit("Throw", []{ throw std::runtime_error("error"); }, TaskPriority::High);
+
+    EXPECT_EQ(result.get(), 42);
+    EXPECT_THROW(failure.get(), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, PendingTasksExecutedOnDestruction)
+{
+    std::atomic<uint32_t> executed{0};
+
+    {
+        ThreadPool pool(2);
+
+        for(uint32_t i = 0; i < 100; i++)
+        {
+            pool.Submit("Count", [&executed]{ executed++; });
+        }
+    }
+
+    EXPECT_EQ(executed, 100U);
+}
@@ -0,0 +1,162 @@
+/**
+ * @author Alejandro Solozabal
+ *
+ * @file zip_writer_tests.cpp
+ *
+ */
+
+/*******************************************************************
+ * Includes
+ *******************************************************************/
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include "../../inc/zip_writer.hpp"
+
+/*******************************************************************
+ * Test class definition
+ *******************************************************************/
+class ZipWriterTest : public ::testing::Test
+{
+public:
+    ZipWriterTest()
+    {
+        path = std::filesystem::temp_directory_path() / "zip_writer_test.zip";
+        std::filesystem::remove(path);
+    }
+
+    ~ZipWriterTest()
+    {
+        std::filesystem::remove(path);
+    }
+
+    std::vector<uint8_t> ReadArchive()
+    {
+        std::ifstream file(path, std::ios::binary);
+
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    static uint32_t Get16(const std::vector<uint8_t>& archive, size_t offset)
+    {
+        return archive[offset] | (archive[offset + 1] << 8);
+    }
+
+    static uint32_t Get32(const std::vector<uint8_t>& archive, size_t offset)
+    {
+        return Get16(archive, offset) | (Get16(archive, offset + 2) << 16);
+    }
+
+protected:
+    std::string path;
+    const std::string content = "123456789";
+    /* CRC32 check value of "123456789" */
+    const uint32_t content_crc = 0xCBF43926;
+};
+
+/*******************************************************************
+ * Test cases
+ *******************************************************************/
+TEST_F(ZipWriterTest, EmptyArchive)
+{
+    ZipWriter writer;
+
+    ASSERT_EQ(writer.Open(path), 0);
+    ASSERT_EQ(writer.Close(), 0);
+
+    std::vector<uint8_t> archive = ReadArchive();
+
+    ASSERT_EQ(archive.size(), 22U);
+    EXPECT_EQ(Get32(archive, 0), 0x06054B50U);
+    EXPECT_EQ(Get16(archive, 10), 0U);
+}
+
+TEST_F(ZipWriterTest, StoredEntries)
+{
+    ZipWriter writer;
+    const std::string names[] = {"0_capture_0.jpeg", "0_capture_1.jpeg"};
+
+    ASSERT_EQ(writer.Open(path), 0);
+    for(const std::string& name : names)
+    {
+        ASSERT_EQ(writer.AddFile(name, reinterpret_cast<const uint8_t*>(content.data()), content.size(), time(NULL)), 0);
+    }
+    EXPECT_EQ(writer.GetNumEntries(), 2U);
+    ASSERT_EQ(writer.Close(), 0);
+
+    std::vector<uint8_t> archive = ReadArchive();
+    size_t local_size = 30 + names[0].size() + content.size();
+    size_t central_offset = 2 * local_size;
+
+    ASSERT_EQ(archive.size(), central_offset + 2 * (46 + names[0].size()) + 22);
+
+    /* Local headers, each followed by the stored data */
+    for(size_t i = 0; i < 2; i++)
+    {
+        size_t offset = i * local_size;
+
+        EXPECT_EQ(Get32(archive, offset), 0x04034B50U);
+        EXPECT_EQ(Get16(archive, offset + 8), 0U);
+        EXPECT_EQ(Get32(archive, offset + 14), content_crc);
+        EXPECT_EQ(Get32(archive, offset + 18), content.size());
+        EXPECT_EQ(Get32(archive, offset + 22), content.size());
+        EXPECT_EQ(std::string(archive.begin() + offset + 30, archive.begin() + offset + 30 + names[i].size()), names[i]);
+        EXPECT_EQ(std::string(archive.begin() + offset + 30 + names[i].size(), archive.begin() + offset + local_size), content);
+
+        /* Central directory entry pointing to it */
+        size_t entry = central_offset + i * (46 + names[i].size());
+
+        EXPECT_EQ(Get32(archive, entry), 0x02014B50U);
+        EXPECT_EQ(Get32(archive, entry + 16), content_crc);
+        EXPECT_EQ(Get32(archive, entry + 42), offset);
+    }
+
+    /* End of central directory */
+    size_t end = archive.size() - 22;
+
+    EXPECT_EQ(Get32(archive, end), 0x06054B50U);
+    EXPECT_EQ(Get16(archive, end + 10), 2U);
+    EXPECT_EQ(Get32(archive, end + 12), end - central_offset);
+    EXPECT_EQ(Get32(archive, end + 16), central_offset);
+}
+
+TEST_F(ZipWriterTest, AddFileAndCloseWithoutOpenFail)
+{
+    ZipWriter writer;
+
+    EXPECT_EQ(writer.AddFile("file", reinterpret_cast<const uint8_t*>(content.data()), content.size(), time(NULL)), -1);
+    EXPECT_EQ(writer.Close(), -1);
+}
+
+TEST_F(ZipWriterTest, EntriesAddedFromSeveralThreads)
+{
+    ZipWriter writer;
+    std::vector<std::thread> threads;
+
+    ASSERT_EQ(writer.Open(path), 0);
+    for(uint32_t t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&, t]
+        {
+            for(uint32_t i = 0; i < 25; i++)
+            {
+                std::string name = std::to_string(t) + "_" + std::to_string(i);
+                EXPECT_EQ(writer.AddFile(name, reinterpret_cast<const uint8_t*>(content.data()), content.size(), time(NULL)), 0);
+            }
+        });
+    }
+    for(std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(writer.Close(), 0);
+
+    std::vector<uint8_t> archive = ReadArchive();
+
+    EXPECT_EQ(Get16(archive, archive.size() - 22 + 10), 100U);
+}